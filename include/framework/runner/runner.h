@@ -24,6 +24,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "util/cru_image.h"
 #include "util/cru_vec.h"
 
 typedef enum runner_isolation_mode runner_isolation_mode_t;
@@ -48,8 +49,19 @@ struct runner_opts {
     bool no_fork;
     bool no_cleanup_phase;
     bool no_image_dumps;
+
+    /// Encode and write image dumps in a background thread of each test.
+    bool use_async_image_dumps;
+
+    /// Dump images as raw files instead of PNG.
+    bool use_raw_image_dumps;
+
+    cru_image_write_info_t dump_write_info;
+
     bool use_separate_cleanup_threads;
     bool run_all_queues;
+    bool use_gpu_compare;
+    bool use_qonos_stats;
     bool verbose;
 
     /// The runner will write JUnit XML to this path, if not NULL.
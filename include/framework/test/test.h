@@ -21,27 +21,46 @@
 
 #pragma once
 
+#include "qonos/qonos_pipeline_dedup.h"
 #include "tapi/t.h"
 
 typedef struct test test_t;
 typedef struct test_create_info test_create_info_t;
+typedef struct test_timing test_timing_t;
 
 struct test_create_info {
     const test_def_t *def;
 
     bool enable_dump;
+    bool enable_async_dump;
+    bool enable_raw_dump;
+
+    /// Options for writing image dumps. NULL selects the defaults.
+    const cru_image_write_info_t *dump_write_info;
+
     bool enable_cleanup_phase;
     bool enable_separate_cleanup_thread;
     bool enable_bootstrap;
     int device_id;
     uint32_t queue_num;
     bool run_all_queues;
+    bool enable_gpu_compare;
+    bool enable_qonos_stats;
     bool verbose;
 
     uint32_t bootstrap_image_width;
     uint32_t bootstrap_image_height;
 };
 
+/// Nanoseconds of CLOCK_MONOTONIC that a test spent in each of its phases.
+/// The precleanup phase includes the comparison against reference images.
+struct test_timing {
+    uint64_t setup_ns;
+    uint64_t main_ns;
+    uint64_t precleanup_ns;
+    uint64_t cleanup_ns;
+};
+
 #ifdef DOXYGEN
 test_t *test_create(const test_create_info_t *va_args info);
 #else
@@ -59,3 +78,6 @@ bool test_is_current(void);
 void test_start(test_t *test);
 void test_wait(test_t *test);
 test_result_t test_get_result(test_t *test);
+void test_get_timing(test_t *test, test_timing_t *timing);
+void test_get_pipeline_dedup_stats(test_t *test,
+                                   qo_pipeline_dedup_stats_t *stats);
@@ -99,8 +99,23 @@ typedef struct QoMemoryAllocateFromRequirementsInfo {
     VkDeviceSize            allocationSize;
     uint32_t                memoryTypeIndex;
     VkMemoryPropertyFlags   properties;
+
+    /// Give a range from qoAllocBufferMemoryRange() or
+    /// qoAllocImageMemoryRange() a VkDeviceMemory of its own. Ranges with a
+    /// pNext chain are always dedicated.
+    VkBool32                dedicated;
 } QoMemoryAllocateFromRequirementsInfo;
 
+/// \brief A range of device memory, usually shared with other ranges.
+///
+/// Bind resources at \a offset, and map the range with qoMapMemoryRange()
+/// rather than qoMapMemory().
+typedef struct QoMemoryRange {
+    VkDeviceMemory          memory;
+    VkDeviceSize            offset;
+    VkDeviceSize            size;
+} QoMemoryRange;
+
 typedef struct QoExtraGraphicsPipelineCreateInfo_ {
     VkGraphicsPipelineCreateInfo *pNext;
     VkPrimitiveTopology topology;
@@ -345,10 +360,54 @@ qoAllocImageMemory(VkDevice dev, VkImage image,
         })
 #endif
 
+#ifdef DOXYGEN
+/// \brief Suballocate memory for a buffer.
+///
+/// Unlike qoAllocBufferMemory(), the memory usually comes from a large block
+/// shared with other buffers and images of the test's device, so the
+/// resource must be bound at QoMemoryRange::offset. Set
+/// QoMemoryAllocateFromRequirementsInfo::dedicated to get the behavior of
+/// qoAllocBufferMemory() instead. The range lives until the test's cleanup.
+QoMemoryRange
+qoAllocBufferMemoryRange(VkDevice dev, VkBuffer buffer,
+                         const QoMemoryAllocateFromRequirementsInfo *va_args override_info);
+#else
+#define qoAllocBufferMemoryRange(dev, buffer, ...) \
+    __qoAllocBufferMemoryRange((dev), (buffer), \
+        &(QoMemoryAllocateFromRequirementsInfo) { \
+            QO_MEMORY_ALLOCATE_FROM_REQUIREMENTS_INFO_DEFAULTS, \
+            ##__VA_ARGS__ , \
+        })
+#endif
+
+#ifdef DOXYGEN
+/// \brief Suballocate memory for an image.
+///
+/// \see qoAllocBufferMemoryRange()
+QoMemoryRange
+qoAllocImageMemoryRange(VkDevice dev, VkImage image,
+                        const QoMemoryAllocateFromRequirementsInfo *va_args override_info);
+#else
+#define qoAllocImageMemoryRange(dev, image, ...) \
+    __qoAllocImageMemoryRange((dev), (image), \
+        &(QoMemoryAllocateFromRequirementsInfo) { \
+            QO_MEMORY_ALLOCATE_FROM_REQUIREMENTS_INFO_DEFAULTS, \
+            ##__VA_ARGS__ , \
+        })
+#endif
+
 void *qoMapMemory(VkDevice dev, VkDeviceMemory mem,
                   VkDeviceSize offset, VkDeviceSize size,
                   VkMemoryMapFlags flags);
 
+/// \brief Map a range from qoAllocBufferMemoryRange() or
+/// qoAllocImageMemoryRange().
+///
+/// The returned pointer addresses the start of the range. A range of the
+/// test's device may be mapped any number of times; it stays mapped until the
+/// test's cleanup.
+void *qoMapMemoryRange(VkDevice dev, const QoMemoryRange *range);
+
 #ifdef DOXYGEN
 VkBuffer qoCreateBuffer(VkDevice dev, ...);
 #else
@@ -437,6 +496,14 @@ VkDescriptorSet qoAllocateDescriptorSet(VkDevice dev, ...);
         })
 #endif
 
+/// \brief Free every descriptor set allocated from \a pool.
+///
+/// If \a pool is t_descriptor_pool, this resets every pool of the chain that
+/// qoAllocateDescriptorSet() grew from it, see qonos_desc_alloc.h. Sets that
+/// qoAllocateDescriptorSet() allocated from any other pool are freed again by
+/// the test's cleanup, so do not reset such a pool.
+VkResult qoResetDescriptorPool(VkDevice dev, VkDescriptorPool pool);
+
 #ifdef DOXYGEN
 VkCommandBuffer qoAllocateCommandBuffer(VkDevice dev, VkCommandPool pool, ...);
 #else
@@ -449,6 +516,87 @@ VkCommandBuffer qoAllocateCommandBuffer(VkDevice dev, VkCommandPool pool, ...);
         })
 #endif
 
+/// \brief Get a recycled command buffer for \a queue_family.
+///
+/// The command buffer comes from the test's ring for the queue family, see
+/// qonos_cmd_ring.h, and is ready to begin. Submit it with
+/// qoQueueSubmitRing() as often as needed. Once the test releases it with
+/// qoReleaseCommandBuffer() and its submissions complete, a later call may
+/// return the same command buffer. \a dev must be the test's device.
+VkCommandBuffer qoAcquireCommandBuffer(VkDevice dev, uint32_t queue_family);
+
+/// \brief Like qoAcquireCommandBuffer(), but for a single submission.
+///
+/// The command buffer is released by its submission, so a later call may
+/// return it once that submission completes. The test must not submit it
+/// again.
+VkCommandBuffer qoAcquireOneShotCommandBuffer(VkDevice dev,
+                                              uint32_t queue_family);
+
+/// Return a command buffer from qoAcquireCommandBuffer() to the test's ring.
+void qoReleaseCommandBuffer(VkDevice dev, uint32_t queue_family,
+                            VkCommandBuffer cmd);
+
+/// \brief Submit a command buffer from the test's ring.
+///
+/// If an earlier submission of \a cmd is still in flight, this waits for it
+/// first, so a command buffer may be recorded once and submitted repeatedly.
+VkResult qoQueueSubmitRing(VkQueue queue, uint32_t queue_family,
+                           VkCommandBuffer cmd);
+
+typedef struct qo_timeline qo_timeline_t;
+
+/// \brief Create a timeline for batched submissions to \a queue.
+///
+/// See qonos_timeline.h. Skip the test if the device lacks the
+/// timelineSemaphore feature. Command buffers from the test's ring for
+/// \a queue_family may be submitted through the timeline. The test's cleanup
+/// stack destroys the timeline after waiting for its batches.
+qo_timeline_t *qoCreateTimeline(VkDevice dev, VkQueue queue,
+                                uint32_t queue_family);
+
+/// \brief Queue a batch of command buffers on \a tl.
+///
+/// Return the timeline value that the batch signals when it completes. The
+/// batch reaches the queue at the latest when a later qoTimelineWait()
+/// waits for it.
+uint64_t qoTimelineSubmit(qo_timeline_t *tl, uint32_t cmd_count,
+                          const VkCommandBuffer *cmds);
+
+/// Submit the batches queued on \a tl.
+VkResult qoTimelineFlush(qo_timeline_t *tl);
+
+/// Wait until the batch that signals \a value, and all batches before it,
+/// have completed.
+VkResult qoTimelineWait(qo_timeline_t *tl, uint64_t value);
+
+/// \brief Copy \a size bytes from \a data to \a buffer through the test's
+/// staging ring.
+///
+/// See qonos_staging.h. The copy is submitted to \a queue, whose family is
+/// \a queue_family, and is visible to work submitted to \a queue afterwards.
+/// \a buffer needs VK_BUFFER_USAGE_TRANSFER_DST_BIT, which qoCreateBuffer()
+/// sets by default. \a dev must be the test's device.
+void qoUploadBuffer(VkDevice dev, VkQueue queue, uint32_t queue_family,
+                    VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size,
+                    const void *data);
+
+/// \brief Copy tightly packed texels from \a data to \a region of \a image.
+///
+/// Like qoUploadBuffer(); see qo_staging_upload_image() for \a region and
+/// \a layout.
+void qoUploadImage(VkDevice dev, VkQueue queue, uint32_t queue_family,
+                   VkImage image, VkFormat format, VkImageLayout layout,
+                   const VkBufferImageCopy *region, const void *data);
+
+/// \brief Copy \a region of \a image to \a data, tightly packed.
+///
+/// Return once the texels are in \a data. See qo_staging_download_image()
+/// for \a region and \a layout.
+void qoDownloadImage(VkDevice dev, VkQueue queue, uint32_t queue_family,
+                     VkImage image, VkFormat format, VkImageLayout layout,
+                     const VkBufferImageCopy *region, void *data);
+
 #ifdef DOXYGEN
 VkResult qoBeginCommandBuffer(VkCommandBuffer cmd, ...);
 #else
@@ -510,6 +658,10 @@ VkImageView qoCreateImageView(VkDevice dev, ...);
     })
 #endif
 
+/// \brief Create a shader module, or reuse one with identical SPIR-V.
+///
+/// On the test's device, a module built from the same SPIR-V earlier in the
+/// test is returned instead of a new one. See qonos_pipeline_dedup.h.
 #ifdef DOXYGEN
 VkShader qoCreateShaderModule(VkDevice dev, ...);
 #else
@@ -531,6 +683,8 @@ VkDeviceMemory __qoAllocMemory(VkDevice dev, const VkMemoryAllocateInfo *info);
 VkDeviceMemory __qoAllocMemoryFromRequirements(VkDevice dev, const VkMemoryRequirements *mem_reqs, const QoMemoryAllocateFromRequirementsInfo *info);
 VkDeviceMemory __qoAllocBufferMemory(VkDevice dev, VkBuffer buffer, const QoMemoryAllocateFromRequirementsInfo *info);
 VkDeviceMemory __qoAllocImageMemory(VkDevice dev, VkImage image, const QoMemoryAllocateFromRequirementsInfo *info);
+QoMemoryRange __qoAllocBufferMemoryRange(VkDevice dev, VkBuffer buffer, const QoMemoryAllocateFromRequirementsInfo *info);
+QoMemoryRange __qoAllocImageMemoryRange(VkDevice dev, VkImage image, const QoMemoryAllocateFromRequirementsInfo *info);
 VkBuffer __qoCreateBuffer(VkDevice dev, const VkBufferCreateInfo *info);
 VkBufferView __qoCreateBufferView(VkDevice dev, const VkBufferViewCreateInfo *info);
 VkQueryPool __qoCreateQueryPool(VkDevice dev, const VkQueryPoolCreateInfo *info);
@@ -548,6 +702,9 @@ VkRenderPass __qoCreateRenderPass(VkDevice dev, const VkRenderPassCreateInfo *in
 VkPipeline qoCreateGraphicsPipeline(VkDevice dev,
                                     VkPipelineCache pipeline_cache,
                                     const QoExtraGraphicsPipelineCreateInfo *info);
+VkPipeline qoCreateComputePipeline(VkDevice dev,
+                                   VkPipelineCache pipeline_cache,
+                                   const VkComputePipelineCreateInfo *info);
 VkImage __qoCreateImage(VkDevice dev, const VkImageCreateInfo *info);
 VkImageView __qoCreateImageView(VkDevice dev, const VkImageViewCreateInfo *info);
 VkShaderModule __qoCreateShaderModule(VkDevice dev, const QoShaderModuleCreateInfo *info);
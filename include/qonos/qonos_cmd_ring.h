@@ -0,0 +1,93 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/// \file
+/// \brief Recycled command buffers for the Qonos wrappers.
+///
+/// Each test owns one qo_cmd_ring_t per queue family of its device, created
+/// on first use, see t_qonos_cmd_ring(). A ring hands out command buffers
+/// from a pool created with VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT.
+/// Each command buffer has a fence that its submissions signal.
+///
+/// The test holds each command buffer that it acquires until it releases it
+/// with qo_cmd_ring_release(), or, for a one-shot command buffer, until its
+/// first submission. Once a command buffer is no longer held and its fence
+/// has signaled, the ring resets it and hands it out again, so a loop that
+/// records and submits repeatedly stops allocating after the first few
+/// iterations.
+///
+/// Like the test's command pools, a ring is externally synchronized: only one
+/// thread may use it at a time.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "util/vk_wrapper.h"
+
+typedef struct qo_cmd_ring qo_cmd_ring_t;
+typedef struct qo_timeline qo_timeline_t;
+
+/// Most command buffers a ring holds. When all are in flight, acquiring one
+/// waits for the oldest submission of a command buffer that the test no
+/// longer holds.
+#define QO_CMD_RING_MAX_SLOTS 64
+
+qo_cmd_ring_t *qo_cmd_ring_create(VkDevice dev, uint32_t queue_family);
+
+/// Wait for the ring's submissions to complete, then free its command
+/// buffers, fences, and pool. Submissions made through a qo_timeline_t are
+/// not waited for; destroy the timeline first.
+void qo_cmd_ring_destroy(qo_cmd_ring_t *ring);
+
+VkDevice qo_cmd_ring_get_device(qo_cmd_ring_t *ring);
+
+/// \brief Get a command buffer in the initial state.
+///
+/// If \a one_shot, the command buffer must be submitted exactly once, after
+/// which the ring may recycle it. Otherwise the test holds it until
+/// qo_cmd_ring_release(), and may submit it any number of times.
+///
+/// Return VK_NULL_HANDLE on failure, or if the test holds every command
+/// buffer of a full ring.
+VkCommandBuffer qo_cmd_ring_acquire(qo_cmd_ring_t *ring, bool one_shot);
+
+/// \brief Return a command buffer from qo_cmd_ring_acquire() to the ring.
+///
+/// The ring recycles it once its last submission, if any, has completed.
+/// The test must not use \a cmd afterwards.
+void qo_cmd_ring_release(qo_cmd_ring_t *ring, VkCommandBuffer cmd);
+
+/// \brief Submit a command buffer held from \a ring to \a queue.
+///
+/// Unless it is one-shot, the command buffer may be submitted again. If an
+/// earlier submission of it is still in flight, this waits for it first.
+VkResult qo_cmd_ring_submit(qo_cmd_ring_t *ring, VkQueue queue,
+                            VkCommandBuffer cmd);
+
+/// \brief Record that \a cmd was submitted through a timeline.
+///
+/// The command buffer stays in flight until \a tl reaches \a value. Like
+/// qo_cmd_ring_submit(), this ends the test's hold on a one-shot command
+/// buffer. Return false if \a cmd does not belong to \a ring.
+bool qo_cmd_ring_mark_pending(qo_cmd_ring_t *ring, VkCommandBuffer cmd,
+                              qo_timeline_t *tl, uint64_t value);
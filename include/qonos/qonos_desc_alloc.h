@@ -0,0 +1,96 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/// \file
+/// \brief A growable chain of descriptor pools.
+///
+/// Each test owns a qo_desc_alloc_t for its device, see t_qonos_desc_alloc.
+/// Its first pool is t_descriptor_pool, sized by test_def_t::descriptor_count
+/// and test_def_t::descriptor_sets. When qoAllocateDescriptorSet() exhausts
+/// t_descriptor_pool, the allocator moves on to the next pool of the chain,
+/// creating one twice as large as the last if needed. Tests therefore need not
+/// size the pool for their worst case.
+///
+/// Sets allocated through the chain are owned by its pools. They are freed
+/// in bulk by qo_desc_alloc_reset() or when the test's cleanup destroys the
+/// pools, never one at a time.
+///
+/// The allocator records how many descriptors of each type, and how many
+/// sets, were allocated between resets, and the peak of each. Descriptors are
+/// counted only for set layouts created through Qonos.
+
+#pragma once
+
+#include <stdint.h>
+
+#include "util/vk_wrapper.h"
+
+typedef struct qo_desc_alloc qo_desc_alloc_t;
+typedef struct qo_desc_alloc_usage qo_desc_alloc_usage_t;
+
+/// The descriptor types of Vulkan 1.0, which the allocator accounts for.
+#define QO_DESC_ALLOC_NUM_TYPES (VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT + 1)
+
+struct qo_desc_alloc_usage {
+    uint32_t sets;
+    uint32_t descriptors[QO_DESC_ALLOC_NUM_TYPES];
+};
+
+/// Create the allocator and its first pool from \a info. Chained pools use
+/// the same flags and types.
+qo_desc_alloc_t *qo_desc_alloc_create(VkDevice dev,
+                                      const VkDescriptorPoolCreateInfo *info);
+
+/// Destroy every pool of the chain, which frees their sets.
+void qo_desc_alloc_destroy(qo_desc_alloc_t *da);
+
+VkDevice qo_desc_alloc_get_device(qo_desc_alloc_t *da);
+
+/// Return the first pool of the chain.
+VkDescriptorPool qo_desc_alloc_get_pool(qo_desc_alloc_t *da);
+
+/// Record the descriptor counts of a set layout for the usage statistics and
+/// for sizing chained pools.
+void qo_desc_alloc_add_layout(qo_desc_alloc_t *da,
+                              VkDescriptorSetLayout layout,
+                              const VkDescriptorSetLayoutCreateInfo *info);
+
+/// \brief Allocate descriptor sets from the chain.
+///
+/// \a info->descriptorPool is ignored. On VK_ERROR_OUT_OF_POOL_MEMORY or
+/// VK_ERROR_FRAGMENTED_POOL, the allocation moves on to the next pool of the
+/// chain. Other errors are returned.
+VkResult qo_desc_alloc_allocate(qo_desc_alloc_t *da,
+                                const VkDescriptorSetAllocateInfo *info,
+                                VkDescriptorSet *sets);
+
+/// Reset every pool of the chain, freeing all of their sets, and start
+/// allocating from the first pool again.
+VkResult qo_desc_alloc_reset(qo_desc_alloc_t *da);
+
+/// Get the most sets and descriptors that were allocated at once.
+void qo_desc_alloc_get_high_water(qo_desc_alloc_t *da,
+                                  qo_desc_alloc_usage_t *usage);
+
+/// \brief Log the high-water marks and the number of pools.
+///
+/// Each line is prefixed with \a name, which is usually the test name.
+void qo_desc_alloc_log(qo_desc_alloc_t *da, const char *name);
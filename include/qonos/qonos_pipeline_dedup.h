@@ -0,0 +1,147 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/// \file
+/// \brief Deduplication of the pipelines that Qonos creates.
+///
+/// Parameterized tests often create the same pipeline many times, once per
+/// call of a helper such as run_simple_pipeline(). Each test owns a
+/// qo_pipeline_dedup_t for its device, see t_qonos_pipeline_dedup. When
+/// qoCreateGraphicsPipeline() or qoCreateComputePipeline() is asked for a
+/// pipeline identical to one it already created, it returns the existing
+/// VkPipeline instead of compiling a new one.
+///
+/// Pipelines are keyed by a hash of their create info. The key does not
+/// include the raw handles that the create info references. Instead it includes
+/// a fingerprint of each shader module, pipeline layout, and render pass: the
+/// hash of the SPIR-V or of the create info that made the object. Pipelines
+/// built from two identical layouts therefore share a key. Pipeline layouts and
+/// render passes created from identical create infos are compatible, so the
+/// shared pipeline is valid with either.
+///
+/// The same table of SPIR-V hashes lets qoCreateShaderModule() return the
+/// existing VkShaderModule when it is asked to create a module from SPIR-V it
+/// has seen before, as happens when a test creates its shaders inside a loop
+/// over its parameters.
+///
+/// Only objects created through the Qonos wrappers have fingerprints, and
+/// those live until the test's cleanup, so their handles are never reused
+/// during the test. A pipeline that references any other object, carries a
+/// pNext chain the key does not understand, derives from a base pipeline, or
+/// uses a pipeline cache other than the test's is created without
+/// deduplication. A test can opt out of deduplication entirely with
+/// test_def_t::no_pipeline_dedup.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "util/cru_hash.h"
+#include "util/vk_wrapper.h"
+
+typedef struct qo_pipeline_dedup qo_pipeline_dedup_t;
+typedef struct qo_pipeline_dedup_stats qo_pipeline_dedup_stats_t;
+
+struct qo_pipeline_dedup_stats {
+    /// Pipelines returned from the cache.
+    uint64_t hits;
+
+    /// Pipelines that had a key but were not yet in the cache.
+    uint64_t misses;
+
+    /// Pipelines created without a key, and hence without deduplication.
+    uint64_t uncached;
+};
+
+/// \a pipeline_cache is the test's pipeline cache. Pipelines created with any
+/// other non-null cache bypass deduplication, because the caller likely
+/// intends to exercise that cache.
+qo_pipeline_dedup_t *qo_pipeline_dedup_create(VkDevice dev,
+                                              VkPipelineCache pipeline_cache);
+void qo_pipeline_dedup_destroy(qo_pipeline_dedup_t *dd);
+
+VkDevice qo_pipeline_dedup_get_device(qo_pipeline_dedup_t *dd);
+
+/// Return the current test's pipeline deduplication if it serves \a dev, or
+/// NULL if the test has none or it serves another device.
+qo_pipeline_dedup_t *qo_pipeline_dedup_for_device(VkDevice dev);
+void qo_pipeline_dedup_get_stats(qo_pipeline_dedup_t *dd,
+                                 qo_pipeline_dedup_stats_t *stats);
+
+/// \brief Find a shader module created from identical SPIR-V.
+///
+/// Set \a key to the hash of the SPIR-V. If there is no such module, return
+/// VK_NULL_HANDLE; the caller should then create the module and call
+/// qo_pipeline_dedup_insert_shader_module() with \a key.
+VkShaderModule qo_pipeline_dedup_lookup_shader_module(qo_pipeline_dedup_t *dd,
+                                                      const void *spirv,
+                                                      size_t spirv_size,
+                                                      cru_hash128_t *key);
+
+/// Record the fingerprint of a new shader module, and share it with later
+/// lookups of the same SPIR-V. If another thread added a module with the same
+/// key first, lookups keep returning that one.
+void qo_pipeline_dedup_insert_shader_module(qo_pipeline_dedup_t *dd,
+                                            cru_hash128_t key,
+                                            VkShaderModule module);
+
+// Record the fingerprints of newly created objects.
+
+void qo_pipeline_dedup_add_descriptor_set_layout(qo_pipeline_dedup_t *dd,
+        VkDescriptorSetLayout layout,
+        const VkDescriptorSetLayoutCreateInfo *info);
+void qo_pipeline_dedup_add_pipeline_layout(qo_pipeline_dedup_t *dd,
+        VkPipelineLayout layout,
+        const VkPipelineLayoutCreateInfo *info);
+void qo_pipeline_dedup_add_render_pass(qo_pipeline_dedup_t *dd,
+                                       VkRenderPass pass,
+                                       const VkRenderPassCreateInfo *info);
+
+/// \brief Compute the key of a graphics pipeline.
+///
+/// Return false if the pipeline must not be deduplicated. In that case, the
+/// caller should create it and call qo_pipeline_dedup_add_uncached().
+bool qo_pipeline_dedup_key_graphics(qo_pipeline_dedup_t *dd,
+                                    VkPipelineCache pipeline_cache,
+                                    const VkGraphicsPipelineCreateInfo *info,
+                                    cru_hash128_t *key);
+
+/// Like qo_pipeline_dedup_key_graphics(), but for compute pipelines.
+bool qo_pipeline_dedup_key_compute(qo_pipeline_dedup_t *dd,
+                                   VkPipelineCache pipeline_cache,
+                                   const VkComputePipelineCreateInfo *info,
+                                   cru_hash128_t *key);
+
+/// \brief Find the pipeline with \a key.
+///
+/// Return VK_NULL_HANDLE, and count a miss, if there is none. The caller
+/// should then create the pipeline and call qo_pipeline_dedup_insert().
+VkPipeline qo_pipeline_dedup_lookup(qo_pipeline_dedup_t *dd,
+                                    cru_hash128_t key);
+
+/// Add \a pipeline to the cache. If another thread added a pipeline with the
+/// same key first, the cache keeps that one.
+void qo_pipeline_dedup_insert(qo_pipeline_dedup_t *dd, cru_hash128_t key,
+                              VkPipeline pipeline);
+
+/// Count a pipeline created without a key.
+void qo_pipeline_dedup_add_uncached(qo_pipeline_dedup_t *dd);
@@ -0,0 +1,90 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/// \file
+/// \brief Staging ring for the Qonos upload and download helpers.
+///
+/// Each test owns one qo_staging_t per queue family of its device, see
+/// t_qonos_staging(). On first use a staging ring allocates a host-visible,
+/// host-coherent buffer of QO_STAGING_SIZE bytes and keeps it mapped for the
+/// rest of the test.
+///
+/// A transfer is split into chunks of at most a quarter of the ring. The ring
+/// copies each chunk into the buffer and submits its GPU copy with a fence of
+/// its own. It then moves on to the next chunk, so the CPU fills one chunk
+/// while the GPU copies the previous one. When the ring wraps around onto a
+/// chunk still in flight, it waits for that chunk's fence.
+///
+/// Uploads return once the last chunk is submitted. Each chunk ends with a
+/// memory barrier, so work submitted later to the same queue sees the
+/// uploaded data. Downloads return once the data has reached the caller.
+///
+/// Like the test's command pools, a staging ring is externally synchronized.
+
+#pragma once
+
+#include "util/vk_wrapper.h"
+
+typedef struct qo_staging qo_staging_t;
+
+/// Size of the staging buffer.
+#define QO_STAGING_SIZE (16u << 20)
+
+/// Most chunks in flight at once.
+#define QO_STAGING_MAX_SUBMITS 8
+
+/// Create an empty staging ring. It allocates nothing until its first
+/// transfer.
+qo_staging_t *qo_staging_create(VkDevice dev, uint32_t queue_family,
+                                const VkPhysicalDeviceMemoryProperties *mem_props);
+
+/// Wait for the ring's chunks to complete, then free its resources.
+void qo_staging_destroy(qo_staging_t *st);
+
+VkDevice qo_staging_get_device(qo_staging_t *st);
+
+/// Copy \a size bytes from \a data to \a buffer at \a offset.
+VkResult qo_staging_upload_buffer(qo_staging_t *st, VkQueue queue,
+                                  VkBuffer buffer, VkDeviceSize offset,
+                                  VkDeviceSize size, const void *data);
+
+/// \brief Copy tightly packed texels from \a data to \a image.
+///
+/// Only the imageSubresource, imageOffset, and imageExtent fields of
+/// \a region are used. It must name a single aspect. \a data holds the
+/// texels of each layer in turn, and within a layer each slice in turn, with
+/// rows tightly packed. \a image must be in \a layout, which must be
+/// VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL or VK_IMAGE_LAYOUT_GENERAL. The
+/// ring's queue family must have a minImageTransferGranularity of 1x1x1.
+VkResult qo_staging_upload_image(qo_staging_t *st, VkQueue queue,
+                                 VkImage image, VkFormat format,
+                                 VkImageLayout layout,
+                                 const VkBufferImageCopy *region,
+                                 const void *data);
+
+/// Like qo_staging_upload_image(), but copy from \a image to \a data.
+/// \a layout must be VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL or
+/// VK_IMAGE_LAYOUT_GENERAL.
+VkResult qo_staging_download_image(qo_staging_t *st, VkQueue queue,
+                                   VkImage image, VkFormat format,
+                                   VkImageLayout layout,
+                                   const VkBufferImageCopy *region,
+                                   void *data);
@@ -0,0 +1,162 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/// \file
+/// \brief Optional instrumentation of the Qonos wrappers.
+///
+/// When the current test owns a qo_stats_t, see t_qonos_stats, each Qonos
+/// wrapper charges the time spent in the Vulkan entry point it wraps to that
+/// entry point, counts the objects it creates, and tracks the device memory
+/// it allocates on each heap. The test reports the totals when it stops.
+///
+/// Only calls made through Qonos are recorded. Vulkan functions that a test
+/// calls directly are invisible to the instrumentation.
+
+#pragma once
+
+#include <stdint.h>
+
+#include "tapi/t_data.h"
+#include "util/misc.h"
+#include "util/vk_wrapper.h"
+
+typedef enum qo_stats_object_type qo_stats_object_type_t;
+typedef enum qo_stats_entrypoint qo_stats_entrypoint_t;
+typedef enum qo_stats_cache qo_stats_cache_t;
+typedef struct qo_stats qo_stats_t;
+
+#define QO_STATS_OBJECT_TYPES(X) \
+    X(BUFFER,                   VkBuffer) \
+    X(BUFFER_VIEW,              VkBufferView) \
+    X(COMMAND_BUFFER,           VkCommandBuffer) \
+    X(DESCRIPTOR_SET,           VkDescriptorSet) \
+    X(DESCRIPTOR_SET_LAYOUT,    VkDescriptorSetLayout) \
+    X(DEVICE_MEMORY,            VkDeviceMemory) \
+    X(FRAMEBUFFER,              VkFramebuffer) \
+    X(IMAGE,                    VkImage) \
+    X(IMAGE_VIEW,               VkImageView) \
+    X(PIPELINE,                 VkPipeline) \
+    X(PIPELINE_CACHE,           VkPipelineCache) \
+    X(PIPELINE_LAYOUT,          VkPipelineLayout) \
+    X(QUERY_POOL,               VkQueryPool) \
+    X(RENDER_PASS,              VkRenderPass) \
+    X(SAMPLER,                  VkSampler) \
+    X(SEMAPHORE,                VkSemaphore) \
+    X(SHADER_MODULE,            VkShaderModule)
+
+#define QO_STATS_ENTRYPOINTS(X) \
+    X(vkAllocateCommandBuffers) \
+    X(vkAllocateDescriptorSets) \
+    X(vkAllocateMemory) \
+    X(vkBeginCommandBuffer) \
+    X(vkBindBufferMemory) \
+    X(vkBindImageMemory) \
+    X(vkCreateBuffer) \
+    X(vkCreateBufferView) \
+    X(vkCreateComputePipelines) \
+    X(vkCreateDescriptorSetLayout) \
+    X(vkCreateFramebuffer) \
+    X(vkCreateGraphicsPipelines) \
+    X(vkCreateImage) \
+    X(vkCreateImageView) \
+    X(vkCreatePipelineCache) \
+    X(vkCreatePipelineLayout) \
+    X(vkCreateQueryPool) \
+    X(vkCreateRenderPass) \
+    X(vkCreateSampler) \
+    X(vkCreateShaderModule) \
+    X(vkEndCommandBuffer) \
+    X(vkGetBufferMemoryRequirements) \
+    X(vkGetImageMemoryRequirements) \
+    X(vkMapMemory) \
+    X(vkQueueSubmit) \
+    X(vkQueueWaitIdle) \
+    X(vkWaitSemaphores)
+
+/// Caches whose lookups are counted, and their names in the log.
+#define QO_STATS_CACHES(X) \
+    X(SHADER_MODULE,            "shader module")
+
+enum qo_stats_cache {
+#define QO_STATS_CACHE_ENUM(name, str) QO_STATS_CACHE_##name,
+    QO_STATS_CACHES(QO_STATS_CACHE_ENUM)
+#undef QO_STATS_CACHE_ENUM
+    QO_STATS_NUM_CACHES,
+};
+
+enum qo_stats_object_type {
+#define QO_STATS_OBJECT_TYPE_ENUM(name, vk_type) QO_STATS_OBJECT_##name,
+    QO_STATS_OBJECT_TYPES(QO_STATS_OBJECT_TYPE_ENUM)
+#undef QO_STATS_OBJECT_TYPE_ENUM
+    QO_STATS_NUM_OBJECT_TYPES,
+};
+
+enum qo_stats_entrypoint {
+#define QO_STATS_ENTRYPOINT_ENUM(name) QO_STATS_ENTRYPOINT_##name,
+    QO_STATS_ENTRYPOINTS(QO_STATS_ENTRYPOINT_ENUM)
+#undef QO_STATS_ENTRYPOINT_ENUM
+    QO_STATS_NUM_ENTRYPOINTS,
+};
+
+qo_stats_t *qo_stats_create(void);
+void qo_stats_destroy(qo_stats_t *stats);
+
+/// \brief Log the recorded totals, one line per non-zero counter.
+///
+/// Each line is prefixed with \a name, which is usually the test name.
+void qo_stats_log(qo_stats_t *stats, const char *name);
+
+// The functions below accept a NULL \a stats, in which case they do nothing.
+// That lets the Qonos wrappers call them unconditionally.
+
+void qo_stats_add_object(qo_stats_t *stats, qo_stats_object_type_t type);
+void qo_stats_add_call(qo_stats_t *stats, qo_stats_entrypoint_t entrypoint,
+                       uint64_t duration_ns);
+
+/// Count an allocation of \a size bytes on \a heap.
+void qo_stats_add_memory(qo_stats_t *stats, uint32_t heap,
+                         VkDeviceSize size);
+
+/// \brief Track \a size bytes on \a heap as live until
+/// qo_stats_remove_live_memory().
+///
+/// Call this only for memory whose free Qonos observes. Memory that a test
+/// frees itself with vkFreeMemory() would otherwise stay live forever.
+void qo_stats_add_live_memory(qo_stats_t *stats, uint32_t heap,
+                              VkDeviceSize size);
+void qo_stats_remove_live_memory(qo_stats_t *stats, uint32_t heap,
+                                 VkDeviceSize size);
+
+void qo_stats_add_cache_lookup(qo_stats_t *stats, qo_stats_cache_t cache,
+                               bool hit);
+
+/// \brief Evaluate the statement \a call and charge its duration to
+/// \a entrypoint in the current test's instrumentation, if any.
+#define QO_STATS_CALL(entrypoint, call) \
+    do { \
+        qo_stats_t *__qo_stats = t_qonos_stats; \
+        uint64_t __qo_start = __qo_stats ? cru_get_time_ns() : 0; \
+        call; \
+        if (__qo_stats) { \
+            qo_stats_add_call(__qo_stats, QO_STATS_ENTRYPOINT_##entrypoint, \
+                              cru_get_time_ns() - __qo_start); \
+        } \
+    } while (0)
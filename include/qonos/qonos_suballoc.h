@@ -0,0 +1,74 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/// \file
+/// \brief Suballocation of device memory for the Qonos wrappers.
+///
+/// Each test owns one qo_suballoc_t for its device, see t_qonos_suballoc.
+/// qoAllocBufferMemoryRange() and qoAllocImageMemoryRange() carve their
+/// ranges out of large blocks of device memory, one list of blocks per memory
+/// type, instead of calling vkAllocateMemory for each resource.
+///
+/// Ranges are never freed individually. Like every other Qonos object, they
+/// live until the test's cleanup, when the suballocator frees its blocks.
+/// That allows a linear strategy: each block hands out ranges from a single
+/// moving top, aligned to the resource's requirements. Images start and end
+/// on a bufferImageGranularity boundary, so linear and optimal resources
+/// never share a granularity page.
+
+#pragma once
+
+#include <stdbool.h>
+
+#include "qonos/qonos.h"
+#include "util/vk_wrapper.h"
+
+typedef struct qo_suballoc qo_suballoc_t;
+
+/// Size of the blocks of device memory. Blocks are smaller on small heaps,
+/// and a range that would fill more than half a block gets its own memory.
+#define QO_SUBALLOC_BLOCK_SIZE (64ull << 20)
+
+qo_suballoc_t *
+qo_suballoc_create(VkDevice dev,
+                   const VkPhysicalDeviceMemoryProperties *mem_props,
+                   VkDeviceSize buffer_image_granularity);
+
+/// Free every block, and hence every range, of the suballocator.
+void qo_suballoc_destroy(qo_suballoc_t *sa);
+
+VkDevice qo_suballoc_get_device(qo_suballoc_t *sa);
+
+/// \brief Allocate a range of memory type \a memory_type.
+///
+/// If \a dedicated is set, then the range gets a VkDeviceMemory of its own,
+/// which is still freed with the suballocator. Return false if
+/// vkAllocateMemory fails.
+bool qo_suballoc_alloc(qo_suballoc_t *sa, uint32_t memory_type,
+                       const VkMemoryRequirements *mem_reqs, bool is_image,
+                       bool dedicated, QoMemoryRange *range);
+
+/// \brief Map a range allocated by \a sa.
+///
+/// The range's whole block is mapped on first use and stays mapped until the
+/// suballocator is destroyed, so a range may be mapped any number of times.
+/// Return NULL if \a range does not belong to \a sa or vkMapMemory fails.
+void *qo_suballoc_map(qo_suballoc_t *sa, const QoMemoryRange *range);
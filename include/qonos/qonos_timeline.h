@@ -0,0 +1,74 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/// \file
+/// \brief Batched queue submission tracked by a timeline semaphore.
+///
+/// A qo_timeline_t owns a timeline semaphore and queues batches of command
+/// buffers for one VkQueue. Each batch signals the next value of the
+/// semaphore. qo_timeline_submit() only records the batch; the batches reach
+/// the driver together, in one vkQueueSubmit(), when the caller flushes them,
+/// waits for one of them, or QO_TIMELINE_MAX_PENDING accumulate. Waiting for a
+/// value waits for that batch and, because semaphore signals cover all earlier
+/// work on the queue, for every earlier batch too. Callers can therefore keep
+/// several batches in flight and wait only for the results they read, instead
+/// of draining the queue with vkQueueWaitIdle().
+///
+/// Command buffers from the test's qo_cmd_ring_t for the timeline's queue
+/// family are returned to the ring once their batch completes.
+///
+/// The device must have the timelineSemaphore feature enabled. A timeline is
+/// externally synchronized.
+
+#pragma once
+
+#include <stdint.h>
+
+#include "qonos/qonos_cmd_ring.h"
+#include "util/vk_wrapper.h"
+
+typedef struct qo_timeline qo_timeline_t;
+
+/// Most batches that qo_timeline_submit() queues before it flushes them.
+#define QO_TIMELINE_MAX_PENDING 16
+
+/// \a ring may be NULL. Otherwise it must serve \a queue's family.
+qo_timeline_t *qo_timeline_create(VkDevice dev, VkQueue queue,
+                                  qo_cmd_ring_t *ring);
+
+/// Flush, wait for every batch to complete, and destroy the semaphore.
+void qo_timeline_destroy(qo_timeline_t *tl);
+
+/// \brief Queue a batch of command buffers.
+///
+/// Return the semaphore value that the batch signals. If queueing the batch
+/// flushed the pending batches and that failed, return 0 and set \a result.
+uint64_t qo_timeline_submit(qo_timeline_t *tl, uint32_t cmd_count,
+                            const VkCommandBuffer *cmds, VkResult *result);
+
+/// Submit the pending batches in one vkQueueSubmit().
+VkResult qo_timeline_flush(qo_timeline_t *tl);
+
+/// Flush if needed and wait until the semaphore reaches \a value.
+VkResult qo_timeline_wait(qo_timeline_t *tl, uint64_t value);
+
+/// Return the value of the last batch known to have completed.
+uint64_t qo_timeline_get_completed(qo_timeline_t *tl);
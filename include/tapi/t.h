@@ -39,6 +39,7 @@
 #include "util/macros.h"
 #include "util/xalloc.h"
 
+#include "t_arena.h"
 #include "t_cleanup.h"
 #include "t_data.h"
 #include "t_def.h"
@@ -0,0 +1,42 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/// \file
+/// \brief Test-lifetime host allocations
+///
+/// Each test thread owns an arena that is freed wholesale when the thread's
+/// cleanup stack unwinds, after every other command on that stack. Memory
+/// from t_arena*() therefore needs no t_cleanup_push_free(), and stays valid
+/// for the cleanup commands of the thread that allocated it.
+///
+/// Concurrent calls to t_arena*() are safe, because each thread allocates
+/// from its own arena.
+
+#pragma once
+
+#include <stddef.h>
+
+#include "util/macros.h"
+
+malloclike void *t_arena_alloc(size_t size);
+malloclike void *t_arena_allocn(size_t n, size_t size);
+malloclike void *t_arena_zalloc(size_t size);
+malloclike void *t_arena_zallocn(size_t n, size_t size);
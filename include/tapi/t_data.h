@@ -31,6 +31,12 @@
 #include "util/vk_wrapper.h"
 
 typedef struct cru_image cru_image_t;
+typedef struct qo_stats qo_stats_t;
+typedef struct qo_suballoc qo_suballoc_t;
+typedef struct qo_cmd_ring qo_cmd_ring_t;
+typedef struct qo_staging qo_staging_t;
+typedef struct qo_desc_alloc qo_desc_alloc_t;
+typedef struct qo_pipeline_dedup qo_pipeline_dedup_t;
 
 #define t_name __t_name()
 #define t_user_data __t_user_data()
@@ -61,6 +67,13 @@ typedef struct cru_image cru_image_t;
 #define t_queue_num (*__t_queue_num())
 #define t_run_all_queues (*__t_run_all_queues())
 #define t_no_image (*__t_no_image());
+#define t_has_timeline_semaphore (*__t_has_timeline_semaphore())
+#define t_qonos_stats (__t_qonos_stats())
+#define t_qonos_suballoc (__t_qonos_suballoc())
+#define t_qonos_cmd_ring(queue_family) (__t_qonos_cmd_ring(queue_family))
+#define t_qonos_staging(queue_family) (__t_qonos_staging(queue_family))
+#define t_qonos_pipeline_dedup (__t_qonos_pipeline_dedup())
+#define t_qonos_desc_alloc (__t_qonos_desc_alloc())
 cru_image_t *t_ref_image(void);
 cru_image_t *t_ref_stencil_image(void);
 
@@ -92,3 +105,34 @@ const uint32_t *__t_width(void);
 const uint32_t * __t_queue_num(void);
 const bool * __t_run_all_queues(void);
 const bool * __t_no_image(void);
+const bool * __t_has_timeline_semaphore(void);
+
+/// Return the Qonos instrumentation of the current test, or NULL if no test
+/// is current in this thread or the test was not created with instrumentation
+/// enabled. Unlike the other accessors, this is legal outside of tests.
+qo_stats_t *__t_qonos_stats(void);
+
+/// Return the current test's device-memory suballocator, or NULL if no test
+/// is current in this thread or the test's device is not yet created. Like
+/// __t_qonos_stats(), this is legal outside of tests.
+qo_suballoc_t *__t_qonos_suballoc(void);
+
+/// Return the current test's command buffer ring for \a queue_family, which
+/// is created on the first call. Return NULL if no test is current in this
+/// thread, the test's device is not yet created, the device has no such
+/// queue family, or the ring cannot be created.
+qo_cmd_ring_t *__t_qonos_cmd_ring(uint32_t queue_family);
+
+/// Return the current test's staging ring for \a queue_family, or NULL if no
+/// test is current in this thread, the test's device is not yet created, or
+/// the device has no such queue family.
+qo_staging_t *__t_qonos_staging(uint32_t queue_family);
+
+/// Return the current test's pipeline deduplication, or NULL if no test is
+/// current in this thread, the test's device is not yet created, or the test
+/// sets test_def_t::no_pipeline_dedup.
+qo_pipeline_dedup_t *__t_qonos_pipeline_dedup(void);
+
+/// Return the current test's descriptor pool chain, or NULL if no test is
+/// current in this thread or the test's device is not yet created.
+qo_desc_alloc_t *__t_qonos_desc_alloc(void);
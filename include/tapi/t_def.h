@@ -36,6 +36,7 @@ enum test_queue_setup {
     QUEUE_SETUP_TRANSFER,
 };
 
+typedef struct cru_raster cru_raster_t;
 typedef struct test_def test_def_t;
 
 /// \brief A test definition.
@@ -67,6 +68,17 @@ struct test_def {
     /// test_def::depthstencil_format must also be set.
     const char *const ref_stencil_filename;
 
+    /// \brief Draw the test's reference image on the CPU.
+    ///
+    /// If set, then the reference image is not loaded from a file. Instead,
+    /// the test framework creates a zero-filled raster of size
+    /// test_def::ref_width by test_def::ref_height and calls this to draw the
+    /// reference image into it. The image is still dumped under
+    /// test_def::image_filename.
+    void (*const ref_raster)(cru_raster_t *raster);
+    const uint32_t ref_width;
+    const uint32_t ref_height;
+
     void (*const start)(void);
     const uint32_t samples;
     const bool no_image;
@@ -97,6 +109,13 @@ struct test_def {
 
     const bool mesh_shader;
 
+    /// \brief Create every pipeline and shader module anew.
+    ///
+    /// Disable the deduplication that Qonos otherwise applies to the
+    /// pipelines and shader modules it creates. This is useful for tests that
+    /// exercise pipeline creation itself.
+    const bool no_pipeline_dedup;
+
     /// \brief Number of each descriptor type required
     ///
     /// If the elements of this array are all zero, the default descriptor
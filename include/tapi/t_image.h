@@ -29,6 +29,7 @@
 
 typedef struct cru_image cru_image_t;
 typedef struct cru_image_array cru_image_array_t;
+typedef struct cru_raster cru_raster_t;
 
 /// \brief Create a Crucible image from a file.
 ///
@@ -55,6 +56,17 @@ t_new_cru_image_from_vk_image(VkDevice dev, VkQueue queue, VkImage image,
                               uint32_t level0_width, uint32_t level0_height,
                               uint32_t miplevel, uint32_t array_slice);
 
+/// \brief Begin reading back a batch of Crucible images without waiting.
+///
+/// This is a wrapper around cru_image_begin_readback(). Readback of all the
+/// images is batched into as few submissions as possible; mapping an image
+/// later waits only for its own copy. On failure, the test fails.
+///
+/// \see cru_image_begin_readback()
+///
+void
+t_begin_cru_image_readback(cru_image_t *const *images, uint32_t count);
+
 /// \brief Create a Crucible image from an array of pixels.
 ///
 /// This is a wrapper around cru_image_from_pixels(). On success, the new image
@@ -66,6 +78,27 @@ malloclike cru_image_t *
 t_new_cru_image_from_pixels(void *restrict pixels, VkFormat format,
                             uint32_t width, uint32_t height);
 
+/// \brief Create a CPU rasterizer for drawing a reference image.
+///
+/// This is a wrapper around cru_raster_create(). On success, the new raster
+/// is pushed onto the test thread's cleanup stack.  On failure, the test
+/// fails.
+///
+/// \see cru_raster_create()
+malloclike cru_raster_t *
+t_new_cru_raster(uint32_t width, uint32_t height);
+
+/// \brief Create a Crucible image of a CPU raster's attachment.
+///
+/// This is a wrapper around cru_raster_get_image(). On success, the new image
+/// is pushed onto the test thread's cleanup stack.  On failure, the test
+/// fails.
+///
+/// \see cru_raster_get_image()
+malloclike cru_image_t *
+t_new_cru_image_from_raster(cru_raster_t *raster,
+                            VkImageAspectFlagBits aspect);
+
 /// \brief Create a Crucible image array from a file.
 ///
 /// This is a wrapper around cru_image_from_filename(). On success, the new
@@ -76,3 +109,20 @@ t_new_cru_image_from_pixels(void *restrict pixels, VkFormat format,
 ///
 malloclike cru_image_array_t *
 t_new_cru_image_array_from_filename(const char *filename);
+
+/// \brief Upload every image of a Crucible image array to a Vulkan image.
+///
+/// Image \a i of the array is uploaded to miplevel
+/// i / cru_image_array_get_num_layers() and array layer
+/// i % cru_image_array_get_num_layers() of \a image, which must have been
+/// created with VK_IMAGE_USAGE_TRANSFER_DST_BIT and at least as many levels
+/// and layers as the array.
+///
+/// All images are packed into one staging buffer and copied with a single
+/// vkCmdCopyBufferToImage, then \a image is transitioned from
+/// VK_IMAGE_LAYOUT_UNDEFINED to \a final_layout. The function waits on
+/// t_queue for the upload to complete. On failure, the test fails.
+void
+t_upload_cru_image_array(cru_image_array_t *ia, VkImage image,
+                         VkImageAspectFlags aspect,
+                         VkImageLayout final_layout);
@@ -0,0 +1,54 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/// \file
+/// \brief Bump-pointer arena for host allocations with a common lifetime
+///
+/// An arena hands out memory from large chunks and frees all of it at once
+/// in cru_arena_destroy(). Individual allocations are never freed. An arena
+/// is not thread-safe; give each thread its own.
+
+#pragma once
+
+#include <stddef.h>
+
+#include "util/macros.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct cru_arena cru_arena_t;
+
+malloclike cru_arena_t *cru_arena_create(void);
+void cru_arena_destroy(cru_arena_t *a);
+
+/// \brief Allocate size bytes, aligned for any type.
+///
+/// Aborts on failure.
+malloclike void *cru_arena_alloc(cru_arena_t *a, size_t size);
+malloclike void *cru_arena_allocn(cru_arena_t *a, size_t n, size_t size);
+malloclike void *cru_arena_zalloc(cru_arena_t *a, size_t size);
+malloclike void *cru_arena_zallocn(cru_arena_t *a, size_t n, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
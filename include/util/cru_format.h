@@ -22,6 +22,7 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include "util/vk_wrapper.h"
@@ -37,6 +38,8 @@ enum cru_num_type {
     CRU_NUM_TYPE_UNORM,
     CRU_NUM_TYPE_UINT,
     CRU_NUM_TYPE_SFLOAT,
+    CRU_NUM_TYPE_SNORM,
+    CRU_NUM_TYPE_SINT,
 };
 
 struct cru_format_info {
@@ -48,6 +51,29 @@ struct cru_format_info {
     uint8_t num_channels;
     uint8_t cpp;
 
+    /// \brief Size in bits of each channel, in RGBA (or depth, stencil)
+    /// order.
+    ///
+    /// The channels are stored consecutively from the least significant bit
+    /// of the pixel, which is read as a little-endian integer. This describes
+    /// both array formats, such as VK_FORMAT_R8G8B8A8_UNORM, and packed
+    /// formats, such as VK_FORMAT_A2B10G10R10_UNORM_PACK32. All zero if the
+    /// format has no such layout, such as a compressed format.
+    ///
+    /// Padding bits follow the channels, as in
+    /// VK_FORMAT_X8_D24_UNORM_PACK32, whose cpp is 4 like that of the
+    /// buffer copies of its images. Combined depth/stencil formats have no
+    /// num_type; each channel has that of its aspect's format.
+    uint8_t channel_bits[4];
+
+    /// \brief Size of a compressed block.
+    ///
+    /// For block-compressed formats, whose cpp is zero, the width and height
+    /// in pixels and the size in bytes of each block. Zero for other formats.
+    uint8_t block_width;
+    uint8_t block_height;
+    uint8_t block_size;
+
     /// This is zero (VK_FORMAT_UNDEFINED) if and only if the format has no
     /// depth component.
     VkFormat depth_format;
@@ -58,6 +84,9 @@ struct cru_format_info {
 
     bool is_color:1;
     bool has_alpha:1;
+
+    /// The RGB channels are sRGB-encoded. num_type is CRU_NUM_TYPE_UNORM.
+    bool is_srgb:1;
 };
 
 /// \brief Lookup info for VkFormat.
@@ -65,6 +94,18 @@ struct cru_format_info {
 /// If Crucible does not have info for the given format, then return NULL.
 const struct cru_format_info *cru_format_get_info(VkFormat format);
 
+/// \brief Lookup info for a VkFormat by its name, such as
+/// "VK_FORMAT_R8G8B8A8_UNORM".
+///
+/// If Crucible does not have info for the given format, then return NULL.
+const struct cru_format_info *cru_format_get_info_by_name(const char *name);
+
+/// \brief Size in bytes of a tightly packed 2D image of the format.
+///
+/// Block-compressed images are padded to whole blocks.
+size_t cru_format_get_image_size(const struct cru_format_info *info,
+                                 uint32_t width, uint32_t height);
+
 #ifdef __cplusplus
 }
 #endif
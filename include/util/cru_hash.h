@@ -0,0 +1,75 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/// \file
+/// \brief A fast, non-cryptographic 128-bit hash.
+///
+/// The hash is MurmurHash3_x64_128. Data may be hashed all at once with
+/// cru_hash128() or incrementally with a cru_hash128_state; both give the
+/// same result for the same bytes.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct cru_hash128 cru_hash128_t;
+typedef struct cru_hash128_state cru_hash128_state_t;
+
+struct cru_hash128 {
+    uint64_t h[2];
+};
+
+struct cru_hash128_state {
+    uint64_t h1;
+    uint64_t h2;
+
+    /// Total number of bytes hashed so far.
+    uint64_t len;
+
+    /// Bytes not yet hashed, because they do not fill a block. The number
+    /// of them is len % 16.
+    uint8_t tail[16];
+};
+
+/// Length of a hash formatted as hexadecimal, excluding the terminator.
+#define CRU_HASH128_STRING_LEN 32
+
+void cru_hash128_init(cru_hash128_state_t *state, uint64_t seed);
+void cru_hash128_update(cru_hash128_state_t *state,
+                        const void *data, size_t size);
+cru_hash128_t cru_hash128_final(const cru_hash128_state_t *state);
+
+cru_hash128_t cru_hash128(const void *data, size_t size);
+
+static inline bool
+cru_hash128_equal(cru_hash128_t a, cru_hash128_t b)
+{
+    return a.h[0] == b.h[0] && a.h[1] == b.h[1];
+}
+
+/// Write \a hash to \a str as 32 lowercase hexadecimal digits.
+void cru_hash128_format(cru_hash128_t hash,
+                        char str[CRU_HASH128_STRING_LEN + 1]);
+
+/// Parse 32 hexadecimal digits at \a str, as written by cru_hash128_format().
+bool cru_hash128_parse(const char *str, cru_hash128_t *hash);
@@ -29,6 +29,12 @@
 ///
 ///         cru_image_write_file(tex_image, filename);
 ///
+///    - Image files are PNG (".png"), KTX (".ktx" or ".ktx2", load only), JPEG
+///      (".jpg" or ".jpeg", load only), or raw (".raw").
+///      A raw file is a one-line JSON header followed by the uncompressed
+///      pixels in the image's own format, so any format can be written to
+///      one quickly.
+///
 ///    - Images created by cru_image_from_pixels() are read-write.
 ///
 ///    - Images created by cru_image_from_filename() are read-only.
@@ -38,6 +44,7 @@
 
 #include <stdbool.h>
 
+#include "util/cru_hash.h"
 #include "util/macros.h"
 #include "util/vk_wrapper.h"
 
@@ -47,6 +54,11 @@ extern "C" {
 
 typedef struct cru_image cru_image_t;
 typedef struct cru_image_array cru_image_array_t;
+typedef struct cru_vk_staging cru_vk_staging_t;
+typedef struct cru_image_compare_info cru_image_compare_info_t;
+typedef struct cru_image_compare_result cru_image_compare_result_t;
+typedef struct cru_image_write_info cru_image_write_info_t;
+typedef struct cru_image_writer cru_image_writer_t;
 enum {
    CRU_IMAGE_MAP_ACCESS_READ = 0x1,
    CRU_IMAGE_MAP_ACCESS_WRITE = 0x2,
@@ -85,24 +97,204 @@ cru_image_from_filename(const char *filename);
 /// has a simpler interface.
 ///
 /// If Crucible submits any Vulkan commands on the \a image, then it will do
-/// so using the provided VkQueue. Crucible may allocate temporary
-/// VkDeviceMemory using the provided VkMemoryType index, which must be
-/// host-visible.
+/// so using the provided VkQueue, which must belong to \a queue_family.
+/// Crucible may allocate temporary VkDeviceMemory using the provided
+/// VkMemoryType index, which must be host-visible.
 ///
 malloclike cru_image_t *
-cru_image_from_vk_image(VkDevice dev, VkQueue queue, VkImage image,
+cru_image_from_vk_image(VkDevice dev, VkQueue queue, uint32_t queue_family,
+                        VkImage image,
                         VkFormat format, VkImageAspectFlagBits aspect,
                         uint32_t level0_width, uint32_t level0_height,
                         uint32_t miplevel, uint32_t array_slice,
                         VkMemoryPropertyFlags tmp_mem_props);
 
+/// \brief Create a staging context for Vulkan images.
+///
+/// The staging context owns a command pool for \a queue_family, a small ring
+/// of command buffers and fences, and a pool of mapped staging buffers
+/// allocated from a memory type with \a tmp_mem_props. Images created with
+/// cru_image_from_vk_image_staged() share these resources rather than
+/// creating and destroying them on each map. The context is reference
+/// counted and safe to share between threads.
+malloclike cru_vk_staging_t *
+cru_vk_staging_create(VkDevice dev, uint32_t queue_family,
+                      const VkPhysicalDeviceMemoryProperties *mem_props,
+                      VkMemoryPropertyFlags tmp_mem_props);
+void cru_vk_staging_reference(cru_vk_staging_t *staging);
+void cru_vk_staging_release(cru_vk_staging_t *staging);
+
+/// \brief Create a Crucible image from a Vulkan image using shared staging.
+///
+/// Like cru_image_from_vk_image(), but transfers go through \a staging. The
+/// \a queue must belong to the staging context's queue family. The image
+/// holds a reference on \a staging.
+malloclike cru_image_t *
+cru_image_from_vk_image_staged(cru_vk_staging_t *staging, VkQueue queue,
+                               VkImage image, VkFormat format,
+                               VkImageAspectFlagBits aspect,
+                               uint32_t level0_width, uint32_t level0_height,
+                               uint32_t miplevel, uint32_t array_slice);
+
+/// \brief Begin reading back a batch of images without waiting.
+///
+/// Copies for all Vulkan images in \a images that share a staging context
+/// and queue are recorded into one command buffer and submitted together.
+/// A later cru_image_map() of any of the images waits for that submission
+/// instead of issuing its own copy, so the caller may do CPU work (such as
+/// decoding reference images) while the copies execute. Images of other
+/// types, and images that are currently mapped, are ignored.
+///
+/// Return false if recording or submission failed.
+bool cru_image_begin_readback(cru_image_t *const *images, uint32_t count);
+
 bool cru_image_write_file(cru_image_t *image, const char *filename);
+
+/// PNG row filter. See png_set_filter(3).
+enum cru_png_filter {
+    /// Let libpng choose.
+    CRU_PNG_FILTER_DEFAULT = 0,
+    CRU_PNG_FILTER_NONE,
+    CRU_PNG_FILTER_SUB,
+    CRU_PNG_FILTER_UP,
+    CRU_PNG_FILTER_AVG,
+    CRU_PNG_FILTER_PAETH,
+
+    /// Let libpng choose the best filter for each row.
+    CRU_PNG_FILTER_ALL,
+};
+
+struct cru_image_write_info {
+    /// zlib compression level of PNG files, from 0 (none) to 9 (smallest),
+    /// or -1 for libpng's default.
+    int png_compression_level;
+
+    enum cru_png_filter png_filter;
+};
+
+/// Like cru_image_write_file(), but with explicit options. A NULL \a info
+/// selects the defaults.
+bool cru_image_write_file_info(cru_image_t *image, const char *filename,
+                               const cru_image_write_info_t *info);
+
+/// \brief Create a writer that writes images to files in a background thread.
+///
+/// The writer copies the options in \a info, which may be NULL.
+malloclike cru_image_writer_t *
+cru_image_writer_create(const cru_image_write_info_t *info);
+
+/// \brief Queue \a image to be written to \a filename.
+///
+/// The pixels are copied before returning, so the caller may modify or
+/// release \a image immediately. The copy maps \a image, which for a Vulkan
+/// image reads it back on the calling thread; only encoding and file I/O are
+/// deferred. Return false if the copy failed.
+bool cru_image_writer_enqueue(cru_image_writer_t *writer, cru_image_t *image,
+                              const char *filename);
+
+/// \brief Wait for all queued writes, then destroy the writer.
+///
+/// Return false if any write failed. A NULL \a writer is ignored.
+bool cru_image_writer_finish(cru_image_writer_t *writer);
 bool cru_image_copy(cru_image_t *dest, cru_image_t *src);
 bool cru_image_compare(cru_image_t *a, cru_image_t *b);
 bool cru_image_compare_rect(cru_image_t *a, uint32_t a_x, uint32_t a_y,
                             cru_image_t *b, uint32_t b_x, uint32_t b_y,
                             uint32_t width, uint32_t height);
 
+/// Instruction set used by cru_image_compare_rect_stats(). Only benchmarks
+/// need to override the default.
+enum cru_image_compare_isa {
+    CRU_IMAGE_COMPARE_ISA_AUTO = 0,
+    CRU_IMAGE_COMPARE_ISA_SCALAR,
+    CRU_IMAGE_COMPARE_ISA_SSE2,
+    CRU_IMAGE_COMPARE_ISA_AVX2,
+};
+
+struct cru_image_compare_info {
+    /// \brief Per-channel absolute tolerance.
+    ///
+    /// Two pixels match if, in every channel, their difference is at most
+    /// the channel's tolerance. The unit is one integer step for normalized
+    /// and integer channels, signed or packed, and 1.0 for float channels,
+    /// half or single precision. Formats without channels, such as
+    /// compressed formats, accept only a zero tolerance.
+    double tolerance[4];
+
+    /// \brief Optional diff image, filled in the same pass as the compare.
+    ///
+    /// Must be a writable VK_FORMAT_R8G8B8A8_UNORM image at least as large
+    /// as the rect. Mismatching pixels become opaque red and all others
+    /// opaque black. Filling it costs a write of every row, so callers that
+    /// expect a match should compare without it first.
+    cru_image_t *diff_image;
+
+    /// \brief Stop after the first row that has a mismatch.
+    ///
+    /// Useful when only pass or fail is needed. The statistics then cover
+    /// only the rows compared. Ignored if there is a diff image, which is
+    /// always filled whole.
+    bool stop_at_first_mismatch;
+
+    enum cru_image_compare_isa isa;
+
+    /// \brief Maximum number of threads that compare a large rect.
+    ///
+    /// Zero means the default of cru_image_compare_set_max_threads(). The
+    /// result does not depend on the number of threads.
+    uint32_t max_threads;
+};
+
+/// \brief Set the default number of threads that compare a large rect.
+///
+/// Zero, the initial value, means one per CPU, up to a small limit. The
+/// threads are created on the first comparison that needs them, so the
+/// default must be set before then. A process that runs several tests at
+/// once should divide the CPUs among them.
+void cru_image_compare_set_max_threads(uint32_t max_threads);
+
+struct cru_image_compare_result {
+    /// Number of pixels with a channel that exceeds its tolerance.
+    uint32_t mismatch_count;
+
+    /// Maximum absolute error of each channel, in the units of
+    /// cru_image_compare_info::tolerance.
+    double max_error[4];
+
+    /// Root mean square of the error over all channels of all pixels.
+    double rms_error;
+
+    /// Inclusive bounding box of the mismatching pixels, relative to the
+    /// rect. Undefined if mismatch_count is 0.
+    uint32_t min_x, min_y, max_x, max_y;
+};
+
+/// \brief Compare two rects with a tolerance and gather error statistics.
+///
+/// Formats whose pixels have no per-channel layout, such as compressed
+/// formats, are compared bitwise and report no error; with a nonzero
+/// tolerance, the comparison fails. A NULL \a info is equivalent to zero
+/// tolerance without a diff image.
+///
+/// Return false if the comparison could not be performed; a mismatch is not
+/// a failure.
+bool
+cru_image_compare_rect_stats(cru_image_t *a, uint32_t a_x, uint32_t a_y,
+                             cru_image_t *b, uint32_t b_x, uint32_t b_y,
+                             uint32_t width, uint32_t height,
+                             const cru_image_compare_info_t *info,
+                             cru_image_compare_result_t *result);
+
+/// \brief Hash the image's format, size, and pixels.
+///
+/// Images whose formats and sizes are equal and whose pixels are bytewise
+/// equal have equal hashes; row padding is not hashed. The hash of a PNG
+/// image is that of its decoded pixels. Formats without a pixel size, such
+/// as compressed formats, are unsupported.
+///
+/// Return false if the image could not be hashed.
+bool cru_image_hash(cru_image_t *image, cru_hash128_t *hash);
+
 /// \brief Map the image to an array of pixels.
 ///
 /// The pixel format is cru_image::format. The array is tightly packed (that
@@ -133,6 +325,8 @@ cru_image_array_from_filename(const char *filename);
 void cru_image_array_reference(cru_image_array_t *ia);
 void cru_image_array_release(cru_image_array_t *ia);
 cru_image_t *cru_image_array_get_image(cru_image_array_t *ia, int index);
+uint32_t cru_image_array_get_num_levels(cru_image_array_t *ia);
+uint32_t cru_image_array_get_num_layers(cru_image_array_t *ia);
 #ifdef __cplusplus
 }
 #endif
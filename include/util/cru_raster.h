@@ -0,0 +1,122 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#pragma once
+
+/// \file
+/// \brief A small CPU rasterizer for building reference images in memory.
+///
+/// The rasterizer draws triangles with Vulkan's conventions: clip-space
+/// positions, a VkViewport and scissor, pixel centers at half-integers, 8
+/// bits of subpixel precision, a top-left fill rule, and the first vertex of
+/// each triangle as the provoking vertex. Color is interpolated
+/// perspective-correctly unless flat shading is requested, and depth is
+/// interpolated linearly in window space.
+///
+/// The color attachment is VK_FORMAT_R8G8B8A8_UNORM and the depth attachment
+/// is VK_FORMAT_D32_SFLOAT. Triangles are rasterized one 2x2 quad of pixels at
+/// a time.
+///
+/// NOTES:
+///    - There is no clipping. A triangle with a vertex whose w <= 0, or whose
+///      window coordinates lie more than CRU_RASTER_GUARD_BAND pixels from
+///      the origin, is dropped. Fragments whose depth lies outside [0, 1]
+///      before the viewport transform are discarded, which is equivalent to
+///      clipping against the near and far planes.
+///
+///    - There is no blending; covered fragments that pass the depth test
+///      overwrite the color attachment.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "util/macros.h"
+#include "util/vk_wrapper.h"
+
+typedef struct cru_image cru_image_t;
+typedef struct cru_raster cru_raster_t;
+typedef struct cru_raster_state cru_raster_state_t;
+typedef struct cru_raster_vertex cru_raster_vertex_t;
+
+/// Triangles reaching farther than this from the window origin are dropped.
+#define CRU_RASTER_GUARD_BAND 16384
+
+struct cru_raster_vertex {
+    /// Clip-space position.
+    float pos[4];
+
+    /// RGBA color, clamped to [0, 1] when written.
+    float color[4];
+};
+
+/// \brief Fixed-function state for cru_raster_draw().
+///
+/// A zero-initialized state draws triangle lists into the whole framebuffer,
+/// with depth range [0, 1], no culling, no depth test, and smooth shading.
+struct cru_raster_state {
+    /// Draw a triangle strip instead of a triangle list.
+    bool triangle_strip;
+
+    /// If the width is 0, then the viewport covers the framebuffer.
+    VkViewport viewport;
+
+    /// If the width is 0, then the scissor covers the framebuffer.
+    VkRect2D scissor;
+
+    VkCullModeFlags cull_mode;
+    VkFrontFace front_face;
+
+    bool depth_test_enable;
+    bool depth_write_enable;
+    VkCompareOp depth_compare_op;
+
+    /// Use the provoking vertex's color for the whole triangle.
+    bool flat_shading;
+};
+
+malloclike cru_raster_t *cru_raster_create(uint32_t width, uint32_t height);
+void cru_raster_destroy(cru_raster_t *raster);
+
+uint32_t cru_raster_get_width(cru_raster_t *raster);
+uint32_t cru_raster_get_height(cru_raster_t *raster);
+
+/// Fill the whole color attachment with \a color and the whole depth
+/// attachment with \a depth.
+void cru_raster_clear(cru_raster_t *raster, const float color[4],
+                      float depth);
+
+/// Draw \a num_vertices vertices as triangles. Incomplete trailing triangles
+/// are ignored.
+void cru_raster_draw(cru_raster_t *raster, const cru_raster_state_t *state,
+                     const cru_raster_vertex_t *vertices,
+                     uint32_t num_vertices);
+
+/// \brief Create a read-write Crucible image of one of the raster's
+/// attachments.
+///
+/// \a aspect is VK_IMAGE_ASPECT_COLOR_BIT or VK_IMAGE_ASPECT_DEPTH_BIT. The
+/// image does not own its pixels, so it must be released before the raster
+/// is destroyed.
+///
+/// If writing a test, consider using t_new_cru_image_from_raster(), which
+/// cleans up after itself.
+malloclike cru_image_t *
+cru_raster_get_image(cru_raster_t *raster, VkImageAspectFlagBits aspect);
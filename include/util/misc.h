@@ -27,6 +27,7 @@
 #include <stdint.h>
 #include <stdnoreturn.h>
 #include <string.h>
+#include <time.h>
 
 #include "util/macros.h"
 
@@ -73,6 +74,31 @@ cru_align_size(size_t n, size_t a)
     return (n + a - 1) & ~(a - 1);
 }
 
+/// Like cru_align_size(), but \a a need not be a power of two.
+static inline size_t
+cru_round_up_size(size_t n, size_t a)
+{
+    return (n + a - 1) / a * a;
+}
+
+static inline size_t
+cru_gcd_size(size_t a, size_t b)
+{
+    while (b != 0) {
+        size_t t = a % b;
+        a = b;
+        b = t;
+    }
+
+    return a;
+}
+
+static inline size_t
+cru_lcm_size(size_t a, size_t b)
+{
+    return a / cru_gcd_size(a, b) * b;
+}
+
 static inline bool
 cru_add_size_checked(size_t *result, size_t a, size_t b)
 {
@@ -87,6 +113,18 @@ cru_mul_size_checked(size_t *result, size_t a, size_t b)
     return a <= SIZE_MAX / b;
 }
 
+/// Return CLOCK_MONOTONIC in nanoseconds, or 0 on failure.
+static inline uint64_t
+cru_get_time_ns(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) < 0)
+        return 0;
+
+    return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
 /// The path that contains all of Crucible's files. This is normally the top of
 /// the git repository.
 const string_t * cru_prefix_path(void);
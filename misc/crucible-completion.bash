@@ -1,4 +1,4 @@
-__crucible_commands="bootstrap dump-image test help ls-tests run version"
+__crucible_commands="bootstrap dump-image gen-data hash-images test help ls-tests run version"
 
 __crucible_bootstrap()
 {
@@ -10,6 +10,16 @@ __crucible_dump_image()
    COMPREPLY=($(compgen -o filenames -A file -W "--help" -- ${COMP_WORDS[COMP_CWORD]}))
 }
 
+__crucible_gen_data()
+{
+   COMPREPLY=($(compgen -o filenames -A file -W "--help --output-dir --size" -- ${COMP_WORDS[COMP_CWORD]}))
+}
+
+__crucible_hash_images()
+{
+   COMPREPLY=($(compgen -o filenames -A file -W "--help --output" -- ${COMP_WORDS[COMP_CWORD]}))
+}
+
 __crucible_help()
 {
     COMPREPLY=($(compgen -W "$__crucible_commands" -- ${COMP_WORDS[COMP_CWORD]}))
@@ -68,6 +78,8 @@ __crucible()
     case "$command" in
 	bootstrap) __crucible_bootstrap $1 ;;
 	dump-image) __crucible_dump_image $1 ;;
+	gen-data) __crucible_gen_data $1 ;;
+	hash-images) __crucible_hash_images $1 ;;
 	help) __crucible_help ;;
 	ls-tests) __crucible_ls_tests $1 ;;
 	run) __crucible_run $1 ;;
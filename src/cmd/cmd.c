@@ -68,6 +68,19 @@ cru_usage_error(const cru_command_t *cmd, const char *format, ...)
     exit(129);
 }
 
+/// Log an error message and exit with failure.
+noreturn void printflike(1, 2)
+cru_die(const char *format, ...)
+{
+    va_list va;
+
+    va_start(va, format);
+    loge_v(format, va);
+    va_end(va);
+
+    exit(EXIT_FAILURE);
+}
+
 
 void
 cru_pop_argv(int start, int count, int *argc, char **argv)
@@ -44,6 +44,7 @@ struct cru_command {
 const cru_command_t *cru_find_command(const char *name);
 void cru_pop_argv(int start, int count, int *argc, char **argv);
 noreturn void cru_usage_error(const cru_command_t *cmd, const char *format, ...) printflike(2, 3);
+noreturn void cru_die(const char *format, ...) printflike(1, 2);
 noreturn void cru_command_page_help(const cru_command_t *cmd);
 noreturn void cru_open_crucible_manpage(int volume, const char *suffix);
 
@@ -31,6 +31,7 @@
 #include "cmd.h"
 
 static string_t arg_filename = STRING_INIT;
+static string_t opt_output = STRING_INIT;
 
 // From man:getopt(3) :
 //
@@ -44,10 +45,11 @@ static string_t arg_filename = STRING_INIT;
 //    above) of optstring is a colon (':'),  then getopt() returns ':' instead
 //    of '?' to indicate a missing option argument.
 //
-static const char *shortopts = "+:h";
+static const char *shortopts = "+:ho:";
 
 static const struct option longopts[] = {
     {"help",          no_argument,       NULL,           'h'},
+    {"output",        required_argument, NULL,           'o'},
     {0},
 };
 
@@ -74,6 +76,9 @@ parse_args(const cru_command_t *cmd, int argc, char **argv)
             cru_command_page_help(cmd);
             exit(0);
             break;
+        case 'o':
+            string_copy_cstr(&opt_output, optarg);
+            break;
         case ':':
             cru_usage_error(cmd, "%s requires an argument", argv[optind-1]);
             break;
@@ -95,18 +100,6 @@ done_getopt:
         cru_usage_error(cmd, "trailing arguments after <filename>");
 }
 
-static noreturn void
-die(const char *format, ...)
-{
-    va_list va;
-
-    va_start(va, format);
-    loge_v(format, va);
-    va_end(va);
-
-    exit(EXIT_FAILURE);
-}
-
 static int
 cmd_start(const cru_command_t *cmd, int argc, char **argv)
 {
@@ -123,23 +116,43 @@ cmd_start(const cru_command_t *cmd, int argc, char **argv)
     if (!img)
         exit(EXIT_FAILURE);
 
+    string_finish(&abs_filename);
+
+    if (opt_output.len > 0) {
+        string_t abs_output = STRING_INIT;
+        path_to_abs(&abs_output, &opt_output);
+
+        if (!cru_image_write_file(img, string_data(&abs_output)))
+            cru_die("failed to write %s", string_data(&abs_output));
+
+        string_finish(&abs_output);
+        cru_image_release(img);
+
+        return 0;
+    }
+
     VkFormat format = cru_image_get_format(img);
 
     const cru_format_info_t *finfo = cru_format_get_info(format);
     if (!finfo)
-        die("file has unknown VkFormat %d", format);
+        cru_die("file has unknown VkFormat %d", format);
+
+    // The rows of block-compressed formats hold blocks, not pixels.
+    if (finfo->cpp == 0)
+        cru_die("cannot print pixels of block-compressed format %s",
+                finfo->name);
 
     const uint8_t *map = cru_image_map(img, CRU_IMAGE_MAP_ACCESS_READ);
     if (!map)
-        die("failed to read file");
+        cru_die("failed to read file");
 
     uint32_t width = cru_image_get_width(img);
     uint32_t height = cru_image_get_height(img);
     uint32_t cpp = finfo->cpp;
-    uint32_t stride = width * cpp;
+    uint32_t stride = cru_image_get_pitch_bytes(img);
 
     if (width == 0 || height == 0)
-        die("file has invalid (width, height) = (%u, %u)", width, height);
+        cru_die("file has invalid (width, height) = (%u, %u)", width, height);
 
     uint32_t y_tick_len = 2 + 2 * (int) log2(height - 1) / 16;
 
@@ -163,6 +176,9 @@ cmd_start(const cru_command_t *cmd, int argc, char **argv)
 
     fflush(stdout);
 
+    cru_image_unmap(img);
+    cru_image_release(img);
+
     return 0;
 }
 
@@ -0,0 +1,262 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/// \file
+/// \brief Generate derived data files at build time.
+///
+/// The source image is decoded once. Its top-left rect of the requested size
+/// is converted to grayscale, and each image of the chain is filtered from
+/// the previous one with a 2:1 box filter, down to 1x1. Each step halves the
+/// width if it is the larger dimension and otherwise the height, so a
+/// 2048x1024 chain continues 1024x1024, 1024x512, 512x512, and so on.
+/// Intermediate images are kept as floats, so each pixel of the chain is the
+/// rounded mean of the source pixels that it covers.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "util/cru_format.h"
+#include "util/cru_image.h"
+#include "util/misc.h"
+#include "util/string.h"
+#include "util/xalloc.h"
+
+#include "cmd.h"
+
+static string_t opt_output_dir = STRING_INIT;
+static uint32_t opt_width = 2048;
+static uint32_t opt_height = 1024;
+static string_t arg_image = STRING_INIT;
+static const char *arg_name;
+
+static const char *shortopts = "+:ho:s:";
+
+static const struct option longopts[] = {
+    {"help",          no_argument,       NULL,           'h'},
+    {"output-dir",    required_argument, NULL,           'o'},
+    {"size",          required_argument, NULL,           's'},
+    {0},
+};
+
+static bool
+is_pow2(uint32_t n)
+{
+    return n > 0 && (n & (n - 1)) == 0;
+}
+
+static void
+parse_args(const cru_command_t *cmd, int argc, char **argv)
+{
+    // Suppress getopt from printing error messages.
+    opterr = 0;
+
+    // Reset getopt.
+    optind = 1;
+
+    string_copy_cstr(&opt_output_dir, ".");
+
+    while (true) {
+        int optchar;
+        char junk;
+
+        optchar = getopt_long(argc, argv, shortopts, longopts, NULL);
+
+        switch (optchar) {
+        case -1:
+            goto done_getopt;
+        case 0:
+            break;
+        case 'h':
+            cru_command_page_help(cmd);
+            exit(0);
+            break;
+        case 'o':
+            string_copy_cstr(&opt_output_dir, optarg);
+            break;
+        case 's':
+            if (sscanf(optarg, "%ux%u%c", &opt_width, &opt_height,
+                       &junk) != 2 ||
+                !is_pow2(opt_width) || !is_pow2(opt_height)) {
+                cru_usage_error(cmd, "--size requires <width>x<height>, "
+                                "each a power of two");
+            }
+            break;
+        case ':':
+            cru_usage_error(cmd, "%s requires an argument", argv[optind-1]);
+            break;
+        case '?':
+        default:
+            cru_usage_error(cmd, "unknown option: %s", argv[optind-1]);
+            break;
+        }
+    }
+
+done_getopt:
+    if (argc - optind < 2)
+        cru_usage_error(cmd, "missing <image> or <name>");
+    if (argc - optind > 2)
+        cru_usage_error(cmd, "trailing arguments after <name>");
+
+    string_copy_cstr(&arg_image, argv[optind]);
+    arg_name = argv[optind + 1];
+}
+
+/// Return the grayscale top-left opt_width x opt_height rect of \a img.
+static float *
+load_gray_rect(cru_image_t *img)
+{
+    const VkFormat format = cru_image_get_format(img);
+    const uint32_t cpp = cru_format_get_info(format)->cpp;
+    const uint32_t stride = cru_image_get_pitch_bytes(img);
+
+    if (format != VK_FORMAT_R8G8B8A8_UNORM && format != VK_FORMAT_R8_UNORM)
+        cru_die("%s: unsupported format", string_data(&arg_image));
+
+    if (cru_image_get_width(img) < opt_width ||
+        cru_image_get_height(img) < opt_height) {
+        cru_die("%s is smaller than %ux%u", string_data(&arg_image),
+                opt_width, opt_height);
+    }
+
+    const uint8_t *map = cru_image_map(img, CRU_IMAGE_MAP_ACCESS_READ);
+    if (!map)
+        cru_die("failed to read %s", string_data(&arg_image));
+
+    float *gray = xmalloc((size_t) opt_width * opt_height * sizeof(*gray));
+
+    for (uint32_t y = 0; y < opt_height; y++) {
+        const uint8_t *row = map + (size_t) y * stride;
+        float *dest = gray + (size_t) y * opt_width;
+
+        for (uint32_t x = 0; x < opt_width; x++) {
+            const uint8_t *p = row + x * cpp;
+
+            // Rec. 601 luma, as JPEG uses.
+            if (cpp == 1)
+                dest[x] = p[0];
+            else
+                dest[x] = 0.299f * p[0] + 0.587f * p[1] + 0.114f * p[2];
+        }
+    }
+
+    cru_image_unmap(img);
+
+    return gray;
+}
+
+static void
+write_gray(const float *gray, uint32_t width, uint32_t height)
+{
+    const size_t num_pixels = (size_t) width * height;
+    uint8_t *pixels = xmalloc(num_pixels);
+    string_t path = STRING_INIT;
+
+    for (size_t i = 0; i < num_pixels; i++)
+        pixels[i] = lrintf(CLAMP(gray[i], 0.0f, 255.0f));
+
+    cru_image_t *img = cru_image_from_pixels(pixels, VK_FORMAT_R8_UNORM,
+                                             width, height);
+    if (!img)
+        cru_die("failed to create image");
+
+    string_copy(&path, &opt_output_dir);
+    path_append_cstr(&path, arg_name);
+    string_appendf(&path, "-grayscale-%ux%u.png", width, height);
+
+    if (!cru_image_write_file(img, string_data(&path)))
+        cru_die("failed to write %s", string_data(&path));
+
+    cru_image_release(img);
+    string_finish(&path);
+    free(pixels);
+}
+
+/// Halve the width of the image if it exceeds the height, otherwise the
+/// height, with a 2:1 box filter, in place.
+static void
+downsample(float *gray, uint32_t *width, uint32_t *height)
+{
+    const uint32_t w = *width;
+    const uint32_t h = *height;
+
+    if (w > h) {
+        for (uint32_t y = 0; y < h; y++) {
+            const float *src = gray + (size_t) y * w;
+            float *dest = gray + (size_t) y * (w / 2);
+
+            for (uint32_t x = 0; x < w / 2; x++)
+                dest[x] = 0.5f * (src[2 * x] + src[2 * x + 1]);
+        }
+        *width = w / 2;
+    } else {
+        for (uint32_t y = 0; y < h / 2; y++) {
+            const float *src0 = gray + (size_t) (2 * y) * w;
+            const float *src1 = src0 + w;
+            float *dest = gray + (size_t) y * w;
+
+            for (uint32_t x = 0; x < w; x++)
+                dest[x] = 0.5f * (src0[x] + src1[x]);
+        }
+        *height = h / 2;
+    }
+}
+
+static int
+cmd_start(const cru_command_t *cmd, int argc, char **argv)
+{
+    string_t abs_image = STRING_INIT;
+
+    parse_args(cmd, argc, argv);
+
+    // cru_image_from_filename() interprets relative filenames as relative to
+    // Crucible's data directory, which is not what a cmdline tool wants.
+    path_to_abs(&abs_image, &arg_image);
+
+    cru_image_t *img = cru_image_from_filename(string_data(&abs_image));
+    if (!img)
+        exit(EXIT_FAILURE);
+
+    float *gray = load_gray_rect(img);
+    cru_image_release(img);
+
+    uint32_t width = opt_width;
+    uint32_t height = opt_height;
+
+    while (true) {
+        write_gray(gray, width, height);
+
+        if (width == 1 && height == 1)
+            break;
+
+        downsample(gray, &width, &height);
+    }
+
+    free(gray);
+    string_finish(&abs_image);
+
+    return 0;
+}
+
+cru_define_command {
+    .name = "gen-data",
+    .start = cmd_start,
+};
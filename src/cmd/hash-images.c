@@ -0,0 +1,165 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include "util/cru_hash.h"
+#include "util/cru_image.h"
+#include "util/string.h"
+
+#include "cmd.h"
+
+static string_t opt_output = STRING_INIT;
+
+static const char *shortopts = "+:ho:";
+
+static const struct option longopts[] = {
+    {"help",          no_argument,       NULL,           'h'},
+    {"output",        required_argument, NULL,           'o'},
+    {0},
+};
+
+static void
+parse_args(const cru_command_t *cmd, int argc, char **argv)
+{
+    // Suppress getopt from printing error messages.
+    opterr = 0;
+
+    // Reset getopt.
+    optind = 1;
+
+    while (true) {
+        int optchar;
+
+        optchar = getopt_long(argc, argv, shortopts, longopts, NULL);
+
+        switch (optchar) {
+        case -1:
+            goto done_getopt;
+        case 0:
+            break;
+        case 'h':
+            cru_command_page_help(cmd);
+            exit(0);
+            break;
+        case 'o':
+            string_copy_cstr(&opt_output, optarg);
+            break;
+        case ':':
+            cru_usage_error(cmd, "%s requires an argument", argv[optind-1]);
+            break;
+        case '?':
+        default:
+            cru_usage_error(cmd, "unknown option: %s", argv[optind-1]);
+            break;
+        }
+    }
+
+done_getopt:
+    if (optind == argc)
+        cru_usage_error(cmd, "missing <filename>");
+}
+
+/// Append a manifest line for the image file to \a out, in the format read
+/// by t_ref_hash_lookup(): the hash of the decoded image, the size of the
+/// file, and its basename.
+static bool
+hash_image_file(const char *filename, FILE *out)
+{
+    string_t arg_filename = STRING_INIT;
+    string_t abs_filename = STRING_INIT;
+    char hash_str[CRU_HASH128_STRING_LEN + 1];
+    cru_hash128_t hash;
+    struct stat st;
+    bool ok = false;
+
+    // cru_image_from_filename() interprets relative filenames as relative to
+    // Crucible's data directory, which is not what a cmdline tool wants.
+    string_copy_cstr(&arg_filename, filename);
+    path_to_abs(&abs_filename, &arg_filename);
+
+    if (stat(string_data(&abs_filename), &st) == -1) {
+        loge("failed to stat %s", string_data(&abs_filename));
+        goto done;
+    }
+
+    cru_image_t *img = cru_image_from_filename(string_data(&abs_filename));
+    if (!img)
+        goto done;
+
+    ok = cru_image_hash(img, &hash);
+    cru_image_release(img);
+
+    if (!ok) {
+        loge("failed to hash %s", string_data(&abs_filename));
+        goto done;
+    }
+
+    const char *basename = strrchr(string_data(&abs_filename), '/') + 1;
+
+    cru_hash128_format(hash, hash_str);
+    fprintf(out, "%s %jd %s\n", hash_str, (intmax_t) st.st_size, basename);
+
+done:
+    string_finish(&arg_filename);
+    string_finish(&abs_filename);
+    return ok;
+}
+
+static int
+cmd_start(const cru_command_t *cmd, int argc, char **argv)
+{
+    FILE *out = stdout;
+    bool ok = true;
+
+    parse_args(cmd, argc, argv);
+
+    if (opt_output.len > 0) {
+        out = fopen(string_data(&opt_output), "w");
+        if (!out) {
+            loge("failed to open %s", string_data(&opt_output));
+            return EXIT_FAILURE;
+        }
+    }
+
+    for (int i = optind; i < argc; i++)
+        ok &= hash_image_file(argv[i], out);
+
+    if (out != stdout)
+        ok &= fclose(out) == 0;
+    else
+        fflush(stdout);
+
+    if (!ok && opt_output.len > 0) {
+        // Never leave a partial manifest behind.
+        remove(string_data(&opt_output));
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+cru_define_command {
+    .name = "hash-images",
+    .start = cmd_start,
+};
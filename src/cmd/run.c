@@ -23,6 +23,7 @@
 #include <unistd.h>
 
 #include "util/misc.h"
+#include "util/cru_image.h"
 #include "util/cru_vec.h"
 
 #include "cmd.h"
@@ -37,11 +38,17 @@ static int opt_fork = -1; // -1 => unset on cmdline
 static int opt_log_pids = 0;
 static int opt_no_cleanup = 0;
 static int opt_dump = 0;
+static int opt_async_dump = 0;
+static int opt_raw_dump = 0;
+static int opt_dump_png_level = -1;
+static enum cru_png_filter opt_dump_png_filter = CRU_PNG_FILTER_DEFAULT;
 static int opt_separate_cleanup_thread = 1;
 static char *opt_junit_xml = NULL;
 static int opt_device_id = 1;
 static int opt_verbose = 0;
 static int opt_all_queues = 0;
+static int opt_gpu_compare = 0;
+static int opt_qonos_stats = 0;
 
 // From man:getopt(3) :
 //
@@ -67,6 +74,9 @@ enum opt_name {
     // Begin long-only options. They begin with the first char value outside
     // the ASCII range.
     OPT_NAME_JUNIT_XML = 128,
+    OPT_NAME_DUMP_PNG_LEVEL,
+    OPT_NAME_DUMP_PNG_FILTER,
+    OPT_NAME_DUMP_FORMAT,
 };
 
 static const struct option longopts[] = {
@@ -80,9 +90,18 @@ static const struct option longopts[] = {
     {"no-cleanup",    no_argument,       &opt_no_cleanup, true},
     {"dump",          no_argument,       &opt_dump,       true},
     {"no-dump",       no_argument,       &opt_dump,       false},
+    {"async-dump",    no_argument,       &opt_async_dump, true},
+    {"no-async-dump", no_argument,       &opt_async_dump, false},
+    {"dump-png-level", required_argument, NULL,           OPT_NAME_DUMP_PNG_LEVEL},
+    {"dump-png-filter", required_argument, NULL,          OPT_NAME_DUMP_PNG_FILTER},
+    {"dump-format",   required_argument, NULL,            OPT_NAME_DUMP_FORMAT},
     {"junit-xml",     required_argument, NULL,            OPT_NAME_JUNIT_XML},
     {"device-id",     required_argument, NULL,            OPT_NAME_DEVICE_ID},
     {"all-queues",    no_argument,       &opt_all_queues, true},
+    {"gpu-compare",   no_argument,       &opt_gpu_compare, true},
+    {"no-gpu-compare", no_argument,      &opt_gpu_compare, false},
+    {"qonos-stats",   no_argument,       &opt_qonos_stats, true},
+    {"no-qonos-stats", no_argument,      &opt_qonos_stats, false},
 
     {"separate-cleanup-threads",    no_argument, &opt_separate_cleanup_thread, true},
     {"no-separate-cleanup-threads", no_argument, &opt_separate_cleanup_thread, false},
@@ -174,6 +193,40 @@ parse_args(const cru_command_t *cmd, int argc, char **argv)
                 cru_usage_error(cmd, "--device must be at least 1");
             }
             break;
+        case OPT_NAME_DUMP_PNG_LEVEL:
+            if (!parse_i32(optarg, &opt_dump_png_level) ||
+                opt_dump_png_level < 0 || opt_dump_png_level > 9) {
+                cru_usage_error(cmd, "--dump-png-level must be in 0..9");
+            }
+            break;
+        case OPT_NAME_DUMP_PNG_FILTER:
+            if (cru_streq(optarg, "none")) {
+                opt_dump_png_filter = CRU_PNG_FILTER_NONE;
+            } else if (cru_streq(optarg, "sub")) {
+                opt_dump_png_filter = CRU_PNG_FILTER_SUB;
+            } else if (cru_streq(optarg, "up")) {
+                opt_dump_png_filter = CRU_PNG_FILTER_UP;
+            } else if (cru_streq(optarg, "avg")) {
+                opt_dump_png_filter = CRU_PNG_FILTER_AVG;
+            } else if (cru_streq(optarg, "paeth")) {
+                opt_dump_png_filter = CRU_PNG_FILTER_PAETH;
+            } else if (cru_streq(optarg, "all")) {
+                opt_dump_png_filter = CRU_PNG_FILTER_ALL;
+            } else {
+                cru_usage_error(cmd, "invalid value '%s' for --dump-png-filter",
+                                argv[optind-1]);
+            }
+            break;
+        case OPT_NAME_DUMP_FORMAT:
+            if (cru_streq(optarg, "png")) {
+                opt_raw_dump = false;
+            } else if (cru_streq(optarg, "raw")) {
+                opt_raw_dump = true;
+            } else {
+                cru_usage_error(cmd, "invalid value '%s' for --dump-format",
+                                argv[optind-1]);
+            }
+            break;
         case ':':
             cru_usage_error(cmd, "%s requires an argument", argv[optind-1]);
             break;
@@ -298,9 +351,17 @@ cmd_start(const cru_command_t *cmd, int argc, char **argv)
         .no_cleanup_phase = opt_no_cleanup,
         .use_separate_cleanup_threads = opt_separate_cleanup_thread,
         .no_image_dumps = !opt_dump,
+        .use_async_image_dumps = opt_async_dump,
+        .use_raw_image_dumps = opt_raw_dump,
+        .dump_write_info = {
+            .png_compression_level = opt_dump_png_level,
+            .png_filter = opt_dump_png_filter,
+        },
         .junit_xml_filepath = opt_junit_xml,
         .device_id = opt_device_id,
         .run_all_queues = opt_all_queues,
+        .use_gpu_compare = opt_gpu_compare,
+        .use_qonos_stats = opt_qonos_stats,
         .verbose = opt_verbose,
     });
 
@@ -22,6 +22,7 @@
 /// \file
 /// \brief The runner's dispatcher process
 
+#include <inttypes.h>
 #include <limits.h>
 #include <signal.h>
 #include <stdatomic.h>
@@ -43,6 +44,7 @@
 #include "framework/test/test_def.h"
 
 #include "util/log.h"
+#include "util/misc.h"
 #include "util/string.h"
 
 #include "dispatcher.h"
@@ -118,6 +120,13 @@ static struct dispatcher {
     uint32_t num_skip;
     uint32_t num_lost;
 
+    /// Sum of the phase timings of all tests that reported them.
+    test_timing_t timing;
+
+    /// Sum of the pipeline deduplication counters of all tests that reported
+    /// them.
+    qo_pipeline_dedup_stats_t pipeline_dedup;
+
     uint32_t num_workers;
     worker_t workers[64];
 
@@ -158,7 +167,9 @@ static void dispatcher_cleanup_dead_worker(worker_t *worker);
 static void dispatcher_collect_result(int timeout_ms);
 
 static void dispatcher_report_result(const test_def_t *def, uint32_t queue_num,
-                                     pid_t pid, test_result_t result);
+                                     pid_t pid, test_result_t result,
+                                     const test_timing_t *timing,
+                                     const qo_pipeline_dedup_stats_t *dedup);
 static bool dispatcher_send_packet(worker_t *worker,
                                    const dispatch_packet_t *pk);
 
@@ -264,8 +275,22 @@ junit_init(void)
     return true;
 }
 
+static double
+ns_to_s(uint64_t ns)
+{
+    return ns / 1e9;
+}
+
+static uint64_t
+timing_total_ns(const test_timing_t *timing)
+{
+    return timing->setup_ns + timing->main_ns + timing->precleanup_ns +
+           timing->cleanup_ns;
+}
+
 static void
-junit_add_result(const char *name, test_result_t result)
+junit_add_result(const char *name, test_result_t result,
+                 const test_timing_t *timing)
 {
     if (!dispatcher.junit.doc)
         return;
@@ -282,6 +307,28 @@ junit_add_result(const char *name, test_result_t result)
     xmlNewProp(testcase_node, u("status"), u(test_result_to_string(result)));
     xmlNewProp(testcase_node, u("name"), u(name));
 
+    if (timing) {
+        // JUnit's schema has no per-testcase properties, so record the
+        // per-phase breakdown in the testcase's system-out.
+        string_t buf = STRING_INIT;
+
+        string_printf(&buf, "%.6f", ns_to_s(timing_total_ns(timing)));
+        xmlNewProp(testcase_node, u("time"), u(string_data(&buf)));
+
+        string_printf(&buf, "phase-time setup %.6f s\n"
+                            "phase-time main %.6f s\n"
+                            "phase-time precleanup %.6f s\n"
+                            "phase-time cleanup %.6f s\n",
+                      ns_to_s(timing->setup_ns),
+                      ns_to_s(timing->main_ns),
+                      ns_to_s(timing->precleanup_ns),
+                      ns_to_s(timing->cleanup_ns));
+        xmlNewTextChild(testcase_node, NULL, u("system-out"),
+                        u(string_data(&buf)));
+
+        string_finish(&buf);
+    }
+
     switch (result) {
     case TEST_RESULT_PASS:
         break;
@@ -343,6 +390,36 @@ junit_finish(void)
     xmlNewProp(root_node, u("disabled"), u(string_data(&buf)));
     xmlNewProp(testsuite_node, u("disabled"), u(string_data(&buf)));
 
+    string_printf(&buf, "%.6f", ns_to_s(timing_total_ns(&dispatcher.timing)));
+    xmlNewProp(root_node, u("time"), u(string_data(&buf)));
+    xmlNewProp(testsuite_node, u("time"), u(string_data(&buf)));
+
+    // The run's aggregate per-phase breakdown. Insert it as the testsuite's
+    // first child so it precedes the testcases.
+    const struct {
+        const char *name;
+        uint64_t ns;
+    } phases[] = {
+        { "phase-time.setup", dispatcher.timing.setup_ns },
+        { "phase-time.main", dispatcher.timing.main_ns },
+        { "phase-time.precleanup", dispatcher.timing.precleanup_ns },
+        { "phase-time.cleanup", dispatcher.timing.cleanup_ns },
+    };
+
+    xmlNodePtr properties_node = xmlNewNode(NULL, u("properties"));
+    for (uint32_t i = 0; i < ARRAY_LENGTH(phases); i++) {
+        xmlNodePtr property_node = xmlNewChild(properties_node, NULL,
+                                               u("property"), NULL);
+        string_printf(&buf, "%.6f", ns_to_s(phases[i].ns));
+        xmlNewProp(property_node, u("name"), u(phases[i].name));
+        xmlNewProp(property_node, u("value"), u(string_data(&buf)));
+    }
+
+    if (testsuite_node->children)
+        xmlAddPrevSibling(testsuite_node->children, properties_node);
+    else
+        xmlAddChild(testsuite_node, properties_node);
+
     if (xmlDocFormatDump(dispatcher.junit.file, doc,
                          /*format*/ 1) == -1) {
         loge("failed to write junit xml file: %s", dispatcher.junit.filepath);
@@ -426,6 +503,31 @@ dispatcher_print_summary(void)
     logi("fail %u", dispatcher.num_fail);
     logi("skip %u", dispatcher.num_skip);
     logi("lost %u", dispatcher.num_lost);
+
+    const qo_pipeline_dedup_stats_t *dedup = &dispatcher.pipeline_dedup;
+    if (dedup->hits + dedup->misses + dedup->uncached > 0) {
+        logi("================================");
+        logi("pipelines reused   %"PRIu64, dedup->hits);
+        logi("pipelines created  %"PRIu64" (%"PRIu64" not deduplicated)",
+             dedup->misses + dedup->uncached, dedup->uncached);
+    }
+
+    const test_timing_t *timing = &dispatcher.timing;
+    const uint64_t total_ns = timing_total_ns(timing);
+
+    if (total_ns == 0)
+        return;
+
+    logi("================================");
+    logi("time in setup      %9.3f s (%4.1f%%)", ns_to_s(timing->setup_ns),
+         100.0 * timing->setup_ns / total_ns);
+    logi("time in main       %9.3f s (%4.1f%%)", ns_to_s(timing->main_ns),
+         100.0 * timing->main_ns / total_ns);
+    logi("time in precleanup %9.3f s (%4.1f%%)",
+         ns_to_s(timing->precleanup_ns),
+         100.0 * timing->precleanup_ns / total_ns);
+    logi("time in cleanup    %9.3f s (%4.1f%%)", ns_to_s(timing->cleanup_ns),
+         100.0 * timing->cleanup_ns / total_ns);
 }
 
 static void
@@ -541,24 +643,29 @@ dispatcher_dispatch_loop_no_fork(void)
 
         for (uint32_t qi = queue_start; qi < queue_end; qi++) {
             test_result_t result;
+            test_timing_t timing = {0};
+            qo_pipeline_dedup_stats_t pipeline_dedup = {0};
 
             if (!def->priv.enable)
                 continue;
 
             if (qi >= dispatcher.num_vulkan_queues) {
                 logi("queue-family-index %d does not exist", qi);
-                dispatcher_report_result(def, qi, 0, TEST_RESULT_SKIP);
+                dispatcher_report_result(def, qi, 0, TEST_RESULT_SKIP,
+                                         NULL, NULL);
                 continue;
             }
 
             if (def->skip) {
-                dispatcher_report_result(def, qi, 0, TEST_RESULT_SKIP);
+                dispatcher_report_result(def, qi, 0, TEST_RESULT_SKIP,
+                                         NULL, NULL);
                 continue;
             }
 
             log_tag("start", 0, "%s.q%d", def->name, qi);
-            result = run_test_def(def, qi);
-            dispatcher_report_result(def, qi, 0, result);
+            result = run_test_def(def, qi, &timing, &pipeline_dedup);
+            dispatcher_report_result(def, qi, 0, result, &timing,
+                                     &pipeline_dedup);
         }
     }
 }
@@ -585,12 +692,14 @@ dispatcher_dispatch_loop_with_fork(void)
 
             if (qi >= dispatcher.num_vulkan_queues) {
                 logi("queue-family-index %d does not exist", qi);
-                dispatcher_report_result(def, qi, 0, TEST_RESULT_SKIP);
+                dispatcher_report_result(def, qi, 0, TEST_RESULT_SKIP,
+                                         NULL, NULL);
                 continue;
             }
 
             if (def->skip) {
-                dispatcher_report_result(def, qi, 0, TEST_RESULT_SKIP);
+                dispatcher_report_result(def, qi, 0, TEST_RESULT_SKIP,
+                                         NULL, NULL);
                 continue;
             }
 
@@ -605,18 +714,6 @@ dispatcher_dispatch_loop_with_fork(void)
     }
 }
 
-static uint64_t
-gettime_ns()
-{
-    struct timespec current;
-    int ret = clock_gettime(CLOCK_MONOTONIC, &current);
-    assert(ret >= 0);
-    if (ret < 0)
-        return 0;
-
-    return (uint64_t) current.tv_sec * 1000000000ULL + current.tv_nsec;
-}
-
 static void
 dispatcher_dispatch_test(const test_def_t *def, uint32_t queue_num)
 {
@@ -795,7 +892,8 @@ dispatcher_cleanup_dead_worker(worker_t *worker)
     // Any remaining tests owned by the worker are lost.
     for (uint32_t i = 0; i < worker->tests.len; ++i) {
         const test_def_t *def = worker->tests.data[i];
-        dispatcher_report_result(def, 0, worker->pid, TEST_RESULT_LOST);
+        dispatcher_report_result(def, 0, worker->pid, TEST_RESULT_LOST,
+                                 NULL, NULL);
     }
 
     assert(dispatcher.cur_dispatched_tests >= worker->tests.len);
@@ -842,7 +940,7 @@ dispatcher_check_timeout()
         return;
 
     int err;
-    uint64_t timenow = gettime_ns();
+    uint64_t timenow = cru_get_time_ns();
     dispatcher_for_each_worker_slot(worker) {
         for (int i = 0; i < worker->tests.len; i++) {
             if (timenow > worker->tests.timeout[i]) {
@@ -875,7 +973,9 @@ dispatcher_collect_result(int timeout_ms)
 
 static void
 dispatcher_report_result(const test_def_t *def, uint32_t queue_num,
-                         pid_t pid, test_result_t result)
+                         pid_t pid, test_result_t result,
+                         const test_timing_t *timing,
+                         const qo_pipeline_dedup_stats_t *pipeline_dedup)
 {
     string_t name = STRING_INIT;
     string_printf(&name, "%s.q%d", def->name, queue_num);
@@ -889,7 +989,20 @@ dispatcher_report_result(const test_def_t *def, uint32_t queue_num,
     case TEST_RESULT_LOST: dispatcher.num_lost++; break;
     }
 
-    junit_add_result(string_data(&name), result);
+    if (timing) {
+        dispatcher.timing.setup_ns += timing->setup_ns;
+        dispatcher.timing.main_ns += timing->main_ns;
+        dispatcher.timing.precleanup_ns += timing->precleanup_ns;
+        dispatcher.timing.cleanup_ns += timing->cleanup_ns;
+    }
+
+    if (pipeline_dedup) {
+        dispatcher.pipeline_dedup.hits += pipeline_dedup->hits;
+        dispatcher.pipeline_dedup.misses += pipeline_dedup->misses;
+        dispatcher.pipeline_dedup.uncached += pipeline_dedup->uncached;
+    }
+
+    junit_add_result(string_data(&name), result, timing);
     string_finish(&name);
 }
 
@@ -1170,7 +1283,7 @@ worker_insert_test(worker_t *worker, const test_def_t *def)
     worker->tests.data[test_idx] = def;
     worker->tests.timeout[test_idx] =
         dispatcher.test_case_timeout_ns ?
-        gettime_ns() + dispatcher.test_case_timeout_ns :
+        cru_get_time_ns() + dispatcher.test_case_timeout_ns :
         UINT64_MAX;
     ++dispatcher.cur_dispatched_tests;
 
@@ -1271,7 +1384,7 @@ worker_drain_result_pipe(worker_t *worker)
 
         worker_rm_test(worker, pk.test_def);
         dispatcher_report_result(pk.test_def, pk.queue_num, worker->pid,
-                                 pk.result);
+                                 pk.result, &pk.timing, &pk.pipeline_dedup);
     }
 }
 
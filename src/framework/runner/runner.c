@@ -32,9 +32,11 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
 
 #include <regex.h>
 
+#include "util/cru_image.h"
 #include "util/log.h"
 
 #include "framework/runner/runner.h"
@@ -80,6 +82,13 @@ runner_init(runner_opts_t *opts)
         return false;
     }
 
+    // Concurrent jobs already keep the CPUs busy, so divide the CPUs among
+    // the jobs' image comparisons rather than giving each job all of them.
+    if (opts->jobs > 1) {
+        long nprocs = sysconf(_SC_NPROCESSORS_ONLN);
+        cru_image_compare_set_max_threads(MAX(nprocs / opts->jobs, 1));
+    }
+
     runner_opts = *opts;
     runner_is_init = true;
 
@@ -87,7 +96,8 @@ runner_init(runner_opts_t *opts)
 }
 
 test_result_t
-run_test_def(const test_def_t *def, uint32_t queue_num)
+run_test_def(const test_def_t *def, uint32_t queue_num, test_timing_t *timing,
+             qo_pipeline_dedup_stats_t *pipeline_dedup)
 {
     ASSERT_RUNNER_IS_INIT;
 
@@ -98,12 +108,17 @@ run_test_def(const test_def_t *def, uint32_t queue_num)
 
     test = test_create(.def = def,
                        .enable_dump = !runner_opts.no_image_dumps,
+                       .enable_async_dump = runner_opts.use_async_image_dumps,
+                       .enable_raw_dump = runner_opts.use_raw_image_dumps,
+                       .dump_write_info = &runner_opts.dump_write_info,
                        .enable_cleanup_phase = !runner_opts.no_cleanup_phase,
                        .enable_separate_cleanup_thread =
                             runner_opts.use_separate_cleanup_threads,
                        .device_id = runner_opts.device_id,
                        .queue_num = queue_num,
                        .run_all_queues = runner_opts.run_all_queues,
+                       .enable_gpu_compare = runner_opts.use_gpu_compare,
+                       .enable_qonos_stats = runner_opts.use_qonos_stats,
                        .verbose = runner_opts.verbose);
     if (!test)
         return TEST_RESULT_FAIL;
@@ -111,6 +126,8 @@ run_test_def(const test_def_t *def, uint32_t queue_num)
     test_start(test);
     test_wait(test);
     result = test_get_result(test);
+    test_get_timing(test, timing);
+    test_get_pipeline_dedup_stats(test, pipeline_dedup);
     test_destroy(test);
 
     return result;
@@ -39,8 +39,12 @@ struct result_packet {
     const test_def_t *test_def;
     uint32_t queue_num;
     test_result_t result;
+    test_timing_t timing;
+    qo_pipeline_dedup_stats_t pipeline_dedup;
 };
 
 extern runner_opts_t runner_opts;
 
-test_result_t run_test_def(const test_def_t *def, uint32_t queue_num);
+test_result_t run_test_def(const test_def_t *def, uint32_t queue_num,
+                           test_timing_t *timing,
+                           qo_pipeline_dedup_stats_t *pipeline_dedup);
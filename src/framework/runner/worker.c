@@ -50,12 +50,15 @@ worker_recv_test(const test_def_t **test_def, uint32_t *queue_num)
 
 static bool
 worker_send_result(const test_def_t *def, uint32_t queue_num,
-                  test_result_t result)
+                  test_result_t result, const test_timing_t *timing,
+                  const qo_pipeline_dedup_stats_t *pipeline_dedup)
 {
     const result_packet_t pk = {
         .test_def = def,
         .queue_num = queue_num,
         .result = result,
+        .timing = *timing,
+        .pipeline_dedup = *pipeline_dedup,
     };
 
     static_assert(sizeof(pk) <= PIPE_BUF, "result packets will not be read "
@@ -71,14 +74,16 @@ worker_loop(void)
 
     for (;;) {
         test_result_t result;
+        test_timing_t timing = {0};
+        qo_pipeline_dedup_stats_t pipeline_dedup = {0};
         uint32_t queue_num;
 
         worker_recv_test(&def, &queue_num);
         if (!def)
             return;
 
-        result = run_test_def(def, queue_num);
-        worker_send_result(def, queue_num, result);
+        result = run_test_def(def, queue_num, &timing, &pipeline_dedup);
+        worker_send_result(def, queue_num, result, &timing, &pipeline_dedup);
     }
 }
 
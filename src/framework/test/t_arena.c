@@ -0,0 +1,54 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "test.h"
+
+void *
+t_arena_alloc(size_t size)
+{
+    ASSERT_TEST_IN_MAJOR_PHASE;
+
+    return cru_arena_alloc(current.arena, size);
+}
+
+void *
+t_arena_allocn(size_t n, size_t size)
+{
+    ASSERT_TEST_IN_MAJOR_PHASE;
+
+    return cru_arena_allocn(current.arena, n, size);
+}
+
+void *
+t_arena_zalloc(size_t size)
+{
+    ASSERT_TEST_IN_MAJOR_PHASE;
+
+    return cru_arena_zalloc(current.arena, size);
+}
+
+void *
+t_arena_zallocn(size_t n, size_t size)
+{
+    ASSERT_TEST_IN_MAJOR_PHASE;
+
+    return cru_arena_zallocn(current.arena, n, size);
+}
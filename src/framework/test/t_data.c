@@ -292,6 +292,80 @@ __t_no_image(void)
     return &t->def->no_image;
 }
 
+const bool *
+__t_has_timeline_semaphore(void)
+{
+    ASSERT_TEST_IN_MAJOR_PHASE;
+    GET_CURRENT_TEST(t);
+
+    return &t->vk.timeline_semaphore;
+}
+
+qo_stats_t *
+__t_qonos_stats(void)
+{
+    // Qonos is usable outside of tests, so don't assert that a test is
+    // current.
+    if (!current.test)
+        return NULL;
+
+    return current.test->qonos_stats;
+}
+
+qo_suballoc_t *
+__t_qonos_suballoc(void)
+{
+    if (!current.test)
+        return NULL;
+
+    return current.test->qonos_suballoc;
+}
+
+qo_cmd_ring_t *
+__t_qonos_cmd_ring(uint32_t queue_family)
+{
+    test_t *t = current.test;
+
+    if (!t || !t->qonos_cmd_rings ||
+        queue_family >= t->vk.queue_family_count)
+        return NULL;
+
+    if (!t->qonos_cmd_rings[queue_family]) {
+        t->qonos_cmd_rings[queue_family] =
+            qo_cmd_ring_create(t->vk.device, queue_family);
+    }
+
+    return t->qonos_cmd_rings[queue_family];
+}
+
+qo_staging_t *
+__t_qonos_staging(uint32_t queue_family)
+{
+    if (!current.test || !current.test->qonos_staging ||
+        queue_family >= current.test->vk.queue_family_count)
+        return NULL;
+
+    return current.test->qonos_staging[queue_family];
+}
+
+qo_pipeline_dedup_t *
+__t_qonos_pipeline_dedup(void)
+{
+    if (!current.test)
+        return NULL;
+
+    return current.test->qonos_pipeline_dedup;
+}
+
+qo_desc_alloc_t *
+__t_qonos_desc_alloc(void)
+{
+    if (!current.test)
+        return NULL;
+
+    return current.test->qonos_desc_alloc;
+}
+
 cru_image_t *
 t_ref_image(void)
 {
@@ -46,7 +46,8 @@ t_dump_seq_image(cru_image_t *image)
 
     string_t filename = STRING_INIT;
     string_printf(&filename, "%s.seq%04" PRIu64 ".png", t_name, seq);
-    cru_image_write_file(image, string_data(&filename));
+    t_dump_write_file(image, string_data(&filename));
+    string_finish(&filename);
 }
 
 void printflike(2, 3)
@@ -75,5 +76,64 @@ t_dump_image_fv(cru_image_t *image, const char *format, va_list va)
     string_append_char(&filename, '.');
     string_vappendf(&filename, format, va);
 
-    cru_image_write_file(image, string_data(&filename));
+    t_dump_write_file(image, string_data(&filename));
+    string_finish(&filename);
+}
+
+/// Write \a image to \a filename with the test's dump options, in the
+/// background if async dumps are enabled. If raw dumps are enabled, a ".png"
+/// extension becomes ".raw". A failed write fails the test when it stops.
+void
+t_dump_write_file(cru_image_t *image, const char *_filename)
+{
+    GET_CURRENT_TEST(t);
+
+    cru_image_writer_t *writer = NULL;
+    string_t filename = STRING_INIT;
+
+    string_copy_cstr(&filename, _filename);
+
+    if (t->opt.raw_dump && string_endswith_cstr(&filename, ".png")) {
+        string_truncate(&filename, filename.len - strlen(".png"));
+        string_append_cstr(&filename, ".raw");
+    }
+
+    if (t->opt.async_dump) {
+        pthread_mutex_lock(&t->dump_mutex);
+        if (!t->dump_writer)
+            t->dump_writer = cru_image_writer_create(&t->opt.dump_write_info);
+        writer = t->dump_writer;
+        pthread_mutex_unlock(&t->dump_mutex);
+    }
+
+    bool ok;
+    if (writer) {
+        ok = cru_image_writer_enqueue(writer, image, string_data(&filename));
+    } else {
+        ok = cru_image_write_file_info(image, string_data(&filename),
+                                       &t->opt.dump_write_info);
+    }
+
+    if (!ok) {
+        pthread_mutex_lock(&t->dump_mutex);
+        t->dump_failed = true;
+        pthread_mutex_unlock(&t->dump_mutex);
+    }
+
+    string_finish(&filename);
+}
+
+/// Wait for the test's queued image dumps to be written. Return false if
+/// any of the test's dumps failed to be written.
+bool
+test_finish_dumps(test_t *t)
+{
+    pthread_mutex_lock(&t->dump_mutex);
+    if (!cru_image_writer_finish(t->dump_writer))
+        t->dump_failed = true;
+    t->dump_writer = NULL;
+    bool ok = !t->dump_failed;
+    pthread_mutex_unlock(&t->dump_mutex);
+
+    return ok;
 }
@@ -0,0 +1,415 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "test.h"
+#include "t_gpu_compare.h"
+
+#include "src/framework/test/t_gpu_compare-spirv.h"
+
+#define GROUP_SIZE 8
+
+/// Layout of the compute shader's result buffer.
+struct result_buffer {
+    uint32_t mismatch_count;
+    uint32_t first_index;
+    uint32_t min_x;
+    uint32_t min_y;
+    uint32_t max_x;
+    uint32_t max_y;
+};
+
+/// \brief Resources of t_gpu_compare_color_image().
+///
+/// Created on the first comparison and kept in cru_test::gpu_compare for the
+/// rest of the test. Each test owns its device, so this is a per-device
+/// cache. The Vulkan objects are destroyed with the device by the test's
+/// cleanup stack.
+struct t_gpu_compare {
+    VkDescriptorSetLayout set_layout;
+    VkPipelineLayout pipeline_layout;
+    VkPipeline pipeline;
+
+    /// Private pool, so that the comparison never competes with the test for
+    /// t_descriptor_pool.
+    VkDescriptorPool desc_pool;
+    VkDescriptorSet set;
+
+    uint32_t width;
+    uint32_t height;
+
+    /// Device-local copy of \a ref_image.
+    const cru_image_t *ref_image;
+    VkBuffer ref_buf;
+
+    /// Device-local copy of the color attachment.
+    VkBuffer actual_buf;
+
+    VkBuffer result_buf;
+    struct result_buffer *result_map;
+};
+
+/// Return true if t_gpu_compare_color_image() can replace the host-side
+/// comparison of the color attachment for the current test.
+bool
+t_gpu_compare_available(void)
+{
+    ASSERT_TEST_IN_MAJOR_PHASE;
+    GET_CURRENT_TEST(t);
+
+    if (t->def->no_image || t->opt.bootstrap || !t->ref.image)
+        return false;
+
+    // The shader compares whole R8G8B8A8 texels as uints.
+    if (cru_image_get_format(t->ref.image) != VK_FORMAT_R8G8B8A8_UNORM)
+        return false;
+
+    uint32_t qfam = t->vk.queue_family[t_queue_num];
+    return t->vk.queue_family_props[qfam].queueFlags & VK_QUEUE_COMPUTE_BIT;
+}
+
+static struct t_gpu_compare *
+t_gpu_compare_create(void)
+{
+    GET_CURRENT_TEST(t);
+
+    VkDevice dev = t->vk.device;
+    VkResult res;
+
+    struct t_gpu_compare *gc = t_arena_zalloc(sizeof(*gc));
+    gc->width = t->ref.width;
+    gc->height = t->ref.height;
+
+    const VkDeviceSize image_size = 4 * gc->width * gc->height;
+
+    gc->set_layout = qoCreateDescriptorSetLayout(dev,
+        .bindingCount = 3,
+        .pBindings = (VkDescriptorSetLayoutBinding[]) {
+            {
+                .binding = 0,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            },
+            {
+                .binding = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            },
+            {
+                .binding = 2,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            },
+        });
+
+    gc->pipeline_layout = qoCreatePipelineLayout(dev,
+        .setLayoutCount = 1,
+        .pSetLayouts = &gc->set_layout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &(VkPushConstantRange) {
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .offset = 0,
+            .size = 2 * sizeof(uint32_t),
+        });
+
+    VkShaderModule cs = qoCreateShaderModuleGLSL(dev, COMPUTE,
+        layout(local_size_x = 8, local_size_y = 8) in;
+
+        layout(push_constant) uniform push_consts {
+            uint width;
+            uint height;
+        };
+
+        layout(set = 0, binding = 0, std430) readonly buffer Actual {
+            uint actual[];
+        };
+
+        layout(set = 0, binding = 1, std430) readonly buffer Reference {
+            uint reference[];
+        };
+
+        layout(set = 0, binding = 2, std430) buffer Result {
+            uint mismatch_count;
+            uint first_index;
+            uint min_x;
+            uint min_y;
+            uint max_x;
+            uint max_y;
+        };
+
+        void main()
+        {
+            uvec2 p = gl_GlobalInvocationID.xy;
+            if (p.x >= width || p.y >= height)
+                return;
+
+            uint i = p.y * width + p.x;
+            if (actual[i] == reference[i])
+                return;
+
+            atomicAdd(mismatch_count, 1);
+            atomicMin(first_index, i);
+            atomicMin(min_x, p.x);
+            atomicMin(min_y, p.y);
+            atomicMax(max_x, p.x);
+            atomicMax(max_y, p.y);
+        }
+    );
+
+    res = vkCreateComputePipelines(dev, t->vk.pipeline_cache, 1,
+        &(VkComputePipelineCreateInfo) {
+            .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+            .stage = {
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+                .module = cs,
+                .pName = "main",
+            },
+            .layout = gc->pipeline_layout,
+        }, NULL, &gc->pipeline);
+    t_assert(res == VK_SUCCESS);
+    t_cleanup_push_vk_pipeline(dev, gc->pipeline);
+
+    res = vkCreateDescriptorPool(dev,
+        &(VkDescriptorPoolCreateInfo) {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+            .maxSets = 1,
+            .poolSizeCount = 1,
+            .pPoolSizes = &(VkDescriptorPoolSize) {
+                .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 3,
+            },
+        }, NULL, &gc->desc_pool);
+    t_assert(res == VK_SUCCESS);
+    t_cleanup_push_vk_descriptor_pool(dev, gc->desc_pool);
+
+    res = vkAllocateDescriptorSets(dev,
+        &(VkDescriptorSetAllocateInfo) {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            .descriptorPool = gc->desc_pool,
+            .descriptorSetCount = 1,
+            .pSetLayouts = &gc->set_layout,
+        }, &gc->set);
+    t_assert(res == VK_SUCCESS);
+
+    gc->actual_buf = qoCreateBuffer(dev,
+        .size = image_size,
+        .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                 VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+    VkDeviceMemory actual_mem = qoAllocBufferMemory(dev, gc->actual_buf,
+        .properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    qoBindBufferMemory(dev, gc->actual_buf, actual_mem, 0);
+
+    gc->ref_buf = qoCreateBuffer(dev,
+        .size = image_size,
+        .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                 VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+    VkDeviceMemory ref_mem = qoAllocBufferMemory(dev, gc->ref_buf,
+        .properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    qoBindBufferMemory(dev, gc->ref_buf, ref_mem, 0);
+
+    gc->result_buf = qoCreateBuffer(dev,
+        .size = sizeof(struct result_buffer),
+        .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    VkDeviceMemory result_mem = qoAllocBufferMemory(dev, gc->result_buf,
+        .properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                      VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    qoBindBufferMemory(dev, gc->result_buf, result_mem, 0);
+    gc->result_map = qoMapMemory(dev, result_mem, 0,
+                                 sizeof(*gc->result_map), 0);
+
+    vkUpdateDescriptorSets(dev, 3,
+        (VkWriteDescriptorSet[]) {
+            {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = gc->set,
+                .dstBinding = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pBufferInfo = &(VkDescriptorBufferInfo) {
+                    .buffer = gc->actual_buf,
+                    .range = VK_WHOLE_SIZE,
+                },
+            },
+            {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = gc->set,
+                .dstBinding = 1,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pBufferInfo = &(VkDescriptorBufferInfo) {
+                    .buffer = gc->ref_buf,
+                    .range = VK_WHOLE_SIZE,
+                },
+            },
+            {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = gc->set,
+                .dstBinding = 2,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pBufferInfo = &(VkDescriptorBufferInfo) {
+                    .buffer = gc->result_buf,
+                    .range = VK_WHOLE_SIZE,
+                },
+            },
+        }, 0, NULL);
+
+    return gc;
+}
+
+/// Upload the reference image into the device-local reference buffer,
+/// unless it is already there.
+static void
+t_gpu_compare_upload_ref(struct t_gpu_compare *gc)
+{
+    GET_CURRENT_TEST(t);
+
+    if (gc->ref_image == t->ref.image)
+        return;
+
+    const uint32_t row_size = 4 * gc->width;
+    const uint8_t *ref_pixels = cru_image_map(t->ref.image,
+                                              CRU_IMAGE_MAP_ACCESS_READ);
+    t_assert(ref_pixels);
+
+    const uint32_t ref_pitch = cru_image_get_pitch_bytes(t->ref.image);
+    const uint8_t *data = ref_pixels;
+    uint8_t *packed = NULL;
+
+    if (ref_pitch != row_size) {
+        packed = xmallocn(gc->height, row_size);
+        for (uint32_t y = 0; y < gc->height; y++) {
+            memcpy(packed + row_size * y, ref_pixels + ref_pitch * y,
+                   row_size);
+        }
+        data = packed;
+    }
+
+    qoUploadBuffer(t->vk.device, t->vk.queue[t_queue_num],
+                   t->vk.queue_family[t_queue_num], gc->ref_buf, 0,
+                   (VkDeviceSize) row_size * gc->height, data);
+
+    free(packed);
+    cru_image_unmap(t->ref.image);
+
+    gc->ref_image = t->ref.image;
+}
+
+/// Compare the color attachment against the reference image on the GPU.
+///
+/// The first comparison in a test uploads the reference into device-local
+/// memory and builds the pipeline. Later comparisons reuse both. The
+/// attachment is copied into a device-local buffer, and a compute shader
+/// reduces the comparison to a mismatch count, the first mismatching pixel
+/// and a bounding box. Only that small result is read back to the host.
+void
+t_gpu_compare_color_image(t_gpu_compare_result_t *result)
+{
+    ASSERT_TEST_IN_MAJOR_PHASE;
+    GET_CURRENT_TEST(t);
+
+    if (!t->gpu_compare)
+        t->gpu_compare = t_gpu_compare_create();
+
+    struct t_gpu_compare *gc = t->gpu_compare;
+    VkDevice dev = t->vk.device;
+    const uint32_t width = gc->width;
+    const uint32_t height = gc->height;
+
+    t_gpu_compare_upload_ref(gc);
+
+    *gc->result_map = (struct result_buffer) {
+        .mismatch_count = 0,
+        .first_index = UINT32_MAX,
+        .min_x = UINT32_MAX,
+        .min_y = UINT32_MAX,
+        .max_x = 0,
+        .max_y = 0,
+    };
+
+    // A one-shot command buffer from the test's ring returns to the ring once
+    // the compare completes, so repeated compares don't grow a command pool.
+    const uint32_t qfam = t->vk.queue_family[t_queue_num];
+    VkCommandBuffer cmd = qoAcquireOneShotCommandBuffer(dev, qfam);
+    qoBeginCommandBuffer(cmd);
+
+    vkCmdCopyImageToBuffer(cmd, t->vk.color_image, VK_IMAGE_LAYOUT_GENERAL,
+        gc->actual_buf, 1,
+        &(VkBufferImageCopy) {
+            .imageSubresource = {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .mipLevel = 0,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+            .imageExtent = { width, height, 1 },
+        });
+
+    vkCmdPipelineBarrier(cmd,
+        VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+        1, &(VkMemoryBarrier) {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT |
+                             VK_ACCESS_HOST_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT |
+                             VK_ACCESS_SHADER_WRITE_BIT,
+        }, 0, NULL, 0, NULL);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, gc->pipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+                            gc->pipeline_layout, 0, 1, &gc->set, 0, NULL);
+    vkCmdPushConstants(cmd, gc->pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT,
+                       0, 2 * sizeof(uint32_t),
+                       (uint32_t[]) { width, height });
+    vkCmdDispatch(cmd, (width + GROUP_SIZE - 1) / GROUP_SIZE,
+                  (height + GROUP_SIZE - 1) / GROUP_SIZE, 1);
+
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_HOST_BIT, 0,
+        1, &(VkMemoryBarrier) {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+        }, 0, NULL, 0, NULL);
+
+    qoEndCommandBuffer(cmd);
+    qoQueueSubmitRing(t->vk.queue[t_queue_num], qfam, cmd);
+    qoQueueWaitIdle(t->vk.queue[t_queue_num]);
+
+    const struct result_buffer *gpu_result = gc->result_map;
+
+    *result = (t_gpu_compare_result_t) {
+        .mismatch_count = gpu_result->mismatch_count,
+    };
+
+    if (gpu_result->mismatch_count > 0) {
+        result->first_x = gpu_result->first_index % width;
+        result->first_y = gpu_result->first_index / width;
+        result->min_x = gpu_result->min_x;
+        result->min_y = gpu_result->min_y;
+        result->max_x = gpu_result->max_x;
+        result->max_y = gpu_result->max_y;
+    }
+}
@@ -0,0 +1,46 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct t_gpu_compare_result t_gpu_compare_result_t;
+
+/// Result of comparing the color attachment against the reference image on
+/// the GPU. Coordinates are meaningful only if mismatch_count > 0.
+struct t_gpu_compare_result {
+    uint32_t mismatch_count;
+
+    /// First mismatching pixel in row-major order.
+    uint32_t first_x;
+    uint32_t first_y;
+
+    /// Inclusive bounding box of all mismatching pixels.
+    uint32_t min_x;
+    uint32_t min_y;
+    uint32_t max_x;
+    uint32_t max_y;
+};
+
+bool t_gpu_compare_available(void);
+void t_gpu_compare_color_image(t_gpu_compare_result_t *result);
@@ -21,7 +21,13 @@
 
 #include "tapi/t.h"
 #include "tapi/t_thread.h"
+#include "util/cru_format.h"
 #include "util/cru_image.h"
+#include "util/cru_raster.h"
+#include "util/misc.h"
+#include "util/xalloc.h"
+
+#include "test.h"
 
 malloclike cru_image_t *
 t_new_cru_image_from_filename(const char *filename)
@@ -37,6 +43,37 @@ t_new_cru_image_from_filename(const char *filename)
     return cimg;
 }
 
+static void
+t_destroy_cru_raster(void *raster)
+{
+    cru_raster_destroy(raster);
+}
+
+malloclike cru_raster_t *
+t_new_cru_raster(uint32_t width, uint32_t height)
+{
+    cru_raster_t *raster = cru_raster_create(width, height);
+    if (!raster)
+        t_failf("%s: failed to create raster", __func__);
+
+    t_cleanup_push_callback(t_destroy_cru_raster, raster);
+
+    return raster;
+}
+
+malloclike cru_image_t *
+t_new_cru_image_from_raster(cru_raster_t *raster,
+                            VkImageAspectFlagBits aspect)
+{
+    cru_image_t *cimg = cru_raster_get_image(raster, aspect);
+    if (!cimg)
+        t_failf("%s: failed to create image", __func__);
+
+    t_cleanup_push_cru_image(cimg);
+
+    return cimg;
+}
+
 malloclike cru_image_array_t *
 t_new_cru_image_array_from_filename(const char *filename)
 {
@@ -57,11 +94,26 @@ t_new_cru_image_from_vk_image(VkDevice dev, VkQueue queue, VkImage image,
                               uint32_t level0_width, uint32_t level0_height,
                               uint32_t miplevel, uint32_t array_slice)
 {
+    GET_CURRENT_TEST(t);
+    cru_image_t *cimg;
+
     t_thread_yield();
 
-    cru_image_t *cimg = cru_image_from_vk_image(t_device, queue, image,
+    // Use the test's shared staging context for the queue. It also fixes the
+    // queue family that the copies are recorded for.
+    cru_vk_staging_t *staging = NULL;
+    for (uint32_t q = 0; q < t->vk.queue_count; q++) {
+        if (t->vk.queue[q] == queue) {
+            staging = t->vk.staging[q];
+            break;
+        }
+    }
+    if (!staging)
+        t_failf("%s: queue does not belong to the test's device", __func__);
+
+    cimg = cru_image_from_vk_image_staged(staging, queue, image,
             format, aspect, level0_width, level0_height, miplevel,
-            array_slice, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            array_slice);
     if (!cimg)
         t_failf("%s: failed to create image", __func__);
 
@@ -70,6 +122,15 @@ t_new_cru_image_from_vk_image(VkDevice dev, VkQueue queue, VkImage image,
     return cimg;
 }
 
+void
+t_begin_cru_image_readback(cru_image_t *const *images, uint32_t count)
+{
+    t_thread_yield();
+
+    if (!cru_image_begin_readback(images, count))
+        t_failf("%s: failed to begin image readback", __func__);
+}
+
 malloclike cru_image_t *
 t_new_cru_image_from_pixels(void *restrict pixels, VkFormat format,
                             uint32_t width, uint32_t height)
@@ -84,3 +145,118 @@ t_new_cru_image_from_pixels(void *restrict pixels, VkFormat format,
 
     return cimg;
 }
+
+void
+t_upload_cru_image_array(cru_image_array_t *ia, VkImage image,
+                         VkImageAspectFlags aspect,
+                         VkImageLayout final_layout)
+{
+    const uint32_t num_levels = cru_image_array_get_num_levels(ia);
+    const uint32_t num_layers = cru_image_array_get_num_layers(ia);
+    const uint32_t num_images = num_levels * num_layers;
+
+    t_thread_yield();
+
+    VkBufferImageCopy *regions = xzalloc(num_images * sizeof(regions[0]));
+    size_t *sizes = xzalloc(num_images * sizeof(sizes[0]));
+    VkDeviceSize buffer_size = 0;
+
+    for (uint32_t i = 0; i < num_images; i++) {
+        cru_image_t *cimg = cru_image_array_get_image(ia, i);
+        const uint32_t width = cru_image_get_width(cimg);
+        const uint32_t height = cru_image_get_height(cimg);
+        const struct cru_format_info *info =
+            cru_format_get_info(cru_image_get_format(cimg));
+
+        t_assert(info != NULL);
+
+        // vkCmdCopyBufferToImage requires each region's offset to be a
+        // multiple of both 4 and the texel (or block) size.
+        const size_t texel_size = info->cpp ? info->cpp : info->block_size;
+        buffer_size = cru_round_up_size(buffer_size,
+                                        cru_lcm_size(4, texel_size));
+        sizes[i] = cru_format_get_image_size(info, width, height);
+
+        regions[i] = (VkBufferImageCopy) {
+            .bufferOffset = buffer_size,
+            .imageSubresource = {
+                .aspectMask = aspect,
+                .mipLevel = i / num_layers,
+                .baseArrayLayer = i % num_layers,
+                .layerCount = 1,
+            },
+            .imageExtent = { width, height, 1 },
+        };
+
+        buffer_size += sizes[i];
+    }
+
+    VkBuffer buffer = qoCreateBuffer(t_device, .size = buffer_size,
+                                     .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+    VkDeviceMemory mem = qoAllocBufferMemory(t_device, buffer,
+        .properties = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    qoBindBufferMemory(t_device, buffer, mem, 0);
+
+    uint8_t *map = qoMapMemory(t_device, mem, 0, buffer_size, 0);
+
+    for (uint32_t i = 0; i < num_images; i++) {
+        cru_image_t *cimg = cru_image_array_get_image(ia, i);
+        const uint8_t *pixels = cru_image_map(cimg, CRU_IMAGE_MAP_ACCESS_READ);
+
+        if (!pixels)
+            t_failf("%s: failed to map image %u", __func__, i);
+
+        memcpy(map + regions[i].bufferOffset, pixels, sizes[i]);
+        cru_image_unmap(cimg);
+    }
+
+    const VkImageSubresourceRange range = {
+        .aspectMask = aspect,
+        .baseMipLevel = 0,
+        .levelCount = num_levels,
+        .baseArrayLayer = 0,
+        .layerCount = num_layers,
+    };
+
+    VkCommandBuffer cmd = qoAllocateCommandBuffer(t_device, t_cmd_pool);
+    qoBeginCommandBuffer(cmd);
+
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL,
+        1, &(VkImageMemoryBarrier) {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .srcAccessMask = 0,
+            .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = image,
+            .subresourceRange = range,
+        });
+
+    vkCmdCopyBufferToImage(cmd, buffer, image,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           num_images, regions);
+
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, NULL, 0, NULL,
+        1, &(VkImageMemoryBarrier) {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_MEMORY_READ_BIT,
+            .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            .newLayout = final_layout,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = image,
+            .subresourceRange = range,
+        });
+
+    qoEndCommandBuffer(cmd);
+    qoQueueSubmit(t_queue, 1, &cmd, VK_NULL_HANDLE);
+    qoQueueWaitIdle(t_queue);
+
+    free(regions);
+    free(sizes);
+}
@@ -79,6 +79,66 @@ static const VkAllocationCallbacks test_alloc_cb = {
     .pfnInternalFree = test_vk_dummy_notify,
 };
 
+static void
+release_vk_staging(void *staging)
+{
+    cru_vk_staging_release(staging);
+}
+
+static void
+destroy_qonos_suballoc(void *data)
+{
+    test_t *t = data;
+
+    qo_suballoc_destroy(t->qonos_suballoc);
+    t->qonos_suballoc = NULL;
+}
+
+static void
+destroy_qonos_desc_alloc(void *data)
+{
+    test_t *t = data;
+
+    if (t->qonos_stats)
+        qo_desc_alloc_log(t->qonos_desc_alloc, string_data(&t->name));
+
+    qo_desc_alloc_destroy(t->qonos_desc_alloc);
+    t->qonos_desc_alloc = NULL;
+}
+
+static void
+destroy_qonos_pipeline_dedup(void *data)
+{
+    test_t *t = data;
+
+    qo_pipeline_dedup_get_stats(t->qonos_pipeline_dedup,
+                                &t->pipeline_dedup_stats);
+    qo_pipeline_dedup_destroy(t->qonos_pipeline_dedup);
+    t->qonos_pipeline_dedup = NULL;
+}
+
+static void
+destroy_qonos_cmd_rings(void *data)
+{
+    test_t *t = data;
+
+    for (uint32_t i = 0; i < t->vk.queue_family_count; i++) {
+        qo_cmd_ring_destroy(t->qonos_cmd_rings[i]);
+        t->qonos_cmd_rings[i] = NULL;
+    }
+}
+
+static void
+destroy_qonos_staging(void *data)
+{
+    test_t *t = data;
+
+    for (uint32_t i = 0; i < t->vk.queue_family_count; i++) {
+        qo_staging_destroy(t->qonos_staging[i]);
+        t->qonos_staging[i] = NULL;
+    }
+}
+
 static void
 t_setup_phys_dev(void)
 {
@@ -342,12 +402,13 @@ t_setup_descriptor_pool(void)
         .pPoolSizes = pool_sizes
     };
 
-    VkResult res = vkCreateDescriptorPool(t->vk.device, &create_info, NULL,
-                                          &t->vk.descriptor_pool);
-    t_assert(res == VK_SUCCESS);
-    t_assert(t->vk.descriptor_pool != VK_NULL_HANDLE);
+    // The pool is the first of a chain that qoAllocateDescriptorSet() grows
+    // when the pool is exhausted.
+    t->qonos_desc_alloc = qo_desc_alloc_create(t->vk.device, &create_info);
+    t_assert(t->qonos_desc_alloc);
+    t_cleanup_push_callback(destroy_qonos_desc_alloc, t);
 
-    t_cleanup_push_vk_descriptor_pool(t->vk.device, t->vk.descriptor_pool);
+    t->vk.descriptor_pool = qo_desc_alloc_get_pool(t->qonos_desc_alloc);
 }
 
 static VkBool32 debug_cb(VkDebugReportFlagsEXT flags,
@@ -396,9 +457,8 @@ t_setup_vulkan(void)
     t_assert(res == VK_SUCCESS);
 
     t->vk.instance_extension_props =
-        malloc(t->vk.instance_extension_count * sizeof(*t->vk.instance_extension_props));
-    t_assert(t->vk.instance_extension_props);
-    t_cleanup_push_free(t->vk.instance_extension_props);
+        t_arena_allocn(t->vk.instance_extension_count,
+                       sizeof(*t->vk.instance_extension_props));
 
     res = vkEnumerateInstanceExtensionProperties(NULL,
         &t->vk.instance_extension_count, t->vk.instance_extension_props);
@@ -502,10 +562,8 @@ t_setup_vulkan(void)
     vkGetPhysicalDeviceQueueFamilyProperties(t->vk.physical_dev,
                                              &t->vk.queue_family_count, NULL);
 
-    t->vk.queue_family_props = malloc(t->vk.queue_family_count *
-                                      sizeof(VkQueueFamilyProperties));
-    t_assert(t->vk.queue_family_props);
-    t_cleanup_push_free(t->vk.queue_family_props);
+    t->vk.queue_family_props = t_arena_allocn(t->vk.queue_family_count,
+                                              sizeof(VkQueueFamilyProperties));
     vkGetPhysicalDeviceQueueFamilyProperties(t->vk.physical_dev,
                                              &t->vk.queue_family_count,
                                              t->vk.queue_family_props);
@@ -567,9 +625,8 @@ t_setup_vulkan(void)
     t_assert(res == VK_SUCCESS);
 
     t->vk.device_extension_props =
-        malloc(t->vk.device_extension_count * sizeof(*t->vk.device_extension_props));
-    t_assert(t->vk.device_extension_props);
-    t_cleanup_push_free(t->vk.device_extension_props);
+        t_arena_allocn(t->vk.device_extension_count,
+                       sizeof(*t->vk.device_extension_props));
 
     res = vkEnumerateDeviceExtensionProperties(t->vk.physical_dev, NULL,
         &t->vk.device_extension_count, t->vk.device_extension_props);
@@ -611,11 +668,15 @@ t_setup_vulkan(void)
     VkPhysicalDeviceMeshShaderFeaturesEXT pdmsf = {
         .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT,
     };
+    VkPhysicalDeviceTimelineSemaphoreFeatures pdtsf = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES,
+    };
     VkPhysicalDeviceFeatures2 pdf2 = {
       .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
     };
     add_pnext(&pdf2, &pdr2f);
     add_pnext(&pdf2, &pdmsf);
+    add_pnext(&pdf2, &pdtsf);
     vkGetPhysicalDeviceFeatures2(t->vk.physical_dev, &pdf2);
 
     if (t->def->robust_image_access && !pdr2f.robustImageAccess2)
@@ -643,6 +704,11 @@ t_setup_vulkan(void)
     if (t->def->mesh_shader)
         add_pnext(&device_info, &pdmsf);
 
+    // Always enabled when supported, for qoCreateTimeline().
+    t->vk.timeline_semaphore = pdtsf.timelineSemaphore;
+    if (t->vk.timeline_semaphore)
+        add_pnext(&device_info, &pdtsf);
+
     res = vkCreateDevice(t->vk.physical_dev, &device_info, NULL, &t->vk.device);
     free(qci);
     free(ext_names);
@@ -650,16 +716,21 @@ t_setup_vulkan(void)
     t_assert(res == VK_SUCCESS);
     t_cleanup_push_vk_device(t->vk.device, NULL);
 
+    // Pushed after the device, so the blocks are freed before the device is
+    // destroyed but after every resource bound to them.
+    t->qonos_suballoc = qo_suballoc_create(t->vk.device,
+        &t->vk.physical_dev_mem_props,
+        t->vk.physical_dev_props.limits.bufferImageGranularity);
+    t_assert(t->qonos_suballoc);
+    t_cleanup_push_callback(destroy_qonos_suballoc, t);
+
     t_setup_descriptor_pool();
 
     t_setup_framebuffer();
 
-    t->vk.queue = calloc(t->vk.queue_count, sizeof(*t->vk.queue));
-    t_assert(t->vk.queue);
-    t_cleanup_push_free(t->vk.queue);
-    t->vk.queue_family = calloc(t->vk.queue_count, sizeof(*t->vk.queue_family));
-    t_assert(t->vk.queue_family);
-    t_cleanup_push_free(t->vk.queue_family);
+    t->vk.queue = t_arena_zallocn(t->vk.queue_count, sizeof(*t->vk.queue));
+    t->vk.queue_family = t_arena_zallocn(t->vk.queue_count,
+                                         sizeof(*t->vk.queue_family));
 
     for (uint32_t qfam = 0, q = 0; qfam < t->vk.queue_family_count; qfam++) {
         uint32_t queues_in_fam = t->vk.queue_family_props[qfam].queueCount;
@@ -672,10 +743,15 @@ t_setup_vulkan(void)
 
     t->vk.pipeline_cache = qoCreatePipelineCache(t->vk.device);
 
+    if (!t->def->no_pipeline_dedup) {
+        t->qonos_pipeline_dedup =
+            qo_pipeline_dedup_create(t->vk.device, t->vk.pipeline_cache);
+        t_assert(t->qonos_pipeline_dedup);
+        t_cleanup_push_callback(destroy_qonos_pipeline_dedup, t);
+    }
+
     t->vk.cmd_pool =
-        calloc(t->vk.queue_count, sizeof(*t->vk.cmd_pool));
-    t_assert(t->vk.cmd_pool);
-    t_cleanup_push_free(t->vk.cmd_pool);
+        t_arena_zallocn(t->vk.queue_count, sizeof(*t->vk.cmd_pool));
 
     for (uint32_t qfam = 0, q = 0; qfam < t->vk.queue_family_count; qfam++) {
         uint32_t queues_in_fam = t->vk.queue_family_props[qfam].queueCount;
@@ -692,6 +768,35 @@ t_setup_vulkan(void)
         q += queues_in_fam;
     }
 
+    // Most tests never use a command buffer ring, so __t_qonos_cmd_ring()
+    // creates each on first use.
+    t->qonos_cmd_rings = t_arena_zallocn(t->vk.queue_family_count,
+                                         sizeof(*t->qonos_cmd_rings));
+    t_cleanup_push_callback(destroy_qonos_cmd_rings, t);
+
+    t->qonos_staging = t_arena_zallocn(t->vk.queue_family_count,
+                                       sizeof(*t->qonos_staging));
+
+    for (uint32_t qfam = 0; qfam < t->vk.queue_family_count; qfam++) {
+        t->qonos_staging[qfam] = qo_staging_create(t->vk.device, qfam,
+            &t->vk.physical_dev_mem_props);
+    }
+    t_cleanup_push_callback(destroy_qonos_staging, t);
+
+    t->vk.staging =
+        t_arena_zallocn(t->vk.queue_count, sizeof(*t->vk.staging));
+
+    for (uint32_t qfam = 0, q = 0; qfam < t->vk.queue_family_count; qfam++) {
+        uint32_t queues_in_fam = t->vk.queue_family_props[qfam].queueCount;
+        t->vk.staging[q] = cru_vk_staging_create(t->vk.device, qfam,
+            &t->vk.physical_dev_mem_props,
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        t_cleanup_push_callback(release_vk_staging, t->vk.staging[q]);
+        for (uint32_t j = 1; j < queues_in_fam; j++)
+            t->vk.staging[q + j] = t->vk.staging[q];
+        q += queues_in_fam;
+    }
+
     t->vk.graphics_and_compute_queue = -1;
     t->vk.graphics_queue = -1;
     t->vk.compute_queue = -1;
@@ -748,7 +853,16 @@ t_setup_ref_images(void)
     assert(!t->def->no_image);
     assert(t->ref.filename.len > 0);
 
-    t->ref.image = t_new_cru_image_from_filename(string_data(&t->ref.filename));
+    if (t->def->ref_raster) {
+        cru_raster_t *raster = t_new_cru_raster(t->def->ref_width,
+                                                t->def->ref_height);
+        t->def->ref_raster(raster);
+        t->ref.image = t_new_cru_image_from_raster(raster,
+                                                   VK_IMAGE_ASPECT_COLOR_BIT);
+    } else {
+        t->ref.image = t_new_cru_image_from_filename(
+            string_data(&t->ref.filename));
+    }
 
     t->ref.width = cru_image_get_width(t->ref.image);
     t->ref.height = cru_image_get_height(t->ref.image);
@@ -30,6 +30,7 @@ t_enter_setup_phase(void)
     GET_CURRENT_TEST(t);
     assert(t->num_threads == 1);
     t->phase = TEST_PHASE_SETUP;
+    t->phase_start_ns[TEST_PHASE_SETUP] = cru_get_time_ns();
 
     if (!t->opt.bootstrap && !t->def->no_image) {
         t_setup_ref_images();
@@ -45,6 +46,7 @@ t_enter_main_phase(void)
     GET_CURRENT_TEST(t);
     assert(t->num_threads == 1);
     t->phase = TEST_PHASE_MAIN;
+    t->phase_start_ns[TEST_PHASE_MAIN] = cru_get_time_ns();
 
     if (t->result_is_final) {
         // A previous phase has already selected the test's result. Therefore
@@ -81,6 +83,7 @@ t_enter_precleanup_phase(void)
     GET_CURRENT_TEST(t);
     assert(t->num_threads == 1);
     t->phase = TEST_PHASE_PRECLEANUP;
+    t->phase_start_ns[TEST_PHASE_PRECLEANUP] = cru_get_time_ns();
 
     if (t->vk.queue) {
         // Don't prematurely end the test before the test has completed executing.
@@ -118,6 +121,7 @@ t_enter_cleanup_phase(void)
     GET_CURRENT_TEST(t);
     assert(t->num_threads == 1);
     t->phase = TEST_PHASE_CLEANUP;
+    t->phase_start_ns[TEST_PHASE_CLEANUP] = cru_get_time_ns();
 
     if (t->opt.no_separate_cleanup_thread) {
         t_unwind_cleanup_stacks(NULL);
@@ -134,12 +138,26 @@ t_enter_stopped_phase(void)
     GET_CURRENT_TEST(t);
     assert(t->num_threads == 1);
 
+    // Stamp the end of the cleanup phase before waiting for image dumps, so
+    // that the cleanup time doesn't include the dump writer's backlog.
+    t->phase_start_ns[TEST_PHASE_STOPPED] = cru_get_time_ns();
+
+    // A dump that could not be written, in the background or not, fails the
+    // test even if it otherwise passed.
+    if (!test_finish_dumps(t)) {
+        loge("failed to write image dumps");
+        test_result_merge(&t->result, TEST_RESULT_FAIL);
+    }
+
     // The test is moments away from death. Maybe its result remains untouched
     // since test initialization, or maybe its result was previously set by
     // t_end(). Regardless, the test's current result value becomes the final
     // result value.
     t->result_is_final = true;
 
+    // Report after the cleanup phase, which frees the test's device memory.
+    qo_stats_log(t->qonos_stats, string_data(&t->name));
+
     // To avoid race conditions with test_wait(), the test's thread count must
     // be zero before the test transitions to TEST_PHASE_STOPPED;
     t->num_threads = 0;
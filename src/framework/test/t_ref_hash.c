@@ -0,0 +1,170 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/// \file
+/// \brief The reference image hash manifest.
+///
+/// The build writes ref-hashes.txt to the data directory with
+/// crucible-hash-images(1). Each line holds the hash of a reference image's
+/// decoded pixels, the size of its file, and its name. The manifest is read
+/// once per process.
+///
+/// An entry is stale if its file's size differs from the manifest's or if
+/// the file was modified after the manifest was written, as it is when the
+/// reference image has been bootstrapped again since the build.
+
+#include <sys/stat.h>
+
+#include "util/xalloc.h"
+
+#include "test.h"
+
+struct ref_hash {
+    char *name;
+    off_t size;
+    cru_hash128_t hash;
+};
+
+static pthread_once_t ref_hashes_once = PTHREAD_ONCE_INIT;
+static struct ref_hash *ref_hashes;
+static size_t num_ref_hashes;
+static struct timespec ref_hashes_mtime;
+
+static int
+ref_hash_cmp(const void *a, const void *b)
+{
+    const struct ref_hash *ha = a;
+    const struct ref_hash *hb = b;
+
+    return strcmp(ha->name, hb->name);
+}
+
+static void
+ref_hashes_load(void)
+{
+    string_t path = STRING_INIT;
+    size_t cap = 0;
+    char *line = NULL;
+    size_t line_cap = 0;
+
+    // The manifest describes the images of the build's data directory. The
+    // images in any other directory may differ.
+    const char *env = getenv("CRU_DATA_DIR");
+    if (env && env[0])
+        return;
+
+    string_copy(&path, cru_prefix_path());
+    path_append_cstr(&path, "data");
+    path_append_cstr(&path, "ref-hashes.txt");
+
+    FILE *f = fopen(string_data(&path), "r");
+    string_finish(&path);
+    if (!f)
+        return;
+
+    struct stat st;
+    if (fstat(fileno(f), &st) == -1) {
+        fclose(f);
+        return;
+    }
+
+    ref_hashes_mtime = st.st_mtim;
+
+    while (getline(&line, &line_cap, f) != -1) {
+        cru_hash128_t hash;
+        intmax_t size;
+        int name_start;
+
+        if (!cru_hash128_parse(line, &hash) ||
+            sscanf(line + CRU_HASH128_STRING_LEN, " %jd %n", &size,
+                   &name_start) != 1) {
+            logw("ignoring malformed line in ref-hashes.txt: %s", line);
+            continue;
+        }
+
+        char *name = line + name_start;
+        name[strcspn(name, "\n")] = '\0';
+
+        if (num_ref_hashes == cap) {
+            cap = cap ? 2 * cap : 128;
+            ref_hashes = xreallocn(ref_hashes, cap, sizeof(ref_hashes[0]));
+        }
+
+        ref_hashes[num_ref_hashes++] = (struct ref_hash) {
+            .name = xstrdup(name),
+            .size = size,
+            .hash = hash,
+        };
+    }
+
+    free(line);
+    fclose(f);
+
+    qsort(ref_hashes, num_ref_hashes, sizeof(ref_hashes[0]), ref_hash_cmp);
+}
+
+static bool
+timespec_newer(const struct timespec *a, const struct timespec *b)
+{
+    if (a->tv_sec != b->tv_sec)
+        return a->tv_sec > b->tv_sec;
+
+    return a->tv_nsec > b->tv_nsec;
+}
+
+/// Look up the hash of the decoded reference image \a filename, which is
+/// relative to the data directory.
+///
+/// Return false if the manifest has no entry for the file or the entry is
+/// stale.
+bool
+t_ref_hash_lookup(const char *filename, cru_hash128_t *hash)
+{
+    pthread_once(&ref_hashes_once, ref_hashes_load);
+
+    if (num_ref_hashes == 0)
+        return false;
+
+    const struct ref_hash key = { .name = (char *) filename };
+    const struct ref_hash *entry =
+        bsearch(&key, ref_hashes, num_ref_hashes, sizeof(ref_hashes[0]),
+                ref_hash_cmp);
+    if (!entry)
+        return false;
+
+    string_t path = STRING_INIT;
+    struct stat st;
+
+    string_copy(&path, cru_prefix_path());
+    path_append_cstr(&path, "data");
+    path_append_cstr(&path, filename);
+
+    const bool ok = stat(string_data(&path), &st) == 0 &&
+                    st.st_size == entry->size &&
+                    !timespec_newer(&st.st_mtim, &ref_hashes_mtime);
+    string_finish(&path);
+
+    if (!ok)
+        return false;
+
+    *hash = entry->hash;
+    return true;
+}
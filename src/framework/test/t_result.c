@@ -20,6 +20,7 @@
 // IN THE SOFTWARE.
 
 #include "test.h"
+#include "t_gpu_compare.h"
 #include "t_thread.h"
 
 noreturn void
@@ -210,8 +211,8 @@ t_require_ext(const char *name)
         t_skipf("missing required extension %s", name);
 }
 
-static bool
-t_compare_color_image(void)
+static cru_image_t *
+t_new_actual_color_image(void)
 {
     ASSERT_TEST_IN_MAJOR_PHASE;
     GET_CURRENT_TEST(t);
@@ -223,41 +224,16 @@ t_compare_color_image(void)
     assert(t->ref.width > 0);
     assert(t->ref.height > 0);
 
-    cru_image_t *actual_image = t_new_cru_image_from_vk_image(t->vk.device,
+    return t_new_cru_image_from_vk_image(t->vk.device,
             t->vk.queue[t_queue_num], t->vk.color_image,
             VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT, t->ref.width,
             t->ref.height, /*miplevel*/ 0, /*array_slice*/ 0);
-
-    if (t->opt.bootstrap) {
-        assert(!t->ref.image);
-        t_assert(cru_image_write_file(actual_image,
-                                      string_data(&t->ref.filename)));
-        return true;
-    }
-
-    assert(t->ref.image);
-
-    if (!cru_image_compare(actual_image, t->ref.image)) {
-        loge("actual and reference images differ");
-
-        // Dump the actual image for inspection.
-        //
-        // FINISHME: Dump the image diff too.
-        string_t actual_path = STRING_INIT;
-        string_copy(&actual_path, cru_prefix_path());
-        path_append_cstr(&actual_path, "data");
-        path_append_cstr(&actual_path, t_name);
-        string_append_cstr(&actual_path, ".actual.png");
-        cru_image_write_file(actual_image, string_data(&actual_path));
-
-        return false;
-    }
-
-    return true;
 }
 
-static bool
-t_compare_stencil_image(void)
+/// Return NULL if the test has no reference stencil image or if the stencil
+/// aspect cannot be read back.
+static cru_image_t *
+t_new_actual_stencil_image(void)
 {
     ASSERT_TEST_IN_MAJOR_PHASE;
     GET_CURRENT_TEST(t);
@@ -270,7 +246,7 @@ t_compare_stencil_image(void)
     assert(t->ref.height > 0);
 
     if (!t->def->ref_stencil_filename)
-        return true;
+        return NULL;
 
     // Check to see if we can actually blit from this format.  Not all
     // hardware supports reading stencil after all.
@@ -280,14 +256,138 @@ t_compare_stencil_image(void)
                                         &format_props);
     if (!(format_props.optimalTilingFeatures &
           VK_FORMAT_FEATURE_BLIT_SRC_BIT))
-        return true;
+        return NULL;
 
     const cru_format_info_t *finfo = t_format_info(t->def->depthstencil_format);
 
-    cru_image_t *actual_image = t_new_cru_image_from_vk_image(t->vk.device,
+    return t_new_cru_image_from_vk_image(t->vk.device,
             t->vk.queue[t_queue_num], t->vk.ds_image,
             finfo->stencil_format, VK_IMAGE_ASPECT_STENCIL_BIT, t->ref.width,
             t->ref.height, /*miplevel*/ 0, /*array_slice*/ 0);
+}
+
+/// Write \a image to "data/<test name><suffix>" under the Crucible prefix.
+static void
+t_write_result_image(cru_image_t *image, const char *suffix)
+{
+    string_t path = STRING_INIT;
+    string_copy(&path, cru_prefix_path());
+    path_append_cstr(&path, "data");
+    path_append_cstr(&path, t_name);
+    string_append_cstr(&path, suffix);
+    t_dump_write_file(image, string_data(&path));
+    string_finish(&path);
+}
+
+static bool
+t_compare_color_image(cru_image_t *actual_image)
+{
+    ASSERT_TEST_IN_MAJOR_PHASE;
+    GET_CURRENT_TEST(t);
+
+    if (t->opt.bootstrap) {
+        assert(!t->ref.image);
+        t_assert(cru_image_write_file(actual_image,
+                                      string_data(&t->ref.filename)));
+        return true;
+    }
+
+    assert(t->ref.image);
+
+    const uint32_t width = cru_image_get_width(actual_image);
+    const uint32_t height = cru_image_get_height(actual_image);
+
+    if (width != cru_image_get_width(t->ref.image) ||
+        height != cru_image_get_height(t->ref.image)) {
+        loge("actual and reference images differ in size");
+        t_write_result_image(actual_image, ".actual.png");
+        return false;
+    }
+
+    // A render that matches the reference bytewise has its hash, so the
+    // common case needs no decode of the reference image.
+    cru_hash128_t ref_hash;
+    cru_hash128_t actual_hash;
+    if (t_ref_hash_lookup(string_data(&t->ref.filename), &ref_hash) &&
+        cru_image_hash(actual_image, &actual_hash) &&
+        cru_hash128_equal(actual_hash, ref_hash))
+        return true;
+
+    cru_image_compare_result_t r;
+    t_assert(cru_image_compare_rect_stats(actual_image, 0, 0,
+                                          t->ref.image, 0, 0,
+                                          width, height, NULL, &r));
+
+    if (r.mismatch_count == 0)
+        return true;
+
+    loge("actual and reference images differ in %u pixels, "
+         "within rect (%u, %u)-(%u, %u), "
+         "max error (%g, %g, %g, %g), rms error %g",
+         r.mismatch_count, r.min_x, r.min_y, r.max_x, r.max_y,
+         r.max_error[0], r.max_error[1], r.max_error[2], r.max_error[3],
+         r.rms_error);
+
+    // Dump the actual image and the diff for inspection. Only a failing
+    // compare pays for the diff, which takes a second pass.
+    void *diff_pixels = t_arena_alloc(4 * width * height);
+
+    cru_image_t *diff_image = t_new_cru_image_from_pixels(diff_pixels,
+            VK_FORMAT_R8G8B8A8_UNORM, width, height);
+
+    t_assert(cru_image_compare_rect_stats(actual_image, 0, 0,
+                                          t->ref.image, 0, 0,
+                                          width, height,
+                                          &(cru_image_compare_info_t) {
+                                              .diff_image = diff_image,
+                                          }, &r));
+
+    t_write_result_image(actual_image, ".actual.png");
+    t_write_result_image(diff_image, ".diff.png");
+
+    return false;
+}
+
+static void
+t_dump_actual_color_image(void)
+{
+    ASSERT_TEST_IN_MAJOR_PHASE;
+
+    t_write_result_image(t_new_actual_color_image(), ".actual.png");
+}
+
+/// Like t_compare_color_image(), but the comparison runs on the GPU and only
+/// a failing test reads back the full color image.
+static bool
+t_gpu_compare_color_image_and_dump(void)
+{
+    ASSERT_TEST_IN_MAJOR_PHASE;
+
+    t_gpu_compare_result_t r;
+    t_gpu_compare_color_image(&r);
+
+    if (r.mismatch_count == 0)
+        return true;
+
+    loge("actual and reference images differ in %u pixels, "
+         "first at (%u, %u), within rect (%u, %u)-(%u, %u)",
+         r.mismatch_count, r.first_x, r.first_y,
+         r.min_x, r.min_y, r.max_x, r.max_y);
+
+    // Dump the actual image for inspection.
+    t_dump_actual_color_image();
+
+    return false;
+}
+
+static bool
+t_compare_stencil_image(cru_image_t *actual_image)
+{
+    ASSERT_TEST_IN_MAJOR_PHASE;
+    GET_CURRENT_TEST(t);
+
+    if (!actual_image)
+        return true;
 
     if (t->opt.bootstrap) {
         assert(!t->ref.stencil_image);
@@ -298,23 +398,38 @@ t_compare_stencil_image(void)
 
     assert(t->ref.stencil_image);
 
-    if (!cru_image_compare(actual_image, t->ref.stencil_image)) {
-        loge("actual and reference stencil images differ");
+    if (cru_image_compare(actual_image, t->ref.stencil_image))
+        return true;
+
+    loge("actual and reference stencil images differ");
+
+    // Dump the actual image and, if the sizes agree, the diff for
+    // inspection.
+    t_write_result_image(actual_image, ".actual-stencil.png");
 
-        // Dump the actual image for inspection.
-        //
-        // FINISHME: Dump the image diff too.
-        string_t actual_path = STRING_INIT;
-        string_copy(&actual_path, cru_prefix_path());
-        path_append_cstr(&actual_path, "data");
-        path_append_cstr(&actual_path, t_name);
-        string_append_cstr(&actual_path, ".actual-stencil.png");
-        cru_image_write_file(actual_image, string_data(&actual_path));
+    const uint32_t width = cru_image_get_width(actual_image);
+    const uint32_t height = cru_image_get_height(actual_image);
 
+    if (width != cru_image_get_width(t->ref.stencil_image) ||
+        height != cru_image_get_height(t->ref.stencil_image))
         return false;
-    }
 
-    return true;
+    void *diff_pixels = t_arena_alloc(4 * width * height);
+
+    cru_image_t *diff_image = t_new_cru_image_from_pixels(diff_pixels,
+            VK_FORMAT_R8G8B8A8_UNORM, width, height);
+
+    cru_image_compare_result_t r;
+    t_assert(cru_image_compare_rect_stats(actual_image, 0, 0,
+                                          t->ref.stencil_image, 0, 0,
+                                          width, height,
+                                          &(cru_image_compare_info_t) {
+                                              .diff_image = diff_image,
+                                          }, &r));
+
+    t_write_result_image(diff_image, ".diff-stencil.png");
+
+    return false;
 }
 
 /// Compare the test's rendered image against its reference image.
@@ -322,13 +437,35 @@ void
 t_compare_image(void)
 {
     ASSERT_TEST_IN_MAJOR_PHASE;
+    GET_CURRENT_TEST(t);
 
     t_thread_yield();
 
     bool ok = true;
-
-    ok &= t_compare_color_image();
-    ok &= t_compare_stencil_image();
+    bool gpu_compare = t->opt.gpu_compare && t_gpu_compare_available();
+
+    cru_image_t *actual_color = NULL;
+    if (!gpu_compare)
+        actual_color = t_new_actual_color_image();
+
+    cru_image_t *actual_stencil = t_new_actual_stencil_image();
+
+    // Read back the aspects compared on the host in one submission. The host
+    // comparisons decode PNG reference images row by row as they compare.
+    cru_image_t *actual[2];
+    uint32_t num_actual = 0;
+    if (actual_color)
+        actual[num_actual++] = actual_color;
+    if (actual_stencil)
+        actual[num_actual++] = actual_stencil;
+    t_begin_cru_image_readback(actual, num_actual);
+
+    if (gpu_compare)
+        ok &= t_gpu_compare_color_image_and_dump();
+    else
+        ok &= t_compare_color_image(actual_color);
+
+    ok &= t_compare_stencil_image(actual_stencil);
 
     if (!ok) {
         // Fail silently because the aspect-specific comparison functions have
@@ -23,6 +23,12 @@
 #include "t_phases.h"
 #include "t_thread.h"
 
+static void
+destroy_arena(void *arena)
+{
+    cru_arena_destroy(arena);
+}
+
 static noreturn void *
 test_thread_start(void *arg)
 {
@@ -46,11 +52,15 @@ test_thread_start(void *arg)
 
     cru_slist_prepend_atomic(&targ.test->cleanup_stacks, cleanup);
 
+    cru_arena_t *arena = cru_arena_create();
+    cru_cleanup_push_callback(cleanup, destroy_arena, arena);
+
     // Bind the thread to the test before entering the thread's real start
     // function.
     current = (cru_current_test_t) {
         .test = t,
         .cleanup = cleanup,
+        .arena = arena,
     };
 
     // Yield, because the test may already be done. If it's done, there's no
@@ -119,11 +119,15 @@ test_destroy(test_t *t)
     //   - In the "stopped" phase, all test threads have exited.
     assert(t->num_threads == 0);
 
+    assert(!t->dump_writer);
+
     pthread_mutex_destroy(&t->stop_mutex);
+    pthread_mutex_destroy(&t->dump_mutex);
     pthread_cond_destroy(&t->stop_cond);
     string_finish(&t->name);
     string_finish(&t->ref.filename);
     string_finish(&t->ref.stencil_filename);
+    qo_stats_destroy(t->qonos_stats);
 
     free(t);
 }
@@ -147,11 +151,17 @@ test_create_s(const test_create_info_t *info)
 
     t->def = info->def;
     t->opt.no_dump = !info->enable_dump;
+    t->opt.async_dump = info->enable_async_dump;
+    t->opt.raw_dump = info->enable_raw_dump;
+    t->opt.dump_write_info = info->dump_write_info
+        ? *info->dump_write_info
+        : (cru_image_write_info_t) { .png_compression_level = -1 };
     t->opt.no_cleanup = !info->enable_cleanup_phase;
     t->opt.no_separate_cleanup_thread = !info->enable_separate_cleanup_thread;
     t->opt.bootstrap = info->enable_bootstrap;
     t->opt.queue_num = info->queue_num;
     t->opt.run_all_queues = info->run_all_queues;
+    t->opt.gpu_compare = info->enable_gpu_compare;
     t->opt.device_id = info->device_id;
     t->opt.verbose = info->verbose;
 
@@ -189,6 +199,14 @@ test_create_s(const test_create_info_t *info)
         abort();
     }
 
+    err = pthread_mutex_init(&t->dump_mutex, NULL);
+    if (err) {
+        // Abort to avoid destroying an uninitialized mutex later.
+        loge("%s: failed to init mutex during test creation",
+             string_data(&t->name));
+        abort();
+    }
+
     err = pthread_cond_init(&t->stop_cond, NULL);
     if (err) {
         // Abort to avoid destroying an uninitialized cond later.
@@ -197,6 +215,12 @@ test_create_s(const test_create_info_t *info)
         abort();
     }
 
+    if (info->enable_qonos_stats) {
+        t->qonos_stats = qo_stats_create();
+        if (!t->qonos_stats)
+            goto fail;
+    }
+
     test_set_ref_filenames(t);
 
     return t;
@@ -217,6 +241,47 @@ test_get_result(test_t *t)
     return t->result;
 }
 
+static uint64_t
+test_get_phase_duration(test_t *t, test_phase_t phase)
+{
+    uint64_t start = t->phase_start_ns[phase];
+    uint64_t end = t->phase_start_ns[phase + 1];
+
+    if (start == 0 || end < start)
+        return 0;
+
+    return end - start;
+}
+
+/// Illegal to call before test_wait().
+void
+test_get_timing(test_t *t, test_timing_t *timing)
+{
+    ASSERT_NOT_IN_TEST_THREAD;
+    ASSERT_TEST_IN_STOPPED_PHASE(t);
+
+    *timing = (test_timing_t) {
+        .setup_ns = test_get_phase_duration(t, TEST_PHASE_SETUP),
+        .main_ns = test_get_phase_duration(t, TEST_PHASE_MAIN),
+        .precleanup_ns = test_get_phase_duration(t, TEST_PHASE_PRECLEANUP),
+        .cleanup_ns = test_get_phase_duration(t, TEST_PHASE_CLEANUP),
+    };
+}
+
+/// Illegal to call before test_wait().
+void
+test_get_pipeline_dedup_stats(test_t *t, qo_pipeline_dedup_stats_t *stats)
+{
+    ASSERT_NOT_IN_TEST_THREAD;
+    ASSERT_TEST_IN_STOPPED_PHASE(t);
+
+    // Without a cleanup phase, the deduplication outlives the test.
+    if (t->qonos_pipeline_dedup)
+        qo_pipeline_dedup_get_stats(t->qonos_pipeline_dedup, stats);
+    else
+        *stats = t->pipeline_dedup_stats;
+}
+
 const cru_format_info_t *
 t_format_info(VkFormat format)
 {
@@ -29,7 +29,14 @@
 
 #include "framework/test/test.h"
 #include "qonos/qonos.h"
+#include "qonos/qonos_cmd_ring.h"
+#include "qonos/qonos_desc_alloc.h"
+#include "qonos/qonos_pipeline_dedup.h"
+#include "qonos/qonos_staging.h"
+#include "qonos/qonos_stats.h"
+#include "qonos/qonos_suballoc.h"
 #include "tapi/t.h"
+#include "util/cru_arena.h"
 #include "util/cru_format.h"
 #include "util/cru_image.h"
 #include "util/log.h"
@@ -57,6 +64,10 @@ enum test_phase {
 struct cru_current_test {
     test_t *test;
     cru_cleanup_stack_t *cleanup;
+
+    /// Backs t_arena*(). Destroyed by the first command on \ref cleanup, so
+    /// it outlives every other command there.
+    cru_arena_t *arena;
 };
 
 struct test_thread_arg {
@@ -110,6 +121,16 @@ struct test {
         /// \see t_dump_image()
         bool no_dump;
 
+        /// Write image dumps in a background thread.
+        ///
+        /// \see cru_test::dump_writer
+        bool async_dump;
+
+        cru_image_write_info_t dump_write_info;
+
+        /// Write image dumps as raw files instead of PNG.
+        bool raw_dump;
+
         /// Don't run the cleanup commands in cru_test::cleanup_stacks.
         bool no_cleanup;
 
@@ -125,12 +146,62 @@ struct test {
 
         bool run_all_queues;
 
+        /// Compare the color attachment against the reference image with
+        /// a compute shader instead of reading it back to the host.
+        bool gpu_compare;
+
         bool verbose;
     } opt;
 
+    /// CLOCK_MONOTONIC timestamp, in nanoseconds, at which the test entered
+    /// each phase. Zero if the test never entered the phase.
+    uint64_t phase_start_ns[TEST_PHASE_STOPPED + 1];
+
+    /// Instrumentation of the test's Qonos calls. NULL unless enabled by
+    /// test_create_info_t::enable_qonos_stats.
+    qo_stats_t *qonos_stats;
+
+    /// Suballocator of device memory for t_device. Created with the device
+    /// in the setup phase and destroyed by the test's cleanup stack.
+    qo_suballoc_t *qonos_suballoc;
+
+    /// Command buffer rings for qoAcquireCommandBuffer(), indexed by queue
+    /// family. Created with the command pools in the setup phase.
+    qo_cmd_ring_t **qonos_cmd_rings;
+
+    /// Staging rings for qoUploadBuffer() and friends, indexed by queue
+    /// family. Created with the command buffer rings.
+    qo_staging_t **qonos_staging;
+
+    /// Chain of descriptor pools that starts with t_descriptor_pool.
+    /// Created in the setup phase and destroyed by the test's cleanup stack.
+    qo_desc_alloc_t *qonos_desc_alloc;
+
+    /// Deduplication of the pipelines that Qonos creates on t_device.
+    /// Created with the pipeline cache in the setup phase and destroyed by
+    /// the test's cleanup stack, which first copies its counters to
+    /// \a pipeline_dedup_stats.
+    qo_pipeline_dedup_t *qonos_pipeline_dedup;
+    qo_pipeline_dedup_stats_t pipeline_dedup_stats;
+
+    /// Pipeline, descriptors and device-local buffers of
+    /// t_gpu_compare_color_image(). Created on the first GPU comparison and
+    /// destroyed with the device by the test's cleanup stack.
+    struct t_gpu_compare *gpu_compare;
+
     /// Atomic counter for t_dump_seq_image().
     cru_refcount_t dump_seq;
 
+    /// \brief Background writer of image dumps.
+    ///
+    /// Created on the first dump if cru_test_options::async_dump is set, and
+    /// finished when the test stops. Protected by \a dump_mutex.
+    cru_image_writer_t *dump_writer;
+    pthread_mutex_t dump_mutex;
+
+    /// An image dump failed to be written. Protected by \a dump_mutex.
+    bool dump_failed;
+
     /// Reference image
     struct {
         uint32_t width;
@@ -182,9 +253,17 @@ struct test {
         /// then it will be preferred.
         int transfer_queue;
 
+        /// The device was created with the timelineSemaphore feature.
+        bool timeline_semaphore;
+
         VkDescriptorPool descriptor_pool;
         VkPipelineCache pipeline_cache;
         VkCommandPool *cmd_pool;
+
+        /// Staging context for cru_image readback on each queue. Like
+        /// cmd_pool, queues in the same family share one context.
+        cru_vk_staging_t **staging;
+
         VkCommandBuffer cmd_buffer;
         VkRenderPass render_pass;
         VkFramebuffer framebuffer;
@@ -203,6 +282,9 @@ struct test {
 
 void test_broadcast_stop(test_t *t);
 void t_compare_image(void);
+void t_dump_write_file(cru_image_t *image, const char *filename);
+bool test_finish_dumps(test_t *t);
+bool t_ref_hash_lookup(const char *filename, cru_hash128_t *hash);
 
 extern __thread cru_current_test_t current
     __attribute__((tls_model("local-exec")));
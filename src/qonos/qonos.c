@@ -23,6 +23,25 @@
 
 #include "framework/test/test.h"
 #include "qonos/qonos.h"
+#include "qonos/qonos_cmd_ring.h"
+#include "qonos/qonos_desc_alloc.h"
+#include "qonos/qonos_pipeline_dedup.h"
+#include "qonos/qonos_staging.h"
+#include "qonos/qonos_stats.h"
+#include "qonos/qonos_suballoc.h"
+#include "qonos/qonos_timeline.h"
+
+/// Return the test's descriptor pool chain if it serves \a dev.
+static qo_desc_alloc_t *
+get_desc_alloc(VkDevice dev)
+{
+    qo_desc_alloc_t *da = t_qonos_desc_alloc;
+
+    if (!da || qo_desc_alloc_get_device(da) != dev)
+        return NULL;
+
+    return da;
+}
 
 void
 qoEnumeratePhysicalDevices(VkInstance instance, uint32_t *count,
@@ -54,7 +73,8 @@ qoGetBufferMemoryRequirements(VkDevice dev, VkBuffer buffer)
 {
     VkMemoryRequirements mem_reqs = {0};
 
-    vkGetBufferMemoryRequirements(dev, buffer, &mem_reqs);
+    QO_STATS_CALL(vkGetBufferMemoryRequirements,
+        vkGetBufferMemoryRequirements(dev, buffer, &mem_reqs));
 
     return mem_reqs;
 }
@@ -64,7 +84,8 @@ qoGetImageMemoryRequirements(VkDevice dev, VkImage image)
 {
     VkMemoryRequirements mem_reqs = {0};
 
-    vkGetImageMemoryRequirements(dev, image, &mem_reqs);
+    QO_STATS_CALL(vkGetImageMemoryRequirements,
+        vkGetImageMemoryRequirements(dev, image, &mem_reqs));
 
     return mem_reqs;
 }
@@ -75,7 +96,8 @@ qoBindBufferMemory(VkDevice device, VkBuffer buffer,
 {
     VkResult result;
 
-    result = vkBindBufferMemory(device, buffer, mem, offset);
+    QO_STATS_CALL(vkBindBufferMemory,
+        result = vkBindBufferMemory(device, buffer, mem, offset));
     t_assert(result == VK_SUCCESS);
 
     return result;
@@ -87,7 +109,8 @@ qoBindImageMemory(VkDevice device, VkImage image,
 {
     VkResult result;
 
-    result = vkBindImageMemory(device, image, mem, offset);
+    QO_STATS_CALL(vkBindImageMemory,
+        result = vkBindImageMemory(device, image, mem, offset));
     t_assert(result == VK_SUCCESS);
 
     return result;
@@ -104,13 +127,14 @@ qoQueueSubmit(VkQueue queue, uint32_t cmdBufferCount,
     for (uint32_t i = 0; i < cmdBufferCount; i++)
         wait_dst_stage_masks[i] = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
 
-    result = vkQueueSubmit(queue, 1,
-        &(VkSubmitInfo) {
-            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-            .commandBufferCount = cmdBufferCount,
-            .pCommandBuffers = commandBuffers,
-            .pWaitDstStageMask = wait_dst_stage_masks,
-        }, fence);
+    QO_STATS_CALL(vkQueueSubmit,
+        result = vkQueueSubmit(queue, 1,
+            &(VkSubmitInfo) {
+                .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                .commandBufferCount = cmdBufferCount,
+                .pCommandBuffers = commandBuffers,
+                .pWaitDstStageMask = wait_dst_stage_masks,
+            }, fence));
     free(wait_dst_stage_masks);
     t_assert(result == VK_SUCCESS);
 
@@ -122,24 +146,59 @@ qoQueueWaitIdle(VkQueue queue)
 {
     VkResult result;
 
-    result = vkQueueWaitIdle(queue);
+    QO_STATS_CALL(vkQueueWaitIdle,
+        result = vkQueueWaitIdle(queue));
     t_assert(result == VK_SUCCESS);
 
     return result;
 }
 
+struct qo_stats_memory {
+    qo_stats_t *stats;
+    uint32_t heap;
+    VkDeviceSize size;
+};
+
+static uint32_t
+memory_type_heap(uint32_t memory_type_index)
+{
+    return t_physical_dev_mem_props->memoryTypes[memory_type_index].heapIndex;
+}
+
+static void
+qo_stats_memory_freed(void *data)
+{
+    struct qo_stats_memory *mem = data;
+
+    qo_stats_remove_live_memory(mem->stats, mem->heap, mem->size);
+    free(mem);
+}
+
 VkResult
 __qoAllocMemoryCanFail(VkDevice dev, const VkMemoryAllocateInfo *info,
                        VkDeviceMemory *memory)
 {
+    qo_stats_t *stats = t_qonos_stats;
+    VkResult result;
+
     t_assert(info->memoryTypeIndex != QO_MEMORY_TYPE_INDEX_INVALID);
 
-    return vkAllocateMemory(dev, info, NULL, memory);
+    QO_STATS_CALL(vkAllocateMemory,
+        result = vkAllocateMemory(dev, info, NULL, memory));
+
+    if (stats && result == VK_SUCCESS) {
+        qo_stats_add_object(stats, QO_STATS_OBJECT_DEVICE_MEMORY);
+        qo_stats_add_memory(stats, memory_type_heap(info->memoryTypeIndex),
+                            info->allocationSize);
+    }
+
+    return result;
 }
 
 VkDeviceMemory
 __qoAllocMemory(VkDevice dev, const VkMemoryAllocateInfo *info)
 {
+    qo_stats_t *stats = t_qonos_stats;
     VkDeviceMemory memory = {0};
     VkResult result = __qoAllocMemoryCanFail(dev, info, &memory);
 
@@ -147,6 +206,20 @@ __qoAllocMemory(VkDevice dev, const VkMemoryAllocateInfo *info)
     t_assert(memory != VK_NULL_HANDLE);
     t_cleanup_push_vk_device_memory(dev, memory);
 
+    if (stats) {
+        // The cleanup stack frees this memory, so it is live until then. The
+        // stack is LIFO, so the callback runs just before the memory is
+        // freed.
+        struct qo_stats_memory *mem = xmalloc(sizeof(*mem));
+        *mem = (struct qo_stats_memory) {
+            .stats = stats,
+            .heap = memory_type_heap(info->memoryTypeIndex),
+            .size = info->allocationSize,
+        };
+        qo_stats_add_live_memory(stats, mem->heap, mem->size);
+        t_cleanup_push_callback(qo_stats_memory_freed, mem);
+    }
+
     return memory;
 }
 
@@ -178,6 +251,23 @@ qoFindMemoryTypeWithProperties(uint32_t memoryTypeBits,
     return QO_MEMORY_TYPE_INDEX_INVALID;
 }
 
+static uint32_t
+choose_memory_type(const VkMemoryRequirements *mem_reqs,
+                   const QoMemoryAllocateFromRequirementsInfo *info)
+{
+    uint32_t memory_type = info->memoryTypeIndex;
+
+    if (memory_type == QO_MEMORY_TYPE_INDEX_INVALID) {
+        memory_type = qoFindMemoryTypeWithProperties(mem_reqs->memoryTypeBits,
+                                                     info->properties);
+    }
+
+    t_assert(memory_type != QO_MEMORY_TYPE_INDEX_INVALID);
+    t_assert((1 << memory_type) & mem_reqs->memoryTypeBits);
+
+    return memory_type;
+}
+
 VkResult
 __qoAllocMemoryFromRequirementsCanFail(VkDevice dev,
                                        const VkMemoryRequirements *mem_reqs,
@@ -196,14 +286,7 @@ __qoAllocMemoryFromRequirementsCanFail(VkDevice dev,
 
     t_assert(alloc_info.allocationSize >= mem_reqs->size);
 
-    if (alloc_info.memoryTypeIndex == QO_MEMORY_TYPE_INDEX_INVALID) {
-        alloc_info.memoryTypeIndex =
-            qoFindMemoryTypeWithProperties(mem_reqs->memoryTypeBits,
-                                           info->properties);
-    }
-
-    t_assert(alloc_info.memoryTypeIndex != QO_MEMORY_TYPE_INDEX_INVALID);
-    t_assert((1 << alloc_info.memoryTypeIndex) & mem_reqs->memoryTypeBits);
+    alloc_info.memoryTypeIndex = choose_memory_type(mem_reqs, info);
 
     return __qoAllocMemoryCanFail(dev, &alloc_info, mem);
 }
@@ -239,6 +322,67 @@ __qoAllocImageMemory(VkDevice dev, VkImage image,
     return __qoAllocMemoryFromRequirements(dev, &mem_reqs, info);
 }
 
+static QoMemoryRange
+alloc_memory_range(VkDevice dev, const VkMemoryRequirements *mem_reqs,
+                   bool is_image,
+                   const QoMemoryAllocateFromRequirementsInfo *info)
+{
+    qo_suballoc_t *sa = t_qonos_suballoc;
+    QoMemoryRange range = {0};
+
+    // The suballocator only serves the test's own device, and can't honor
+    // extension structs or an explicit allocation size.
+    if (!sa || qo_suballoc_get_device(sa) != dev ||
+        info->pNext || info->allocationSize) {
+        range.memory = __qoAllocMemoryFromRequirements(dev, mem_reqs, info);
+        range.size = MAX(info->allocationSize, mem_reqs->size);
+        t_assert(range.memory != VK_NULL_HANDLE);
+        return range;
+    }
+
+    const uint32_t memory_type = choose_memory_type(mem_reqs, info);
+    t_assert(qo_suballoc_alloc(sa, memory_type, mem_reqs, is_image,
+                               info->dedicated, &range));
+
+    return range;
+}
+
+QoMemoryRange
+__qoAllocBufferMemoryRange(VkDevice dev, VkBuffer buffer,
+                           const QoMemoryAllocateFromRequirementsInfo *info)
+{
+    VkMemoryRequirements mem_reqs =
+        qoGetBufferMemoryRequirements(dev, buffer);
+
+    return alloc_memory_range(dev, &mem_reqs, /*is_image*/ false, info);
+}
+
+QoMemoryRange
+__qoAllocImageMemoryRange(VkDevice dev, VkImage image,
+                          const QoMemoryAllocateFromRequirementsInfo *info)
+{
+    VkMemoryRequirements mem_reqs =
+        qoGetImageMemoryRequirements(dev, image);
+
+    return alloc_memory_range(dev, &mem_reqs, /*is_image*/ true, info);
+}
+
+void *
+qoMapMemoryRange(VkDevice dev, const QoMemoryRange *range)
+{
+    qo_suballoc_t *sa = t_qonos_suballoc;
+    void *map = NULL;
+
+    if (sa && qo_suballoc_get_device(sa) == dev)
+        map = qo_suballoc_map(sa, range);
+
+    // Ranges of other devices have memory of their own.
+    if (!map)
+        map = qoMapMemory(dev, range->memory, range->offset, range->size, 0);
+
+    return map;
+}
+
 void *
 qoMapMemory(VkDevice dev, VkDeviceMemory mem,
             VkDeviceSize offset, VkDeviceSize size,
@@ -247,7 +391,8 @@ qoMapMemory(VkDevice dev, VkDeviceMemory mem,
     void *map;
     VkResult result;
 
-    result = vkMapMemory(dev, mem, offset, size, flags, &map);
+    QO_STATS_CALL(vkMapMemory,
+        result = vkMapMemory(dev, mem, offset, size, flags, &map));
 
     t_assert(result == VK_SUCCESS);
     t_assert(map);
@@ -262,11 +407,13 @@ __qoCreatePipelineCache(VkDevice dev, const VkPipelineCacheCreateInfo *info)
     VkPipelineCache pipeline_cache = {0};
     VkResult result;
 
-    result = vkCreatePipelineCache(dev, info, NULL, &pipeline_cache);
+    QO_STATS_CALL(vkCreatePipelineCache,
+        result = vkCreatePipelineCache(dev, info, NULL, &pipeline_cache));
 
     t_assert(result == VK_SUCCESS);
     t_assert(pipeline_cache != VK_NULL_HANDLE);
     t_cleanup_push_vk_pipeline_cache(dev, pipeline_cache);
+    qo_stats_add_object(t_qonos_stats, QO_STATS_OBJECT_PIPELINE_CACHE);
 
     return pipeline_cache;
 }
@@ -277,11 +424,17 @@ __qoCreatePipelineLayout(VkDevice dev, const VkPipelineLayoutCreateInfo *info)
     VkPipelineLayout pipeline_layout = {0};
     VkResult result;
 
-    result = vkCreatePipelineLayout(dev, info, NULL, &pipeline_layout);
+    QO_STATS_CALL(vkCreatePipelineLayout,
+        result = vkCreatePipelineLayout(dev, info, NULL, &pipeline_layout));
 
     t_assert(result == VK_SUCCESS);
     t_assert(pipeline_layout != VK_NULL_HANDLE);
     t_cleanup_push_vk_pipeline_layout(dev, pipeline_layout);
+    qo_stats_add_object(t_qonos_stats, QO_STATS_OBJECT_PIPELINE_LAYOUT);
+
+    qo_pipeline_dedup_t *dd = qo_pipeline_dedup_for_device(dev);
+    if (dd)
+        qo_pipeline_dedup_add_pipeline_layout(dd, pipeline_layout, info);
 
     return pipeline_layout;
 }
@@ -292,11 +445,13 @@ __qoCreateSampler(VkDevice dev, const VkSamplerCreateInfo *info)
     VkSampler sampler = {0};
     VkResult result;
 
-    result = vkCreateSampler(dev, info, NULL, &sampler);
+    QO_STATS_CALL(vkCreateSampler,
+        result = vkCreateSampler(dev, info, NULL, &sampler));
 
     t_assert(result == VK_SUCCESS);
     t_assert(sampler != VK_NULL_HANDLE);
     t_cleanup_push_vk_sampler(dev, sampler);
+    qo_stats_add_object(t_qonos_stats, QO_STATS_OBJECT_SAMPLER);
 
     return sampler;
 }
@@ -308,11 +463,21 @@ __qoCreateDescriptorSetLayout(VkDevice dev,
     VkDescriptorSetLayout layout = {0};
     VkResult result;
 
-    result = vkCreateDescriptorSetLayout(dev, info, NULL, &layout);
+    QO_STATS_CALL(vkCreateDescriptorSetLayout,
+        result = vkCreateDescriptorSetLayout(dev, info, NULL, &layout));
 
     t_assert(result == VK_SUCCESS);
     t_assert(layout != VK_NULL_HANDLE);
     t_cleanup_push_vk_descriptor_set_layout(dev, layout);
+    qo_stats_add_object(t_qonos_stats, QO_STATS_OBJECT_DESCRIPTOR_SET_LAYOUT);
+
+    qo_pipeline_dedup_t *dd = qo_pipeline_dedup_for_device(dev);
+    if (dd)
+        qo_pipeline_dedup_add_descriptor_set_layout(dd, layout, info);
+
+    qo_desc_alloc_t *da = get_desc_alloc(dev);
+    if (da)
+        qo_desc_alloc_add_layout(da, layout, info);
 
     return layout;
 }
@@ -326,26 +491,59 @@ __qoAllocateDescriptorSet(VkDevice dev, const VkDescriptorSetAllocateInfo *info)
     t_assert(info->descriptorSetCount == 1);
     t_assert(info->pSetLayouts != NULL);
 
-    result = vkAllocateDescriptorSets(dev, info, &set);
+    qo_desc_alloc_t *da = get_desc_alloc(dev);
+    if (da && info->descriptorPool == qo_desc_alloc_get_pool(da)) {
+        // The chain's pools own the set, so it needs no cleanup of its own.
+        QO_STATS_CALL(vkAllocateDescriptorSets,
+            result = qo_desc_alloc_allocate(da, info, &set));
+
+        t_assert(result == VK_SUCCESS);
+        t_assert(set != VK_NULL_HANDLE);
+        qo_stats_add_object(t_qonos_stats, QO_STATS_OBJECT_DESCRIPTOR_SET);
+
+        return set;
+    }
+
+    QO_STATS_CALL(vkAllocateDescriptorSets,
+        result = vkAllocateDescriptorSets(dev, info, &set));
 
     t_assert(result == VK_SUCCESS);
     t_assert(set != VK_NULL_HANDLE);
     t_cleanup_push_vk_descriptor_set(dev, info->descriptorPool, set);
+    qo_stats_add_object(t_qonos_stats, QO_STATS_OBJECT_DESCRIPTOR_SET);
 
     return set;
 }
 
+VkResult
+qoResetDescriptorPool(VkDevice dev, VkDescriptorPool pool)
+{
+    qo_desc_alloc_t *da = get_desc_alloc(dev);
+    VkResult result;
+
+    if (da && pool == qo_desc_alloc_get_pool(da))
+        result = qo_desc_alloc_reset(da);
+    else
+        result = vkResetDescriptorPool(dev, pool, 0);
+
+    t_assert(result == VK_SUCCESS);
+
+    return result;
+}
+
 VkBuffer
 __qoCreateBuffer(VkDevice dev, const VkBufferCreateInfo *info)
 {
     VkBuffer buffer = {0};
     VkResult result;
 
-    result = vkCreateBuffer(dev, info, NULL, &buffer);
+    QO_STATS_CALL(vkCreateBuffer,
+        result = vkCreateBuffer(dev, info, NULL, &buffer));
 
     t_assert(result == VK_SUCCESS);
     t_assert(buffer != VK_NULL_HANDLE);
     t_cleanup_push_vk_buffer(dev, buffer);
+    qo_stats_add_object(t_qonos_stats, QO_STATS_OBJECT_BUFFER);
 
     return buffer;
 }
@@ -356,11 +554,13 @@ __qoCreateBufferView(VkDevice dev, const VkBufferViewCreateInfo *info)
     VkBufferView view = {0};
     VkResult result;
 
-    result = vkCreateBufferView(dev, info, NULL, &view);
+    QO_STATS_CALL(vkCreateBufferView,
+        result = vkCreateBufferView(dev, info, NULL, &view));
 
     t_assert(result == VK_SUCCESS);
     t_assert(view != VK_NULL_HANDLE);
     t_cleanup_push_vk_buffer_view(dev, view);
+    qo_stats_add_object(t_qonos_stats, QO_STATS_OBJECT_BUFFER_VIEW);
 
     return view;
 }
@@ -371,11 +571,13 @@ __qoCreateQueryPool(VkDevice dev, const VkQueryPoolCreateInfo *info)
     VkQueryPool pool = VK_NULL_HANDLE;
     VkResult result;
 
-    result = vkCreateQueryPool(dev, info, NULL, &pool);
+    QO_STATS_CALL(vkCreateQueryPool,
+        result = vkCreateQueryPool(dev, info, NULL, &pool));
 
     t_assert(result == VK_SUCCESS);
     t_assert(pool != VK_NULL_HANDLE);
     t_cleanup_push_vk_query_pool(dev, pool);
+    qo_stats_add_object(t_qonos_stats, QO_STATS_OBJECT_QUERY_POOL);
 
     return pool;
 }
@@ -390,22 +592,184 @@ __qoAllocateCommandBuffer(VkDevice dev, VkCommandPool pool,
     assert(info->commandPool == pool);
     assert(info->commandBufferCount == 1);
 
-    result = vkAllocateCommandBuffers(dev, info, &cmd);
+    QO_STATS_CALL(vkAllocateCommandBuffers,
+        result = vkAllocateCommandBuffers(dev, info, &cmd));
 
     t_assert(result == VK_SUCCESS);
     t_assert(cmd);
     t_cleanup_push_vk_cmd_buffer(dev, pool, cmd);
+    qo_stats_add_object(t_qonos_stats, QO_STATS_OBJECT_COMMAND_BUFFER);
 
     return cmd;
 }
 
+static qo_cmd_ring_t *
+get_cmd_ring(VkDevice dev, uint32_t queue_family)
+{
+    qo_cmd_ring_t *ring = t_qonos_cmd_ring(queue_family);
+
+    t_assertf(ring && qo_cmd_ring_get_device(ring) == dev,
+              "no command buffer ring for queue family %u", queue_family);
+
+    return ring;
+}
+
+VkCommandBuffer
+qoAcquireCommandBuffer(VkDevice dev, uint32_t queue_family)
+{
+    VkCommandBuffer cmd;
+
+    cmd = qo_cmd_ring_acquire(get_cmd_ring(dev, queue_family), false);
+    t_assert(cmd);
+
+    return cmd;
+}
+
+VkCommandBuffer
+qoAcquireOneShotCommandBuffer(VkDevice dev, uint32_t queue_family)
+{
+    VkCommandBuffer cmd;
+
+    cmd = qo_cmd_ring_acquire(get_cmd_ring(dev, queue_family), true);
+    t_assert(cmd);
+
+    return cmd;
+}
+
+void
+qoReleaseCommandBuffer(VkDevice dev, uint32_t queue_family,
+                       VkCommandBuffer cmd)
+{
+    qo_cmd_ring_release(get_cmd_ring(dev, queue_family), cmd);
+}
+
+VkResult
+qoQueueSubmitRing(VkQueue queue, uint32_t queue_family, VkCommandBuffer cmd)
+{
+    qo_cmd_ring_t *ring = t_qonos_cmd_ring(queue_family);
+    VkResult result;
+
+    t_assert(ring);
+    result = qo_cmd_ring_submit(ring, queue, cmd);
+    t_assert(result == VK_SUCCESS);
+
+    return result;
+}
+
+static void
+destroy_timeline(void *tl)
+{
+    qo_timeline_destroy(tl);
+}
+
+qo_timeline_t *
+qoCreateTimeline(VkDevice dev, VkQueue queue, uint32_t queue_family)
+{
+    qo_cmd_ring_t *ring = t_qonos_cmd_ring(queue_family);
+    qo_timeline_t *tl;
+
+    if (!t_has_timeline_semaphore)
+        t_skipf("device does not support timelineSemaphore");
+
+    if (ring && qo_cmd_ring_get_device(ring) != dev)
+        ring = NULL;
+
+    tl = qo_timeline_create(dev, queue, ring);
+    t_assert(tl);
+    t_cleanup_push_callback(destroy_timeline, tl);
+    qo_stats_add_object(t_qonos_stats, QO_STATS_OBJECT_SEMAPHORE);
+
+    return tl;
+}
+
+uint64_t
+qoTimelineSubmit(qo_timeline_t *tl, uint32_t cmd_count,
+                 const VkCommandBuffer *cmds)
+{
+    VkResult result;
+    uint64_t value;
+
+    value = qo_timeline_submit(tl, cmd_count, cmds, &result);
+    t_assert(result == VK_SUCCESS);
+
+    return value;
+}
+
+VkResult
+qoTimelineFlush(qo_timeline_t *tl)
+{
+    VkResult result = qo_timeline_flush(tl);
+
+    t_assert(result == VK_SUCCESS);
+
+    return result;
+}
+
+VkResult
+qoTimelineWait(qo_timeline_t *tl, uint64_t value)
+{
+    VkResult result = qo_timeline_wait(tl, value);
+
+    t_assert(result == VK_SUCCESS);
+
+    return result;
+}
+
+static qo_staging_t *
+get_staging(VkDevice dev, uint32_t queue_family)
+{
+    qo_staging_t *st = t_qonos_staging(queue_family);
+
+    t_assertf(st && qo_staging_get_device(st) == dev,
+              "no staging ring for queue family %u", queue_family);
+
+    return st;
+}
+
+void
+qoUploadBuffer(VkDevice dev, VkQueue queue, uint32_t queue_family,
+               VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size,
+               const void *data)
+{
+    VkResult result;
+
+    result = qo_staging_upload_buffer(get_staging(dev, queue_family), queue,
+                                      buffer, offset, size, data);
+    t_assert(result == VK_SUCCESS);
+}
+
+void
+qoUploadImage(VkDevice dev, VkQueue queue, uint32_t queue_family,
+              VkImage image, VkFormat format, VkImageLayout layout,
+              const VkBufferImageCopy *region, const void *data)
+{
+    VkResult result;
+
+    result = qo_staging_upload_image(get_staging(dev, queue_family), queue,
+                                     image, format, layout, region, data);
+    t_assert(result == VK_SUCCESS);
+}
+
+void
+qoDownloadImage(VkDevice dev, VkQueue queue, uint32_t queue_family,
+                VkImage image, VkFormat format, VkImageLayout layout,
+                const VkBufferImageCopy *region, void *data)
+{
+    VkResult result;
+
+    result = qo_staging_download_image(get_staging(dev, queue_family), queue,
+                                       image, format, layout, region, data);
+    t_assert(result == VK_SUCCESS);
+}
+
 VkResult
 __qoBeginCommandBuffer(VkCommandBuffer cmd,
                        const VkCommandBufferBeginInfo *info)
 {
     VkResult result;
 
-    result = vkBeginCommandBuffer(cmd, info);
+    QO_STATS_CALL(vkBeginCommandBuffer,
+        result = vkBeginCommandBuffer(cmd, info));
     t_assert(result == VK_SUCCESS);
 
     return result;
@@ -416,7 +780,8 @@ __qoEndCommandBuffer(VkCommandBuffer cmd)
 {
     VkResult result;
 
-    result = vkEndCommandBuffer(cmd);
+    QO_STATS_CALL(vkEndCommandBuffer,
+        result = vkEndCommandBuffer(cmd));
     t_assert(result == VK_SUCCESS);
 
     return result;
@@ -428,11 +793,13 @@ __qoCreateFramebuffer(VkDevice dev, const VkFramebufferCreateInfo *info)
     VkFramebuffer fb = {0};
     VkResult result;
 
-    result = vkCreateFramebuffer(dev, info, NULL, &fb);
+    QO_STATS_CALL(vkCreateFramebuffer,
+        result = vkCreateFramebuffer(dev, info, NULL, &fb));
 
     t_assert(result == VK_SUCCESS);
     t_assert(fb != VK_NULL_HANDLE);
     t_cleanup_push_vk_framebuffer(dev, fb);
+    qo_stats_add_object(t_qonos_stats, QO_STATS_OBJECT_FRAMEBUFFER);
 
     return fb;
 }
@@ -443,11 +810,17 @@ __qoCreateRenderPass(VkDevice dev, const VkRenderPassCreateInfo *info)
     VkRenderPass pass = {0};
     VkResult result;
 
-    result = vkCreateRenderPass(dev, info, NULL, &pass);
+    QO_STATS_CALL(vkCreateRenderPass,
+        result = vkCreateRenderPass(dev, info, NULL, &pass));
 
     t_assert(result == VK_SUCCESS);
     t_assert(pass != VK_NULL_HANDLE);
     t_cleanup_push_vk_render_pass(dev, pass);
+    qo_stats_add_object(t_qonos_stats, QO_STATS_OBJECT_RENDER_PASS);
+
+    qo_pipeline_dedup_t *dd = qo_pipeline_dedup_for_device(dev);
+    if (dd)
+        qo_pipeline_dedup_add_render_pass(dd, pass, info);
 
     return pass;
 }
@@ -460,11 +833,13 @@ __qoCreateImage(VkDevice dev, const VkImageCreateInfo *info)
     VkImage image = {0};
     VkResult result;
 
-    result = vkCreateImage(dev, info, NULL, &image);
+    QO_STATS_CALL(vkCreateImage,
+        result = vkCreateImage(dev, info, NULL, &image));
 
     t_assert(result == VK_SUCCESS);
     t_assert(image != VK_NULL_HANDLE);
     t_cleanup_push_vk_image(dev, image);
+    qo_stats_add_object(t_qonos_stats, QO_STATS_OBJECT_IMAGE);
 
     return image;
 }
@@ -475,11 +850,13 @@ __qoCreateImageView(VkDevice dev, const VkImageViewCreateInfo *info)
     VkImageView view = {0};
     VkResult result;
 
-    result = vkCreateImageView(dev, info, NULL, &view);
+    QO_STATS_CALL(vkCreateImageView,
+        result = vkCreateImageView(dev, info, NULL, &view));
 
     t_assert(result == VK_SUCCESS);
     t_assert(view != VK_NULL_HANDLE);
     t_cleanup_push_vk_image_view(dev, view);
+    qo_stats_add_object(t_qonos_stats, QO_STATS_OBJECT_IMAGE_VIEW);
 
     return view;
 }
@@ -498,11 +875,29 @@ __qoCreateShaderModule(VkDevice dev, const QoShaderModuleCreateInfo *info)
     module_info.codeSize = info->spirvSize;
     module_info.pCode = info->pSpirv;
 
-    result = vkCreateShaderModule(dev, &module_info, NULL, &module);
+    // Share modules built from identical SPIR-V, as the SPIR-V is all that
+    // reaches vkCreateShaderModule().
+    qo_pipeline_dedup_t *dd = qo_pipeline_dedup_for_device(dev);
+    cru_hash128_t key;
+    if (dd) {
+        module = qo_pipeline_dedup_lookup_shader_module(dd, info->pSpirv,
+                                                        info->spirvSize, &key);
+        qo_stats_add_cache_lookup(t_qonos_stats, QO_STATS_CACHE_SHADER_MODULE,
+                                  module != VK_NULL_HANDLE);
+        if (module)
+            return module;
+    }
+
+    QO_STATS_CALL(vkCreateShaderModule,
+        result = vkCreateShaderModule(dev, &module_info, NULL, &module));
 
     t_assert(result == VK_SUCCESS);
     t_assert(module != VK_NULL_HANDLE);
     t_cleanup_push_vk_shader_module(dev, module);
+    qo_stats_add_object(t_qonos_stats, QO_STATS_OBJECT_SHADER_MODULE);
+
+    if (dd)
+        qo_pipeline_dedup_insert_shader_module(dd, key, module);
 
     return module;
 }
@@ -0,0 +1,354 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <stdlib.h>
+
+#include "qonos/qonos_cmd_ring.h"
+#include "qonos/qonos_stats.h"
+#include "qonos/qonos_timeline.h"
+#include "util/log.h"
+#include "util/misc.h"
+#include "util/xalloc.h"
+
+enum slot_state {
+    /// Never acquired, or released and its last submission has completed.
+    SLOT_IDLE,
+
+    /// Acquired and not yet submitted.
+    SLOT_ACQUIRED,
+
+    /// Submitted; the fence, or the timeline if the slot has one, signals
+    /// when the submission completes.
+    SLOT_PENDING,
+};
+
+struct qo_cmd_ring_slot {
+    VkCommandBuffer cmd;
+    VkFence fence;
+    enum slot_state state;
+
+    /// The test may still record or submit the command buffer, so the ring
+    /// must not recycle it. Cleared by qo_cmd_ring_release(), or by the
+    /// first submission of a one-shot command buffer.
+    bool held;
+    bool one_shot;
+
+    /// The fence was submitted and must be reset before its next submission.
+    bool fence_used;
+
+    /// If non-NULL, the last submission went through this timeline and
+    /// completes when it reaches timeline_value.
+    qo_timeline_t *timeline;
+    uint64_t timeline_value;
+
+    /// The command buffer holds commands from a previous use.
+    bool dirty;
+
+    /// Order of the last submission, for waiting on the oldest one.
+    uint64_t serial;
+};
+
+struct qo_cmd_ring {
+    VkDevice device;
+    VkCommandPool pool;
+
+    struct qo_cmd_ring_slot slots[QO_CMD_RING_MAX_SLOTS];
+    uint32_t num_slots;
+
+    uint64_t next_serial;
+};
+
+qo_cmd_ring_t *
+qo_cmd_ring_create(VkDevice dev, uint32_t queue_family)
+{
+    qo_cmd_ring_t *ring = xzalloc(sizeof(*ring));
+    VkResult result;
+
+    ring->device = dev;
+
+    result = vkCreateCommandPool(dev,
+        &(VkCommandPoolCreateInfo) {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+            .queueFamilyIndex = queue_family,
+        }, NULL, &ring->pool);
+    if (result != VK_SUCCESS) {
+        loge("%s: failed to create command pool", __func__);
+        free(ring);
+        return NULL;
+    }
+
+    return ring;
+}
+
+void
+qo_cmd_ring_destroy(qo_cmd_ring_t *ring)
+{
+    if (!ring)
+        return;
+
+    for (uint32_t i = 0; i < ring->num_slots; i++) {
+        struct qo_cmd_ring_slot *slot = &ring->slots[i];
+
+        // A timeline waits for its batches when it is destroyed, which
+        // happens before the ring is.
+        if (slot->state == SLOT_PENDING && !slot->timeline) {
+            vkWaitForFences(ring->device, 1, &slot->fence, VK_TRUE,
+                            UINT64_MAX);
+        }
+
+        vkDestroyFence(ring->device, slot->fence, NULL);
+    }
+
+    // Destroying the pool frees its command buffers.
+    vkDestroyCommandPool(ring->device, ring->pool, NULL);
+    free(ring);
+}
+
+VkDevice
+qo_cmd_ring_get_device(qo_cmd_ring_t *ring)
+{
+    return ring->device;
+}
+
+static struct qo_cmd_ring_slot *
+add_slot(qo_cmd_ring_t *ring)
+{
+    struct qo_cmd_ring_slot *slot = &ring->slots[ring->num_slots];
+    VkResult result;
+
+    *slot = (struct qo_cmd_ring_slot) { .state = SLOT_IDLE };
+
+    QO_STATS_CALL(vkAllocateCommandBuffers,
+        result = vkAllocateCommandBuffers(ring->device,
+            &(VkCommandBufferAllocateInfo) {
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                .commandPool = ring->pool,
+                .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                .commandBufferCount = 1,
+            }, &slot->cmd));
+    if (result != VK_SUCCESS)
+        return NULL;
+
+    result = vkCreateFence(ring->device,
+        &(VkFenceCreateInfo) {
+            .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+        }, NULL, &slot->fence);
+    if (result != VK_SUCCESS) {
+        vkFreeCommandBuffers(ring->device, ring->pool, 1, &slot->cmd);
+        return NULL;
+    }
+
+    qo_stats_add_object(t_qonos_stats, QO_STATS_OBJECT_COMMAND_BUFFER);
+    ring->num_slots++;
+
+    return slot;
+}
+
+static bool
+slot_is_done(qo_cmd_ring_t *ring, struct qo_cmd_ring_slot *slot)
+{
+    if (slot->timeline) {
+        return qo_timeline_get_completed(slot->timeline) >=
+               slot->timeline_value;
+    }
+
+    return vkGetFenceStatus(ring->device, slot->fence) == VK_SUCCESS;
+}
+
+static VkResult
+slot_wait(qo_cmd_ring_t *ring, struct qo_cmd_ring_slot *slot)
+{
+    if (slot->timeline)
+        return qo_timeline_wait(slot->timeline, slot->timeline_value);
+
+    return vkWaitForFences(ring->device, 1, &slot->fence, VK_TRUE,
+                           UINT64_MAX);
+}
+
+static struct qo_cmd_ring_slot *
+find_slot(qo_cmd_ring_t *ring, VkCommandBuffer cmd)
+{
+    for (uint32_t i = 0; i < ring->num_slots; i++) {
+        if (ring->slots[i].cmd == cmd)
+            return &ring->slots[i];
+    }
+
+    return NULL;
+}
+
+/// Return a slot whose command buffer is not in use, or NULL if every slot
+/// is held or still pending.
+static struct qo_cmd_ring_slot *
+find_idle_slot(qo_cmd_ring_t *ring)
+{
+    for (uint32_t i = 0; i < ring->num_slots; i++) {
+        struct qo_cmd_ring_slot *slot = &ring->slots[i];
+
+        if (slot->held)
+            continue;
+
+        if (slot->state == SLOT_PENDING && slot_is_done(ring, slot))
+            slot->state = SLOT_IDLE;
+
+        if (slot->state == SLOT_IDLE)
+            return slot;
+    }
+
+    return NULL;
+}
+
+static struct qo_cmd_ring_slot *
+wait_oldest_slot(qo_cmd_ring_t *ring)
+{
+    struct qo_cmd_ring_slot *oldest = NULL;
+
+    for (uint32_t i = 0; i < ring->num_slots; i++) {
+        struct qo_cmd_ring_slot *slot = &ring->slots[i];
+
+        if (slot->state == SLOT_PENDING && !slot->held &&
+            (!oldest || slot->serial < oldest->serial))
+            oldest = slot;
+    }
+
+    if (!oldest)
+        return NULL;
+
+    if (slot_wait(ring, oldest) != VK_SUCCESS)
+        return NULL;
+
+    oldest->state = SLOT_IDLE;
+    return oldest;
+}
+
+VkCommandBuffer
+qo_cmd_ring_acquire(qo_cmd_ring_t *ring, bool one_shot)
+{
+    struct qo_cmd_ring_slot *slot = find_idle_slot(ring);
+
+    if (!slot && ring->num_slots < QO_CMD_RING_MAX_SLOTS)
+        slot = add_slot(ring);
+
+    if (!slot)
+        slot = wait_oldest_slot(ring);
+
+    if (!slot)
+        return VK_NULL_HANDLE;
+
+    if (slot->dirty) {
+        if (vkResetCommandBuffer(slot->cmd, 0) != VK_SUCCESS)
+            return VK_NULL_HANDLE;
+        slot->dirty = false;
+    }
+
+    slot->state = SLOT_ACQUIRED;
+    slot->held = true;
+    slot->one_shot = one_shot;
+    return slot->cmd;
+}
+
+void
+qo_cmd_ring_release(qo_cmd_ring_t *ring, VkCommandBuffer cmd)
+{
+    struct qo_cmd_ring_slot *slot = find_slot(ring, cmd);
+
+    if (!slot || !slot->held) {
+        loge("%s: command buffer is not held from the ring", __func__);
+        return;
+    }
+
+    slot->held = false;
+
+    // The command buffer may have been recorded but never submitted.
+    if (slot->state == SLOT_ACQUIRED) {
+        slot->state = SLOT_IDLE;
+        slot->dirty = true;
+    }
+}
+
+/// Record a submission of \a slot, which completes when its fence signals
+/// or, if \a tl is non-NULL, when \a tl reaches \a value.
+static void
+slot_mark_pending(qo_cmd_ring_t *ring, struct qo_cmd_ring_slot *slot,
+                  qo_timeline_t *tl, uint64_t value)
+{
+    slot->state = SLOT_PENDING;
+    slot->dirty = true;
+    slot->timeline = tl;
+    slot->timeline_value = value;
+    slot->serial = ++ring->next_serial;
+
+    if (slot->one_shot)
+        slot->held = false;
+}
+
+VkResult
+qo_cmd_ring_submit(qo_cmd_ring_t *ring, VkQueue queue, VkCommandBuffer cmd)
+{
+    struct qo_cmd_ring_slot *slot = find_slot(ring, cmd);
+    VkResult result;
+
+    if (!slot || !slot->held) {
+        loge("%s: command buffer is not held from the ring", __func__);
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    if (slot->state == SLOT_PENDING) {
+        result = slot_wait(ring, slot);
+        if (result != VK_SUCCESS)
+            return result;
+    }
+
+    if (slot->fence_used) {
+        result = vkResetFences(ring->device, 1, &slot->fence);
+        if (result != VK_SUCCESS)
+            return result;
+    }
+
+    QO_STATS_CALL(vkQueueSubmit,
+        result = vkQueueSubmit(queue, 1,
+            &(VkSubmitInfo) {
+                .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                .commandBufferCount = 1,
+                .pCommandBuffers = &cmd,
+            }, slot->fence));
+    if (result != VK_SUCCESS)
+        return result;
+
+    slot->fence_used = true;
+    slot_mark_pending(ring, slot, NULL, 0);
+
+    return VK_SUCCESS;
+}
+
+bool
+qo_cmd_ring_mark_pending(qo_cmd_ring_t *ring, VkCommandBuffer cmd,
+                         qo_timeline_t *tl, uint64_t value)
+{
+    struct qo_cmd_ring_slot *slot = find_slot(ring, cmd);
+
+    if (!slot)
+        return false;
+
+    slot_mark_pending(ring, slot, tl, value);
+
+    return true;
+}
@@ -0,0 +1,338 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "qonos/qonos_desc_alloc.h"
+#include "util/log.h"
+#include "util/misc.h"
+#include "util/xalloc.h"
+
+struct layout_entry {
+    VkDescriptorSetLayout layout;
+    uint32_t descriptors[QO_DESC_ALLOC_NUM_TYPES];
+};
+
+struct qo_desc_alloc {
+    VkDevice device;
+    VkDescriptorPoolCreateFlags flags;
+
+    /// Protects everything below.
+    pthread_mutex_t mutex;
+
+    /// The chain. Allocations come from pools[current]; the pools before it
+    /// were exhausted since the last reset.
+    VkDescriptorPool *pools;
+    uint32_t num_pools;
+    uint32_t current;
+
+    /// Sizes of the last pool of the chain. The array has room for one more
+    /// entry per accounted type than the first pool had.
+    uint32_t max_sets;
+    VkDescriptorPoolSize *sizes;
+    uint32_t num_sizes;
+
+    struct layout_entry *layouts;
+    uint32_t num_layouts;
+
+    qo_desc_alloc_usage_t usage;
+    qo_desc_alloc_usage_t high_water;
+};
+
+static const char *const type_names[QO_DESC_ALLOC_NUM_TYPES] = {
+    [VK_DESCRIPTOR_TYPE_SAMPLER] = "sampler",
+    [VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER] = "combined image sampler",
+    [VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE] = "sampled image",
+    [VK_DESCRIPTOR_TYPE_STORAGE_IMAGE] = "storage image",
+    [VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER] = "uniform texel buffer",
+    [VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER] = "storage texel buffer",
+    [VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER] = "uniform buffer",
+    [VK_DESCRIPTOR_TYPE_STORAGE_BUFFER] = "storage buffer",
+    [VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC] = "uniform buffer dynamic",
+    [VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC] = "storage buffer dynamic",
+    [VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT] = "input attachment",
+};
+
+static VkResult
+add_pool(qo_desc_alloc_t *da)
+{
+    VkDescriptorPool pool;
+    VkResult result;
+
+    result = vkCreateDescriptorPool(da->device,
+        &(VkDescriptorPoolCreateInfo) {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+            .flags = da->flags,
+            .maxSets = da->max_sets,
+            .poolSizeCount = da->num_sizes,
+            .pPoolSizes = da->sizes,
+        }, NULL, &pool);
+    if (result != VK_SUCCESS)
+        return result;
+
+    da->pools = xreallocn(da->pools, da->num_pools + 1, sizeof(*da->pools));
+    da->pools[da->num_pools++] = pool;
+
+    return VK_SUCCESS;
+}
+
+qo_desc_alloc_t *
+qo_desc_alloc_create(VkDevice dev, const VkDescriptorPoolCreateInfo *info)
+{
+    qo_desc_alloc_t *da = xzalloc(sizeof(*da));
+
+    da->device = dev;
+    da->flags = info->flags;
+    da->max_sets = info->maxSets;
+    da->num_sizes = info->poolSizeCount;
+    da->sizes = xzallocn(info->poolSizeCount + QO_DESC_ALLOC_NUM_TYPES,
+                         sizeof(*da->sizes));
+    memcpy(da->sizes, info->pPoolSizes,
+           info->poolSizeCount * sizeof(*da->sizes));
+
+    if (pthread_mutex_init(&da->mutex, NULL) != 0) {
+        loge("%s: failed to init mutex", __func__);
+        goto fail;
+    }
+
+    if (add_pool(da) != VK_SUCCESS) {
+        loge("%s: failed to create descriptor pool", __func__);
+        pthread_mutex_destroy(&da->mutex);
+        goto fail;
+    }
+
+    return da;
+
+fail:
+    free(da->sizes);
+    free(da);
+    return NULL;
+}
+
+void
+qo_desc_alloc_destroy(qo_desc_alloc_t *da)
+{
+    if (!da)
+        return;
+
+    for (uint32_t i = 0; i < da->num_pools; i++)
+        vkDestroyDescriptorPool(da->device, da->pools[i], NULL);
+
+    pthread_mutex_destroy(&da->mutex);
+    free(da->pools);
+    free(da->sizes);
+    free(da->layouts);
+    free(da);
+}
+
+VkDevice
+qo_desc_alloc_get_device(qo_desc_alloc_t *da)
+{
+    return da->device;
+}
+
+VkDescriptorPool
+qo_desc_alloc_get_pool(qo_desc_alloc_t *da)
+{
+    return da->pools[0];
+}
+
+void
+qo_desc_alloc_add_layout(qo_desc_alloc_t *da, VkDescriptorSetLayout layout,
+                         const VkDescriptorSetLayoutCreateInfo *info)
+{
+    struct layout_entry entry = { .layout = layout };
+
+    for (uint32_t i = 0; i < info->bindingCount; i++) {
+        const VkDescriptorSetLayoutBinding *b = &info->pBindings[i];
+
+        if (b->descriptorType < QO_DESC_ALLOC_NUM_TYPES)
+            entry.descriptors[b->descriptorType] += b->descriptorCount;
+    }
+
+    pthread_mutex_lock(&da->mutex);
+    da->layouts = xreallocn(da->layouts, da->num_layouts + 1,
+                            sizeof(*da->layouts));
+    da->layouts[da->num_layouts++] = entry;
+    pthread_mutex_unlock(&da->mutex);
+}
+
+/// Return the descriptor counts of \a layout, or NULL if it was not created
+/// through Qonos. Called with the mutex held.
+static const uint32_t *
+find_layout(qo_desc_alloc_t *da, VkDescriptorSetLayout layout)
+{
+    // Search from the end, because tests usually allocate from the layouts
+    // they created last.
+    for (uint32_t i = da->num_layouts; i > 0; i--) {
+        if (da->layouts[i - 1].layout == layout)
+            return da->layouts[i - 1].descriptors;
+    }
+
+    return NULL;
+}
+
+/// Double the sizes for the next pool of the chain, and make them large
+/// enough for \a need. Called with the mutex held.
+static void
+grow_sizes(qo_desc_alloc_t *da, const qo_desc_alloc_usage_t *need)
+{
+    bool has_type[QO_DESC_ALLOC_NUM_TYPES] = {0};
+
+    da->max_sets = MAX(2 * da->max_sets, need->sets);
+
+    for (uint32_t i = 0; i < da->num_sizes; i++) {
+        VkDescriptorPoolSize *size = &da->sizes[i];
+
+        size->descriptorCount *= 2;
+
+        if (size->type < QO_DESC_ALLOC_NUM_TYPES) {
+            size->descriptorCount = MAX(size->descriptorCount,
+                                        need->descriptors[size->type]);
+            has_type[size->type] = true;
+        }
+    }
+
+    for (uint32_t t = 0; t < QO_DESC_ALLOC_NUM_TYPES; t++) {
+        if (!has_type[t] && need->descriptors[t] > 0) {
+            da->sizes[da->num_sizes++] = (VkDescriptorPoolSize) {
+                .type = t,
+                .descriptorCount = need->descriptors[t],
+            };
+        }
+    }
+}
+
+VkResult
+qo_desc_alloc_allocate(qo_desc_alloc_t *da,
+                       const VkDescriptorSetAllocateInfo *info,
+                       VkDescriptorSet *sets)
+{
+    VkDescriptorSetAllocateInfo pool_info = *info;
+    qo_desc_alloc_usage_t need = { .sets = info->descriptorSetCount };
+    bool added_pool = false;
+    VkResult result;
+
+    pthread_mutex_lock(&da->mutex);
+
+    for (uint32_t i = 0; i < info->descriptorSetCount; i++) {
+        const uint32_t *descriptors = find_layout(da, info->pSetLayouts[i]);
+
+        for (uint32_t t = 0; descriptors && t < QO_DESC_ALLOC_NUM_TYPES; t++)
+            need.descriptors[t] += descriptors[t];
+    }
+
+    for (;;) {
+        pool_info.descriptorPool = da->pools[da->current];
+        result = vkAllocateDescriptorSets(da->device, &pool_info, sets);
+
+        if (result != VK_ERROR_OUT_OF_POOL_MEMORY &&
+            result != VK_ERROR_FRAGMENTED_POOL)
+            break;
+
+        if (da->current + 1 < da->num_pools) {
+            da->current++;
+            continue;
+        }
+
+        // Even a new pool, sized for this allocation, could not hold it.
+        if (added_pool)
+            break;
+
+        grow_sizes(da, &need);
+        result = add_pool(da);
+        if (result != VK_SUCCESS)
+            break;
+
+        added_pool = true;
+        da->current++;
+    }
+
+    if (result == VK_SUCCESS) {
+        da->usage.sets += need.sets;
+        da->high_water.sets = MAX(da->high_water.sets, da->usage.sets);
+
+        for (uint32_t t = 0; t < QO_DESC_ALLOC_NUM_TYPES; t++) {
+            da->usage.descriptors[t] += need.descriptors[t];
+            da->high_water.descriptors[t] = MAX(da->high_water.descriptors[t],
+                                                da->usage.descriptors[t]);
+        }
+    }
+
+    pthread_mutex_unlock(&da->mutex);
+
+    return result;
+}
+
+VkResult
+qo_desc_alloc_reset(qo_desc_alloc_t *da)
+{
+    VkResult result = VK_SUCCESS;
+
+    pthread_mutex_lock(&da->mutex);
+
+    for (uint32_t i = 0; i < da->num_pools; i++) {
+        VkResult r = vkResetDescriptorPool(da->device, da->pools[i], 0);
+        if (r != VK_SUCCESS)
+            result = r;
+    }
+
+    da->current = 0;
+    da->usage = (qo_desc_alloc_usage_t) {0};
+
+    pthread_mutex_unlock(&da->mutex);
+
+    return result;
+}
+
+void
+qo_desc_alloc_get_high_water(qo_desc_alloc_t *da,
+                             qo_desc_alloc_usage_t *usage)
+{
+    pthread_mutex_lock(&da->mutex);
+    *usage = da->high_water;
+    pthread_mutex_unlock(&da->mutex);
+}
+
+void
+qo_desc_alloc_log(qo_desc_alloc_t *da, const char *name)
+{
+    pthread_mutex_lock(&da->mutex);
+
+    if (da->high_water.sets == 0)
+        goto done;
+
+    logi("%s: qonos: descriptor pools: %u, peak %u sets", name,
+         da->num_pools, da->high_water.sets);
+
+    for (uint32_t t = 0; t < QO_DESC_ALLOC_NUM_TYPES; t++) {
+        if (da->high_water.descriptors[t] == 0)
+            continue;
+
+        logi("%s: qonos: descriptor pools: peak %u %s descriptors", name,
+             da->high_water.descriptors[t], type_names[t]);
+    }
+
+done:
+    pthread_mutex_unlock(&da->mutex);
+}
@@ -23,6 +23,8 @@
 #include <string.h>
 
 #include "qonos/qonos.h"
+#include "qonos/qonos_pipeline_dedup.h"
+#include "qonos/qonos_stats.h"
 #include "src/qonos/qonos_pipeline-spirv.h"
 #include "tapi/t_cleanup.h"
 #include "tapi/t_data.h"
@@ -326,12 +328,68 @@ qoCreateGraphicsPipeline(VkDevice device,
         }
     }
 
-    result = vkCreateGraphicsPipelines(device, pipeline_cache,
-                                       1, &pipeline_info, NULL, &pipeline);
+    qo_pipeline_dedup_t *dd = qo_pipeline_dedup_for_device(device);
+    cru_hash128_t key;
+    bool has_key = false;
+
+    if (dd) {
+        has_key = qo_pipeline_dedup_key_graphics(dd, pipeline_cache,
+                                                 &pipeline_info, &key);
+        if (!has_key) {
+            qo_pipeline_dedup_add_uncached(dd);
+        } else if ((pipeline = qo_pipeline_dedup_lookup(dd, key))) {
+            return pipeline;
+        }
+    }
+
+    QO_STATS_CALL(vkCreateGraphicsPipelines,
+        result = vkCreateGraphicsPipelines(device, pipeline_cache,
+                                           1, &pipeline_info, NULL,
+                                           &pipeline));
 
     t_assert(result == VK_SUCCESS);
     t_assert(pipeline != VK_NULL_HANDLE);
     t_cleanup_push_vk_pipeline(device, pipeline);
+    qo_stats_add_object(t_qonos_stats, QO_STATS_OBJECT_PIPELINE);
+
+    if (has_key)
+        qo_pipeline_dedup_insert(dd, key, pipeline);
+
+    return pipeline;
+}
+
+VkPipeline
+qoCreateComputePipeline(VkDevice device,
+                        VkPipelineCache pipeline_cache,
+                        const VkComputePipelineCreateInfo *info)
+{
+    qo_pipeline_dedup_t *dd = qo_pipeline_dedup_for_device(device);
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkResult result;
+    cru_hash128_t key;
+    bool has_key = false;
+
+    if (dd) {
+        has_key = qo_pipeline_dedup_key_compute(dd, pipeline_cache, info,
+                                                &key);
+        if (!has_key) {
+            qo_pipeline_dedup_add_uncached(dd);
+        } else if ((pipeline = qo_pipeline_dedup_lookup(dd, key))) {
+            return pipeline;
+        }
+    }
+
+    QO_STATS_CALL(vkCreateComputePipelines,
+        result = vkCreateComputePipelines(device, pipeline_cache,
+                                          1, info, NULL, &pipeline));
+
+    t_assert(result == VK_SUCCESS);
+    t_assert(pipeline != VK_NULL_HANDLE);
+    t_cleanup_push_vk_pipeline(device, pipeline);
+    qo_stats_add_object(t_qonos_stats, QO_STATS_OBJECT_PIPELINE);
+
+    if (has_key)
+        qo_pipeline_dedup_insert(dd, key, pipeline);
 
     return pipeline;
 }
@@ -0,0 +1,809 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "qonos/qonos_pipeline_dedup.h"
+#include "tapi/t_data.h"
+#include "util/log.h"
+#include "util/misc.h"
+#include "util/xalloc.h"
+
+/// Object types of the fingerprint table. They keep handles of different
+/// types apart, which matters where handles are plain integers.
+enum object_type {
+    OBJECT_SHADER_MODULE = 1,
+    OBJECT_DESCRIPTOR_SET_LAYOUT,
+    OBJECT_PIPELINE_LAYOUT,
+    OBJECT_RENDER_PASS,
+};
+
+struct table_entry {
+    cru_hash128_t key;
+    cru_hash128_t value;
+
+    bool used;
+
+    /// False if the object was created through Qonos but has no fingerprint.
+    /// Recorded so that a stale fingerprint never outlives its handle.
+    bool valid;
+};
+
+/// An open-addressed hash table with linear probing. Entries are never
+/// removed.
+struct table {
+    struct table_entry *entries;
+
+    /// Zero or a power of two.
+    uint32_t capacity;
+    uint32_t count;
+};
+
+struct qo_pipeline_dedup {
+    VkDevice device;
+    VkPipelineCache pipeline_cache;
+
+    /// Protects everything below.
+    pthread_mutex_t mutex;
+
+    /// Fingerprints of shader modules, layouts, and render passes, keyed by
+    /// object type and handle.
+    struct table fingerprints;
+
+    /// Pipelines, keyed by their create info. The value's first word is the
+    /// VkPipeline.
+    struct table pipelines;
+
+    /// Shader modules, keyed by the hash of their SPIR-V. The value's first
+    /// word is the VkShaderModule.
+    struct table shader_modules;
+
+    qo_pipeline_dedup_stats_t stats;
+};
+
+static uint32_t
+table_slot(const struct table *t, cru_hash128_t key)
+{
+    // Handles are often aligned pointers, so mix the bits before masking.
+    uint64_t h = (key.h[0] ^ key.h[1]) * 0x9e3779b97f4a7c15ull;
+
+    return (h >> 32) & (t->capacity - 1);
+}
+
+static struct table_entry *
+table_find(const struct table *t, cru_hash128_t key)
+{
+    if (t->capacity == 0)
+        return NULL;
+
+    for (uint32_t i = table_slot(t, key); ; i = (i + 1) & (t->capacity - 1)) {
+        struct table_entry *e = &t->entries[i];
+
+        if (!e->used)
+            return NULL;
+        if (cru_hash128_equal(e->key, key))
+            return e;
+    }
+}
+
+static void table_set(struct table *t, cru_hash128_t key,
+                      cru_hash128_t value, bool valid);
+
+static void
+table_grow(struct table *t)
+{
+    struct table old = *t;
+
+    t->capacity = MAX(2 * old.capacity, 64);
+    t->entries = xzalloc(t->capacity * sizeof(t->entries[0]));
+    t->count = 0;
+
+    for (uint32_t i = 0; i < old.capacity; i++) {
+        if (old.entries[i].used) {
+            table_set(t, old.entries[i].key, old.entries[i].value,
+                      old.entries[i].valid);
+        }
+    }
+
+    free(old.entries);
+}
+
+/// Insert or replace the entry with \a key.
+static void
+table_set(struct table *t, cru_hash128_t key, cru_hash128_t value, bool valid)
+{
+    struct table_entry *e = table_find(t, key);
+
+    if (!e) {
+        if (4 * (t->count + 1) > 3 * t->capacity)
+            table_grow(t);
+
+        uint32_t i = table_slot(t, key);
+        while (t->entries[i].used)
+            i = (i + 1) & (t->capacity - 1);
+
+        e = &t->entries[i];
+        e->used = true;
+        e->key = key;
+        t->count++;
+    }
+
+    e->value = value;
+    e->valid = valid;
+}
+
+static cru_hash128_t
+object_key(enum object_type type, uint64_t handle)
+{
+    return (cru_hash128_t) { .h = { handle, type } };
+}
+
+/// Record the fingerprint of an object, or that it has none if \a fp is
+/// NULL. Called with the mutex held.
+static void
+set_fingerprint(qo_pipeline_dedup_t *dd, enum object_type type,
+                uint64_t handle, const cru_hash128_t *fp)
+{
+    table_set(&dd->fingerprints, object_key(type, handle),
+              fp ? *fp : (cru_hash128_t) {0}, fp != NULL);
+}
+
+/// Return false if the object has no fingerprint. Called with the mutex
+/// held.
+static bool
+get_fingerprint(qo_pipeline_dedup_t *dd, enum object_type type,
+                uint64_t handle, cru_hash128_t *fp)
+{
+    const struct table_entry *e =
+        table_find(&dd->fingerprints, object_key(type, handle));
+
+    if (!e || !e->valid)
+        return false;
+
+    *fp = e->value;
+    return true;
+}
+
+// Helpers that hash one value each. Create infos are hashed field by field,
+// never as whole structs, because their padding is uninitialized. Arrays of
+// structs with neither pointers nor padding are hashed as bytes.
+
+static void
+hash_u32(cru_hash128_state_t *s, uint32_t v)
+{
+    cru_hash128_update(s, &v, sizeof(v));
+}
+
+static void
+hash_f32(cru_hash128_state_t *s, float v)
+{
+    cru_hash128_update(s, &v, sizeof(v));
+}
+
+static void
+hash_fp(cru_hash128_state_t *s, cru_hash128_t fp)
+{
+    cru_hash128_update(s, fp.h, sizeof(fp.h));
+}
+
+static void
+hash_array(cru_hash128_state_t *s, const void *data, uint32_t count,
+           size_t elem_size)
+{
+    hash_u32(s, count);
+    if (count > 0)
+        cru_hash128_update(s, data, count * elem_size);
+}
+
+/// Hash whether \a p is null, so that a missing array or struct differs from
+/// an empty one. Return true if \a p is non-null.
+static bool
+hash_present(cru_hash128_state_t *s, const void *p)
+{
+    hash_u32(s, p != NULL);
+    return p != NULL;
+}
+
+static void
+hash_string(cru_hash128_state_t *s, const char *str)
+{
+    if (hash_present(s, str))
+        hash_array(s, str, strlen(str), 1);
+}
+
+qo_pipeline_dedup_t *
+qo_pipeline_dedup_create(VkDevice dev, VkPipelineCache pipeline_cache)
+{
+    qo_pipeline_dedup_t *dd = xzalloc(sizeof(*dd));
+
+    dd->device = dev;
+    dd->pipeline_cache = pipeline_cache;
+
+    if (pthread_mutex_init(&dd->mutex, NULL) != 0) {
+        loge("%s: failed to init mutex", __func__);
+        free(dd);
+        return NULL;
+    }
+
+    return dd;
+}
+
+void
+qo_pipeline_dedup_destroy(qo_pipeline_dedup_t *dd)
+{
+    if (!dd)
+        return;
+
+    // The pipelines belong to the test's cleanup stack.
+    pthread_mutex_destroy(&dd->mutex);
+    free(dd->fingerprints.entries);
+    free(dd->pipelines.entries);
+    free(dd->shader_modules.entries);
+    free(dd);
+}
+
+VkDevice
+qo_pipeline_dedup_get_device(qo_pipeline_dedup_t *dd)
+{
+    return dd->device;
+}
+
+qo_pipeline_dedup_t *
+qo_pipeline_dedup_for_device(VkDevice dev)
+{
+    qo_pipeline_dedup_t *dd = t_qonos_pipeline_dedup;
+
+    if (!dd || dd->device != dev)
+        return NULL;
+
+    return dd;
+}
+
+void
+qo_pipeline_dedup_get_stats(qo_pipeline_dedup_t *dd,
+                            qo_pipeline_dedup_stats_t *stats)
+{
+    pthread_mutex_lock(&dd->mutex);
+    *stats = dd->stats;
+    pthread_mutex_unlock(&dd->mutex);
+}
+
+VkShaderModule
+qo_pipeline_dedup_lookup_shader_module(qo_pipeline_dedup_t *dd,
+                                       const void *spirv, size_t spirv_size,
+                                       cru_hash128_t *key)
+{
+    const struct table_entry *e;
+    VkShaderModule module = VK_NULL_HANDLE;
+
+    *key = cru_hash128(spirv, spirv_size);
+
+    pthread_mutex_lock(&dd->mutex);
+
+    e = table_find(&dd->shader_modules, *key);
+    if (e)
+        module = (VkShaderModule) e->value.h[0];
+
+    pthread_mutex_unlock(&dd->mutex);
+
+    return module;
+}
+
+void
+qo_pipeline_dedup_insert_shader_module(qo_pipeline_dedup_t *dd,
+                                       cru_hash128_t key,
+                                       VkShaderModule module)
+{
+    pthread_mutex_lock(&dd->mutex);
+
+    // The SPIR-V hash is also the module's fingerprint.
+    set_fingerprint(dd, OBJECT_SHADER_MODULE, (uint64_t) module, &key);
+
+    if (!table_find(&dd->shader_modules, key)) {
+        table_set(&dd->shader_modules, key,
+                  (cru_hash128_t) { .h = { (uint64_t) module, 0 } }, true);
+    }
+
+    pthread_mutex_unlock(&dd->mutex);
+}
+
+void
+qo_pipeline_dedup_add_descriptor_set_layout(qo_pipeline_dedup_t *dd,
+        VkDescriptorSetLayout layout,
+        const VkDescriptorSetLayoutCreateInfo *info)
+{
+    cru_hash128_state_t s;
+    cru_hash128_t fp;
+    bool valid = info->pNext == NULL;
+
+    cru_hash128_init(&s, 0);
+    hash_u32(&s, info->flags);
+    hash_u32(&s, info->bindingCount);
+
+    for (uint32_t i = 0; i < info->bindingCount; i++) {
+        const VkDescriptorSetLayoutBinding *b = &info->pBindings[i];
+
+        hash_u32(&s, b->binding);
+        hash_u32(&s, b->descriptorType);
+        hash_u32(&s, b->descriptorCount);
+        hash_u32(&s, b->stageFlags);
+
+        // Immutable samplers are raw handles.
+        if (b->pImmutableSamplers &&
+            (b->descriptorType == VK_DESCRIPTOR_TYPE_SAMPLER ||
+             b->descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER))
+            valid = false;
+    }
+
+    fp = cru_hash128_final(&s);
+
+    pthread_mutex_lock(&dd->mutex);
+    set_fingerprint(dd, OBJECT_DESCRIPTOR_SET_LAYOUT, (uint64_t) layout,
+                    valid ? &fp : NULL);
+    pthread_mutex_unlock(&dd->mutex);
+}
+
+void
+qo_pipeline_dedup_add_pipeline_layout(qo_pipeline_dedup_t *dd,
+                                      VkPipelineLayout layout,
+                                      const VkPipelineLayoutCreateInfo *info)
+{
+    cru_hash128_state_t s;
+    cru_hash128_t fp;
+    bool valid = info->pNext == NULL;
+
+    pthread_mutex_lock(&dd->mutex);
+
+    cru_hash128_init(&s, 0);
+    hash_u32(&s, info->flags);
+    hash_u32(&s, info->setLayoutCount);
+
+    for (uint32_t i = 0; i < info->setLayoutCount; i++) {
+        cru_hash128_t set_fp;
+
+        // VK_EXT_graphics_pipeline_library permits null set layouts.
+        if (!hash_present(&s, info->pSetLayouts[i]))
+            continue;
+
+        if (!get_fingerprint(dd, OBJECT_DESCRIPTOR_SET_LAYOUT,
+                             (uint64_t) info->pSetLayouts[i], &set_fp)) {
+            valid = false;
+            break;
+        }
+
+        hash_fp(&s, set_fp);
+    }
+
+    hash_array(&s, info->pPushConstantRanges, info->pushConstantRangeCount,
+               sizeof(info->pPushConstantRanges[0]));
+
+    fp = cru_hash128_final(&s);
+    set_fingerprint(dd, OBJECT_PIPELINE_LAYOUT, (uint64_t) layout,
+                    valid ? &fp : NULL);
+
+    pthread_mutex_unlock(&dd->mutex);
+}
+
+static void
+hash_attachment_refs(cru_hash128_state_t *s,
+                     const VkAttachmentReference *refs, uint32_t count)
+{
+    if (hash_present(s, refs))
+        hash_array(s, refs, count, sizeof(refs[0]));
+}
+
+void
+qo_pipeline_dedup_add_render_pass(qo_pipeline_dedup_t *dd,
+                                  VkRenderPass pass,
+                                  const VkRenderPassCreateInfo *info)
+{
+    cru_hash128_state_t s;
+    cru_hash128_t fp;
+
+    cru_hash128_init(&s, 0);
+    hash_u32(&s, info->flags);
+    hash_array(&s, info->pAttachments, info->attachmentCount,
+               sizeof(info->pAttachments[0]));
+
+    hash_u32(&s, info->subpassCount);
+    for (uint32_t i = 0; i < info->subpassCount; i++) {
+        const VkSubpassDescription *sp = &info->pSubpasses[i];
+
+        hash_u32(&s, sp->flags);
+        hash_u32(&s, sp->pipelineBindPoint);
+        hash_attachment_refs(&s, sp->pInputAttachments,
+                             sp->inputAttachmentCount);
+        hash_attachment_refs(&s, sp->pColorAttachments,
+                             sp->colorAttachmentCount);
+        hash_attachment_refs(&s, sp->pResolveAttachments,
+                             sp->colorAttachmentCount);
+        hash_attachment_refs(&s, sp->pDepthStencilAttachment, 1);
+        hash_array(&s, sp->pPreserveAttachments, sp->preserveAttachmentCount,
+                   sizeof(sp->pPreserveAttachments[0]));
+    }
+
+    hash_array(&s, info->pDependencies, info->dependencyCount,
+               sizeof(info->pDependencies[0]));
+
+    fp = cru_hash128_final(&s);
+
+    pthread_mutex_lock(&dd->mutex);
+    set_fingerprint(dd, OBJECT_RENDER_PASS, (uint64_t) pass,
+                    info->pNext == NULL ? &fp : NULL);
+    pthread_mutex_unlock(&dd->mutex);
+}
+
+/// Return false if the stage has no key. Called with the mutex held.
+static bool
+hash_stage(qo_pipeline_dedup_t *dd, cru_hash128_state_t *s,
+           const VkPipelineShaderStageCreateInfo *stage)
+{
+    const VkSpecializationInfo *spec = stage->pSpecializationInfo;
+    cru_hash128_t module_fp;
+
+    hash_u32(s, stage->flags);
+    hash_u32(s, stage->stage);
+
+    if (stage->pNext) {
+        const VkPipelineShaderStageRequiredSubgroupSizeCreateInfoEXT *rss =
+            stage->pNext;
+
+        if (rss->sType != VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_REQUIRED_SUBGROUP_SIZE_CREATE_INFO_EXT ||
+            rss->pNext != NULL)
+            return false;
+
+        hash_u32(s, rss->requiredSubgroupSize);
+    }
+
+    if (!get_fingerprint(dd, OBJECT_SHADER_MODULE, (uint64_t) stage->module,
+                         &module_fp))
+        return false;
+
+    hash_fp(s, module_fp);
+    hash_string(s, stage->pName);
+
+    if (hash_present(s, spec)) {
+        hash_array(s, spec->pMapEntries, spec->mapEntryCount,
+                   sizeof(spec->pMapEntries[0]));
+        hash_array(s, spec->pData, spec->dataSize, 1);
+    }
+
+    return true;
+}
+
+static bool
+has_dynamic_state(const VkPipelineDynamicStateCreateInfo *info,
+                  VkDynamicState state)
+{
+    if (!info)
+        return false;
+
+    for (uint32_t i = 0; i < info->dynamicStateCount; i++) {
+        if (info->pDynamicStates[i] == state)
+            return true;
+    }
+
+    return false;
+}
+
+static bool
+hash_graphics(qo_pipeline_dedup_t *dd, cru_hash128_state_t *s,
+              const VkGraphicsPipelineCreateInfo *info)
+{
+    const VkPipelineDynamicStateCreateInfo *dy = info->pDynamicState;
+    const VkPipelineRasterizationStateCreateInfo *rs =
+        info->pRasterizationState;
+    bool has_tess = false, has_mesh = false;
+    cru_hash128_t fp;
+
+    // Dynamic rendering, libraries, and other extensions live in the pNext
+    // chain.
+    if (info->pNext || (info->flags & VK_PIPELINE_CREATE_DERIVATIVE_BIT))
+        return false;
+
+    hash_u32(s, VK_PIPELINE_BIND_POINT_GRAPHICS);
+    hash_u32(s, info->flags);
+
+    hash_u32(s, info->stageCount);
+    for (uint32_t i = 0; i < info->stageCount; i++) {
+        switch (info->pStages[i].stage) {
+        case VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT:
+        case VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT:
+            has_tess = true;
+            break;
+        case VK_SHADER_STAGE_MESH_BIT_NV:
+            has_mesh = true;
+            break;
+        default:
+            break;
+        }
+
+        if (!hash_stage(dd, s, &info->pStages[i]))
+            return false;
+    }
+
+    // Mesh pipelines ignore the vertex input and input assembly states.
+    if (!has_mesh) {
+        const VkPipelineVertexInputStateCreateInfo *vi =
+            info->pVertexInputState;
+        const VkPipelineInputAssemblyStateCreateInfo *ia =
+            info->pInputAssemblyState;
+
+        if (hash_present(s, vi)) {
+            if (vi->pNext)
+                return false;
+
+            hash_u32(s, vi->flags);
+            hash_array(s, vi->pVertexBindingDescriptions,
+                       vi->vertexBindingDescriptionCount,
+                       sizeof(vi->pVertexBindingDescriptions[0]));
+            hash_array(s, vi->pVertexAttributeDescriptions,
+                       vi->vertexAttributeDescriptionCount,
+                       sizeof(vi->pVertexAttributeDescriptions[0]));
+        }
+
+        if (hash_present(s, ia)) {
+            if (ia->pNext)
+                return false;
+
+            hash_u32(s, ia->flags);
+            hash_u32(s, ia->topology);
+            hash_u32(s, ia->primitiveRestartEnable);
+        }
+    }
+
+    if (has_tess && hash_present(s, info->pTessellationState)) {
+        if (info->pTessellationState->pNext)
+            return false;
+
+        hash_u32(s, info->pTessellationState->flags);
+        hash_u32(s, info->pTessellationState->patchControlPoints);
+    }
+
+    if (!rs || rs->pNext)
+        return false;
+
+    hash_u32(s, rs->flags);
+    hash_u32(s, rs->depthClampEnable);
+    hash_u32(s, rs->rasterizerDiscardEnable);
+    hash_u32(s, rs->polygonMode);
+    hash_u32(s, rs->cullMode);
+    hash_u32(s, rs->frontFace);
+    hash_u32(s, rs->depthBiasEnable);
+    hash_f32(s, rs->depthBiasConstantFactor);
+    hash_f32(s, rs->depthBiasClamp);
+    hash_f32(s, rs->depthBiasSlopeFactor);
+    hash_f32(s, rs->lineWidth);
+
+    // The remaining states are ignored when rasterization is disabled, and
+    // may then be dangling.
+    if (!rs->rasterizerDiscardEnable) {
+        const VkPipelineViewportStateCreateInfo *vp = info->pViewportState;
+        const VkPipelineMultisampleStateCreateInfo *ms =
+            info->pMultisampleState;
+        const VkPipelineDepthStencilStateCreateInfo *ds =
+            info->pDepthStencilState;
+        const VkPipelineColorBlendStateCreateInfo *cb =
+            info->pColorBlendState;
+
+        if (!vp || vp->pNext || !ms || ms->pNext)
+            return false;
+
+        hash_u32(s, vp->flags);
+        hash_u32(s, vp->viewportCount);
+        hash_u32(s, vp->scissorCount);
+        if (!has_dynamic_state(dy, VK_DYNAMIC_STATE_VIEWPORT) &&
+            hash_present(s, vp->pViewports)) {
+            hash_array(s, vp->pViewports, vp->viewportCount,
+                       sizeof(vp->pViewports[0]));
+        }
+        if (!has_dynamic_state(dy, VK_DYNAMIC_STATE_SCISSOR) &&
+            hash_present(s, vp->pScissors)) {
+            hash_array(s, vp->pScissors, vp->scissorCount,
+                       sizeof(vp->pScissors[0]));
+        }
+
+        hash_u32(s, ms->flags);
+        hash_u32(s, ms->rasterizationSamples);
+        hash_u32(s, ms->sampleShadingEnable);
+        hash_f32(s, ms->minSampleShading);
+        if (hash_present(s, ms->pSampleMask)) {
+            hash_array(s, ms->pSampleMask,
+                       (ms->rasterizationSamples + 31) / 32,
+                       sizeof(ms->pSampleMask[0]));
+        }
+        hash_u32(s, ms->alphaToCoverageEnable);
+        hash_u32(s, ms->alphaToOneEnable);
+
+        if (hash_present(s, ds)) {
+            if (ds->pNext)
+                return false;
+
+            hash_u32(s, ds->flags);
+            hash_u32(s, ds->depthTestEnable);
+            hash_u32(s, ds->depthWriteEnable);
+            hash_u32(s, ds->depthCompareOp);
+            hash_u32(s, ds->depthBoundsTestEnable);
+            hash_u32(s, ds->stencilTestEnable);
+            hash_array(s, &ds->front, 1, sizeof(ds->front));
+            hash_array(s, &ds->back, 1, sizeof(ds->back));
+            hash_f32(s, ds->minDepthBounds);
+            hash_f32(s, ds->maxDepthBounds);
+        }
+
+        if (hash_present(s, cb)) {
+            if (cb->pNext)
+                return false;
+
+            hash_u32(s, cb->flags);
+            hash_u32(s, cb->logicOpEnable);
+            hash_u32(s, cb->logicOp);
+            hash_array(s, cb->pAttachments, cb->attachmentCount,
+                       sizeof(cb->pAttachments[0]));
+            hash_array(s, cb->blendConstants, 4, sizeof(float));
+        }
+    }
+
+    if (hash_present(s, dy)) {
+        if (dy->pNext)
+            return false;
+
+        hash_u32(s, dy->flags);
+        hash_array(s, dy->pDynamicStates, dy->dynamicStateCount,
+                   sizeof(dy->pDynamicStates[0]));
+    }
+
+    if (!get_fingerprint(dd, OBJECT_PIPELINE_LAYOUT,
+                         (uint64_t) info->layout, &fp))
+        return false;
+    hash_fp(s, fp);
+
+    if (!get_fingerprint(dd, OBJECT_RENDER_PASS,
+                         (uint64_t) info->renderPass, &fp))
+        return false;
+    hash_fp(s, fp);
+    hash_u32(s, info->subpass);
+
+    return true;
+}
+
+static bool
+hash_compute(qo_pipeline_dedup_t *dd, cru_hash128_state_t *s,
+             const VkComputePipelineCreateInfo *info)
+{
+    cru_hash128_t fp;
+
+    if (info->pNext || (info->flags & VK_PIPELINE_CREATE_DERIVATIVE_BIT))
+        return false;
+
+    hash_u32(s, VK_PIPELINE_BIND_POINT_COMPUTE);
+    hash_u32(s, info->flags);
+
+    if (!hash_stage(dd, s, &info->stage))
+        return false;
+
+    if (!get_fingerprint(dd, OBJECT_PIPELINE_LAYOUT,
+                         (uint64_t) info->layout, &fp))
+        return false;
+    hash_fp(s, fp);
+
+    return true;
+}
+
+static bool
+uses_other_cache(qo_pipeline_dedup_t *dd, VkPipelineCache pipeline_cache)
+{
+    return pipeline_cache != VK_NULL_HANDLE &&
+           pipeline_cache != dd->pipeline_cache;
+}
+
+bool
+qo_pipeline_dedup_key_graphics(qo_pipeline_dedup_t *dd,
+                               VkPipelineCache pipeline_cache,
+                               const VkGraphicsPipelineCreateInfo *info,
+                               cru_hash128_t *key)
+{
+    cru_hash128_state_t s;
+    bool ok;
+
+    if (uses_other_cache(dd, pipeline_cache))
+        return false;
+
+    cru_hash128_init(&s, 0);
+
+    pthread_mutex_lock(&dd->mutex);
+    ok = hash_graphics(dd, &s, info);
+    pthread_mutex_unlock(&dd->mutex);
+
+    if (ok)
+        *key = cru_hash128_final(&s);
+
+    return ok;
+}
+
+bool
+qo_pipeline_dedup_key_compute(qo_pipeline_dedup_t *dd,
+                              VkPipelineCache pipeline_cache,
+                              const VkComputePipelineCreateInfo *info,
+                              cru_hash128_t *key)
+{
+    cru_hash128_state_t s;
+    bool ok;
+
+    if (uses_other_cache(dd, pipeline_cache))
+        return false;
+
+    cru_hash128_init(&s, 0);
+
+    pthread_mutex_lock(&dd->mutex);
+    ok = hash_compute(dd, &s, info);
+    pthread_mutex_unlock(&dd->mutex);
+
+    if (ok)
+        *key = cru_hash128_final(&s);
+
+    return ok;
+}
+
+VkPipeline
+qo_pipeline_dedup_lookup(qo_pipeline_dedup_t *dd, cru_hash128_t key)
+{
+    const struct table_entry *e;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+
+    pthread_mutex_lock(&dd->mutex);
+
+    e = table_find(&dd->pipelines, key);
+    if (e) {
+        pipeline = (VkPipeline) e->value.h[0];
+        dd->stats.hits++;
+    } else {
+        dd->stats.misses++;
+    }
+
+    pthread_mutex_unlock(&dd->mutex);
+
+    return pipeline;
+}
+
+void
+qo_pipeline_dedup_insert(qo_pipeline_dedup_t *dd, cru_hash128_t key,
+                         VkPipeline pipeline)
+{
+    pthread_mutex_lock(&dd->mutex);
+
+    if (!table_find(&dd->pipelines, key)) {
+        table_set(&dd->pipelines, key,
+                  (cru_hash128_t) { .h = { (uint64_t) pipeline, 0 } }, true);
+    }
+
+    pthread_mutex_unlock(&dd->mutex);
+}
+
+void
+qo_pipeline_dedup_add_uncached(qo_pipeline_dedup_t *dd)
+{
+    pthread_mutex_lock(&dd->mutex);
+    dd->stats.uncached++;
+    pthread_mutex_unlock(&dd->mutex);
+}
@@ -0,0 +1,662 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "qonos/qonos_stats.h"
+#include "qonos/qonos_staging.h"
+#include "util/cru_format.h"
+#include "util/log.h"
+#include "util/misc.h"
+#include "util/xalloc.h"
+
+/// Largest chunk, so that several chunks fit in the ring at once.
+#define STAGING_CHUNK_SIZE (QO_STAGING_SIZE / 4)
+
+/// Alignment of the chunks of buffer uploads. Buffer-to-buffer copies have
+/// no alignment requirement; this merely keeps the chunks word-aligned.
+#define STAGING_BUFFER_ALIGNMENT 4
+
+struct staging_submit {
+    VkCommandBuffer cmd;
+    VkFence fence;
+
+    /// The fence was submitted and must be reset before its next submission.
+    bool fence_used;
+
+    /// The ring's head after this chunk was allocated. Once the chunk
+    /// completes, the ring is free up to here.
+    VkDeviceSize ring_end;
+
+    /// For downloads, where to copy the chunk once it completes.
+    void *readback_dst;
+    VkDeviceSize readback_offset;
+    VkDeviceSize readback_size;
+};
+
+struct qo_staging {
+    VkDevice device;
+    uint32_t queue_family;
+    VkPhysicalDeviceMemoryProperties mem_props;
+
+    /// Created by the first transfer.
+    VkBuffer buffer;
+    VkDeviceMemory memory;
+    uint8_t *map;
+    VkCommandPool pool;
+
+    /// Chunks in flight, oldest first, in a circular queue.
+    struct staging_submit submits[QO_STAGING_MAX_SUBMITS];
+    uint32_t first_pending;
+    uint32_t num_pending;
+
+    /// The ring is in use from \a tail up to \a head, wrapping around at
+    /// QO_STAGING_SIZE. It is empty when no chunk is pending.
+    VkDeviceSize head;
+    VkDeviceSize tail;
+};
+
+qo_staging_t *
+qo_staging_create(VkDevice dev, uint32_t queue_family,
+                  const VkPhysicalDeviceMemoryProperties *mem_props)
+{
+    qo_staging_t *st = xzalloc(sizeof(*st));
+
+    st->device = dev;
+    st->queue_family = queue_family;
+    st->mem_props = *mem_props;
+
+    return st;
+}
+
+static VkResult retire_all(qo_staging_t *st);
+
+void
+qo_staging_destroy(qo_staging_t *st)
+{
+    if (!st)
+        return;
+
+    retire_all(st);
+
+    for (uint32_t i = 0; i < QO_STAGING_MAX_SUBMITS; i++) {
+        if (st->submits[i].fence)
+            vkDestroyFence(st->device, st->submits[i].fence, NULL);
+    }
+
+    // Destroying the pool frees its command buffers.
+    if (st->pool)
+        vkDestroyCommandPool(st->device, st->pool, NULL);
+    if (st->buffer)
+        vkDestroyBuffer(st->device, st->buffer, NULL);
+    if (st->memory)
+        vkFreeMemory(st->device, st->memory, NULL);
+
+    free(st);
+}
+
+VkDevice
+qo_staging_get_device(qo_staging_t *st)
+{
+    return st->device;
+}
+
+/// Prefer cached memory, which downloads read from.
+static uint32_t
+choose_memory_type(qo_staging_t *st, uint32_t type_bits)
+{
+    const VkMemoryPropertyFlags required =
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    uint32_t best = UINT32_MAX;
+
+    for (uint32_t i = 0; i < st->mem_props.memoryTypeCount; i++) {
+        VkMemoryPropertyFlags flags = st->mem_props.memoryTypes[i].propertyFlags;
+
+        if (!(type_bits & (1u << i)) || (flags & required) != required)
+            continue;
+
+        if (flags & VK_MEMORY_PROPERTY_HOST_CACHED_BIT)
+            return i;
+
+        if (best == UINT32_MAX)
+            best = i;
+    }
+
+    return best;
+}
+
+static VkResult
+init_ring(qo_staging_t *st)
+{
+    VkMemoryRequirements reqs;
+    uint32_t type;
+    void *map;
+    VkResult result;
+
+    if (st->buffer)
+        return VK_SUCCESS;
+
+    result = vkCreateCommandPool(st->device,
+        &(VkCommandPoolCreateInfo) {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT |
+                     VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+            .queueFamilyIndex = st->queue_family,
+        }, NULL, &st->pool);
+    if (result != VK_SUCCESS)
+        goto fail;
+
+    result = vkCreateBuffer(st->device,
+        &(VkBufferCreateInfo) {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+            .size = QO_STAGING_SIZE,
+            .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                     VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        }, NULL, &st->buffer);
+    if (result != VK_SUCCESS)
+        goto fail;
+
+    vkGetBufferMemoryRequirements(st->device, st->buffer, &reqs);
+    type = choose_memory_type(st, reqs.memoryTypeBits);
+    if (type == UINT32_MAX) {
+        loge("%s: no host-visible, host-coherent memory type", __func__);
+        result = VK_ERROR_FEATURE_NOT_PRESENT;
+        goto fail;
+    }
+
+    result = vkAllocateMemory(st->device,
+        &(VkMemoryAllocateInfo) {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            .allocationSize = reqs.size,
+            .memoryTypeIndex = type,
+        }, NULL, &st->memory);
+    if (result != VK_SUCCESS)
+        goto fail;
+
+    result = vkBindBufferMemory(st->device, st->buffer, st->memory, 0);
+    if (result != VK_SUCCESS)
+        goto fail;
+
+    result = vkMapMemory(st->device, st->memory, 0, VK_WHOLE_SIZE, 0, &map);
+    if (result != VK_SUCCESS)
+        goto fail;
+
+    st->map = map;
+    return VK_SUCCESS;
+
+fail:
+    loge("%s: failed to create staging buffer", __func__);
+
+    if (st->memory)
+        vkFreeMemory(st->device, st->memory, NULL);
+    if (st->buffer)
+        vkDestroyBuffer(st->device, st->buffer, NULL);
+    if (st->pool)
+        vkDestroyCommandPool(st->device, st->pool, NULL);
+
+    st->memory = VK_NULL_HANDLE;
+    st->buffer = VK_NULL_HANDLE;
+    st->pool = VK_NULL_HANDLE;
+
+    return result;
+}
+
+/// Wait for the oldest chunk in flight and reclaim its space.
+static VkResult
+retire_oldest(qo_staging_t *st)
+{
+    struct staging_submit *s = &st->submits[st->first_pending];
+    VkResult result;
+
+    result = vkWaitForFences(st->device, 1, &s->fence, VK_TRUE, UINT64_MAX);
+    if (result != VK_SUCCESS)
+        return result;
+
+    if (s->readback_dst) {
+        memcpy(s->readback_dst, st->map + s->readback_offset,
+               s->readback_size);
+        s->readback_dst = NULL;
+    }
+
+    st->tail = s->ring_end;
+    st->first_pending = (st->first_pending + 1) % QO_STAGING_MAX_SUBMITS;
+    st->num_pending--;
+
+    return VK_SUCCESS;
+}
+
+static VkResult
+retire_all(qo_staging_t *st)
+{
+    while (st->num_pending > 0) {
+        VkResult result = retire_oldest(st);
+        if (result != VK_SUCCESS)
+            return result;
+    }
+
+    return VK_SUCCESS;
+}
+
+/// Find \a size free bytes in the ring, at a multiple of \a alignment,
+/// without waiting.
+static bool
+ring_fit(qo_staging_t *st, VkDeviceSize size, VkDeviceSize alignment,
+         VkDeviceSize *offset)
+{
+    VkDeviceSize start;
+
+    if (st->num_pending == 0)
+        st->head = st->tail = 0;
+
+    start = cru_round_up_size(st->head, alignment);
+
+    if (st->num_pending == 0 || st->head > st->tail) {
+        // Free space runs from the head to the end, then from the start to
+        // the tail.
+        if (start + size <= QO_STAGING_SIZE) {
+            *offset = start;
+            return true;
+        }
+
+        if (size <= st->tail) {
+            *offset = 0;
+            return true;
+        }
+
+        return false;
+    }
+
+    // The ring has wrapped; free space runs from the head to the tail. If
+    // they are equal, the ring is full.
+    if (st->head < st->tail && start + size <= st->tail) {
+        *offset = start;
+        return true;
+    }
+
+    return false;
+}
+
+/// \brief Start a chunk of \a size bytes.
+///
+/// Get a free submission and ring space at a multiple of \a alignment for
+/// the chunk, waiting for older chunks as needed, and begin the submission's
+/// command buffer.
+static VkResult
+begin_chunk(qo_staging_t *st, VkDeviceSize size, VkDeviceSize alignment,
+            struct staging_submit **submit, VkDeviceSize *offset)
+{
+    struct staging_submit *s;
+    VkResult result;
+
+    assert(size <= STAGING_CHUNK_SIZE);
+
+    result = init_ring(st);
+    if (result != VK_SUCCESS)
+        return result;
+
+    if (st->num_pending == QO_STAGING_MAX_SUBMITS) {
+        result = retire_oldest(st);
+        if (result != VK_SUCCESS)
+            return result;
+    }
+
+    while (!ring_fit(st, size, alignment, offset)) {
+        result = retire_oldest(st);
+        if (result != VK_SUCCESS)
+            return result;
+    }
+
+    s = &st->submits[(st->first_pending + st->num_pending) %
+                     QO_STAGING_MAX_SUBMITS];
+
+    if (!s->cmd) {
+        QO_STATS_CALL(vkAllocateCommandBuffers,
+            result = vkAllocateCommandBuffers(st->device,
+                &(VkCommandBufferAllocateInfo) {
+                    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                    .commandPool = st->pool,
+                    .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                    .commandBufferCount = 1,
+                }, &s->cmd));
+        if (result != VK_SUCCESS)
+            return result;
+
+        result = vkCreateFence(st->device,
+            &(VkFenceCreateInfo) {
+                .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+            }, NULL, &s->fence);
+        if (result != VK_SUCCESS)
+            return result;
+
+        qo_stats_add_object(t_qonos_stats, QO_STATS_OBJECT_COMMAND_BUFFER);
+    }
+
+    // Claim the space now. Until the chunk is submitted, nothing waits on
+    // or resets the ring.
+    st->head = *offset + size;
+    s->ring_end = st->head;
+    s->readback_dst = NULL;
+
+    QO_STATS_CALL(vkBeginCommandBuffer,
+        result = vkBeginCommandBuffer(s->cmd,
+            &(VkCommandBufferBeginInfo) {
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+            }));
+
+    *submit = s;
+    return result;
+}
+
+static VkResult
+end_chunk(qo_staging_t *st, VkQueue queue, struct staging_submit *s)
+{
+    VkResult result;
+
+    QO_STATS_CALL(vkEndCommandBuffer,
+        result = vkEndCommandBuffer(s->cmd));
+    if (result != VK_SUCCESS)
+        return result;
+
+    if (s->fence_used) {
+        result = vkResetFences(st->device, 1, &s->fence);
+        if (result != VK_SUCCESS)
+            return result;
+    }
+
+    QO_STATS_CALL(vkQueueSubmit,
+        result = vkQueueSubmit(queue, 1,
+            &(VkSubmitInfo) {
+                .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                .commandBufferCount = 1,
+                .pCommandBuffers = &s->cmd,
+            }, s->fence));
+    if (result != VK_SUCCESS)
+        return result;
+
+    s->fence_used = true;
+    st->num_pending++;
+
+    return VK_SUCCESS;
+}
+
+/// Order the chunk's transfer after all earlier work on the queue, and all
+/// later work after it.
+static void
+cmd_barrier(VkCommandBuffer cmd, VkPipelineStageFlags src_stage,
+            VkAccessFlags src_access, VkPipelineStageFlags dst_stage,
+            VkAccessFlags dst_access)
+{
+    vkCmdPipelineBarrier(cmd, src_stage, dst_stage, 0, 1,
+        &(VkMemoryBarrier) {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = src_access,
+            .dstAccessMask = dst_access,
+        }, 0, NULL, 0, NULL);
+}
+
+VkResult
+qo_staging_upload_buffer(qo_staging_t *st, VkQueue queue, VkBuffer buffer,
+                         VkDeviceSize offset, VkDeviceSize size,
+                         const void *data)
+{
+    const uint8_t *src = data;
+    VkResult result;
+
+    for (VkDeviceSize done = 0; done < size; ) {
+        VkDeviceSize chunk = MIN(size - done, STAGING_CHUNK_SIZE);
+        struct staging_submit *s;
+        VkDeviceSize ring_offset;
+
+        result = begin_chunk(st, chunk, STAGING_BUFFER_ALIGNMENT, &s,
+                             &ring_offset);
+        if (result != VK_SUCCESS)
+            return result;
+
+        memcpy(st->map + ring_offset, src + done, chunk);
+
+        cmd_barrier(s->cmd,
+                    VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                    VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    VK_ACCESS_TRANSFER_WRITE_BIT);
+        vkCmdCopyBuffer(s->cmd, st->buffer, buffer, 1,
+            &(VkBufferCopy) {
+                .srcOffset = ring_offset,
+                .dstOffset = offset + done,
+                .size = chunk,
+            });
+        cmd_barrier(s->cmd,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    VK_ACCESS_TRANSFER_WRITE_BIT,
+                    VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                    VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT);
+
+        result = end_chunk(st, queue, s);
+        if (result != VK_SUCCESS)
+            return result;
+
+        done += chunk;
+    }
+
+    return VK_SUCCESS;
+}
+
+/// Bytes per texel of buffer copies of the depth and stencil aspects. They
+/// follow the Vulkan spec's packing for buffer copies rather than the texel
+/// size of the aspect's format; notably, each D24 depth value takes 4 bytes.
+static const struct {
+    VkFormat format;
+    VkImageAspectFlags aspect;
+    uint32_t copy_size;
+} ds_copy_sizes[] = {
+    { VK_FORMAT_D16_UNORM,           VK_IMAGE_ASPECT_DEPTH_BIT,   2 },
+    { VK_FORMAT_X8_D24_UNORM_PACK32, VK_IMAGE_ASPECT_DEPTH_BIT,   4 },
+    { VK_FORMAT_D32_SFLOAT,          VK_IMAGE_ASPECT_DEPTH_BIT,   4 },
+    { VK_FORMAT_S8_UINT,             VK_IMAGE_ASPECT_STENCIL_BIT, 1 },
+    { VK_FORMAT_D16_UNORM_S8_UINT,   VK_IMAGE_ASPECT_DEPTH_BIT,   2 },
+    { VK_FORMAT_D16_UNORM_S8_UINT,   VK_IMAGE_ASPECT_STENCIL_BIT, 1 },
+    { VK_FORMAT_D24_UNORM_S8_UINT,   VK_IMAGE_ASPECT_DEPTH_BIT,   4 },
+    { VK_FORMAT_D24_UNORM_S8_UINT,   VK_IMAGE_ASPECT_STENCIL_BIT, 1 },
+    { VK_FORMAT_D32_SFLOAT_S8_UINT,  VK_IMAGE_ASPECT_DEPTH_BIT,   4 },
+    { VK_FORMAT_D32_SFLOAT_S8_UINT,  VK_IMAGE_ASPECT_STENCIL_BIT, 1 },
+};
+
+/// Size and extent of the texel blocks that buffer copies of \a aspect of
+/// \a format use.
+static bool
+get_texel_block(VkFormat format, VkImageAspectFlags aspect,
+                uint32_t *block_width, uint32_t *block_height,
+                uint32_t *block_size)
+{
+    const struct cru_format_info *info = cru_format_get_info(format);
+
+    if (!info)
+        return false;
+
+    *block_width = 1;
+    *block_height = 1;
+
+    switch (aspect) {
+    case VK_IMAGE_ASPECT_DEPTH_BIT:
+    case VK_IMAGE_ASPECT_STENCIL_BIT:
+        for (uint32_t i = 0; i < ARRAY_LENGTH(ds_copy_sizes); i++) {
+            if (ds_copy_sizes[i].format == format &&
+                ds_copy_sizes[i].aspect == aspect) {
+                *block_size = ds_copy_sizes[i].copy_size;
+                return true;
+            }
+        }
+        return false;
+    case VK_IMAGE_ASPECT_COLOR_BIT:
+        if (info->block_size > 0) {
+            *block_width = info->block_width;
+            *block_height = info->block_height;
+            *block_size = info->block_size;
+        } else {
+            *block_size = info->cpp;
+        }
+        return *block_size > 0;
+    default:
+        return false;
+    }
+}
+
+/// Copy \a region of the image in chunks of whole rows. Uploads fill each
+/// chunk from \a upload_data; downloads copy each chunk to
+/// \a download_data once it completes.
+static VkResult
+transfer_image(qo_staging_t *st, VkQueue queue, VkImage image,
+               VkFormat format, VkImageLayout layout,
+               const VkBufferImageCopy *region, const void *upload_data,
+               void *download_data)
+{
+    const VkImageSubresourceLayers *sub = &region->imageSubresource;
+    uint32_t block_width, block_height, block_size;
+    VkResult result;
+
+    if (!get_texel_block(format, sub->aspectMask, &block_width,
+                         &block_height, &block_size)) {
+        loge("%s: unsupported format or aspect", __func__);
+        return VK_ERROR_FORMAT_NOT_SUPPORTED;
+    }
+
+    const uint32_t width = region->imageExtent.width;
+    const uint32_t height = region->imageExtent.height;
+    const uint32_t depth = region->imageExtent.depth;
+    const uint32_t block_rows = (height + block_height - 1) / block_height;
+    const VkDeviceSize row_size =
+        (VkDeviceSize) ((width + block_width - 1) / block_width) * block_size;
+
+    if (row_size > STAGING_CHUNK_SIZE) {
+        loge("%s: image row of %"PRIu64" bytes does not fit in a chunk",
+             __func__, row_size);
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    // vkCmdCopyBufferToImage requires buffer offsets that are multiples of 4
+    // and of the texel block size.
+    const VkDeviceSize alignment = cru_lcm_size(4, block_size);
+    const uint32_t rows_per_chunk = STAGING_CHUNK_SIZE / row_size;
+    VkDeviceSize data_offset = 0;
+
+    for (uint32_t layer = 0; layer < sub->layerCount; layer++) {
+        for (uint32_t z = 0; z < depth; z++) {
+            for (uint32_t row = 0; row < block_rows; row += rows_per_chunk) {
+                const uint32_t rows = MIN(block_rows - row, rows_per_chunk);
+                const VkDeviceSize chunk = rows * row_size;
+                struct staging_submit *s;
+                VkDeviceSize ring_offset;
+
+                result = begin_chunk(st, chunk, alignment, &s,
+                                     &ring_offset);
+                if (result != VK_SUCCESS)
+                    return result;
+
+                const VkBufferImageCopy copy = {
+                    .bufferOffset = ring_offset,
+                    .imageSubresource = {
+                        .aspectMask = sub->aspectMask,
+                        .mipLevel = sub->mipLevel,
+                        .baseArrayLayer = sub->baseArrayLayer + layer,
+                        .layerCount = 1,
+                    },
+                    .imageOffset = {
+                        .x = region->imageOffset.x,
+                        .y = region->imageOffset.y + row * block_height,
+                        .z = region->imageOffset.z + z,
+                    },
+                    .imageExtent = {
+                        .width = width,
+                        .height = MIN(height - row * block_height,
+                                      rows * block_height),
+                        .depth = 1,
+                    },
+                };
+
+                cmd_barrier(s->cmd,
+                            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                            VK_ACCESS_MEMORY_READ_BIT |
+                            VK_ACCESS_MEMORY_WRITE_BIT,
+                            VK_PIPELINE_STAGE_TRANSFER_BIT,
+                            VK_ACCESS_TRANSFER_READ_BIT |
+                            VK_ACCESS_TRANSFER_WRITE_BIT);
+
+                if (upload_data) {
+                    memcpy(st->map + ring_offset,
+                           (const uint8_t *) upload_data + data_offset, chunk);
+                    vkCmdCopyBufferToImage(s->cmd, st->buffer, image, layout,
+                                           1, &copy);
+                    cmd_barrier(s->cmd,
+                                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                VK_ACCESS_TRANSFER_WRITE_BIT,
+                                VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                                VK_ACCESS_MEMORY_READ_BIT |
+                                VK_ACCESS_MEMORY_WRITE_BIT);
+                } else {
+                    vkCmdCopyImageToBuffer(s->cmd, image, layout, st->buffer,
+                                           1, &copy);
+                    cmd_barrier(s->cmd,
+                                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                VK_ACCESS_TRANSFER_WRITE_BIT,
+                                VK_PIPELINE_STAGE_HOST_BIT,
+                                VK_ACCESS_HOST_READ_BIT);
+                    s->readback_dst = (uint8_t *) download_data + data_offset;
+                    s->readback_offset = ring_offset;
+                    s->readback_size = chunk;
+                }
+
+                result = end_chunk(st, queue, s);
+                if (result != VK_SUCCESS)
+                    return result;
+
+                data_offset += chunk;
+            }
+        }
+    }
+
+    if (download_data)
+        return retire_all(st);
+
+    return VK_SUCCESS;
+}
+
+VkResult
+qo_staging_upload_image(qo_staging_t *st, VkQueue queue, VkImage image,
+                        VkFormat format, VkImageLayout layout,
+                        const VkBufferImageCopy *region, const void *data)
+{
+    return transfer_image(st, queue, image, format, layout, region,
+                          data, NULL);
+}
+
+VkResult
+qo_staging_download_image(qo_staging_t *st, VkQueue queue, VkImage image,
+                          VkFormat format, VkImageLayout layout,
+                          const VkBufferImageCopy *region, void *data)
+{
+    return transfer_image(st, queue, image, format, layout, region,
+                          NULL, data);
+}
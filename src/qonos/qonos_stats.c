@@ -0,0 +1,228 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <inttypes.h>
+
+#include "qonos/qonos_stats.h"
+#include "util/log.h"
+#include "util/misc.h"
+#include "util/xalloc.h"
+
+/// \brief Counters of one test.
+///
+/// Every counter is updated with relaxed atomics, so that instrumented calls
+/// on several threads never serialize on the counters. qo_stats_log() runs
+/// after all test threads have stopped.
+struct qo_stats {
+    uint64_t object_count[QO_STATS_NUM_OBJECT_TYPES];
+
+    struct {
+        uint64_t call_count;
+        uint64_t total_ns;
+    } entrypoint[QO_STATS_NUM_ENTRYPOINTS];
+
+    struct {
+        uint64_t alloc_count;
+
+        /// Sum of the sizes of all allocations, including freed ones.
+        uint64_t total_bytes;
+
+        /// Bytes currently allocated, and the maximum of that. Only
+        /// allocations whose free Qonos observes are counted; see
+        /// qo_stats_add_live_memory().
+        uint64_t live_bytes;
+        uint64_t peak_bytes;
+    } heap[VK_MAX_MEMORY_HEAPS];
+
+    struct {
+        uint64_t hits;
+        uint64_t misses;
+    } cache[QO_STATS_NUM_CACHES];
+};
+
+static const char *const object_type_names[] = {
+#define QO_STATS_OBJECT_TYPE_NAME(name, vk_type) [QO_STATS_OBJECT_##name] = #vk_type,
+    QO_STATS_OBJECT_TYPES(QO_STATS_OBJECT_TYPE_NAME)
+#undef QO_STATS_OBJECT_TYPE_NAME
+};
+
+static const char *const cache_names[] = {
+#define QO_STATS_CACHE_NAME(name, str) [QO_STATS_CACHE_##name] = str,
+    QO_STATS_CACHES(QO_STATS_CACHE_NAME)
+#undef QO_STATS_CACHE_NAME
+};
+
+static const char *const entrypoint_names[] = {
+#define QO_STATS_ENTRYPOINT_NAME(name) [QO_STATS_ENTRYPOINT_##name] = #name,
+    QO_STATS_ENTRYPOINTS(QO_STATS_ENTRYPOINT_NAME)
+#undef QO_STATS_ENTRYPOINT_NAME
+};
+
+static inline void
+counter_add(uint64_t *counter, uint64_t n)
+{
+    __atomic_fetch_add(counter, n, __ATOMIC_RELAXED);
+}
+
+static inline uint64_t
+counter_get(const uint64_t *counter)
+{
+    return __atomic_load_n(counter, __ATOMIC_RELAXED);
+}
+
+qo_stats_t *
+qo_stats_create(void)
+{
+    return xzalloc(sizeof(qo_stats_t));
+}
+
+void
+qo_stats_destroy(qo_stats_t *stats)
+{
+    free(stats);
+}
+
+void
+qo_stats_add_object(qo_stats_t *stats, qo_stats_object_type_t type)
+{
+    if (!stats)
+        return;
+
+    assert(type < QO_STATS_NUM_OBJECT_TYPES);
+
+    counter_add(&stats->object_count[type], 1);
+}
+
+void
+qo_stats_add_call(qo_stats_t *stats, qo_stats_entrypoint_t entrypoint,
+                  uint64_t duration_ns)
+{
+    if (!stats)
+        return;
+
+    assert(entrypoint < QO_STATS_NUM_ENTRYPOINTS);
+
+    counter_add(&stats->entrypoint[entrypoint].call_count, 1);
+    counter_add(&stats->entrypoint[entrypoint].total_ns, duration_ns);
+}
+
+void
+qo_stats_add_memory(qo_stats_t *stats, uint32_t heap, VkDeviceSize size)
+{
+    if (!stats)
+        return;
+
+    assert(heap < VK_MAX_MEMORY_HEAPS);
+
+    counter_add(&stats->heap[heap].alloc_count, 1);
+    counter_add(&stats->heap[heap].total_bytes, size);
+}
+
+void
+qo_stats_add_live_memory(qo_stats_t *stats, uint32_t heap, VkDeviceSize size)
+{
+    if (!stats)
+        return;
+
+    assert(heap < VK_MAX_MEMORY_HEAPS);
+
+    uint64_t live = __atomic_add_fetch(&stats->heap[heap].live_bytes, size,
+                                       __ATOMIC_RELAXED);
+    uint64_t peak = counter_get(&stats->heap[heap].peak_bytes);
+
+    while (peak < live &&
+           !__atomic_compare_exchange_n(&stats->heap[heap].peak_bytes, &peak,
+                                        live, /*weak*/ true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+void
+qo_stats_remove_live_memory(qo_stats_t *stats, uint32_t heap,
+                            VkDeviceSize size)
+{
+    if (!stats)
+        return;
+
+    assert(heap < VK_MAX_MEMORY_HEAPS);
+
+    uint64_t old = __atomic_fetch_sub(&stats->heap[heap].live_bytes, size,
+                                      __ATOMIC_RELAXED);
+    assert(old >= size);
+    (void) old;
+}
+
+void
+qo_stats_add_cache_lookup(qo_stats_t *stats, qo_stats_cache_t cache,
+                          bool hit)
+{
+    if (!stats)
+        return;
+
+    assert(cache < QO_STATS_NUM_CACHES);
+
+    if (hit)
+        counter_add(&stats->cache[cache].hits, 1);
+    else
+        counter_add(&stats->cache[cache].misses, 1);
+}
+
+void
+qo_stats_log(qo_stats_t *stats, const char *name)
+{
+    if (!stats)
+        return;
+
+    for (uint32_t i = 0; i < QO_STATS_NUM_OBJECT_TYPES; i++) {
+        if (stats->object_count[i] == 0)
+            continue;
+
+        logi("%s: qonos: created %"PRIu64" %s", name,
+             stats->object_count[i], object_type_names[i]);
+    }
+
+    for (uint32_t i = 0; i < VK_MAX_MEMORY_HEAPS; i++) {
+        if (stats->heap[i].alloc_count == 0)
+            continue;
+
+        logi("%s: qonos: heap %u: %"PRIu64" allocations, "
+             "%"PRIu64" bytes total, %"PRIu64" bytes peak", name, i,
+             stats->heap[i].alloc_count, stats->heap[i].total_bytes,
+             stats->heap[i].peak_bytes);
+    }
+
+    for (uint32_t i = 0; i < QO_STATS_NUM_CACHES; i++) {
+        if (stats->cache[i].hits + stats->cache[i].misses == 0)
+            continue;
+
+        logi("%s: qonos: %s cache: %"PRIu64" hits, %"PRIu64" misses", name,
+             cache_names[i], stats->cache[i].hits, stats->cache[i].misses);
+    }
+
+    for (uint32_t i = 0; i < QO_STATS_NUM_ENTRYPOINTS; i++) {
+        if (stats->entrypoint[i].call_count == 0)
+            continue;
+
+        logi("%s: qonos: %s: %"PRIu64" calls, %.3f ms", name,
+             entrypoint_names[i], stats->entrypoint[i].call_count,
+             stats->entrypoint[i].total_ns / 1e6);
+    }
+}
@@ -0,0 +1,262 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <pthread.h>
+
+#include "qonos/qonos_stats.h"
+#include "qonos/qonos_suballoc.h"
+#include "util/log.h"
+#include "util/misc.h"
+#include "util/xalloc.h"
+
+struct qo_suballoc_block {
+    VkDeviceMemory memory;
+    uint32_t memory_type;
+    VkDeviceSize size;
+
+    /// Offset of the first free byte.
+    VkDeviceSize top;
+
+    /// The range just below \a top belongs to an image.
+    bool top_is_image;
+
+    /// The block holds a single dedicated range.
+    bool dedicated;
+
+    /// Mapping of the whole block, or NULL if not yet mapped.
+    void *map;
+};
+
+struct qo_suballoc {
+    VkDevice device;
+    VkPhysicalDeviceMemoryProperties mem_props;
+    VkDeviceSize granularity;
+
+    /// The test's instrumentation, captured at creation so that freeing the
+    /// blocks does not depend on which thread destroys the suballocator.
+    qo_stats_t *stats;
+
+    pthread_mutex_t mutex;
+
+    struct qo_suballoc_block *blocks;
+    uint32_t num_blocks;
+    uint32_t max_blocks;
+};
+
+qo_suballoc_t *
+qo_suballoc_create(VkDevice dev,
+                   const VkPhysicalDeviceMemoryProperties *mem_props,
+                   VkDeviceSize buffer_image_granularity)
+{
+    qo_suballoc_t *sa = xzalloc(sizeof(*sa));
+
+    if (pthread_mutex_init(&sa->mutex, NULL) != 0) {
+        loge("%s: failed to init mutex", __func__);
+        free(sa);
+        return NULL;
+    }
+
+    sa->device = dev;
+    sa->mem_props = *mem_props;
+    sa->granularity = MAX(buffer_image_granularity, 1);
+    sa->stats = t_qonos_stats;
+
+    return sa;
+}
+
+void
+qo_suballoc_destroy(qo_suballoc_t *sa)
+{
+    if (!sa)
+        return;
+
+    for (uint32_t i = 0; i < sa->num_blocks; i++) {
+        const struct qo_suballoc_block *block = &sa->blocks[i];
+        const uint32_t heap =
+            sa->mem_props.memoryTypes[block->memory_type].heapIndex;
+
+        // Freeing the memory also unmaps it.
+        vkFreeMemory(sa->device, block->memory, NULL);
+        qo_stats_remove_live_memory(sa->stats, heap, block->size);
+    }
+
+    free(sa->blocks);
+    pthread_mutex_destroy(&sa->mutex);
+    free(sa);
+}
+
+VkDevice
+qo_suballoc_get_device(qo_suballoc_t *sa)
+{
+    return sa->device;
+}
+
+static VkDeviceSize
+block_size_for_type(const qo_suballoc_t *sa, uint32_t memory_type)
+{
+    const uint32_t heap = sa->mem_props.memoryTypes[memory_type].heapIndex;
+
+    // Don't let a single block claim a large share of a small heap.
+    return MIN(QO_SUBALLOC_BLOCK_SIZE, sa->mem_props.memoryHeaps[heap].size / 8);
+}
+
+/// Return the offset at which \a block would place the range, or UINT64_MAX
+/// if the range does not fit.
+static VkDeviceSize
+block_fit(const qo_suballoc_t *sa, const struct qo_suballoc_block *block,
+          const VkMemoryRequirements *mem_reqs, bool is_image)
+{
+    VkDeviceSize alignment = MAX(mem_reqs->alignment, 1);
+
+    // An image must not share a granularity page with anything, and nothing
+    // may follow an image on the image's last page.
+    if (is_image || block->top_is_image)
+        alignment = MAX(alignment, sa->granularity);
+
+    const VkDeviceSize offset = cru_align_size(block->top, alignment);
+    if (offset > block->size || block->size - offset < mem_reqs->size)
+        return UINT64_MAX;
+
+    return offset;
+}
+
+static struct qo_suballoc_block *
+add_block(qo_suballoc_t *sa, uint32_t memory_type, VkDeviceSize size,
+          bool dedicated)
+{
+    VkDeviceMemory memory;
+    VkResult result;
+
+    result = __qoAllocMemoryCanFail(sa->device,
+        &(VkMemoryAllocateInfo) {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            .allocationSize = size,
+            .memoryTypeIndex = memory_type,
+        }, &memory);
+    if (result != VK_SUCCESS)
+        return NULL;
+
+    // qo_suballoc_destroy() frees the block.
+    qo_stats_add_live_memory(sa->stats,
+                             sa->mem_props.memoryTypes[memory_type].heapIndex,
+                             size);
+
+    if (sa->num_blocks == sa->max_blocks) {
+        sa->max_blocks = MAX(2 * sa->max_blocks, 16);
+        sa->blocks = xreallocn(sa->blocks, sa->max_blocks,
+                               sizeof(sa->blocks[0]));
+    }
+
+    struct qo_suballoc_block *block = &sa->blocks[sa->num_blocks++];
+    *block = (struct qo_suballoc_block) {
+        .memory = memory,
+        .memory_type = memory_type,
+        .size = size,
+        .dedicated = dedicated,
+    };
+
+    return block;
+}
+
+bool
+qo_suballoc_alloc(qo_suballoc_t *sa, uint32_t memory_type,
+                  const VkMemoryRequirements *mem_reqs, bool is_image,
+                  bool dedicated, QoMemoryRange *range)
+{
+    const VkDeviceSize block_size = block_size_for_type(sa, memory_type);
+    struct qo_suballoc_block *block = NULL;
+    VkDeviceSize offset = 0;
+
+    if (mem_reqs->size > block_size / 2)
+        dedicated = true;
+
+    pthread_mutex_lock(&sa->mutex);
+
+    if (dedicated) {
+        block = add_block(sa, memory_type, mem_reqs->size, true);
+    } else {
+        // Blocks are few, so a first-fit walk over all of them is cheap and
+        // lets small ranges fill the tail of older blocks.
+        for (uint32_t i = 0; i < sa->num_blocks; i++) {
+            struct qo_suballoc_block *b = &sa->blocks[i];
+            if (b->dedicated || b->memory_type != memory_type)
+                continue;
+
+            offset = block_fit(sa, b, mem_reqs, is_image);
+            if (offset != UINT64_MAX) {
+                block = b;
+                break;
+            }
+        }
+
+        if (!block) {
+            block = add_block(sa, memory_type, block_size, false);
+            offset = 0;
+        }
+    }
+
+    if (block) {
+        block->top = offset + mem_reqs->size;
+        block->top_is_image = is_image;
+
+        *range = (QoMemoryRange) {
+            .memory = block->memory,
+            .offset = offset,
+            .size = mem_reqs->size,
+        };
+    }
+
+    pthread_mutex_unlock(&sa->mutex);
+
+    return block != NULL;
+}
+
+void *
+qo_suballoc_map(qo_suballoc_t *sa, const QoMemoryRange *range)
+{
+    void *map = NULL;
+
+    pthread_mutex_lock(&sa->mutex);
+
+    for (uint32_t i = 0; i < sa->num_blocks; i++) {
+        struct qo_suballoc_block *block = &sa->blocks[i];
+        if (block->memory != range->memory)
+            continue;
+
+        if (!block->map) {
+            VkResult result;
+
+            QO_STATS_CALL(vkMapMemory,
+                result = vkMapMemory(sa->device, block->memory, 0,
+                                     VK_WHOLE_SIZE, 0, &block->map));
+            if (result != VK_SUCCESS)
+                block->map = NULL;
+        }
+
+        if (block->map)
+            map = (uint8_t *) block->map + range->offset;
+        break;
+    }
+
+    pthread_mutex_unlock(&sa->mutex);
+
+    return map;
+}
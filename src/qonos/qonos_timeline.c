@@ -0,0 +1,266 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <inttypes.h>
+#include <stdlib.h>
+
+#include "qonos/qonos_stats.h"
+#include "qonos/qonos_timeline.h"
+#include "util/log.h"
+#include "util/misc.h"
+#include "util/xalloc.h"
+
+struct qo_timeline_batch {
+    /// Index of the batch's first command buffer in qo_timeline::cmds.
+    uint32_t first_cmd;
+    uint32_t cmd_count;
+    uint64_t value;
+};
+
+struct qo_timeline {
+    VkDevice device;
+    VkQueue queue;
+    qo_cmd_ring_t *ring;
+    VkSemaphore semaphore;
+
+    PFN_vkWaitSemaphores wait_semaphores;
+    PFN_vkGetSemaphoreCounterValue get_counter_value;
+
+    /// Value of the last batch queued, submitted, and known complete.
+    uint64_t last_value;
+    uint64_t submitted_value;
+    uint64_t completed_value;
+
+    struct qo_timeline_batch batches[QO_TIMELINE_MAX_PENDING];
+    uint32_t num_batches;
+
+    /// Command buffers of the pending batches.
+    VkCommandBuffer *cmds;
+    uint32_t num_cmds;
+    uint32_t cmds_capacity;
+};
+
+/// Timeline semaphores are core in Vulkan 1.2 and otherwise come from
+/// VK_KHR_timeline_semaphore.
+static PFN_vkVoidFunction
+get_proc_addr(VkDevice dev, const char *core_name, const char *khr_name)
+{
+    PFN_vkVoidFunction f = vkGetDeviceProcAddr(dev, core_name);
+
+    if (!f)
+        f = vkGetDeviceProcAddr(dev, khr_name);
+
+    return f;
+}
+
+qo_timeline_t *
+qo_timeline_create(VkDevice dev, VkQueue queue, qo_cmd_ring_t *ring)
+{
+    qo_timeline_t *tl = xzalloc(sizeof(*tl));
+    VkResult result;
+
+    tl->device = dev;
+    tl->queue = queue;
+    tl->ring = ring;
+
+    tl->wait_semaphores = (PFN_vkWaitSemaphores)
+        get_proc_addr(dev, "vkWaitSemaphores", "vkWaitSemaphoresKHR");
+    tl->get_counter_value = (PFN_vkGetSemaphoreCounterValue)
+        get_proc_addr(dev, "vkGetSemaphoreCounterValue",
+                      "vkGetSemaphoreCounterValueKHR");
+    if (!tl->wait_semaphores || !tl->get_counter_value) {
+        loge("%s: device does not support timeline semaphores", __func__);
+        free(tl);
+        return NULL;
+    }
+
+    result = vkCreateSemaphore(dev,
+        &(VkSemaphoreCreateInfo) {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+            .pNext = &(VkSemaphoreTypeCreateInfo) {
+                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+                .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+                .initialValue = 0,
+            },
+        }, NULL, &tl->semaphore);
+    if (result != VK_SUCCESS) {
+        loge("%s: failed to create timeline semaphore", __func__);
+        free(tl);
+        return NULL;
+    }
+
+    return tl;
+}
+
+void
+qo_timeline_destroy(qo_timeline_t *tl)
+{
+    if (!tl)
+        return;
+
+    // Wait even if the flush fails, for the batches submitted before it.
+    qo_timeline_flush(tl);
+    if (tl->submitted_value > tl->completed_value) {
+        tl->wait_semaphores(tl->device,
+            &(VkSemaphoreWaitInfo) {
+                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+                .semaphoreCount = 1,
+                .pSemaphores = &tl->semaphore,
+                .pValues = &tl->submitted_value,
+            }, UINT64_MAX);
+    }
+
+    vkDestroySemaphore(tl->device, tl->semaphore, NULL);
+    free(tl->cmds);
+    free(tl);
+}
+
+uint64_t
+qo_timeline_submit(qo_timeline_t *tl, uint32_t cmd_count,
+                   const VkCommandBuffer *cmds, VkResult *result)
+{
+    *result = VK_SUCCESS;
+
+    if (tl->num_batches == QO_TIMELINE_MAX_PENDING) {
+        *result = qo_timeline_flush(tl);
+        if (*result != VK_SUCCESS)
+            return 0;
+    }
+
+    if (tl->num_cmds + cmd_count > tl->cmds_capacity) {
+        tl->cmds_capacity = MAX(2 * tl->cmds_capacity,
+                                tl->num_cmds + cmd_count);
+        tl->cmds = xreallocn(tl->cmds, tl->cmds_capacity,
+                             sizeof(tl->cmds[0]));
+    }
+
+    for (uint32_t i = 0; i < cmd_count; i++)
+        tl->cmds[tl->num_cmds + i] = cmds[i];
+
+    tl->batches[tl->num_batches++] = (struct qo_timeline_batch) {
+        .first_cmd = tl->num_cmds,
+        .cmd_count = cmd_count,
+        .value = ++tl->last_value,
+    };
+    tl->num_cmds += cmd_count;
+
+    return tl->last_value;
+}
+
+VkResult
+qo_timeline_flush(qo_timeline_t *tl)
+{
+    VkSubmitInfo submits[QO_TIMELINE_MAX_PENDING];
+    VkTimelineSemaphoreSubmitInfo values[QO_TIMELINE_MAX_PENDING];
+    VkResult result;
+
+    if (tl->num_batches == 0)
+        return VK_SUCCESS;
+
+    for (uint32_t i = 0; i < tl->num_batches; i++) {
+        const struct qo_timeline_batch *b = &tl->batches[i];
+
+        values[i] = (VkTimelineSemaphoreSubmitInfo) {
+            .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+            .signalSemaphoreValueCount = 1,
+            .pSignalSemaphoreValues = &b->value,
+        };
+        submits[i] = (VkSubmitInfo) {
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .pNext = &values[i],
+            .commandBufferCount = b->cmd_count,
+            .pCommandBuffers = &tl->cmds[b->first_cmd],
+            .signalSemaphoreCount = 1,
+            .pSignalSemaphores = &tl->semaphore,
+        };
+    }
+
+    QO_STATS_CALL(vkQueueSubmit,
+        result = vkQueueSubmit(tl->queue, tl->num_batches, submits,
+                               VK_NULL_HANDLE));
+
+    // Drop the batches even on failure. Resubmitting them would signal
+    // values out of order if some of them did reach the queue.
+    if (result == VK_SUCCESS && tl->ring) {
+        for (uint32_t i = 0; i < tl->num_batches; i++) {
+            const struct qo_timeline_batch *b = &tl->batches[i];
+
+            for (uint32_t j = 0; j < b->cmd_count; j++) {
+                qo_cmd_ring_mark_pending(tl->ring, tl->cmds[b->first_cmd + j],
+                                         tl, b->value);
+            }
+        }
+    }
+
+    if (result == VK_SUCCESS)
+        tl->submitted_value = tl->batches[tl->num_batches - 1].value;
+
+    tl->num_batches = 0;
+    tl->num_cmds = 0;
+
+    return result;
+}
+
+VkResult
+qo_timeline_wait(qo_timeline_t *tl, uint64_t value)
+{
+    VkResult result;
+
+    if (value <= tl->completed_value)
+        return VK_SUCCESS;
+
+    if (value > tl->submitted_value) {
+        result = qo_timeline_flush(tl);
+        if (result != VK_SUCCESS)
+            return result;
+
+        if (value > tl->submitted_value) {
+            loge("%s: value %"PRIu64" was never queued", __func__, value);
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+    }
+
+    QO_STATS_CALL(vkWaitSemaphores,
+        result = tl->wait_semaphores(tl->device,
+            &(VkSemaphoreWaitInfo) {
+                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+                .semaphoreCount = 1,
+                .pSemaphores = &tl->semaphore,
+                .pValues = &value,
+            }, UINT64_MAX));
+    if (result != VK_SUCCESS)
+        return result;
+
+    tl->completed_value = value;
+    return VK_SUCCESS;
+}
+
+uint64_t
+qo_timeline_get_completed(qo_timeline_t *tl)
+{
+    uint64_t value;
+
+    if (tl->completed_value < tl->submitted_value &&
+        tl->get_counter_value(tl->device, tl->semaphore, &value) == VK_SUCCESS)
+        tl->completed_value = MIN(value, tl->submitted_value);
+
+    return tl->completed_value;
+}
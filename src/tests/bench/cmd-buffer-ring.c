@@ -0,0 +1,103 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/// \file
+/// \brief Cost of getting a fresh command buffer for every submission.
+///
+/// Each cycle gets a command buffer, records a small fill into it, and submits
+/// it. The queue is drained every BATCH_SIZE cycles, like a test that waits
+/// for its results now and then. The cycles run once with
+/// qoAllocateCommandBuffer(), which allocates a new command buffer every time,
+/// and once with qoAcquireOneShotCommandBuffer(), which recycles the command
+/// buffers of completed submissions. Both the time spent getting command
+/// buffers and the time of the whole cycle are reported.
+
+#include "tapi/t.h"
+#include "util/misc.h"
+
+#define NUM_CYCLES 4096
+#define BATCH_SIZE 16
+#define BUFFER_SIZE 4096
+
+static VkBuffer
+create_buffer(void)
+{
+    VkBuffer buffer = qoCreateBuffer(t_device, .size = BUFFER_SIZE,
+                                     .usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+    QoMemoryRange mem = qoAllocBufferMemoryRange(t_device, buffer);
+    qoBindBufferMemory(t_device, buffer, mem.memory, mem.offset);
+
+    return buffer;
+}
+
+static void
+run_cycles(VkBuffer buffer, bool use_ring)
+{
+    uint64_t get_ns = 0;
+    uint64_t start = cru_get_time_ns();
+
+    for (uint32_t i = 0; i < NUM_CYCLES; i++) {
+        uint64_t get_start = cru_get_time_ns();
+        VkCommandBuffer cmd;
+
+        if (use_ring)
+            cmd = qoAcquireOneShotCommandBuffer(t_device, t_queue_family);
+        else
+            cmd = qoAllocateCommandBuffer(t_device, t_cmd_pool);
+
+        get_ns += cru_get_time_ns() - get_start;
+
+        qoBeginCommandBuffer(cmd);
+        vkCmdFillBuffer(cmd, buffer, 0, BUFFER_SIZE, i);
+        qoEndCommandBuffer(cmd);
+
+        if (use_ring)
+            qoQueueSubmitRing(t_queue, t_queue_family, cmd);
+        else
+            qoQueueSubmit(t_queue, 1, &cmd, VK_NULL_HANDLE);
+
+        if ((i + 1) % BATCH_SIZE == 0)
+            qoQueueWaitIdle(t_queue);
+    }
+
+    qoQueueWaitIdle(t_queue);
+
+    uint64_t total_ns = cru_get_time_ns() - start;
+
+    logi("%-8s %u cycles: get %.3fus, cycle %.3fus",
+         use_ring ? "ring" : "allocate", NUM_CYCLES,
+         get_ns / 1e3 / NUM_CYCLES, total_ns / 1e3 / NUM_CYCLES);
+}
+
+static void
+test(void)
+{
+    VkBuffer buffer = create_buffer();
+
+    run_cycles(buffer, false);
+    run_cycles(buffer, true);
+}
+
+test_define {
+    .name = "bench.cmd-buffer-ring",
+    .start = test,
+    .no_image = true,
+};
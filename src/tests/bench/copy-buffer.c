@@ -69,6 +69,61 @@ second_to_unit_str(double value)
     return "s";
 }
 
+static void
+record_copy(VkCommandBuffer cmd_buffer, VkBuffer buffer1, VkBuffer buffer2,
+            uint64_t buffer_size, uint64_t cmd_buffer_copy_size,
+            uint64_t single_copy_size, VkQueryPool query,
+            bool first_run, bool last_run)
+{
+    qoBeginCommandBuffer(cmd_buffer);
+
+    if (first_run) {
+        vkCmdResetQueryPool(cmd_buffer, query, 0, 2);
+        vkCmdWriteTimestamp(cmd_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                            query, 0);
+    }
+
+    vkCmdPipelineBarrier(cmd_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 0, 0, NULL, 1,
+        &(VkBufferMemoryBarrier) {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_HOST_READ_BIT,
+            .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .buffer = buffer2,
+            .offset = 0,
+            .size = buffer_size,
+        }, 0, NULL);
+
+    for (uint64_t i = 0; i < cmd_buffer_copy_size; i += single_copy_size) {
+        assert(buffer_size % single_copy_size == 0);
+        uint64_t offset = i % buffer_size;
+        vkCmdCopyBuffer(cmd_buffer, buffer1, buffer2, 1,
+            &(VkBufferCopy) {
+                .srcOffset = offset,
+                .dstOffset = offset,
+                .size = single_copy_size,
+            });
+    }
+
+    vkCmdPipelineBarrier(cmd_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 0, 0, NULL, 1,
+        &(VkBufferMemoryBarrier) {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+            .buffer = buffer2,
+            .offset = 0,
+            .size = buffer_size,
+        }, 0, NULL);
+
+    if (last_run) {
+        vkCmdWriteTimestamp(cmd_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                            query, 1);
+    }
+
+    qoEndCommandBuffer(cmd_buffer);
+}
+
 static void
 test_large_copy(void)
 {
@@ -104,7 +159,15 @@ test_large_copy(void)
     qoBindBufferMemory(t_device, buffer1, mem, 0);
     qoBindBufferMemory(t_device, buffer2, mem, total_buffer_reqs.size / 2);
 
-    VkCommandBuffer cmd_buffer = qoAllocateCommandBuffer(t_device, t_cmd_pool);
+    // Each size queues all of its runs before waiting, so the queue never
+    // drains between runs. Consecutive runs may overlap on the GPU, so a
+    // single pair of timestamps brackets the whole batch: the first run
+    // writes the start and the last run writes the end.
+    qo_timeline_t *timeline = qoCreateTimeline(t_device, t_queue,
+                                               t_queue_family);
+
+    VkCommandBuffer cmd_buffer =
+        qoAcquireOneShotCommandBuffer(t_device, t_queue_family);
     qoBeginCommandBuffer(cmd_buffer);
     vkCmdPipelineBarrier(cmd_buffer, 0, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
                          0, NULL, 2,
@@ -127,7 +190,7 @@ test_large_copy(void)
             },
         }, 0, NULL);
     qoEndCommandBuffer(cmd_buffer);
-    qoQueueSubmit(t_queue, 1, &cmd_buffer, VK_NULL_HANDLE);
+    qoTimelineSubmit(timeline, 1, &cmd_buffer);
 
     VkQueryPool query = qoCreateQueryPool(t_device,
                                           .queryType = VK_QUERY_TYPE_TIMESTAMP,
@@ -141,64 +204,25 @@ test_large_copy(void)
         uint64_t cmd_buffer_copy_size = 1ull << bytes_to_copy_log2;
         uint64_t single_copy_size = 1ull << s;
 
-        cmd_buffer = qoAllocateCommandBuffer(t_device, t_cmd_pool);
-        qoBeginCommandBuffer(cmd_buffer);
-
-        vkCmdWriteTimestamp(cmd_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                            query, 0);
-
-        vkCmdPipelineBarrier(cmd_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                             0, 0, 0, NULL, 1,
-            &(VkBufferMemoryBarrier) {
-                .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
-                .srcAccessMask = VK_ACCESS_HOST_READ_BIT,
-                .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-                .buffer = buffer2,
-                .offset = 0,
-                .size = buffer_size,
-            }, 0, NULL);
-
-        for (uint64_t i = 0; i < cmd_buffer_copy_size; i += single_copy_size) {
-            assert(buffer_size % single_copy_size == 0);
-            uint64_t offset = i % buffer_size;
-            vkCmdCopyBuffer(cmd_buffer, buffer1, buffer2, 1,
-                &(VkBufferCopy) {
-                    .srcOffset = offset,
-                    .dstOffset = offset,
-                    .size = single_copy_size,
-                });
+        uint64_t last_run = 0;
+        for (unsigned run = 0; run < runs_per_size; run++) {
+            cmd_buffer = qoAcquireOneShotCommandBuffer(t_device,
+                                                       t_queue_family);
+            record_copy(cmd_buffer, buffer1, buffer2, buffer_size,
+                        cmd_buffer_copy_size, single_copy_size,
+                        query, run == 0, run == runs_per_size - 1);
+            last_run = qoTimelineSubmit(timeline, 1, &cmd_buffer);
         }
 
-        vkCmdPipelineBarrier(cmd_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                             0, 0, 0, NULL, 1,
-            &(VkBufferMemoryBarrier) {
-                .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
-                .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-                .dstAccessMask = VK_ACCESS_HOST_READ_BIT,
-                .buffer = buffer2,
-                .offset = 0,
-                .size = buffer_size,
-            }, 0, NULL);
-
-        vkCmdWriteTimestamp(cmd_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                            query, 1);
-
-        qoEndCommandBuffer(cmd_buffer);
+        qoTimelineWait(timeline, last_run);
 
-        uint64_t bytes_copied = 0, time = 0;
-        for (unsigned run = 0; run < runs_per_size; run++) {
-            qoQueueSubmit(t_queue, 1, &cmd_buffer, VK_NULL_HANDLE);
-            qoQueueWaitIdle(t_queue);
+        uint64_t query_results[2];
+        vkGetQueryPoolResults(t_device, query, 0, 2, sizeof(query_results),
+                              query_results, sizeof(*query_results),
+                              VK_QUERY_RESULT_64_BIT);
 
-            uint64_t query_results[2];
-            vkGetQueryPoolResults(t_device, query, 0, 2,
-                                  sizeof(query_results), query_results,
-                                  sizeof(query_results[0]),
-                                  VK_QUERY_RESULT_64_BIT);
-
-            bytes_copied += cmd_buffer_copy_size;
-            time += query_results[1] - query_results[0];
-        }
+        uint64_t bytes_copied = runs_per_size * cmd_buffer_copy_size;
+        uint64_t time = query_results[1] - query_results[0];
 
         double seconds =
             (time * (double)t_physical_dev_props->limits.timestampPeriod) /
@@ -69,6 +69,56 @@ second_to_unit_str(double value)
     return "s";
 }
 
+static void
+record_fill(VkCommandBuffer cmd_buffer, VkBuffer buffer, uint64_t buffer_size,
+            uint64_t cmd_buffer_fill_size, uint64_t single_fill_size,
+            VkQueryPool query, bool first_run, bool last_run)
+{
+    qoBeginCommandBuffer(cmd_buffer);
+
+    if (first_run) {
+        vkCmdResetQueryPool(cmd_buffer, query, 0, 2);
+        vkCmdWriteTimestamp(cmd_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                            query, 0);
+    }
+
+    vkCmdPipelineBarrier(cmd_buffer, VK_PIPELINE_STAGE_HOST_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 1,
+        &(VkBufferMemoryBarrier) {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_HOST_READ_BIT,
+            .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .buffer = buffer,
+            .offset = 0,
+            .size = buffer_size,
+        }, 0, NULL);
+
+    for (uint64_t i = 0; i < cmd_buffer_fill_size; i += single_fill_size) {
+        assert(buffer_size % single_fill_size == 0);
+        uint64_t offset = i % buffer_size;
+        vkCmdFillBuffer(cmd_buffer, buffer, offset, single_fill_size,
+                        0x55aa5aa5);
+    }
+
+    vkCmdPipelineBarrier(cmd_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_HOST_BIT, 0, 0, NULL, 1,
+        &(VkBufferMemoryBarrier) {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+            .buffer = buffer,
+            .offset = 0,
+            .size = buffer_size,
+        }, 0, NULL);
+
+    if (last_run) {
+        vkCmdWriteTimestamp(cmd_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                            query, 1);
+    }
+
+    qoEndCommandBuffer(cmd_buffer);
+}
+
 static void
 test_large_fill(void)
 {
@@ -95,7 +145,15 @@ test_large_fill(void)
 
     qoBindBufferMemory(t_device, buffer, mem, 0);
 
-    VkCommandBuffer cmd_buffer = qoAllocateCommandBuffer(t_device, t_cmd_pool);
+    // Each size queues all of its runs before waiting, so the queue never
+    // drains between runs. Consecutive runs may overlap on the GPU, so a
+    // single pair of timestamps brackets the whole batch: the first run
+    // writes the start and the last run writes the end.
+    qo_timeline_t *timeline = qoCreateTimeline(t_device, t_queue,
+                                               t_queue_family);
+
+    VkCommandBuffer cmd_buffer =
+        qoAcquireOneShotCommandBuffer(t_device, t_queue_family);
     qoBeginCommandBuffer(cmd_buffer);
     vkCmdPipelineBarrier(cmd_buffer, VK_PIPELINE_STAGE_HOST_BIT,
                          VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 1,
@@ -110,7 +168,7 @@ test_large_fill(void)
             },
         }, 0, NULL);
     qoEndCommandBuffer(cmd_buffer);
-    qoQueueSubmit(t_queue, 1, &cmd_buffer, VK_NULL_HANDLE);
+    qoTimelineSubmit(timeline, 1, &cmd_buffer);
 
     VkQueryPool query = qoCreateQueryPool(t_device,
                                           .queryType = VK_QUERY_TYPE_TIMESTAMP,
@@ -124,60 +182,25 @@ test_large_fill(void)
         uint64_t cmd_buffer_fill_size = 1ull << bytes_to_fill_log2;
         uint64_t single_fill_size = 1ull << s;
 
-        cmd_buffer = qoAllocateCommandBuffer(t_device, t_cmd_pool);
-        qoBeginCommandBuffer(cmd_buffer);
-
-        vkCmdWriteTimestamp(cmd_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                            query, 0);
-
-        vkCmdPipelineBarrier(cmd_buffer, VK_PIPELINE_STAGE_HOST_BIT,
-                             VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 1,
-            &(VkBufferMemoryBarrier) {
-                .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
-                .srcAccessMask = VK_ACCESS_HOST_READ_BIT,
-                .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-                .buffer = buffer,
-                .offset = 0,
-                .size = buffer_size,
-            }, 0, NULL);
-
-        for (uint64_t i = 0; i < cmd_buffer_fill_size; i += single_fill_size) {
-            assert(buffer_size % single_fill_size == 0);
-            uint64_t offset = i % buffer_size;
-            vkCmdFillBuffer(cmd_buffer, buffer, offset, single_fill_size,
-                            0x55aa5aa5);
+        uint64_t last_run = 0;
+        for (unsigned run = 0; run < runs_per_size; run++) {
+            cmd_buffer = qoAcquireOneShotCommandBuffer(t_device,
+                                                       t_queue_family);
+            record_fill(cmd_buffer, buffer, buffer_size,
+                        cmd_buffer_fill_size, single_fill_size,
+                        query, run == 0, run == runs_per_size - 1);
+            last_run = qoTimelineSubmit(timeline, 1, &cmd_buffer);
         }
 
-        vkCmdPipelineBarrier(cmd_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                             VK_PIPELINE_STAGE_HOST_BIT, 0, 0, NULL, 1,
-            &(VkBufferMemoryBarrier) {
-                .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
-                .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-                .dstAccessMask = VK_ACCESS_HOST_READ_BIT,
-                .buffer = buffer,
-                .offset = 0,
-                .size = buffer_size,
-            }, 0, NULL);
+        qoTimelineWait(timeline, last_run);
 
-        vkCmdWriteTimestamp(cmd_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                            query, 1);
+        uint64_t query_results[2];
+        vkGetQueryPoolResults(t_device, query, 0, 2, sizeof(query_results),
+                              query_results, sizeof(*query_results),
+                              VK_QUERY_RESULT_64_BIT);
 
-        qoEndCommandBuffer(cmd_buffer);
-
-        uint64_t bytes_filled = 0, time = 0;
-        for (unsigned run = 0; run < runs_per_size; run++) {
-            qoQueueSubmit(t_queue, 1, &cmd_buffer, VK_NULL_HANDLE);
-            qoQueueWaitIdle(t_queue);
-
-            uint64_t query_results[2];
-            vkGetQueryPoolResults(t_device, query, 0, 2,
-                                  sizeof(query_results), query_results,
-                                  sizeof(query_results[0]),
-                                  VK_QUERY_RESULT_64_BIT);
-
-            bytes_filled += cmd_buffer_fill_size;
-            time += query_results[1] - query_results[0];
-        }
+        uint64_t bytes_filled = runs_per_size * cmd_buffer_fill_size;
+        uint64_t time = query_results[1] - query_results[0];
 
         double seconds =
             (time * (double)t_physical_dev_props->limits.timestampPeriod) /
@@ -0,0 +1,136 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/// \file
+/// \brief Throughput of the CPU image comparison kernels.
+///
+/// Each iteration compares two VK_FORMAT_R8G8B8A8_UNORM images that differ
+/// by at most 1 in every channel, with a tolerance of 1, so every row goes
+/// through the full kernel. The exact memcmp() loop that
+/// cru_image_compare_rect() used before it gained a tolerance is measured on
+/// identical images, which is its best case. Each kernel runs on one thread,
+/// and the default kernel also runs on as many threads as the comparison
+/// uses by default.
+
+#include "tapi/t.h"
+#include "util/cru_image.h"
+#include "util/misc.h"
+
+#define NUM_ITERATIONS 64
+
+struct bench_size {
+    uint32_t width;
+    uint32_t height;
+};
+
+static const struct bench_size sizes[] = {
+    { 16384, 32 },
+    { 2048, 1024 },
+};
+
+static double
+gib_per_sec(uint64_t bytes, uint64_t ns)
+{
+    return ns ? (bytes / (ns / 1e9)) / (1ull << 30) : 0;
+}
+
+static void
+bench_memcmp(const uint8_t *a, const uint8_t *b, const struct bench_size *size)
+{
+    const uint32_t row_size = 4 * size->width;
+    uint64_t start = cru_get_time_ns();
+
+    for (uint32_t i = 0; i < NUM_ITERATIONS; i++) {
+        for (uint32_t y = 0; y < size->height; y++) {
+            t_assert(memcmp(a + y * row_size, b + y * row_size,
+                            row_size) == 0);
+        }
+    }
+
+    uint64_t ns = cru_get_time_ns() - start;
+    uint64_t bytes = 2ull * NUM_ITERATIONS * row_size * size->height;
+
+    logi("%ux%u memcmp loop: %.2f GiB/s", size->width, size->height,
+         gib_per_sec(bytes, ns));
+}
+
+static void
+bench_kernel(cru_image_t *a, cru_image_t *b, const struct bench_size *size,
+             enum cru_image_compare_isa isa, const char *isa_name,
+             uint32_t max_threads)
+{
+    const cru_image_compare_info_t info = {
+        .tolerance = { 1, 1, 1, 1 },
+        .isa = isa,
+        .max_threads = max_threads,
+    };
+    cru_image_compare_result_t result;
+    uint64_t start = cru_get_time_ns();
+
+    for (uint32_t i = 0; i < NUM_ITERATIONS; i++) {
+        t_assert(cru_image_compare_rect_stats(a, 0, 0, b, 0, 0,
+                                              size->width, size->height,
+                                              &info, &result));
+        t_assert(result.mismatch_count == 0);
+    }
+
+    uint64_t ns = cru_get_time_ns() - start;
+    uint64_t bytes = 2ull * NUM_ITERATIONS * 4 * size->width * size->height;
+
+    logi("%ux%u %s kernel, %s: %.2f GiB/s, rms error %.3f", size->width,
+         size->height, isa_name,
+         max_threads == 1 ? "1 thread" : "default threads",
+         gib_per_sec(bytes, ns), result.rms_error);
+}
+
+static void
+test(void)
+{
+    for (uint32_t s = 0; s < ARRAY_LENGTH(sizes); s++) {
+        const struct bench_size *size = &sizes[s];
+        const size_t num_bytes = 4ull * size->width * size->height;
+
+        uint8_t *a_pixels = t_arena_alloc(num_bytes);
+        uint8_t *b_pixels = t_arena_alloc(num_bytes);
+
+        for (size_t i = 0; i < num_bytes; i++) {
+            a_pixels[i] = i * 7;
+            b_pixels[i] = a_pixels[i] ^ (i & 1);
+        }
+
+        cru_image_t *a = t_new_cru_image_from_pixels(a_pixels,
+                VK_FORMAT_R8G8B8A8_UNORM, size->width, size->height);
+        cru_image_t *b = t_new_cru_image_from_pixels(b_pixels,
+                VK_FORMAT_R8G8B8A8_UNORM, size->width, size->height);
+
+        bench_memcmp(a_pixels, a_pixels, size);
+        bench_kernel(a, b, size, CRU_IMAGE_COMPARE_ISA_SCALAR, "scalar", 1);
+        bench_kernel(a, b, size, CRU_IMAGE_COMPARE_ISA_SSE2, "sse2", 1);
+        bench_kernel(a, b, size, CRU_IMAGE_COMPARE_ISA_AVX2, "avx2", 1);
+        bench_kernel(a, b, size, CRU_IMAGE_COMPARE_ISA_AUTO, "default", 0);
+    }
+}
+
+test_define {
+    .name = "bench.image-compare",
+    .start = test,
+    .no_image = true,
+};
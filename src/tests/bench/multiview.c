@@ -307,7 +307,7 @@ test_view_count(VkBuffer position_buffer, VkBuffer color_buffer,
         qoQueueWaitIdle(t_queue);
     }
 
-    vkResetDescriptorPool(t_device, t_descriptor_pool, 0);
+    qoResetDescriptorPool(t_device, t_descriptor_pool);
 
     return image;
 }
@@ -51,8 +51,7 @@ test_copy_ref_image(void)
     const uint32_t width = t_width;
     const uint32_t height = t_height;
 
-    uint32_t *copy_pixels = xmalloc(4 * width * height);
-    t_cleanup_push_free(copy_pixels);
+    uint32_t *copy_pixels = t_arena_alloc(4 * width * height);
 
     cru_image_t *copy_image = t_new_cru_image_from_pixels(
             copy_pixels, VK_FORMAT_R8G8B8A8_UNORM, width, height);
@@ -77,8 +76,7 @@ test_dump_seq_images(void)
     const uint32_t width = 16;
     const uint32_t height = 16;
 
-    void *pixels = xmalloc(4 * width * height);
-    t_cleanup_push_free(pixels);
+    void *pixels = t_arena_alloc(4 * width * height);
 
     cru_image_t *img = t_new_cru_image_from_pixels(
         pixels, VK_FORMAT_R8G8B8A8_UNORM, width, height);
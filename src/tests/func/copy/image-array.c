@@ -0,0 +1,94 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "util/cru_image.h"
+#include "tapi/t.h"
+
+// Upload every level and layer of a KTX2 image array with
+// t_upload_cru_image_array(), then read each one back and compare it to the
+// file's pixels.
+
+static void
+test(void)
+{
+    const char *filename = t_user_data;
+
+#ifndef HAVE_ZSTD
+    if (strstr(filename, "zstd"))
+        t_skipf("crucible was built without zstd");
+#endif
+
+    cru_image_array_t *ia = t_new_cru_image_array_from_filename(filename);
+    const uint32_t num_levels = cru_image_array_get_num_levels(ia);
+    const uint32_t num_layers = cru_image_array_get_num_layers(ia);
+
+    cru_image_t *base = cru_image_array_get_image(ia, 0);
+    const VkFormat format = cru_image_get_format(base);
+    const uint32_t width = cru_image_get_width(base);
+    const uint32_t height = cru_image_get_height(base);
+
+    VkImage image = qoCreateImage(t_device,
+        .format = format,
+        .usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+                 VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+        .mipLevels = num_levels,
+        .arrayLayers = num_layers,
+        .extent = {
+            .width = width,
+            .height = height,
+            .depth = 1,
+        });
+
+    VkDeviceMemory mem = qoAllocImageMemory(t_device, image);
+    qoBindImageMemory(t_device, image, mem, 0);
+
+    t_upload_cru_image_array(ia, image, VK_IMAGE_ASPECT_COLOR_BIT,
+                             VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+
+    for (uint32_t i = 0; i < num_levels * num_layers; i++) {
+        const uint32_t level = i / num_layers;
+        const uint32_t layer = i % num_layers;
+
+        cru_image_t *actual = t_new_cru_image_from_vk_image(t_device,
+            t_queue, image, format, VK_IMAGE_ASPECT_COLOR_BIT,
+            width, height, level, layer);
+
+        t_assertf(cru_image_compare(actual, cru_image_array_get_image(ia, i)),
+                  "%s: level %u layer %u differs from the file",
+                  filename, level, layer);
+    }
+
+    t_pass();
+}
+
+test_define {
+    .name = "func.copy.image-array.ktx2",
+    .start = test,
+    .user_data = "gradient-rgba8-8x8-2layers.ktx2",
+    .no_image = true,
+};
+
+test_define {
+    .name = "func.copy.image-array.ktx2-zstd",
+    .start = test,
+    .user_data = "gradient-rgba8-8x8-2layers-zstd.ktx2",
+    .no_image = true,
+};
@@ -0,0 +1,214 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "tapi/t.h"
+
+// The transfers are larger than the staging ring, so they take several
+// chunks and wrap around it at least once.
+
+static void
+test_upload_buffer(void)
+{
+    const VkDeviceSize buffer_size = 40 << 20;
+
+    VkBuffer buffer = qoCreateBuffer(t_device, .size = buffer_size);
+
+    VkDeviceMemory mem = qoAllocBufferMemory(t_device, buffer,
+        .properties = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    qoBindBufferMemory(t_device, buffer, mem, 0);
+
+    uint32_t *map32 = qoMapMemory(t_device, mem, 0, buffer_size, 0);
+
+    uint32_t *data = t_arena_alloc(buffer_size);
+
+    for (unsigned i = 0; i < buffer_size / sizeof(*data); i++) {
+        data[i] = i * 0x9e3779b9;
+        map32[i] = 0xdeadbeef;
+    }
+
+    qoUploadBuffer(t_device, t_queue, t_queue_family, buffer, 0, buffer_size,
+                   data);
+    qoQueueWaitIdle(t_queue);
+
+    for (unsigned i = 0; i < buffer_size / sizeof(*data); i++) {
+        t_assertf(map32[i] == data[i],
+                  "buffer mismatch at dword %u: found 0x%x, "
+                  "expected 0x%x", i, map32[i], data[i]);
+    }
+}
+
+test_define {
+    .name = "func.copy.staging.upload-buffer",
+    .start = test_upload_buffer,
+    .no_image = true,
+};
+
+typedef struct test_params test_params_t;
+
+struct test_params {
+    VkFormat format;
+
+    /// Aspects of the image, for its layout transition.
+    VkImageAspectFlags aspects;
+
+    /// The aspect to copy, and the bytes per texel of its buffer copies.
+    VkImageAspectFlags copy_aspect;
+    uint32_t texel_size;
+
+    /// The bits of each texel that survive the round trip. A zero byte masks
+    /// out padding, whose contents are undefined after a download.
+    uint8_t texel_mask[4];
+
+    /// Odd widths make rows that are not a multiple of 4 bytes, so the
+    /// chunks need more than 4-byte alignment.
+    uint32_t width;
+};
+
+static void
+test_image_roundtrip(void)
+{
+    const test_params_t *p = t_user_data;
+    const uint32_t width = p->width;
+    const uint32_t height = 1536;
+    const uint32_t layers = 2;
+    const size_t size = (size_t) width * height * layers * p->texel_size;
+
+    VkImageFormatProperties format_props;
+    VkResult result = vkGetPhysicalDeviceImageFormatProperties(t_physical_dev,
+        p->format, VK_IMAGE_TYPE_2D, VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+        0, &format_props);
+    if (result == VK_ERROR_FORMAT_NOT_SUPPORTED)
+        t_skipf("format does not support transfers");
+
+    VkImage image = qoCreateImage(t_device,
+        .format = p->format,
+        .usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+                 VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+        .arrayLayers = layers,
+        .extent = {
+            .width = width,
+            .height = height,
+            .depth = 1,
+        });
+
+    VkDeviceMemory mem = qoAllocImageMemory(t_device, image);
+    qoBindImageMemory(t_device, image, mem, 0);
+
+    VkCommandBuffer cmd = qoAllocateCommandBuffer(t_device, t_cmd_pool);
+    qoBeginCommandBuffer(cmd);
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1,
+        &(VkImageMemoryBarrier) {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .srcAccessMask = 0,
+            .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+            .image = image,
+            .subresourceRange = {
+                .aspectMask = p->aspects,
+                .levelCount = 1,
+                .layerCount = layers,
+            },
+        });
+    qoEndCommandBuffer(cmd);
+    qoQueueSubmit(t_queue, 1, &cmd, VK_NULL_HANDLE);
+
+    uint8_t *src = t_arena_alloc(size);
+    uint8_t *dst = t_arena_alloc(size);
+
+    for (size_t i = 0; i < size; i++) {
+        src[i] = (i * 0x9e3779b9) >> 24;
+        dst[i] = 0xde;
+    }
+
+    const VkBufferImageCopy region = {
+        .imageSubresource = {
+            .aspectMask = p->copy_aspect,
+            .mipLevel = 0,
+            .baseArrayLayer = 0,
+            .layerCount = layers,
+        },
+        .imageExtent = {
+            .width = width,
+            .height = height,
+            .depth = 1,
+        },
+    };
+
+    qoUploadImage(t_device, t_queue, t_queue_family, image, p->format,
+                  VK_IMAGE_LAYOUT_GENERAL, &region, src);
+    qoDownloadImage(t_device, t_queue, t_queue_family, image, p->format,
+                    VK_IMAGE_LAYOUT_GENERAL, &region, dst);
+
+    for (size_t i = 0; i < size; i++) {
+        const uint8_t mask = p->texel_mask[i % p->texel_size];
+
+        t_assertf((dst[i] & mask) == (src[i] & mask),
+                  "image mismatch at byte %zu of texel %zu: found 0x%02x, "
+                  "expected 0x%02x", i % p->texel_size, i / p->texel_size,
+                  dst[i] & mask, src[i] & mask);
+    }
+}
+
+test_define {
+    .name = "func.copy.staging.image-roundtrip.rgba8",
+    .start = test_image_roundtrip,
+    .no_image = true,
+    .user_data = &(test_params_t) {
+        .format = VK_FORMAT_R8G8B8A8_UNORM,
+        .aspects = VK_IMAGE_ASPECT_COLOR_BIT,
+        .copy_aspect = VK_IMAGE_ASPECT_COLOR_BIT,
+        .texel_size = 4,
+        .texel_mask = { 0xff, 0xff, 0xff, 0xff },
+        .width = 2048,
+    },
+};
+
+test_define {
+    .name = "func.copy.staging.image-roundtrip.rgb8",
+    .start = test_image_roundtrip,
+    .no_image = true,
+    .user_data = &(test_params_t) {
+        .format = VK_FORMAT_R8G8B8_UNORM,
+        .aspects = VK_IMAGE_ASPECT_COLOR_BIT,
+        .copy_aspect = VK_IMAGE_ASPECT_COLOR_BIT,
+        .texel_size = 3,
+        .texel_mask = { 0xff, 0xff, 0xff },
+        .width = 2047,
+    },
+};
+
+test_define {
+    .name = "func.copy.staging.image-roundtrip.d24",
+    .start = test_image_roundtrip,
+    .no_image = true,
+    .user_data = &(test_params_t) {
+        .format = VK_FORMAT_D24_UNORM_S8_UINT,
+        .aspects = VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT,
+        .copy_aspect = VK_IMAGE_ASPECT_DEPTH_BIT,
+        .texel_size = 4,
+        .texel_mask = { 0xff, 0xff, 0xff, 0x00 },
+        .width = 2047,
+    },
+};
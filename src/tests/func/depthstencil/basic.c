@@ -21,14 +21,65 @@
 
 #include <stdlib.h>
 #include "tapi/t.h"
+#include "util/cru_raster.h"
 
 #include "src/tests/func/depthstencil/basic-spirv.h"
 
 typedef struct test_params {
     float depth_clear_value;
     VkCompareOp depth_compare_op;
+
+    /// The GPU-rendered reference image that the CPU reference must match.
+    const char *ref_png_filename;
 } test_params_t;
 
+/// Width and height of the reference images.
+#define REF_SIZE 32
+
+static const float clear_color[] = { 0.2, 0.2, 0.2, 1.0 };
+
+static const float vertex_data[] = {
+    /* First triangle coordinates */
+    -0.7, -0.5, 0.5, 1.0,
+    0.3, -0.5, 0.5, 1.0,
+    -0.2,  0.5, 0.5, 1.0,
+
+    /* Second triangle coordinates */
+    -0.3, -0.3, 0.4, 1.0,
+    0.7, -0.3, 0.4, 1.0,
+    0.2,  0.7, 0.8, 1.0,
+
+    /* First triangle color */
+    1.0,  1.0, 0.2, 1.0,
+
+    /* Second triangle color */
+    0.2,  0.2, 1.0, 1.0,
+};
+
+/// Draw the reference image on the CPU, with the same vertices and state as
+/// the test's pipeline.
+static void
+draw_ref(cru_raster_t *raster)
+{
+    const test_params_t *params = t_user_data;
+    cru_raster_vertex_t vertices[6];
+
+    for (uint32_t i = 0; i < 6; i++) {
+        const float *color = &vertex_data[4 * (6 + i / 3)];
+
+        memcpy(vertices[i].pos, &vertex_data[4 * i], sizeof(vertices[i].pos));
+        memcpy(vertices[i].color, color, sizeof(vertices[i].color));
+    }
+
+    cru_raster_clear(raster, clear_color, params->depth_clear_value);
+    cru_raster_draw(raster,
+        &(cru_raster_state_t) {
+            .depth_test_enable = true,
+            .depth_write_enable = true,
+            .depth_compare_op = params->depth_compare_op,
+        }, vertices, 6);
+}
+
 static void
 test(void)
 {
@@ -94,24 +145,6 @@ test(void)
             .subpass = 0,
         }});
 
-    static const float vertex_data[] = {
-        /* First triangle coordinates */
-        -0.7, -0.5, 0.5, 1.0,
-        0.3, -0.5, 0.5, 1.0,
-        -0.2,  0.5, 0.5, 1.0,
-
-        /* Second triangle coordinates */
-        -0.3, -0.3, 0.4, 1.0,
-        0.7, -0.3, 0.4, 1.0,
-        0.2,  0.7, 0.8, 1.0,
-
-        /* First triangle color */
-        1.0,  1.0, 0.2, 1.0,
-
-        /* Second triangle color */
-        0.2,  0.2, 1.0, 1.0,
-    };
-
     VkBuffer vertex_buffer = qoCreateBuffer(t_device,
         .size = sizeof(vertex_data),
         .usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
@@ -133,7 +166,8 @@ test(void)
             .renderArea = { { 0, 0 }, { t_width, t_height } },
             .clearValueCount = 2,
             .pClearValues = (VkClearValue[]) {
-                { .color = { .float32 = { 0.2, 0.2, 0.2, 1.0 } } },
+                { .color = { .float32 = { clear_color[0], clear_color[1],
+                                          clear_color[2], clear_color[3] } } },
                 { .depthStencil = { .depth = params->depth_clear_value } },
             }
         }, VK_SUBPASS_CONTENTS_INLINE);
@@ -152,42 +186,56 @@ test(void)
     qoQueueSubmit(t_queue, 1, &t_cmd_buffer, VK_NULL_HANDLE);
 }
 
-test_define {
-    .name = "func.depthstencil.basic-depth.clear-0.0.op-less",
-    .start = test,
-    .depthstencil_format = VK_FORMAT_X8_D24_UNORM_PACK32,
-    .user_data = &(test_params_t) {
-        .depth_compare_op = VK_COMPARE_OP_LESS,
-        .depth_clear_value = 0.0,
-    },
-};
+/// Check that the CPU draws the same reference image that the GPU drew into
+/// the test's committed PNG, so that comparing the render against the CPU
+/// reference is as strict as comparing it against the PNG.
+static void
+test_ref_raster(void)
+{
+    const test_params_t *params = t_user_data;
 
-test_define {
-    .name = "func.depthstencil.basic-depth.clear-0.0.op-greater",
-    .start = test,
-    .depthstencil_format = VK_FORMAT_X8_D24_UNORM_PACK32,
-    .user_data = &(test_params_t) {
-        .depth_compare_op = VK_COMPARE_OP_GREATER,
-        .depth_clear_value = 0.0,
-    },
-};
+    cru_raster_t *raster = t_new_cru_raster(REF_SIZE, REF_SIZE);
+    draw_ref(raster);
 
-test_define {
-    .name = "func.depthstencil.basic-depth.clear-0.5.op-greater-equal",
-    .start = test,
-    .depthstencil_format = VK_FORMAT_X8_D24_UNORM_PACK32,
-    .user_data = &(test_params_t) {
-        .depth_clear_value = 0.5,
-        .depth_compare_op = VK_COMPARE_OP_GREATER_OR_EQUAL,
-    },
-};
+    cru_image_t *actual =
+        t_new_cru_image_from_raster(raster, VK_IMAGE_ASPECT_COLOR_BIT);
+    cru_image_t *expected =
+        t_new_cru_image_from_filename(params->ref_png_filename);
 
-test_define {
-    .name = "func.depthstencil.basic-depth.clear-1.0.op-greater",
-    .start = test,
-    .depthstencil_format = VK_FORMAT_X8_D24_UNORM_PACK32,
-    .user_data = &(test_params_t) {
-        .depth_clear_value = 1.0,
-        .depth_compare_op = VK_COMPARE_OP_GREATER,
-    },
-};
+    t_assertf(cru_image_compare(actual, expected),
+              "CPU reference differs from %s", params->ref_png_filename);
+    t_pass();
+}
+
+/// Define the test and the check of its CPU reference image.
+#define basic_depth_tests(_suffix, _clear_value, _compare_op)           \
+    test_define {                                                       \
+        .name = "func.depthstencil.basic-depth." _suffix,               \
+        .start = test,                                                  \
+        .depthstencil_format = VK_FORMAT_X8_D24_UNORM_PACK32,           \
+        .ref_raster = draw_ref,                                         \
+        .ref_width = REF_SIZE,                                          \
+        .ref_height = REF_SIZE,                                         \
+        .user_data = &(test_params_t) {                                 \
+            .depth_clear_value = _clear_value,                          \
+            .depth_compare_op = _compare_op,                            \
+        },                                                              \
+    };                                                                  \
+                                                                        \
+    test_define {                                                       \
+        .name = "func.depthstencil.basic-depth." _suffix ".ref-raster", \
+        .start = test_ref_raster,                                       \
+        .no_image = true,                                               \
+        .user_data = &(test_params_t) {                                 \
+            .depth_clear_value = _clear_value,                          \
+            .depth_compare_op = _compare_op,                            \
+            .ref_png_filename =                                         \
+                "func.depthstencil.basic-depth." _suffix ".ref.png",    \
+        },                                                              \
+    }
+
+basic_depth_tests("clear-0.0.op-less", 0.0, VK_COMPARE_OP_LESS);
+basic_depth_tests("clear-0.0.op-greater", 0.0, VK_COMPARE_OP_GREATER);
+basic_depth_tests("clear-0.5.op-greater-equal", 0.5,
+                  VK_COMPARE_OP_GREATER_OR_EQUAL);
+basic_depth_tests("clear-1.0.op-greater", 1.0, VK_COMPARE_OP_GREATER);
@@ -293,19 +293,33 @@ test_multiview()
 
     test_result_t result = TEST_RESULT_PASS;
 
+    // Views outside the view mask are never rendered, so their contents
+    // are undefined. Read back the rendered views in one submission and load
+    // the references while the copies execute.
+    cru_image_t *actuals[params->view_count];
+    int views[params->view_count];
+    uint32_t num_views = 0;
     for (int i = 0; i < params->view_count; i++) {
-        string_t ref_name = STRING_INIT;
         if ((params->view_mask & (1 << i)) == 0)
-            string_printf(&ref_name, "func.multiview.ref.empty.png");
-        else
-            string_printf(&ref_name, "func.multiview.ref.%d.png", i);
-        cru_image_t *ref = t_new_cru_image_from_filename(string_data(&ref_name));
-        string_finish(&ref_name);
+            continue;
 
-        cru_image_t *actual = t_new_cru_image_from_vk_image(t_device,
+        views[num_views] = i;
+        actuals[num_views] = t_new_cru_image_from_vk_image(t_device,
             t_queue, image, VK_FORMAT_R8G8B8A8_UNORM,
             VK_IMAGE_ASPECT_COLOR_BIT, width, height,
             /*miplevel*/ 0, /*array_slice*/i);
+        num_views++;
+    }
+    t_begin_cru_image_readback(actuals, num_views);
+
+    for (uint32_t v = 0; v < num_views; v++) {
+        int i = views[v];
+        cru_image_t *actual = actuals[v];
+
+        string_t ref_name = STRING_INIT;
+        string_printf(&ref_name, "func.multiview.ref.%d.png", i);
+        cru_image_t *ref = t_new_cru_image_from_filename(string_data(&ref_name));
+        string_finish(&ref_name);
 
         t_dump_image_f(actual, "actual.%d.png", i);
 
@@ -164,8 +164,7 @@ test_color_view_one(void)
         actual_images[i] = t_new_cru_image_from_pixels(dest_buffer_map,
             formats[i], width, height);
 
-        void *ref_image_mem = xmalloc(dest_buffer_size);
-        t_cleanup_push_free(ref_image_mem);
+        void *ref_image_mem = t_arena_alloc(dest_buffer_size);
 
         ref_images[i] = t_new_cru_image_from_pixels(ref_image_mem,
                 formats[i], width, height);
@@ -377,8 +376,7 @@ test_color8(void)
         actual_images[i] = t_new_cru_image_from_pixels(dest_buffer_map,
             formats[i], width, height);
 
-        void *ref_image_mem = xmalloc(dest_buffer_size);
-        t_cleanup_push_free(ref_image_mem);
+        void *ref_image_mem = t_arena_alloc(dest_buffer_size);
 
         ref_images[i] = t_new_cru_image_from_pixels(ref_image_mem,
                 formats[i], width, height);
@@ -616,8 +614,7 @@ test_color8_shared_memory(void)
         actual_images[i] = t_new_cru_image_from_pixels(dest_buffer_map,
             formats[i], width, height);
 
-        void *ref_image_mem = xmalloc(dest_buffer_size);
-        t_cleanup_push_free(ref_image_mem);
+        void *ref_image_mem = t_arena_alloc(dest_buffer_size);
 
         ref_images[i] = t_new_cru_image_from_pixels(ref_image_mem,
                 formats[i], width, height);
@@ -120,14 +120,11 @@ create_buffer(void)
 
     VkBuffer buffer = qoCreateBuffer(t_device, .size = buffer_size);
 
-    VkDeviceMemory mem = qoAllocBufferMemory(t_device, buffer,
-        .properties = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT |
-                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+    VkDeviceMemory mem = qoAllocBufferMemory(t_device, buffer);
 
     qoBindBufferMemory(t_device, buffer, mem, /*offset*/ 0);
 
-    void *map = qoMapMemory(t_device, mem, /*offset*/ 0,
-                            buffer_size, /*flags*/ 0);
+    uint8_t *data = t_arena_zalloc(buffer_size);
 
     uint32_t offset = 0;
 
@@ -140,10 +137,13 @@ create_buffer(void)
 
     for (unsigned i = 0; i < UBO_BLOCK_COUNT; ++i) {
         assert(offset + sizeof(colors) <= buffer_size);
-        memcpy(map + offset, colors, sizeof(colors));
+        memcpy(data + offset, colors, sizeof(colors));
         offset += sizeof(colors);
     }
 
+    qoUploadBuffer(t_device, t_queue, t_queue_family, buffer, /*offset*/ 0,
+                   buffer_size, data);
+
     return buffer;
 }
 
@@ -135,23 +135,20 @@ create_buffer(uint32_t bind_offset)
 
     VkBuffer buffer = qoCreateBuffer(t_device, .size = buffer_size);
 
-    VkDeviceMemory mem = qoAllocBufferMemory(t_device, buffer,
-        .properties = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT |
-                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+    VkDeviceMemory mem = qoAllocBufferMemory(t_device, buffer);
 
     qoBindBufferMemory(t_device, buffer, mem, /*offset*/ 0);
 
-    void *map = qoMapMemory(t_device, mem, /*offset*/ 0,
-                            buffer_size, /*flags*/ 0);
+    uint8_t *data = t_arena_zalloc(buffer_size);
 
     uint32_t offset = 0;
 
     assert(offset + bind_offset <= buffer_size);
-    memset(map + offset, 0, bind_offset);
+    memset(data + offset, 0, bind_offset);
     offset += bind_offset;
 
     assert(offset + UBO_PAD_SIZE <= buffer_size);
-    memset(map + offset, 0, UBO_PAD_SIZE);
+    memset(data + offset, 0, UBO_PAD_SIZE);
     offset += UBO_PAD_SIZE;
 
     const float colors[8] = {
@@ -159,9 +156,12 @@ create_buffer(uint32_t bind_offset)
         1.0f, 0.0f, 0.0f, 1.0f,
     };
     assert(offset + sizeof(colors) <= buffer_size);
-    memcpy(map + offset, colors, sizeof(colors));
+    memcpy(data + offset, colors, sizeof(colors));
     offset += sizeof(colors);
 
+    qoUploadBuffer(t_device, t_queue, t_queue_family, buffer, /*offset*/ 0,
+                   buffer_size, data);
+
     return buffer;
 }
 
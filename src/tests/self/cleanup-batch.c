@@ -0,0 +1,213 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/// \file
+/// \brief Test that batched frees keep the cleanup stack in LIFO order.
+///
+/// cru_cleanup_pop_all() frees a run of adjacent command buffers or
+/// descriptor sets from the same pool with one call. This test interleaves
+/// such runs with callbacks and with objects from other pools, and checks
+/// that the callbacks run in reverse order and that every descriptor set
+/// pushed after a callback is free by the time the callback runs.
+
+#include "tapi/t.h"
+
+#define NUM_SETS 6
+#define NUM_CHECKS 3
+
+struct state {
+    VkDescriptorPool desc_pool;
+    VkDescriptorSetLayout set_layout;
+
+    /// Ids of the checks, in the order they ran.
+    uint32_t order[NUM_CHECKS];
+    uint32_t num_run;
+
+    /// Whether each check could allocate the sets freed before it ran.
+    bool alloc_ok[NUM_CHECKS];
+};
+
+struct check {
+    struct state *state;
+    uint32_t id;
+
+    /// Descriptor sets pushed after this check.
+    uint32_t num_freed;
+};
+
+/// Allocate and free again as many sets as the cleanup should have freed.
+/// The pool holds only NUM_SETS, so this may fail if any of them is still
+/// live.
+static void
+run_check(void *data)
+{
+    struct check *check = data;
+    struct state *state = check->state;
+    VkDescriptorSetLayout layouts[NUM_SETS];
+    VkDescriptorSet sets[NUM_SETS];
+
+    state->order[state->num_run++] = check->id;
+
+    for (uint32_t i = 0; i < check->num_freed; i++)
+        layouts[i] = state->set_layout;
+
+    VkResult result = vkAllocateDescriptorSets(t_device,
+        &(VkDescriptorSetAllocateInfo) {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            .descriptorPool = state->desc_pool,
+            .descriptorSetCount = check->num_freed,
+            .pSetLayouts = layouts,
+        }, sets);
+    if (result != VK_SUCCESS)
+        return;
+
+    vkFreeDescriptorSets(t_device, state->desc_pool, check->num_freed, sets);
+    state->alloc_ok[check->id] = true;
+}
+
+static void
+push_set(cru_cleanup_stack_t *c, struct state *state)
+{
+    VkDescriptorSet set;
+    VkResult result = vkAllocateDescriptorSets(t_device,
+        &(VkDescriptorSetAllocateInfo) {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            .descriptorPool = state->desc_pool,
+            .descriptorSetCount = 1,
+            .pSetLayouts = &state->set_layout,
+        }, &set);
+    t_assert(result == VK_SUCCESS);
+
+    cru_cleanup_push_vk_descriptor_set(c, t_device, state->desc_pool, set);
+}
+
+static void
+push_cmd_buffer(cru_cleanup_stack_t *c, VkCommandPool pool)
+{
+    VkCommandBuffer cmd;
+    VkResult result = vkAllocateCommandBuffers(t_device,
+        &(VkCommandBufferAllocateInfo) {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = pool,
+            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 1,
+        }, &cmd);
+    t_assert(result == VK_SUCCESS);
+
+    cru_cleanup_push_vk_command_buffer(c, t_device, pool, cmd);
+}
+
+static VkCommandPool
+create_cmd_pool(void)
+{
+    VkCommandPool pool;
+    VkResult result = vkCreateCommandPool(t_device,
+        &(VkCommandPoolCreateInfo) {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            .queueFamilyIndex = t_queue_family,
+        }, NULL, &pool);
+    t_assert(result == VK_SUCCESS);
+    t_cleanup_push_vk_cmd_pool(t_device, pool);
+
+    return pool;
+}
+
+static void
+test_lifo(void)
+{
+    struct state state = {
+        .set_layout = qoCreateDescriptorSetLayout(t_device,
+            .bindingCount = 1,
+            .pBindings = (VkDescriptorSetLayoutBinding[]) {
+                {
+                    .binding = 0,
+                    .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                    .descriptorCount = 1,
+                    .stageFlags = VK_SHADER_STAGE_ALL,
+                },
+            }),
+    };
+
+    // Every set uses the same layout, so freed sets never fragment the pool.
+    VkResult result = vkCreateDescriptorPool(t_device,
+        &(VkDescriptorPoolCreateInfo) {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+            .flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT,
+            .maxSets = NUM_SETS,
+            .poolSizeCount = 1,
+            .pPoolSizes = &(VkDescriptorPoolSize) {
+                .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                .descriptorCount = NUM_SETS,
+            },
+        }, NULL, &state.desc_pool);
+    t_assert(result == VK_SUCCESS);
+    t_cleanup_push_vk_descriptor_pool(t_device, state.desc_pool);
+
+    VkCommandPool pool_a = create_cmd_pool();
+    VkCommandPool pool_b = create_cmd_pool();
+
+    struct check checks[NUM_CHECKS] = {
+        { &state, 0, 6 },
+        { &state, 1, 4 },
+        { &state, 2, 1 },
+    };
+
+    cru_cleanup_stack_t *c = cru_cleanup_create();
+    t_assert(c);
+
+    // Push, bottom to top. The comments give the stack as it unwinds.
+    cru_cleanup_push_callback(c, run_check, &checks[0]);  // sets 1-6 freed
+    push_set(c, &state);                                  // set 1
+    push_set(c, &state);                                  // set 2
+    push_cmd_buffer(c, pool_a);
+    cru_cleanup_push_callback(c, run_check, &checks[1]);  // sets 3-6 freed
+    push_set(c, &state);                                  // set 3
+    push_cmd_buffer(c, pool_a);
+    push_cmd_buffer(c, pool_b);
+    push_cmd_buffer(c, pool_a);
+    push_set(c, &state);                                  // set 4
+    push_set(c, &state);                                  // set 5
+    cru_cleanup_push_callback(c, run_check, &checks[2]);  // set 6 freed
+    push_set(c, &state);                                  // set 6
+    push_cmd_buffer(c, pool_a);
+    push_cmd_buffer(c, pool_a);
+
+    cru_cleanup_pop_all(c);
+    cru_cleanup_release(c);
+
+    t_assert(state.num_run == NUM_CHECKS);
+
+    for (uint32_t i = 0; i < NUM_CHECKS; i++) {
+        t_assertf(state.order[i] == NUM_CHECKS - 1 - i,
+                  "check %u ran in position %u", state.order[i], i);
+        t_assertf(state.alloc_ok[i],
+                  "check %u ran before the sets pushed after it were freed",
+                  i);
+    }
+
+    t_pass();
+}
+
+test_define {
+    .name = "self.cleanup-batch.lifo",
+    .start = test_lifo,
+    .no_image = true,
+};
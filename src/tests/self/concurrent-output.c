@@ -32,8 +32,7 @@
 static char *
 mk_big_str(char c)
 {
-    char *s = xmalloc(8096);
-    t_cleanup_push_free(s);
+    char *s = t_arena_alloc(8096);
     memset(s, c, 8096);
     s[8096 - 1] = 0;
     return s;
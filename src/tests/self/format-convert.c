@@ -0,0 +1,204 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/// \file
+/// \brief Test that pixel format conversions round-trip.
+///
+/// Each subtest converts every value of a format's channel to a wider
+/// format and back, and checks that the result is the input. The depth
+/// subtest also checks that the channels of combined depth/stencil formats
+/// are read with their aspects' number types.
+
+#include "util/cru_format.h"
+#include "tapi/t.h"
+
+/// Convert \a width pixels of \a format to \a via and back, and check that
+/// the pixels are unchanged.
+static void
+check_round_trip(void *pixels, VkFormat format, VkFormat via, uint32_t width)
+{
+    const cru_format_info_t *info = t_format_info(format);
+    const cru_format_info_t *via_info = t_format_info(via);
+
+    void *via_pixels = t_arena_zallocn(width, via_info->cpp);
+    void *out_pixels = t_arena_zallocn(width, info->cpp);
+
+    cru_image_t *src = t_new_cru_image_from_pixels(pixels, format, width, 1);
+    cru_image_t *mid = t_new_cru_image_from_pixels(via_pixels, via,
+                                                   width, 1);
+    cru_image_t *out = t_new_cru_image_from_pixels(out_pixels, format,
+                                                   width, 1);
+
+    t_assert(cru_image_copy(mid, src));
+    t_assert(cru_image_copy(out, mid));
+
+    const uint8_t *a = pixels;
+    const uint8_t *b = out_pixels;
+
+    for (uint32_t x = 0; x < width; ++x) {
+        if (memcmp(a + x * info->cpp, b + x * info->cpp, info->cpp) != 0) {
+            t_failf("pixel %u of %s changed in a round trip through %s",
+                    x, info->name, via_info->name);
+        }
+    }
+}
+
+static void
+test_unorm(void)
+{
+    uint8_t *u8 = t_arena_allocn(256, sizeof(*u8));
+    for (uint32_t i = 0; i < 256; ++i)
+        u8[i] = i;
+
+    check_round_trip(u8, VK_FORMAT_R8_UNORM, VK_FORMAT_R16_UNORM, 256);
+
+    uint16_t *u16 = t_arena_allocn(65536, sizeof(*u16));
+    for (uint32_t i = 0; i < 65536; ++i)
+        u16[i] = i;
+
+    check_round_trip(u16, VK_FORMAT_R16_UNORM, VK_FORMAT_R32_SFLOAT, 65536);
+
+    t_pass();
+}
+
+test_define {
+    .name = "self.format-convert.unorm",
+    .start = test_unorm,
+    .no_image = true,
+};
+
+static void
+test_snorm(void)
+{
+    // The most negative value is a second encoding of -1.0, so it becomes
+    // the other one and is left out.
+    int8_t *s8 = t_arena_allocn(255, sizeof(*s8));
+    for (int32_t i = 0; i < 255; ++i)
+        s8[i] = i - 127;
+
+    check_round_trip(s8, VK_FORMAT_R8_SNORM, VK_FORMAT_R32_SFLOAT, 255);
+    check_round_trip(s8, VK_FORMAT_R8_SNORM, VK_FORMAT_R16_SNORM, 255);
+
+    int16_t *s16 = t_arena_allocn(65535, sizeof(*s16));
+    for (int32_t i = 0; i < 65535; ++i)
+        s16[i] = i - 32767;
+
+    check_round_trip(s16, VK_FORMAT_R16_SNORM, VK_FORMAT_R32_SFLOAT, 65535);
+
+    t_pass();
+}
+
+test_define {
+    .name = "self.format-convert.snorm",
+    .start = test_snorm,
+    .no_image = true,
+};
+
+static void
+test_half(void)
+{
+    // Every half but the NaNs, whose payloads need not survive.
+    uint16_t *h = t_arena_allocn(65536, sizeof(*h));
+    uint32_t n = 0;
+
+    for (uint32_t i = 0; i < 65536; ++i) {
+        if ((i & 0x7c00) == 0x7c00 && (i & 0x3ff) != 0)
+            continue;
+        h[n++] = i;
+    }
+
+    check_round_trip(h, VK_FORMAT_R16_SFLOAT, VK_FORMAT_R32_SFLOAT, n);
+
+    t_pass();
+}
+
+test_define {
+    .name = "self.format-convert.half",
+    .start = test_half,
+    .no_image = true,
+};
+
+static void
+test_packed(void)
+{
+    // Every 10-bit value in each of R, G and B, and every 2-bit alpha.
+    uint32_t *p = t_arena_allocn(1024, sizeof(*p));
+    for (uint32_t i = 0; i < 1024; ++i) {
+        p[i] = (i & 3) << 30 | (1023 - i) << 20 | ((i * 7) & 1023) << 10 | i;
+    }
+
+    check_round_trip(p, VK_FORMAT_A2B10G10R10_UNORM_PACK32,
+                     VK_FORMAT_R16G16B16A16_UNORM, 1024);
+    check_round_trip(p, VK_FORMAT_A2B10G10R10_UINT_PACK32,
+                     VK_FORMAT_R32G32B32A32_UINT, 1024);
+
+    t_pass();
+}
+
+test_define {
+    .name = "self.format-convert.packed",
+    .start = test_packed,
+    .no_image = true,
+};
+
+static void
+test_depth(void)
+{
+    uint16_t *d16 = t_arena_allocn(65536, sizeof(*d16));
+    for (uint32_t i = 0; i < 65536; ++i)
+        d16[i] = i;
+
+    check_round_trip(d16, VK_FORMAT_D16_UNORM, VK_FORMAT_R32_SFLOAT, 65536);
+
+    // X8_D24 pixels are 4 bytes, with the padding in the high byte.
+    const uint32_t n = 4096;
+    uint32_t *d24 = t_arena_allocn(n, sizeof(*d24));
+    for (uint32_t i = 0; i < n; ++i)
+        d24[i] = (i * 4099) & 0xffffff;
+
+    check_round_trip(d24, VK_FORMAT_X8_D24_UNORM_PACK32, VK_FORMAT_R32_UINT,
+                     n);
+
+    // The depth and stencil of a combined format differ by one step each.
+    uint32_t ds_a[] = { 0x05000100 };
+    uint32_t ds_b[] = { 0x04000101 };
+    cru_image_t *a = t_new_cru_image_from_pixels(ds_a,
+            VK_FORMAT_D24_UNORM_S8_UINT, 1, 1);
+    cru_image_t *b = t_new_cru_image_from_pixels(ds_b,
+            VK_FORMAT_D24_UNORM_S8_UINT, 1, 1);
+
+    cru_image_compare_result_t r;
+    t_assert(cru_image_compare_rect_stats(a, 0, 0, b, 0, 0, 1, 1,
+                                          &(cru_image_compare_info_t) {
+                                              .tolerance = { 1, 1 },
+                                          }, &r));
+
+    t_assert(r.mismatch_count == 0);
+    t_assert(r.max_error[0] == 1 && r.max_error[1] == 1);
+
+    t_pass();
+}
+
+test_define {
+    .name = "self.format-convert.depth",
+    .start = test_depth,
+    .no_image = true,
+};
@@ -109,13 +109,12 @@ test_lots_of_surface_state(VkShaderModule vs, VkShaderModule fs,
         qoCreateBuffer(t_device, .size = ubo_size,
                        .usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
 
-    VkDeviceMemory ubo_mem = qoAllocBufferMemory(t_device, ubo,
+    QoMemoryRange ubo_mem = qoAllocBufferMemoryRange(t_device, ubo,
         .properties = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
-    void *ubo_map = qoMapMemory(t_device, ubo_mem, /*offset*/ 0,
-                                ubo_size, /*flags*/ 0);
+    void *ubo_map = qoMapMemoryRange(t_device, &ubo_mem);
 
-    qoBindBufferMemory(t_device, ubo, ubo_mem, /*offset*/ 0);
+    qoBindBufferMemory(t_device, ubo, ubo_mem.memory, ubo_mem.offset);
 
     size_t vbo_size = 32 * 32 * 2 * sizeof(float);
 
@@ -123,13 +122,12 @@ test_lots_of_surface_state(VkShaderModule vs, VkShaderModule fs,
         qoCreateBuffer(t_device, .size = vbo_size,
                        .usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
 
-    VkDeviceMemory vbo_mem = qoAllocBufferMemory(t_device, vbo,
+    QoMemoryRange vbo_mem = qoAllocBufferMemoryRange(t_device, vbo,
         .properties = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
-    float *const vbo_map = qoMapMemory(t_device, vbo_mem, /*offset*/ 0,
-                                       vbo_size, /*flags*/ 0);
+    float *const vbo_map = qoMapMemoryRange(t_device, &vbo_mem);
 
-    qoBindBufferMemory(t_device, vbo, vbo_mem, /*offset*/ 0);
+    qoBindBufferMemory(t_device, vbo, vbo_mem.memory, vbo_mem.offset);
 
     // Fill the VBO with 2D coordinates. One per pixel in a 32x32 image.
     for (int x = 0; x < 32; x++) {
@@ -483,13 +481,12 @@ test_lots_of_surface_state_cs(bool use_dynamic_offsets)
         qoCreateBuffer(t_device, .size = ubo_size,
                        .usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
 
-    VkDeviceMemory ubo_mem = qoAllocBufferMemory(t_device, ubo,
+    QoMemoryRange ubo_mem = qoAllocBufferMemoryRange(t_device, ubo,
         .properties = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
-    void *ubo_map = qoMapMemory(t_device, ubo_mem, /*offset*/ 0,
-                                ubo_size, /*flags*/ 0);
+    void *ubo_map = qoMapMemoryRange(t_device, &ubo_mem);
 
-    qoBindBufferMemory(t_device, ubo, ubo_mem, /*offset*/ 0);
+    qoBindBufferMemory(t_device, ubo, ubo_mem.memory, ubo_mem.offset);
 
     srand(0);
 
@@ -509,10 +506,10 @@ test_lots_of_surface_state_cs(bool use_dynamic_offsets)
         qoCreateBuffer(t_device, .size = ssbo_size,
                        .usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
 
-    VkDeviceMemory ssbo_mem = qoAllocBufferMemory(t_device, ssbo,
+    QoMemoryRange ssbo_mem = qoAllocBufferMemoryRange(t_device, ssbo,
         .properties = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
-    qoBindBufferMemory(t_device, ssbo, ssbo_mem, /*offset*/ 0);
+    qoBindBufferMemory(t_device, ssbo, ssbo_mem.memory, ssbo_mem.offset);
 
     vkCmdPipelineBarrier(t_cmd_buffer,
                          VK_PIPELINE_STAGE_HOST_BIT,
@@ -723,8 +720,7 @@ test_lots_of_surface_state_cs(bool use_dynamic_offsets)
     qoQueueSubmit(t_queue, 1, &t_cmd_buffer, VK_NULL_HANDLE);
     qoQueueWaitIdle(t_queue);
 
-    void *ssbo_map = qoMapMemory(t_device, ssbo_mem, /*offset*/ 0,
-                                 ssbo_size, /*flags*/ 0);
+    void *ssbo_map = qoMapMemoryRange(t_device, &ssbo_mem);
 
     for (unsigned i = 0; i < 1024; i++) {
         float *f = ssbo_map + i * ssbo_stride;
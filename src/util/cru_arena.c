@@ -0,0 +1,156 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <stdalign.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "util/cru_arena.h"
+#include "util/misc.h"
+#include "util/xalloc.h"
+
+/// Size of the data in a regular chunk.
+#define CRU_ARENA_CHUNK_SIZE (64 * 1024)
+
+/// Allocations larger than this get a chunk of their own, so that one large
+/// allocation doesn't waste the tail of the current chunk.
+#define CRU_ARENA_MAX_SMALL_SIZE (CRU_ARENA_CHUNK_SIZE / 4)
+
+struct cru_arena_chunk {
+    struct cru_arena_chunk *next;
+
+    /// Size of data, in bytes.
+    size_t size;
+
+    /// Bytes of data already handed out.
+    size_t used;
+
+    max_align_t data[];
+};
+
+struct cru_arena {
+    /// The chunk that small allocations are bumped from, followed by all
+    /// older chunks.
+    struct cru_arena_chunk *chunks;
+};
+
+cru_arena_t *
+cru_arena_create(void)
+{
+    return xzalloc(sizeof(cru_arena_t));
+}
+
+void
+cru_arena_destroy(cru_arena_t *a)
+{
+    if (!a)
+        return;
+
+    struct cru_arena_chunk *chunk = a->chunks;
+    while (chunk) {
+        struct cru_arena_chunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+
+    free(a);
+}
+
+static struct cru_arena_chunk *
+cru_arena_new_chunk(size_t size)
+{
+    size_t total_size;
+
+    if (!cru_add_size_checked(&total_size, sizeof(struct cru_arena_chunk),
+                              size))
+        cru_oom();
+
+    struct cru_arena_chunk *chunk = xmalloc(total_size);
+    chunk->next = NULL;
+    chunk->size = size;
+    chunk->used = 0;
+
+    return chunk;
+}
+
+void *
+cru_arena_alloc(cru_arena_t *a, size_t size)
+{
+    struct cru_arena_chunk *head = a->chunks;
+    struct cru_arena_chunk *chunk;
+
+    if (size > SIZE_MAX - alignof(max_align_t))
+        cru_oom();
+
+    size = cru_align_size(MAX(size, 1), alignof(max_align_t));
+
+    if (head && head->size - head->used >= size) {
+        chunk = head;
+    } else if (size > CRU_ARENA_MAX_SMALL_SIZE) {
+        // Keep bumping from the current chunk afterwards.
+        chunk = cru_arena_new_chunk(size);
+        if (head) {
+            chunk->next = head->next;
+            head->next = chunk;
+        } else {
+            a->chunks = chunk;
+        }
+    } else {
+        chunk = cru_arena_new_chunk(CRU_ARENA_CHUNK_SIZE);
+        chunk->next = head;
+        a->chunks = chunk;
+    }
+
+    void *p = (char *) chunk->data + chunk->used;
+    chunk->used += size;
+
+    return p;
+}
+
+void *
+cru_arena_allocn(cru_arena_t *a, size_t n, size_t size)
+{
+    size_t total_size;
+
+    if (!unlikely(cru_mul_size_checked(&total_size, n, size)))
+        cru_oom();
+
+    return cru_arena_alloc(a, total_size);
+}
+
+void *
+cru_arena_zalloc(cru_arena_t *a, size_t size)
+{
+    void *p = cru_arena_alloc(a, size);
+    memset(p, 0, size);
+    return p;
+}
+
+void *
+cru_arena_zallocn(cru_arena_t *a, size_t n, size_t size)
+{
+    size_t total_size;
+
+    if (!unlikely(cru_mul_size_checked(&total_size, n, size)))
+        cru_oom();
+
+    return cru_arena_zalloc(a, total_size);
+}
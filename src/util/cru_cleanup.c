@@ -639,6 +639,102 @@ cru_cleanup_pop_impl(cru_cleanup_stack_t *c, bool noop)
     #undef CMD_DO
 }
 
+/// Maximum number of handles freed by one batched vkFree* call.
+#define CRU_CLEANUP_MAX_BATCH 64
+
+/// Return the header of the topmost command, or NULL if the stack is empty.
+static struct cmd_header *
+cru_cleanup_peek_header(cru_cleanup_stack_t *c)
+{
+    if (c->commands.len == 0)
+        return NULL;
+
+    return (void *) ((char *) c->commands.data + c->commands.len -
+                     sizeof(struct cmd_header));
+}
+
+/// \brief Unwind a run of pool-allocated objects with one vkFree* call.
+///
+/// Tests often allocate many command buffers or descriptor sets from the
+/// same pool back-to-back, and freeing them one at a time costs a trip
+/// through the loader and driver for each handle. This coalesces the run
+/// of adjacent commands on top of the stack that have the same type, device
+/// and pool into a single vkFreeCommandBuffers or vkFreeDescriptorSets.
+///
+/// Only adjacent commands are coalesced, so every other command still
+/// unwinds in strict LIFO order relative to the run.
+///
+/// Return false if the topmost command is not batchable.
+static bool
+cru_cleanup_pop_batch(cru_cleanup_stack_t *c)
+{
+    struct cmd_header *header = cru_cleanup_peek_header(c);
+    uint32_t n = 0;
+
+    if (!header)
+        return false;
+
+    #define CMD_PEEK(T) \
+        ((T *) ((char *) header - sizeof(T)))
+
+    #define CMD_POP(T) \
+        do { \
+            cru_vec_pop(&c->commands, sizeof(struct cmd_header)); \
+            cru_vec_pop(&c->commands, sizeof(T)); \
+            header = cru_cleanup_peek_header(c); \
+        } while (0)
+
+    switch (header->cmd_type) {
+        case CRU_CLEANUP_CMD_VK_COMMAND_BUFFER: {
+            const struct cmd_vk_cmd_buffer *top =
+                CMD_PEEK(struct cmd_vk_cmd_buffer);
+            VkDevice dev = top->dev;
+            VkCommandPool pool = top->pool;
+            VkCommandBuffer handles[CRU_CLEANUP_MAX_BATCH];
+
+            while (header && n < CRU_CLEANUP_MAX_BATCH &&
+                   header->cmd_type == CRU_CLEANUP_CMD_VK_COMMAND_BUFFER) {
+                const struct cmd_vk_cmd_buffer *cmd =
+                    CMD_PEEK(struct cmd_vk_cmd_buffer);
+                if (cmd->dev != dev || cmd->pool != pool)
+                    break;
+
+                handles[n++] = cmd->x;
+                CMD_POP(struct cmd_vk_cmd_buffer);
+            }
+
+            vkFreeCommandBuffers(dev, pool, n, handles);
+            return true;
+        }
+        case CRU_CLEANUP_CMD_VK_DESCRIPTOR_SET: {
+            const struct cmd_vk_descriptor_set *top =
+                CMD_PEEK(struct cmd_vk_descriptor_set);
+            VkDevice dev = top->dev;
+            VkDescriptorPool pool = top->pool;
+            VkDescriptorSet handles[CRU_CLEANUP_MAX_BATCH];
+
+            while (header && n < CRU_CLEANUP_MAX_BATCH &&
+                   header->cmd_type == CRU_CLEANUP_CMD_VK_DESCRIPTOR_SET) {
+                const struct cmd_vk_descriptor_set *cmd =
+                    CMD_PEEK(struct cmd_vk_descriptor_set);
+                if (cmd->dev != dev || cmd->pool != pool)
+                    break;
+
+                handles[n++] = cmd->set;
+                CMD_POP(struct cmd_vk_descriptor_set);
+            }
+
+            vkFreeDescriptorSets(dev, pool, n, handles);
+            return true;
+        }
+        default:
+            return false;
+    }
+
+    #undef CMD_PEEK
+    #undef CMD_POP
+}
+
 void
 cru_cleanup_pop(cru_cleanup_stack_t *c)
 {
@@ -654,7 +750,7 @@ cru_cleanup_pop_noop(cru_cleanup_stack_t *c)
 void
 cru_cleanup_pop_all(cru_cleanup_stack_t *c)
 {
-    while (cru_cleanup_pop_impl(c, false))
+    while (cru_cleanup_pop_batch(c) || cru_cleanup_pop_impl(c, false))
       ;;
 }
 
@@ -19,6 +19,8 @@
 // FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
 // IN THE SOFTWARE.
 
+#include <string.h>
+
 #include "util/cru_format.h"
 
 #define FMT(__vk_token) .format = __vk_token, .name = #__vk_token
@@ -30,6 +32,7 @@ cru_format_info_table[] = {
         .num_type = CRU_NUM_TYPE_UNORM,
         .num_channels = 1,
         .cpp = 1,
+        .channel_bits = { 8 },
         .is_color = true,
     },
     {
@@ -37,6 +40,7 @@ cru_format_info_table[] = {
         .num_type = CRU_NUM_TYPE_UNORM,
         .num_channels = 4,
         .cpp = 4,
+        .channel_bits = { 8, 8, 8, 8 },
         .is_color = true,
         .has_alpha = true,
     },
@@ -45,6 +49,7 @@ cru_format_info_table[] = {
         .num_type = CRU_NUM_TYPE_UNORM,
         .num_channels = 1,
         .cpp = 2,
+        .channel_bits = { 16 },
         .is_color = true,
     },
     {
@@ -52,6 +57,7 @@ cru_format_info_table[] = {
         .num_type = CRU_NUM_TYPE_SFLOAT,
         .num_channels = 1,
         .cpp = 4,
+        .channel_bits = { 32 },
         .is_color = true,
     },
     {
@@ -59,20 +65,178 @@ cru_format_info_table[] = {
         .num_type = CRU_NUM_TYPE_UINT,
         .num_channels = 1,
         .cpp = 4,
+        .channel_bits = { 32 },
+        .is_color = true,
+    },
+    {
+        FMT(VK_FORMAT_R8_SNORM),
+        .num_type = CRU_NUM_TYPE_SNORM,
+        .num_channels = 1,
+        .cpp = 1,
+        .channel_bits = { 8 },
+        .is_color = true,
+    },
+    {
+        FMT(VK_FORMAT_R8_UINT),
+        .num_type = CRU_NUM_TYPE_UINT,
+        .num_channels = 1,
+        .cpp = 1,
+        .channel_bits = { 8 },
+        .is_color = true,
+    },
+    {
+        FMT(VK_FORMAT_R8_SINT),
+        .num_type = CRU_NUM_TYPE_SINT,
+        .num_channels = 1,
+        .cpp = 1,
+        .channel_bits = { 8 },
+        .is_color = true,
+    },
+    {
+        FMT(VK_FORMAT_R8G8B8A8_SNORM),
+        .num_type = CRU_NUM_TYPE_SNORM,
+        .num_channels = 4,
+        .cpp = 4,
+        .channel_bits = { 8, 8, 8, 8 },
+        .is_color = true,
+        .has_alpha = true,
+    },
+    {
+        FMT(VK_FORMAT_R8G8B8A8_UINT),
+        .num_type = CRU_NUM_TYPE_UINT,
+        .num_channels = 4,
+        .cpp = 4,
+        .channel_bits = { 8, 8, 8, 8 },
+        .is_color = true,
+        .has_alpha = true,
+    },
+    {
+        FMT(VK_FORMAT_R8G8B8A8_SINT),
+        .num_type = CRU_NUM_TYPE_SINT,
+        .num_channels = 4,
+        .cpp = 4,
+        .channel_bits = { 8, 8, 8, 8 },
+        .is_color = true,
+        .has_alpha = true,
+    },
+    {
+        FMT(VK_FORMAT_R8G8B8A8_SRGB),
+        .num_type = CRU_NUM_TYPE_UNORM,
+        .num_channels = 4,
+        .cpp = 4,
+        .channel_bits = { 8, 8, 8, 8 },
+        .is_color = true,
+        .has_alpha = true,
+        .is_srgb = true,
+    },
+    {
+        FMT(VK_FORMAT_A2B10G10R10_UNORM_PACK32),
+        .num_type = CRU_NUM_TYPE_UNORM,
+        .num_channels = 4,
+        .cpp = 4,
+        .channel_bits = { 10, 10, 10, 2 },
+        .is_color = true,
+        .has_alpha = true,
+    },
+    {
+        FMT(VK_FORMAT_A2B10G10R10_UINT_PACK32),
+        .num_type = CRU_NUM_TYPE_UINT,
+        .num_channels = 4,
+        .cpp = 4,
+        .channel_bits = { 10, 10, 10, 2 },
+        .is_color = true,
+        .has_alpha = true,
+    },
+    {
+        FMT(VK_FORMAT_R16_SNORM),
+        .num_type = CRU_NUM_TYPE_SNORM,
+        .num_channels = 1,
+        .cpp = 2,
+        .channel_bits = { 16 },
+        .is_color = true,
+    },
+    {
+        FMT(VK_FORMAT_R16_UINT),
+        .num_type = CRU_NUM_TYPE_UINT,
+        .num_channels = 1,
+        .cpp = 2,
+        .channel_bits = { 16 },
+        .is_color = true,
+    },
+    {
+        FMT(VK_FORMAT_R16_SINT),
+        .num_type = CRU_NUM_TYPE_SINT,
+        .num_channels = 1,
+        .cpp = 2,
+        .channel_bits = { 16 },
+        .is_color = true,
+    },
+    {
+        FMT(VK_FORMAT_R16_SFLOAT),
+        .num_type = CRU_NUM_TYPE_SFLOAT,
+        .num_channels = 1,
+        .cpp = 2,
+        .channel_bits = { 16 },
+        .is_color = true,
+    },
+    {
+        FMT(VK_FORMAT_R16G16B16A16_UNORM),
+        .num_type = CRU_NUM_TYPE_UNORM,
+        .num_channels = 4,
+        .cpp = 8,
+        .channel_bits = { 16, 16, 16, 16 },
+        .is_color = true,
+        .has_alpha = true,
+    },
+    {
+        FMT(VK_FORMAT_R16G16B16A16_SFLOAT),
+        .num_type = CRU_NUM_TYPE_SFLOAT,
+        .num_channels = 4,
+        .cpp = 8,
+        .channel_bits = { 16, 16, 16, 16 },
+        .is_color = true,
+        .has_alpha = true,
+    },
+    {
+        FMT(VK_FORMAT_R32_SINT),
+        .num_type = CRU_NUM_TYPE_SINT,
+        .num_channels = 1,
+        .cpp = 4,
+        .channel_bits = { 32 },
         .is_color = true,
     },
+    {
+        FMT(VK_FORMAT_R32G32B32A32_UINT),
+        .num_type = CRU_NUM_TYPE_UINT,
+        .num_channels = 4,
+        .cpp = 16,
+        .channel_bits = { 32, 32, 32, 32 },
+        .is_color = true,
+        .has_alpha = true,
+    },
+    {
+        FMT(VK_FORMAT_R32G32B32A32_SFLOAT),
+        .num_type = CRU_NUM_TYPE_SFLOAT,
+        .num_channels = 4,
+        .cpp = 16,
+        .channel_bits = { 32, 32, 32, 32 },
+        .is_color = true,
+        .has_alpha = true,
+    },
     {
         FMT(VK_FORMAT_D16_UNORM),
         .num_type = CRU_NUM_TYPE_UNORM,
         .num_channels = 1,
         .cpp = 2,
+        .channel_bits = { 16 },
         .depth_format = VK_FORMAT_D16_UNORM,
     },
     {
         FMT(VK_FORMAT_X8_D24_UNORM_PACK32),
         .num_type = CRU_NUM_TYPE_UNORM,
         .num_channels = 1,
-        .cpp = 3,
+        .cpp = 4,
+        .channel_bits = { 24 },
         .depth_format = VK_FORMAT_X8_D24_UNORM_PACK32,
     },
     {
@@ -80,6 +244,7 @@ cru_format_info_table[] = {
         .num_type = CRU_NUM_TYPE_SFLOAT,
         .num_channels = 1,
         .cpp = 4,
+        .channel_bits = { 32 },
         .depth_format = VK_FORMAT_D32_SFLOAT,
     },
     {
@@ -87,6 +252,7 @@ cru_format_info_table[] = {
         .num_type = CRU_NUM_TYPE_UINT,
         .num_channels = 1,
         .cpp = 1,
+        .channel_bits = { 8 },
         .stencil_format = VK_FORMAT_S8_UINT,
     },
     {
@@ -94,6 +260,7 @@ cru_format_info_table[] = {
         .num_type = CRU_NUM_TYPE_UNDEFINED,
         .num_channels = 2,
         .cpp = 3,
+        .channel_bits = { 16, 8 },
         .depth_format = VK_FORMAT_D16_UNORM,
         .stencil_format = VK_FORMAT_S8_UINT,
     },
@@ -102,6 +269,7 @@ cru_format_info_table[] = {
         .num_type = CRU_NUM_TYPE_UNDEFINED,
         .num_channels = 2,
         .cpp = 4,
+        .channel_bits = { 24, 8 },
         .depth_format = VK_FORMAT_X8_D24_UNORM_PACK32,
         .stencil_format = VK_FORMAT_S8_UINT,
     },
@@ -110,12 +278,16 @@ cru_format_info_table[] = {
         .num_type = CRU_NUM_TYPE_UNDEFINED,
         .num_channels = 2,
         .cpp = 5,
+        .channel_bits = { 32, 8 },
         .depth_format = VK_FORMAT_D32_SFLOAT,
         .stencil_format = VK_FORMAT_S8_UINT,
     },
     {
         FMT(VK_FORMAT_BC3_UNORM_BLOCK),
         .num_type = CRU_NUM_TYPE_UNORM,
+        .block_width = 4,
+        .block_height = 4,
+        .block_size = 16,
         .is_color = true,
     },
     {
@@ -139,3 +311,33 @@ cru_format_get_info(VkFormat format)
 
     return NULL;
 }
+
+const struct cru_format_info *
+cru_format_get_info_by_name(const char *name)
+{
+    const struct cru_format_info *info;
+
+    for (info = cru_format_info_table;
+         info->format != VK_FORMAT_UNDEFINED; ++info) {
+        if (strcmp(info->name, name) == 0) {
+            return info;
+        }
+    }
+
+    return NULL;
+}
+
+size_t
+cru_format_get_image_size(const struct cru_format_info *info,
+                          uint32_t width, uint32_t height)
+{
+    if (info->block_size > 0) {
+        const size_t blocks_x = (width + info->block_width - 1) /
+                                info->block_width;
+        const size_t blocks_y = (height + info->block_height - 1) /
+                                info->block_height;
+        return blocks_x * blocks_y * info->block_size;
+    }
+
+    return (size_t) width * height * info->cpp;
+}
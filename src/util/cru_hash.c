@@ -0,0 +1,211 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/// \file
+/// \brief MurmurHash3_x64_128, by Austin Appleby, who placed it in the public
+/// domain.
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "util/cru_hash.h"
+
+static const uint64_t c1 = 0x87c37b91114253d5ull;
+static const uint64_t c2 = 0x4cf5ad432745937full;
+
+static inline uint64_t
+rotl64(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t
+fmix64(uint64_t k)
+{
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdull;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ull;
+    k ^= k >> 33;
+    return k;
+}
+
+static inline uint64_t
+mix_k1(uint64_t k1)
+{
+    k1 *= c1;
+    k1 = rotl64(k1, 31);
+    k1 *= c2;
+    return k1;
+}
+
+static inline uint64_t
+mix_k2(uint64_t k2)
+{
+    k2 *= c2;
+    k2 = rotl64(k2, 33);
+    k2 *= c1;
+    return k2;
+}
+
+static void
+hash_blocks(cru_hash128_state_t *state, const uint8_t *data, size_t nblocks)
+{
+    uint64_t h1 = state->h1;
+    uint64_t h2 = state->h2;
+
+    for (size_t i = 0; i < nblocks; i++) {
+        uint64_t k1, k2;
+
+        // Crucible runs only on little-endian hosts.
+        memcpy(&k1, data + 16 * i, 8);
+        memcpy(&k2, data + 16 * i + 8, 8);
+
+        h1 ^= mix_k1(k1);
+        h1 = rotl64(h1, 27);
+        h1 += h2;
+        h1 = h1 * 5 + 0x52dce729;
+
+        h2 ^= mix_k2(k2);
+        h2 = rotl64(h2, 31);
+        h2 += h1;
+        h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    state->h1 = h1;
+    state->h2 = h2;
+}
+
+void
+cru_hash128_init(cru_hash128_state_t *state, uint64_t seed)
+{
+    *state = (cru_hash128_state_t) {
+        .h1 = seed,
+        .h2 = seed,
+    };
+}
+
+void
+cru_hash128_update(cru_hash128_state_t *state, const void *data, size_t size)
+{
+    const uint8_t *p = data;
+    size_t tail_len = state->len % 16;
+
+    state->len += size;
+
+    if (tail_len > 0) {
+        size_t n = 16 - tail_len;
+        if (n > size)
+            n = size;
+
+        memcpy(state->tail + tail_len, p, n);
+        p += n;
+        size -= n;
+
+        if (tail_len + n < 16)
+            return;
+
+        hash_blocks(state, state->tail, 1);
+    }
+
+    hash_blocks(state, p, size / 16);
+    memcpy(state->tail, p + size / 16 * 16, size % 16);
+}
+
+cru_hash128_t
+cru_hash128_final(const cru_hash128_state_t *state)
+{
+    const size_t tail_len = state->len % 16;
+    uint64_t h1 = state->h1;
+    uint64_t h2 = state->h2;
+    uint64_t k1 = 0;
+    uint64_t k2 = 0;
+
+    for (size_t i = tail_len; i > 8; i--)
+        k2 ^= (uint64_t) state->tail[i - 1] << (8 * (i - 9));
+    if (tail_len > 8)
+        h2 ^= mix_k2(k2);
+
+    for (size_t i = tail_len < 8 ? tail_len : 8; i > 0; i--)
+        k1 ^= (uint64_t) state->tail[i - 1] << (8 * (i - 1));
+    if (tail_len > 0)
+        h1 ^= mix_k1(k1);
+
+    h1 ^= state->len;
+    h2 ^= state->len;
+
+    h1 += h2;
+    h2 += h1;
+
+    h1 = fmix64(h1);
+    h2 = fmix64(h2);
+
+    h1 += h2;
+    h2 += h1;
+
+    return (cru_hash128_t) { .h = { h1, h2 } };
+}
+
+cru_hash128_t
+cru_hash128(const void *data, size_t size)
+{
+    cru_hash128_state_t state;
+
+    cru_hash128_init(&state, 0);
+    cru_hash128_update(&state, data, size);
+    return cru_hash128_final(&state);
+}
+
+void
+cru_hash128_format(cru_hash128_t hash, char str[CRU_HASH128_STRING_LEN + 1])
+{
+    snprintf(str, CRU_HASH128_STRING_LEN + 1, "%016" PRIx64 "%016" PRIx64,
+             hash.h[0], hash.h[1]);
+}
+
+bool
+cru_hash128_parse(const char *str, cru_hash128_t *hash)
+{
+    for (int i = 0; i < 2; i++) {
+        uint64_t h = 0;
+
+        for (int j = 0; j < 16; j++) {
+            const char c = str[16 * i + j];
+            uint64_t d;
+
+            if (c >= '0' && c <= '9')
+                d = c - '0';
+            else if (c >= 'a' && c <= 'f')
+                d = c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F')
+                d = c - 'A' + 10;
+            else
+                return false;
+
+            h = (h << 4) | d;
+        }
+
+        hash->h[i] = h;
+    }
+
+    return true;
+}
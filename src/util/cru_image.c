@@ -30,11 +30,6 @@
 
 #include "cru_image.h"
 
-typedef bool (*pixel_copy_func_t)(
-                uint32_t width, uint32_t height,
-                void *src, uint32_t src_x, uint32_t src_y, uint32_t src_stride,
-                void *dest, uint32_t dest_x, uint32_t dest_y, uint32_t dest_stride);
-
 /// Caller must free the returned string.
 char *
 cru_image_get_abspath(const char *filename)
@@ -170,7 +165,13 @@ cru_image_from_filename(const char *_filename)
 
     if (string_endswith_cstr(&filename, ".png")) {
         image = cru_png_image_load_file(_filename);
-    } else if (string_endswith_cstr(&filename, ".ktx")) {
+    } else if (string_endswith_cstr(&filename, ".raw")) {
+        image = cru_raw_image_load_file(_filename);
+    } else if (string_endswith_cstr(&filename, ".jpg") ||
+               string_endswith_cstr(&filename, ".jpeg")) {
+        image = cru_jpeg_image_load_file(_filename);
+    } else if (string_endswith_cstr(&filename, ".ktx") ||
+               string_endswith_cstr(&filename, ".ktx2")) {
         loge("loading ktx requires array in %s", _filename);
     } else {
         loge("unknown file extension in %s", _filename);
@@ -182,15 +183,32 @@ cru_image_from_filename(const char *_filename)
 }
 
 bool
-cru_image_write_file(cru_image_t *image, const char *_filename)
+cru_image_write_file(cru_image_t *image, const char *filename)
+{
+    return cru_image_write_file_info(image, filename, NULL);
+}
+
+bool
+cru_image_write_file_info(cru_image_t *image, const char *_filename,
+                          const cru_image_write_info_t *info)
 {
+    static const cru_image_write_info_t default_info = {
+        .png_compression_level = -1,
+        .png_filter = CRU_PNG_FILTER_DEFAULT,
+    };
+
     string_t filename = STRING_INIT;
     bool res;
 
+    if (!info)
+        info = &default_info;
+
     string_copy_cstr(&filename, _filename);
 
     if (string_endswith_cstr(&filename, ".png")) {
-        res = cru_png_image_write_file(image, &filename);
+        res = cru_png_image_write_file(image, &filename, info);
+    } else if (string_endswith_cstr(&filename, ".raw")) {
+        res = cru_raw_image_write_file(image, &filename);
     } else {
         loge("unknown file extension in %s", _filename);
         res = false;
@@ -201,142 +219,13 @@ cru_image_write_file(cru_image_t *image, const char *_filename)
     return res;
 }
 
-static bool
-copy_unorm8_to_uint8(
-    uint32_t width, uint32_t height,
-    void *src, uint32_t src_x, uint32_t src_y, uint32_t src_stride,
-    void *dest, uint32_t dest_x, uint32_t dest_y, uint32_t dest_stride)
-{
-    const uint32_t cpp = 1;
-
-    for (uint32_t y = 0; y < height; ++y) {
-        void *src_row = src + ((src_y + y) * src_stride + src_x * cpp);
-        void *dest_row = dest + ((dest_y + y) * dest_stride + dest_x * cpp);
-        memcpy(dest_row, src_row, width * cpp);
-    }
-
-    return true;
-}
-
-static bool
-copy_uint8_to_unorm8(
-    uint32_t width, uint32_t height,
-    void *src, uint32_t src_x, uint32_t src_y, uint32_t src_stride,
-    void *dest, uint32_t dest_x, uint32_t dest_y, uint32_t dest_stride)
-{
-    return copy_unorm8_to_uint8(width, height,
-                                src, src_x, src_y, src_stride,
-                                dest, dest_x, dest_y, dest_stride);
-}
-
-static bool
-copy_unorm8_to_f32(
-    uint32_t width, uint32_t height,
-    void *src, uint32_t src_x, uint32_t src_y, uint32_t src_stride,
-    void *dest, uint32_t dest_x, uint32_t dest_y, uint32_t dest_stride)
-{
-    const uint32_t src_cpp = 1;
-    const uint32_t dest_cpp = 4;
-
-    for (uint32_t y = 0; y < height; ++y) {
-        void *src_row = src + ((src_y + y) * src_stride +
-                               src_x * src_cpp);
-
-        void *dest_row = dest + ((dest_y + y) * dest_stride +
-                                 dest_x * dest_cpp);
-
-        for (uint32_t x = 0; x < width; ++x) {
-            uint8_t *src_pix = src_row + (x * src_cpp);
-            float *dest_pix = dest_row + (x * dest_cpp);
-
-            dest_pix[0] = (float) src_pix[0] / UINT8_MAX;
-        }
-    }
-
-    return true;
-}
-
-static bool
-copy_f32_to_unorm8(
-    uint32_t width, uint32_t height,
-    void *src, uint32_t src_x, uint32_t src_y, uint32_t src_stride,
-    void *dest, uint32_t dest_x, uint32_t dest_y, uint32_t dest_stride)
-{
-    const uint32_t src_cpp = 4;
-    const uint32_t dest_cpp = 1;
-
-    for (uint32_t y = 0; y < height; ++y) {
-        void *src_row = src + ((src_y + y) * src_stride +
-                               src_x * src_cpp);
-
-        void *dest_row = dest + ((dest_y + y) * dest_stride +
-                                 dest_x * dest_cpp);
-
-        for (uint32_t x = 0; x < width; ++x) {
-            float *src_pix = src_row + (x * src_cpp);
-            uint8_t *dest_pix = dest_row + (x * dest_cpp);
-
-            dest_pix[0] = UINT8_MAX * src_pix[0];
-        }
-    }
-
-    return true;
-}
-
-static bool
-copy_unorm32_to_unorm8(
-    uint32_t width, uint32_t height,
-    void *src, uint32_t src_x, uint32_t src_y, uint32_t src_stride,
-    void *dest, uint32_t dest_x, uint32_t dest_y, uint32_t dest_stride)
-{
-    const uint32_t src_cpp = 4;
-    const uint32_t dest_cpp = 1;
-
-    for (uint32_t y = 0; y < height; ++y) {
-        void *src_row = src + ((src_y + y) * src_stride +
-                               src_x * src_cpp);
-
-        void *dest_row = dest + ((dest_y + y) * dest_stride +
-                                 dest_x * dest_cpp);
-
-        for (uint32_t x = 0; x < width; ++x) {
-            uint32_t *src_pix = src_row + (x * src_cpp);
-            uint8_t *dest_pix = dest_row + (x * dest_cpp);
-
-            dest_pix[0] = UINT8_MAX * ((uint64_t)src_pix[0]) / UINT32_MAX;
-        }
-    }
-
-    return true;
-}
-
-static bool
-copy_oneshot_memcpy(
-    uint32_t width, uint32_t height,
-    void *src, uint32_t src_x, uint32_t src_y, uint32_t src_stride,
-    void *dest, uint32_t dest_x, uint32_t dest_y, uint32_t dest_stride)
-{
-    assert(src_x == 0);
-    assert(src_y == 0);
-    assert(dest_x == 0);
-    assert(dest_y == 0);
-    assert(src_stride == dest_stride);
-
-    memcpy(dest, src, height * src_stride);
-
-    return true;
-}
-
 static bool
 cru_image_copy_pixels_to_pixels(cru_image_t *dest, cru_image_t *src)
 {
     bool result = false;
     uint8_t *src_pixels = NULL;
     uint8_t *dest_pixels = NULL;
-    pixel_copy_func_t copy_func;
-
-    const VkFormat src_format = src->format_info->format;
-    const VkFormat dest_format = dest->format_info->format;
+    cru_format_convert_t conv;
 
     const uint32_t width = src->width;
     const uint32_t height = src->height;
@@ -361,36 +250,18 @@ cru_image_copy_pixels_to_pixels(cru_image_t *dest, cru_image_t *src)
 
     if (src->format_info == dest->format_info
         && src_stride == dest_stride) {
-        copy_func = copy_oneshot_memcpy;
-    } else if (src_format == VK_FORMAT_R8_UNORM &&
-               dest_format == VK_FORMAT_D32_SFLOAT) {
-        copy_func = copy_unorm8_to_f32;
-    } else if (src_format == VK_FORMAT_R32_SFLOAT &&
-               dest_format == VK_FORMAT_R8_UNORM) {
-        copy_func = copy_f32_to_unorm8;
-    } else if (src_format == VK_FORMAT_R32_UINT &&
-               dest_format == VK_FORMAT_R8_UNORM) {
-        copy_func = copy_unorm32_to_unorm8;
-    } else if (src_format == VK_FORMAT_D32_SFLOAT &&
-               dest_format == VK_FORMAT_R8_UNORM) {
-        copy_func = copy_f32_to_unorm8;
-    } else if (src_format == VK_FORMAT_R8_UNORM &&
-               dest_format == VK_FORMAT_S8_UINT) {
-        copy_func = copy_unorm8_to_uint8;
-    } else if (src_format == VK_FORMAT_S8_UINT &&
-               dest_format == VK_FORMAT_R8_UNORM) {
-        copy_func = copy_uint8_to_unorm8;
+        memcpy(dest_pixels, src_pixels, height * src_stride);
+        result = true;
+    } else if (cru_format_convert_init(&conv, src->format_info,
+                                       dest->format_info)) {
+        cru_format_convert_rect(&conv, width, height,
+                                src_pixels, 0, 0, src_stride,
+                                dest_pixels, 0, 0, dest_stride);
+        result = true;
     } else {
         loge("%s: unsupported format combination", __func__);
-        goto fail_no_copy_func;
     }
 
-    result = copy_func(width, height,
-                       src_pixels, 0, 0, src_stride,
-                       dest_pixels, 0, 0, dest_stride);
-
-fail_no_copy_func:
-
     // Check the result of unmapping the destination image because writeback
     // can fail during unmap.
     result &= dest->unmap_pixels(dest);
@@ -425,83 +296,43 @@ cru_image_copy(cru_image_t *dest, cru_image_t *src)
 }
 
 bool
-cru_image_compare(cru_image_t *a, cru_image_t *b)
+cru_image_hash(cru_image_t *image, cru_hash128_t *hash)
 {
-    if (a->width != b->width || a->height != b->height) {
-        loge("%s: image dimensions differ", __func__);
+    const uint32_t cpp = image->format_info->cpp;
+    cru_hash128_state_t state;
+
+    if (cpp == 0) {
+        loge("%s: cannot hash image of format %s", __func__,
+             image->format_info->name);
         return false;
     }
 
-    return cru_image_compare_rect(a, 0, 0, b, 0, 0, a->width, a->height);
-}
-
-bool
-cru_image_compare_rect(cru_image_t *a, uint32_t a_x, uint32_t a_y,
-                       cru_image_t *b, uint32_t b_x, uint32_t b_y,
-                       uint32_t width, uint32_t height)
-{
-    bool result = false;
-    void *a_map = NULL;
-    void *b_map = NULL;
-
-    if (a == b)
-        return true;
-
-    if (a->format_info != b->format_info &&
-
-        !((a->format_info->format == VK_FORMAT_S8_UINT &&
-           b->format_info->format == VK_FORMAT_R8_UNORM) ||
-
-          (a->format_info->format == VK_FORMAT_R8_UNORM &&
-           b->format_info->format == VK_FORMAT_S8_UINT))) {
+    const uint8_t *pixels = image->map_pixels(image, CRU_IMAGE_MAP_ACCESS_READ);
+    if (!pixels)
+        return false;
 
-        // Maybe one day we'll want to support more formats.
-        loge("%s: image formats are incompatible", __func__);
-        goto cleanup;
-    }
+    const uint32_t row_size = image->width * cpp;
+    const uint32_t stride = cru_image_get_pitch_bytes(image);
+    const uint32_t header[] = {
+        image->format_info->format,
+        image->width,
+        image->height,
+    };
 
-    if (a_x + width > a->width || a_y + height > a->height ||
-        b_x + width > b->width || b_y + height > b->height) {
-        loge("%s: rect exceeds image dimensions", __func__);
-        goto cleanup;
-    }
+    cru_hash128_init(&state, 0);
+    cru_hash128_update(&state, header, sizeof(header));
 
-    const uint32_t cpp = a->format_info->cpp;
-    const uint32_t row_size = cpp * width;
-    const uint32_t a_stride = cru_image_get_pitch_bytes(a);
-    const uint32_t b_stride = cru_image_get_pitch_bytes(b);
-
-    a_map = a->map_pixels(a, CRU_IMAGE_MAP_ACCESS_READ);
-    if (!a_map)
-        goto cleanup;
-
-    b_map = b->map_pixels(b, CRU_IMAGE_MAP_ACCESS_READ);
-    if (!b_map)
-        goto cleanup;
-
-    // FINISHME: Support a configurable tolerance.
-    // FINISHME: Support dumping the diff to file.
-    for (uint32_t y = 0; y < height; ++y) {
-        const void *a_row = a_map + ((a_y + y) * a_stride + a_x * cpp);
-        const void *b_row = b_map + ((b_y + y) * b_stride + b_x * cpp);
-
-        if (memcmp(a_row, b_row, row_size) != 0) {
-            loge("%s: diff found in row %u of rect", __func__, y);
-            result = false;
-            goto cleanup;
-        }
+    if (stride == row_size) {
+        cru_hash128_update(&state, pixels, (size_t) row_size * image->height);
+    } else {
+        for (uint32_t y = 0; y < image->height; y++)
+            cru_hash128_update(&state, pixels + (size_t) y * stride, row_size);
     }
 
-    result = true;
-
-cleanup:
-    if (a_map)
-        a->unmap_pixels(a);
+    image->unmap_pixels(image);
 
-    if (b_map)
-        b->unmap_pixels(b);
-
-    return result;
+    *hash = cru_hash128_final(&state);
+    return true;
 }
 
 void *
@@ -546,6 +377,18 @@ cru_image_array_get_image(cru_image_array_t *ia, int index)
     return ia->images[index];
 }
 
+uint32_t
+cru_image_array_get_num_levels(cru_image_array_t *ia)
+{
+    return ia->num_levels;
+}
+
+uint32_t
+cru_image_array_get_num_layers(cru_image_array_t *ia)
+{
+    return ia->num_layers;
+}
+
 cru_image_array_t *
 cru_image_array_from_filename(const char *_filename)
 {
@@ -560,6 +403,8 @@ cru_image_array_from_filename(const char *_filename)
             return NULL;
         cru_refcount_init(&ia->refcount);
         ia->num_images = 1;
+        ia->num_levels = 1;
+        ia->num_layers = 1;
         ia->images = calloc(1, sizeof(struct cru_image *));
         if (!ia->images) {
             free(ia);
@@ -571,7 +416,8 @@ cru_image_array_from_filename(const char *_filename)
             free(ia);
             return NULL;
         }
-    } else if (string_endswith_cstr(&filename, ".ktx")) {
+    } else if (string_endswith_cstr(&filename, ".ktx") ||
+               string_endswith_cstr(&filename, ".ktx2")) {
         ia = cru_ktx_image_array_load_file(_filename);
     }
 
@@ -56,9 +56,56 @@ struct cru_image {
 struct cru_image_array {
     cru_refcount_t refcount;
     int num_images;
+
+    /// The images are ordered by miplevel and then by array layer, so the
+    /// image of a (level, layer) is at index level * num_layers + layer.
+    uint32_t num_levels;
+    uint32_t num_layers;
+
     struct cru_image **images;
 };
 
+// file: cru_format_convert.c
+typedef struct cru_format_convert cru_format_convert_t;
+
+/// \brief Converter of pixels from one format to another.
+///
+/// \see cru_format_convert_init()
+struct cru_format_convert {
+    const cru_format_info_t *src;
+    const cru_format_info_t *dest;
+
+    /// Convert \a width pixels of a row.
+    void (*convert_row)(const cru_format_convert_t *conv, uint32_t width,
+                        const uint8_t *src, uint8_t *dest);
+};
+
+/// Choose how to convert pixels from format \a src to format \a dest.
+/// Return false if the conversion is unsupported.
+bool cru_format_convert_init(cru_format_convert_t *conv,
+                             const cru_format_info_t *src,
+                             const cru_format_info_t *dest);
+
+void cru_format_convert_rect(const cru_format_convert_t *conv,
+                             uint32_t width, uint32_t height,
+                             const void *src, uint32_t src_x, uint32_t src_y,
+                             uint32_t src_stride,
+                             void *dest, uint32_t dest_x, uint32_t dest_y,
+                             uint32_t dest_stride);
+
+/// Return true if each pixel of the format is a little-endian integer of
+/// consecutive channels of one number type, which cru_format_read_channel()
+/// can read.
+bool cru_format_has_channels(const cru_format_info_t *info);
+
+/// \brief Read channel \a c of \a pixel without normalizing it.
+///
+/// Normalized and integer channels read as their integer value, sign
+/// extended if signed, and float channels, half or single precision, as
+/// their value.
+double cru_format_read_channel(const cru_format_info_t *info,
+                               const uint8_t *pixel, uint32_t c);
+
 // file: cru_image.c
 bool
 cru_image_init(cru_image_t *image, enum cru_image_type type, VkFormat format,
@@ -66,9 +113,42 @@ cru_image_init(cru_image_t *image, enum cru_image_type type, VkFormat format,
 char *cru_image_get_abspath(const char *filename);
 
 // file: cru_png_image.c
+typedef struct cru_png_row_reader cru_png_row_reader_t;
+
 cru_image_t *cru_png_image_load_file(const char *filename);
-bool cru_png_image_write_file(cru_image_t *image, const string_t *filename);
+bool cru_png_image_write_file(cru_image_t *image, const string_t *filename,
+                              const cru_image_write_info_t *info);
 bool cru_png_image_copy_to_pixels(cru_image_t *png_image, cru_image_t *dest);
 
+/// \brief Decode a PNG image one row at a time, from top to bottom.
+///
+/// Each row is in the image's format and is valid until the next read. The
+/// image must not be mapped while the reader exists. Return NULL if \a image
+/// is not a PNG image or cannot be decoded row by row, such as when it is
+/// interlaced.
+cru_png_row_reader_t *cru_png_image_begin_read_rows(cru_image_t *image);
+const uint8_t *cru_png_row_reader_read(cru_png_row_reader_t *reader);
+void cru_png_row_reader_destroy(cru_png_row_reader_t *reader);
+
+/// Return true if cru_image_map() of \a image would decode it.
+bool cru_png_image_needs_decode(cru_image_t *image);
+
+// file: cru_pixel_image.c
+
+/// Like cru_image_from_pixels(), but the image is read-only and frees
+/// \a pixels, which must come from malloc(), when destroyed. \a pixels is
+/// freed on failure too.
+cru_image_t *cru_pixel_image_from_owned_pixels(void *restrict pixels,
+                                               VkFormat format,
+                                               uint32_t width,
+                                               uint32_t height);
+
+// file: cru_jpeg_image.c
+cru_image_t *cru_jpeg_image_load_file(const char *filename);
+
+// file: cru_raw_image.c
+cru_image_t *cru_raw_image_load_file(const char *filename);
+bool cru_raw_image_write_file(cru_image_t *image, const string_t *filename);
+
 // file: cru_ktx_image.c
 cru_image_array_t *cru_ktx_image_array_load_file(const char *filename);
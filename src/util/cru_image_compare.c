@@ -0,0 +1,1065 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/// \file
+/// \brief Tolerant image comparison.
+///
+/// Images whose channels are all 8-bit compare a full SIMD vector of bytes
+/// per step. Other formats compare one channel at a time, and formats whose
+/// channels are signed, half float, or packed decode each channel first.
+/// Rows that are bitwise identical are skipped with memcmp(), which is also
+/// the common case for passing tests.
+///
+/// PNG images that have not been decoded yet are decoded one row at a time
+/// as the comparison proceeds, rather than mapped, so the decoded image is
+/// never held in memory whole and decoding stops early if the comparison
+/// does.
+///
+/// Large rects are split into bands of rows that a few threads compare in
+/// parallel. The result is identical to that of a single thread. The helper
+/// threads belong to a pool that is created on the first parallel
+/// comparison and shared by all later ones, so a comparison never waits for
+/// threads to start.
+
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CRU_IMAGE_COMPARE_X86 1
+#endif
+
+#include "util/log.h"
+#include "util/misc.h"
+#include "util/xalloc.h"
+
+#include "cru_image.h"
+
+struct compare_state {
+    uint32_t cpp;
+    uint32_t num_channels;
+
+    /// Size of each channel if all are unsigned integers or 32-bit floats
+    /// of 1, 2, or 4 bytes, which are compared in place. Otherwise zero.
+    uint32_t channel_size;
+
+    /// If channel_size is zero, the format whose channels are decoded with
+    /// cru_format_read_channel(). If this is NULL too, the format has no
+    /// channels and pixels are compared bitwise.
+    const cru_format_info_t *decode_info;
+
+    bool is_float;
+    double tolerance[4];
+
+    /// The tolerance of each byte of a 32-byte vector, for the 8-bit
+    /// kernels. Byte i belongs to channel i % cpp.
+    uint8_t tolerance_u8[32];
+
+    /// Maximum error of each byte lane of the 8-bit kernels. Reduced into
+    /// max_error when the comparison finishes.
+    uint8_t max_error_u8[32];
+    uint64_t sum_sq_u64;
+
+    double max_error[4];
+    double sum_sq;
+
+    uint64_t mismatch_count;
+    uint32_t min_x, min_y, max_x, max_y;
+
+    /// Row of the diff image for the row being compared, or NULL.
+    uint8_t *diff_row;
+};
+
+typedef void (*compare_row_func_t)(struct compare_state *s,
+                                   const uint8_t *a, const uint8_t *b,
+                                   uint32_t width, uint32_t y);
+
+static const uint8_t diff_match[4] = { 0, 0, 0, 255 };
+static const uint8_t diff_mismatch[4] = { 255, 0, 0, 255 };
+
+static void
+fill_diff_row(uint8_t *diff_row, uint32_t width)
+{
+    for (uint32_t x = 0; x < width; x++)
+        memcpy(diff_row + 4 * x, diff_match, 4);
+}
+
+static inline void
+mark_mismatch(struct compare_state *s, uint32_t x)
+{
+    if (s->diff_row)
+        memcpy(s->diff_row + 4 * x, diff_mismatch, 4);
+}
+
+/// Record that the mismatching pixels of row \a y number \a count and lie
+/// within [first_x, last_x].
+static void
+record_row(struct compare_state *s, uint32_t y, uint32_t count,
+           uint32_t first_x, uint32_t last_x)
+{
+    if (count == 0)
+        return;
+
+    if (s->mismatch_count == 0) {
+        s->min_x = first_x;
+        s->max_x = last_x;
+        s->min_y = y;
+    } else {
+        s->min_x = MIN(s->min_x, first_x);
+        s->max_x = MAX(s->max_x, last_x);
+    }
+
+    s->max_y = y;
+    s->mismatch_count += count;
+}
+
+static double
+channel_error(const struct compare_state *s, const uint8_t *a,
+              const uint8_t *b)
+{
+    switch (s->channel_size) {
+    case 1:
+        return abs((int) *a - (int) *b);
+    case 2: {
+        uint16_t a16, b16;
+        memcpy(&a16, a, 2);
+        memcpy(&b16, b, 2);
+        return abs((int) a16 - (int) b16);
+    }
+    case 4:
+        if (memcmp(a, b, 4) == 0)
+            return 0;
+
+        if (s->is_float) {
+            float af, bf;
+            memcpy(&af, a, 4);
+            memcpy(&bf, b, 4);
+
+            double err = fabs((double) af - (double) bf);
+            return isnan(err) ? INFINITY : err;
+        } else {
+            uint32_t a32, b32;
+            memcpy(&a32, a, 4);
+            memcpy(&b32, b, 4);
+            return a32 > b32 ? a32 - b32 : b32 - a32;
+        }
+    default:
+        cru_unreachable;
+    }
+}
+
+static double
+decoded_channel_error(const struct compare_state *s, const uint8_t *a,
+                      const uint8_t *b, uint32_t c)
+{
+    const double va = cru_format_read_channel(s->decode_info, a, c);
+    const double vb = cru_format_read_channel(s->decode_info, b, c);
+    const double err = fabs(va - vb);
+
+    if (isnan(err))
+        return isnan(va) && isnan(vb) ? 0 : INFINITY;
+
+    return err;
+}
+
+static void
+compare_row_scalar(struct compare_state *s, const uint8_t *a,
+                   const uint8_t *b, uint32_t width, uint32_t y)
+{
+    const uint32_t cpp = s->cpp;
+    uint32_t count = 0, first_x = 0, last_x = 0;
+
+    for (uint32_t x = 0; x < width; x++) {
+        const uint8_t *pa = a + x * cpp;
+        const uint8_t *pb = b + x * cpp;
+        bool mismatch = false;
+
+        if (s->channel_size == 0 && !s->decode_info) {
+            mismatch = memcmp(pa, pb, cpp) != 0;
+        } else {
+            for (uint32_t c = 0; c < s->num_channels; c++) {
+                const uint32_t offset = c * s->channel_size;
+                double err = s->decode_info ?
+                    decoded_channel_error(s, pa, pb, c) :
+                    channel_error(s, pa + offset, pb + offset);
+
+                s->max_error[c] = MAX(s->max_error[c], err);
+                s->sum_sq += err * err;
+
+                if (err > s->tolerance[c])
+                    mismatch = true;
+            }
+        }
+
+        if (mismatch) {
+            if (count++ == 0)
+                first_x = x;
+            last_x = x;
+            mark_mismatch(s, x);
+        }
+    }
+
+    record_row(s, y, count, first_x, last_x);
+}
+
+#ifdef CRU_IMAGE_COMPARE_X86
+
+/// Within a mask of the bytes of a vector that exceed the tolerance, set the
+/// first bit of each pixel that has any such byte, and clear all other bits.
+static inline uint32_t
+byte_mask_to_pixel_mask(uint32_t mask, uint32_t cpp)
+{
+    switch (cpp) {
+    case 1:
+        return mask;
+    case 2:
+        return (mask | (mask >> 1)) & 0x55555555;
+    case 4:
+        return (mask | (mask >> 1) | (mask >> 2) | (mask >> 3)) & 0x11111111;
+    default:
+        cru_unreachable;
+    }
+}
+
+static inline void
+record_block(struct compare_state *s, uint32_t byte_mask, uint32_t first_pixel,
+             uint32_t *count, uint32_t *first_x, uint32_t *last_x)
+{
+    uint32_t mask = byte_mask_to_pixel_mask(byte_mask, s->cpp);
+
+    if (*count == 0)
+        *first_x = first_pixel + __builtin_ctz(mask) / s->cpp;
+    *last_x = first_pixel + (31 - __builtin_clz(mask)) / s->cpp;
+    *count += __builtin_popcount(mask);
+
+    if (s->diff_row) {
+        while (mask) {
+            mark_mismatch(s, first_pixel + __builtin_ctz(mask) / s->cpp);
+            mask &= mask - 1;
+        }
+    }
+}
+
+/// Compare the pixels of an 8-bit row that follow the last full vector.
+static inline void
+compare_row_u8_tail(struct compare_state *s, const uint8_t *a,
+                    const uint8_t *b, uint32_t start, uint32_t width,
+                    uint32_t *count, uint32_t *first_x, uint32_t *last_x)
+{
+    const uint32_t cpp = s->cpp;
+
+    for (uint32_t x = start; x < width; x++) {
+        bool mismatch = false;
+
+        for (uint32_t c = 0; c < cpp; c++) {
+            const uint32_t i = x * cpp + c;
+            uint8_t err = a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+
+            s->max_error_u8[i % 32] = MAX(s->max_error_u8[i % 32], err);
+            s->sum_sq_u64 += (uint32_t) err * err;
+
+            if (err > s->tolerance_u8[c])
+                mismatch = true;
+        }
+
+        if (mismatch) {
+            if ((*count)++ == 0)
+                *first_x = x;
+            *last_x = x;
+            mark_mismatch(s, x);
+        }
+    }
+}
+
+__attribute__((target("sse2")))
+static uint64_t
+hsum_epi32_sse2(__m128i v)
+{
+    uint32_t lanes[4];
+    _mm_storeu_si128((__m128i *) lanes, v);
+    return (uint64_t) lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+__attribute__((target("sse2")))
+static void
+compare_row_u8_sse2(struct compare_state *s, const uint8_t *a,
+                    const uint8_t *b, uint32_t width, uint32_t y)
+{
+    // Each 32-bit lane of sum_sq grows by at most 4 * 255^2 per step, so
+    // flush it to 64 bits well before it can overflow.
+    const uint32_t flush_interval = 4096;
+
+    const uint32_t row_size = width * s->cpp;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i tol = _mm_loadu_si128((const __m128i *) s->tolerance_u8);
+    __m128i max = _mm_loadu_si128((const __m128i *) s->max_error_u8);
+    __m128i sum_sq = zero;
+    uint32_t count = 0, first_x = 0, last_x = 0;
+    uint32_t i, n = 0;
+
+    for (i = 0; i + 16 <= row_size; i += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i *) (a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i *) (b + i));
+        __m128i diff = _mm_or_si128(_mm_subs_epu8(va, vb),
+                                    _mm_subs_epu8(vb, va));
+
+        max = _mm_max_epu8(max, diff);
+
+        __m128i lo = _mm_unpacklo_epi8(diff, zero);
+        __m128i hi = _mm_unpackhi_epi8(diff, zero);
+        sum_sq = _mm_add_epi32(sum_sq, _mm_madd_epi16(lo, lo));
+        sum_sq = _mm_add_epi32(sum_sq, _mm_madd_epi16(hi, hi));
+
+        __m128i ok = _mm_cmpeq_epi8(_mm_subs_epu8(diff, tol), zero);
+        uint32_t mask = ~_mm_movemask_epi8(ok) & 0xffff;
+        if (mask)
+            record_block(s, mask, i / s->cpp, &count, &first_x, &last_x);
+
+        if (++n == flush_interval) {
+            s->sum_sq_u64 += hsum_epi32_sse2(sum_sq);
+            sum_sq = zero;
+            n = 0;
+        }
+    }
+
+    s->sum_sq_u64 += hsum_epi32_sse2(sum_sq);
+    _mm_storeu_si128((__m128i *) s->max_error_u8, max);
+
+    compare_row_u8_tail(s, a, b, i / s->cpp, width,
+                        &count, &first_x, &last_x);
+    record_row(s, y, count, first_x, last_x);
+}
+
+__attribute__((target("avx2")))
+static void
+compare_row_u8_avx2(struct compare_state *s, const uint8_t *a,
+                    const uint8_t *b, uint32_t width, uint32_t y)
+{
+    // See compare_row_u8_sse2().
+    const uint32_t flush_interval = 4096;
+
+    const uint32_t row_size = width * s->cpp;
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i tol = _mm256_loadu_si256((const __m256i *) s->tolerance_u8);
+    __m256i max = _mm256_loadu_si256((const __m256i *) s->max_error_u8);
+    __m256i sum_sq = zero;
+    uint32_t count = 0, first_x = 0, last_x = 0;
+    uint32_t i, n = 0;
+
+    for (i = 0; i + 32 <= row_size; i += 32) {
+        __m256i va = _mm256_loadu_si256((const __m256i *) (a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i *) (b + i));
+        __m256i diff = _mm256_or_si256(_mm256_subs_epu8(va, vb),
+                                       _mm256_subs_epu8(vb, va));
+
+        max = _mm256_max_epu8(max, diff);
+
+        __m256i lo = _mm256_unpacklo_epi8(diff, zero);
+        __m256i hi = _mm256_unpackhi_epi8(diff, zero);
+        sum_sq = _mm256_add_epi32(sum_sq, _mm256_madd_epi16(lo, lo));
+        sum_sq = _mm256_add_epi32(sum_sq, _mm256_madd_epi16(hi, hi));
+
+        __m256i ok = _mm256_cmpeq_epi8(_mm256_subs_epu8(diff, tol), zero);
+        uint32_t mask = ~(uint32_t) _mm256_movemask_epi8(ok);
+        if (mask)
+            record_block(s, mask, i / s->cpp, &count, &first_x, &last_x);
+
+        if (++n == flush_interval) {
+            s->sum_sq_u64 +=
+                hsum_epi32_sse2(_mm_add_epi32(_mm256_castsi256_si128(sum_sq),
+                                _mm256_extracti128_si256(sum_sq, 1)));
+            sum_sq = zero;
+            n = 0;
+        }
+    }
+
+    s->sum_sq_u64 +=
+        hsum_epi32_sse2(_mm_add_epi32(_mm256_castsi256_si128(sum_sq),
+                        _mm256_extracti128_si256(sum_sq, 1)));
+    _mm256_storeu_si256((__m256i *) s->max_error_u8, max);
+
+    compare_row_u8_tail(s, a, b, i / s->cpp, width,
+                        &count, &first_x, &last_x);
+    record_row(s, y, count, first_x, last_x);
+}
+
+#endif // CRU_IMAGE_COMPARE_X86
+
+static compare_row_func_t
+choose_row_func(const struct compare_state *s, enum cru_image_compare_isa isa)
+{
+    // The 8-bit kernels require that every channel be one byte and that a
+    // vector hold whole pixels.
+    if (s->channel_size != 1 || (s->cpp != 1 && s->cpp != 2 && s->cpp != 4))
+        return compare_row_scalar;
+
+#ifdef CRU_IMAGE_COMPARE_X86
+    if (isa == CRU_IMAGE_COMPARE_ISA_AUTO) {
+        if (__builtin_cpu_supports("avx2"))
+            return compare_row_u8_avx2;
+        if (__builtin_cpu_supports("sse2"))
+            return compare_row_u8_sse2;
+    }
+
+    if (isa == CRU_IMAGE_COMPARE_ISA_AVX2 && __builtin_cpu_supports("avx2"))
+        return compare_row_u8_avx2;
+
+    if ((isa == CRU_IMAGE_COMPARE_ISA_AVX2 ||
+         isa == CRU_IMAGE_COMPARE_ISA_SSE2) &&
+        __builtin_cpu_supports("sse2"))
+        return compare_row_u8_sse2;
+#endif
+
+    return compare_row_scalar;
+}
+
+/// Source of the rows of one of the compared images.
+struct row_source {
+    cru_image_t *image;
+
+    /// Set if the image is mapped.
+    uint8_t *map;
+    uint32_t stride;
+
+    /// Set if the image is a PNG image being decoded row by row.
+    cru_png_row_reader_t *png;
+    const uint8_t *png_row;
+    uint32_t png_next_y;
+};
+
+/// If \a allow_png_rows, a PNG image that has not been decoded yet is
+/// decoded one row at a time rather than mapped.
+static bool
+row_source_begin(struct row_source *src, cru_image_t *image,
+                 bool allow_png_rows)
+{
+    *src = (struct row_source) { .image = image };
+
+    if (allow_png_rows && cru_png_image_needs_decode(image)) {
+        src->png = cru_png_image_begin_read_rows(image);
+        if (src->png)
+            return true;
+    }
+
+    src->map = image->map_pixels(image, CRU_IMAGE_MAP_ACCESS_READ);
+    src->stride = cru_image_get_pitch_bytes(image);
+
+    return src->map != NULL;
+}
+
+/// Return row \a y of the image. Successive calls must not decrease \a y,
+/// unless the image is mapped, in which case any thread may call this.
+static const uint8_t *
+row_source_get(struct row_source *src, uint32_t y)
+{
+    if (src->map)
+        return src->map + y * src->stride;
+
+    while (src->png_next_y <= y) {
+        src->png_row = cru_png_row_reader_read(src->png);
+        if (!src->png_row)
+            return NULL;
+        src->png_next_y++;
+    }
+
+    return src->png_row;
+}
+
+static void
+row_source_finish(struct row_source *src)
+{
+    if (src->map)
+        src->image->unmap_pixels(src->image);
+
+    cru_png_row_reader_destroy(src->png);
+}
+
+static bool
+formats_are_compatible(const cru_format_info_t *a, const cru_format_info_t *b)
+{
+    if (a == b)
+        return true;
+
+    // Stencil images are compared against R8 reference images.
+    return (a->format == VK_FORMAT_S8_UINT &&
+            b->format == VK_FORMAT_R8_UNORM) ||
+           (a->format == VK_FORMAT_R8_UNORM &&
+            b->format == VK_FORMAT_S8_UINT);
+}
+
+/// Return false if the comparison needs a tolerance that the format has no
+/// channels to apply to.
+static bool
+compare_state_init(struct compare_state *s, const cru_format_info_t *info,
+                   const cru_image_compare_info_t *compare_info)
+{
+    *s = (struct compare_state) {
+        .cpp = info->cpp,
+        .num_channels = info->num_channels,
+        .is_float = info->num_type == CRU_NUM_TYPE_SFLOAT,
+    };
+
+    if (cru_format_has_channels(info)) {
+        s->channel_size = info->cpp / info->num_channels;
+        if (s->channel_size != 1 && s->channel_size != 2 &&
+            s->channel_size != 4)
+            s->channel_size = 0;
+
+        // Packed, signed, and half float channels are decoded.
+        for (uint32_t c = 0; c < info->num_channels; c++) {
+            if (info->channel_bits[c] != 8 * s->channel_size)
+                s->channel_size = 0;
+        }
+
+        if (info->num_type == CRU_NUM_TYPE_SNORM ||
+            info->num_type == CRU_NUM_TYPE_SINT ||
+            (s->is_float && s->channel_size != 4))
+            s->channel_size = 0;
+
+        if (s->channel_size == 0)
+            s->decode_info = info;
+    } else {
+        s->num_channels = 1;
+    }
+
+    for (uint32_t c = 0; c < 4; c++)
+        s->tolerance[c] = MAX(compare_info->tolerance[c], 0.0);
+
+    if (!s->decode_info && s->channel_size == 0) {
+        for (uint32_t c = 0; c < 4; c++) {
+            if (s->tolerance[c] > 0)
+                return false;
+        }
+    }
+
+    // Channel differences are integers, so truncating the tolerance doesn't
+    // change which pixels match.
+    if (s->channel_size == 1) {
+        for (uint32_t i = 0; i < ARRAY_LENGTH(s->tolerance_u8); i++) {
+            double tol = s->tolerance[i % s->cpp % 4];
+            s->tolerance_u8[i] = MIN(tol, 255.0);
+        }
+    }
+
+    return true;
+}
+
+static void
+compare_state_finish(struct compare_state *s, uint32_t width, uint32_t height,
+                     cru_image_compare_result_t *result)
+{
+    if (s->channel_size == 1) {
+        for (uint32_t i = 0; i < ARRAY_LENGTH(s->max_error_u8); i++) {
+            uint32_t c = i % s->cpp % 4;
+            s->max_error[c] = MAX(s->max_error[c], s->max_error_u8[i]);
+        }
+    }
+
+    const uint64_t num_samples = (uint64_t) width * height * s->num_channels;
+    const double sum_sq = s->sum_sq + s->sum_sq_u64;
+
+    *result = (cru_image_compare_result_t) {
+        .mismatch_count = s->mismatch_count,
+        .rms_error = num_samples ? sqrt(sum_sq / num_samples) : 0,
+        .min_x = s->min_x,
+        .min_y = s->min_y,
+        .max_x = s->max_x,
+        .max_y = s->max_y,
+    };
+
+    for (uint32_t c = 0; c < s->num_channels; c++)
+        result->max_error[c] = s->max_error[c];
+}
+
+/// Merge the state of a band of rows into \a s, which holds the state of the
+/// bands above it.
+static void
+compare_state_merge(struct compare_state *s, const struct compare_state *band)
+{
+    for (uint32_t i = 0; i < ARRAY_LENGTH(s->max_error_u8); i++)
+        s->max_error_u8[i] = MAX(s->max_error_u8[i], band->max_error_u8[i]);
+
+    for (uint32_t c = 0; c < 4; c++)
+        s->max_error[c] = MAX(s->max_error[c], band->max_error[c]);
+
+    s->sum_sq_u64 += band->sum_sq_u64;
+    s->sum_sq += band->sum_sq;
+
+    if (band->mismatch_count == 0)
+        return;
+
+    if (s->mismatch_count == 0) {
+        s->min_x = band->min_x;
+        s->max_x = band->max_x;
+        s->min_y = band->min_y;
+    } else {
+        s->min_x = MIN(s->min_x, band->min_x);
+        s->max_x = MAX(s->max_x, band->max_x);
+    }
+
+    s->max_y = band->max_y;
+    s->mismatch_count += band->mismatch_count;
+}
+
+/// A comparison of a rect, split into bands of rows.
+///
+/// The bands depend only on the size of the rect, and their states are
+/// merged in order, so the result is the same however many threads compare
+/// them. In particular, the floating-point error sums are always added in
+/// the same order.
+struct compare_job {
+    compare_row_func_t compare_row;
+
+    /// cru_image_compare_info::stop_at_first_mismatch, unless there is a
+    /// diff image, whose rows must all be filled.
+    bool stop_at_first_mismatch;
+
+    /// State of a band before any row is compared.
+    const struct compare_state *init;
+
+    struct row_source *a_src;
+    struct row_source *b_src;
+    uint32_t a_x, a_y;
+    uint32_t b_x, b_y;
+    uint32_t width;
+    uint32_t height;
+
+    uint8_t *diff_map;
+    uint32_t diff_stride;
+
+    uint32_t rows_per_band;
+    uint32_t num_bands;
+
+    /// The parallel comparison's state of each band.
+    struct compare_state *bands;
+    atomic_uint next_band;
+
+    /// With stop_at_first_mismatch, the lowest band
+    /// known to have a mismatch. Later bands need not be compared.
+    atomic_uint first_mismatch_band;
+
+    /// The pool's list of jobs with bands left to claim. The fields are
+    /// protected by compare_pool::mutex.
+    struct compare_job *next_job;
+    uint32_t max_helpers;
+    uint32_t num_helpers;
+};
+
+/// The helper threads of parallel comparisons. Each job's calling thread
+/// compares bands too, and helpers join it while it has bands left to claim.
+///
+/// The pool is created lazily and its threads live until the process exits.
+/// The test runner forks its workers before any of them compares an image,
+/// so no process inherits the pool of another.
+static struct compare_pool {
+    pthread_once_t once;
+    pthread_mutex_t mutex;
+
+    /// Signaled when a job is posted.
+    pthread_cond_t job_posted;
+
+    /// Signaled when a helper leaves a job.
+    pthread_cond_t helper_done;
+
+    struct compare_job *jobs;
+    uint32_t num_threads;
+} compare_pool = {
+    .once = PTHREAD_ONCE_INIT,
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .job_posted = PTHREAD_COND_INITIALIZER,
+    .helper_done = PTHREAD_COND_INITIALIZER,
+};
+
+/// Default of cru_image_compare_info::max_threads, or 0 for one per CPU.
+static atomic_uint compare_default_max_threads;
+
+/// Rects of at least this many pixels are split into bands of about
+/// COMPARE_BAND_PIXELS pixels, which may be compared in parallel.
+#define COMPARE_PARALLEL_MIN_PIXELS (1u << 20)
+#define COMPARE_BAND_PIXELS (1u << 16)
+#define COMPARE_MAX_THREADS 8
+
+static void
+compare_job_init_bands(struct compare_job *job)
+{
+    if ((uint64_t) job->width * job->height < COMPARE_PARALLEL_MIN_PIXELS) {
+        job->rows_per_band = MAX(job->height, 1);
+    } else {
+        job->rows_per_band = MAX(COMPARE_BAND_PIXELS / job->width, 1);
+    }
+
+    job->num_bands = (job->height + job->rows_per_band - 1) /
+                     job->rows_per_band;
+}
+
+/// Compare band \a band of the job's rect into \a s, which must be a copy
+/// of the job's initial state. Rows are fetched in increasing order, which
+/// a PNG row source requires.
+static bool
+compare_band(const struct compare_job *job, uint32_t band,
+             struct compare_state *s)
+{
+    const uint32_t cpp = s->cpp;
+    const uint32_t row_size = cpp * job->width;
+    const uint32_t y_begin = band * job->rows_per_band;
+    const uint32_t y_end = MIN(y_begin + job->rows_per_band, job->height);
+
+    for (uint32_t y = y_begin; y < y_end; ++y) {
+        const uint8_t *a_row = row_source_get(job->a_src, job->a_y + y);
+        const uint8_t *b_row = row_source_get(job->b_src, job->b_y + y);
+
+        if (!a_row || !b_row)
+            return false;
+
+        a_row += job->a_x * cpp;
+        b_row += job->b_x * cpp;
+
+        // Identical rows contribute nothing to the error.
+        const bool identical = memcmp(a_row, b_row, row_size) == 0;
+
+        if (job->diff_map) {
+            s->diff_row = job->diff_map + y * job->diff_stride;
+            fill_diff_row(s->diff_row, job->width);
+        }
+
+        if (identical)
+            continue;
+
+        job->compare_row(s, a_row, b_row, job->width, y);
+
+        if (s->mismatch_count > 0 && job->stop_at_first_mismatch)
+            break;
+    }
+
+    return true;
+}
+
+static bool
+compare_job_run_serial(struct compare_job *job, struct compare_state *s)
+{
+    for (uint32_t band = 0; band < job->num_bands; band++) {
+        struct compare_state band_state = *job->init;
+
+        if (!compare_band(job, band, &band_state))
+            return false;
+
+        compare_state_merge(s, &band_state);
+
+        if (s->mismatch_count > 0 && job->stop_at_first_mismatch)
+            break;
+    }
+
+    return true;
+}
+
+static void
+compare_job_work(struct compare_job *job)
+{
+    uint32_t band;
+
+    while ((band = atomic_fetch_add(&job->next_band, 1)) < job->num_bands) {
+        if (band > atomic_load(&job->first_mismatch_band))
+            continue;
+
+        struct compare_state *band_state = &job->bands[band];
+        *band_state = *job->init;
+
+        // Both images are mapped, so fetching a row cannot fail.
+        compare_band(job, band, band_state);
+
+        if (band_state->mismatch_count > 0 &&
+            job->stop_at_first_mismatch) {
+            uint32_t first = atomic_load(&job->first_mismatch_band);
+            while (band < first &&
+                   !atomic_compare_exchange_weak(&job->first_mismatch_band,
+                                                 &first, band)) {}
+        }
+    }
+}
+
+/// Return a posted job that can take another helper, or NULL.
+static struct compare_job *
+compare_pool_find_job(void)
+{
+    for (struct compare_job *job = compare_pool.jobs; job;
+         job = job->next_job) {
+        if (job->num_helpers < job->max_helpers &&
+            atomic_load(&job->next_band) < job->num_bands)
+            return job;
+    }
+
+    return NULL;
+}
+
+static void *
+compare_pool_thread(void *arg)
+{
+    struct compare_job *job;
+
+    pthread_mutex_lock(&compare_pool.mutex);
+
+    while (true) {
+        while (!(job = compare_pool_find_job()))
+            pthread_cond_wait(&compare_pool.job_posted, &compare_pool.mutex);
+
+        job->num_helpers++;
+        pthread_mutex_unlock(&compare_pool.mutex);
+
+        compare_job_work(job);
+
+        pthread_mutex_lock(&compare_pool.mutex);
+        job->num_helpers--;
+        pthread_cond_broadcast(&compare_pool.helper_done);
+    }
+
+    return NULL;
+}
+
+static void
+compare_pool_init(void)
+{
+    uint32_t n = atomic_load(&compare_default_max_threads);
+
+    if (n == 0) {
+        long nprocs = sysconf(_SC_NPROCESSORS_ONLN);
+        n = nprocs > 0 ? nprocs : 1;
+    }
+
+    n = MIN(n, COMPARE_MAX_THREADS);
+
+    // The calling thread of each job is the remaining thread.
+    for (uint32_t i = 1; i < n; i++) {
+        pthread_t thread;
+
+        if (pthread_create(&thread, NULL, compare_pool_thread, NULL) != 0)
+            break;
+
+        pthread_detach(thread);
+        compare_pool.num_threads++;
+    }
+}
+
+/// Compare the bands on up to \a num_threads threads, including the calling
+/// thread. Both row sources must be mapped.
+static void
+compare_job_run_parallel(struct compare_job *job, struct compare_state *s,
+                         uint32_t num_threads)
+{
+    job->bands = xmalloc(job->num_bands * sizeof(job->bands[0]));
+    atomic_init(&job->next_band, 0);
+    atomic_init(&job->first_mismatch_band, UINT32_MAX);
+    job->max_helpers = num_threads - 1;
+    job->num_helpers = 0;
+
+    pthread_mutex_lock(&compare_pool.mutex);
+    job->next_job = compare_pool.jobs;
+    compare_pool.jobs = job;
+    pthread_cond_broadcast(&compare_pool.job_posted);
+    pthread_mutex_unlock(&compare_pool.mutex);
+
+    compare_job_work(job);
+
+    // Every band has been claimed. Unlink the job so that no more helpers
+    // join it, and wait for those that did to finish their bands.
+    pthread_mutex_lock(&compare_pool.mutex);
+
+    struct compare_job **link = &compare_pool.jobs;
+    while (*link != job)
+        link = &(*link)->next_job;
+    *link = job->next_job;
+
+    while (job->num_helpers > 0)
+        pthread_cond_wait(&compare_pool.helper_done, &compare_pool.mutex);
+
+    pthread_mutex_unlock(&compare_pool.mutex);
+
+    const uint32_t last_band = MIN(atomic_load(&job->first_mismatch_band),
+                                   job->num_bands - 1);
+    for (uint32_t band = 0; band <= last_band; band++)
+        compare_state_merge(s, &job->bands[band]);
+
+    free(job->bands);
+}
+
+static uint32_t
+compare_num_threads(const cru_image_compare_info_t *info,
+                    const struct compare_job *job)
+{
+    if (job->num_bands <= 1 || info->max_threads == 1)
+        return 1;
+
+    pthread_once(&compare_pool.once, compare_pool_init);
+
+    uint32_t n = compare_pool.num_threads + 1;
+
+    if (info->max_threads > 0)
+        n = MIN(n, info->max_threads);
+
+    return MIN(n, job->num_bands);
+}
+
+void
+cru_image_compare_set_max_threads(uint32_t max_threads)
+{
+    atomic_store(&compare_default_max_threads, max_threads);
+}
+
+bool
+cru_image_compare_rect_stats(cru_image_t *a, uint32_t a_x, uint32_t a_y,
+                             cru_image_t *b, uint32_t b_x, uint32_t b_y,
+                             uint32_t width, uint32_t height,
+                             const cru_image_compare_info_t *info,
+                             cru_image_compare_result_t *result)
+{
+    static const cru_image_compare_info_t default_info = {0};
+    struct compare_state init, s;
+    struct row_source a_src = {0}, b_src = {0};
+    bool ok = false;
+
+    if (!info)
+        info = &default_info;
+
+    if (!formats_are_compatible(a->format_info, b->format_info)) {
+        // Maybe one day we'll want to support more formats.
+        loge("%s: image formats are incompatible", __func__);
+        return false;
+    }
+
+    if (a_x + width > a->width || a_y + height > a->height ||
+        b_x + width > b->width || b_y + height > b->height) {
+        loge("%s: rect exceeds image dimensions", __func__);
+        return false;
+    }
+
+    cru_image_t *diff = info->diff_image;
+    if (diff && (diff->format_info->format != VK_FORMAT_R8G8B8A8_UNORM ||
+                 diff->width < width || diff->height < height)) {
+        loge("%s: diff image must be VK_FORMAT_R8G8B8A8_UNORM and cover "
+             "the rect", __func__);
+        return false;
+    }
+
+    if (!compare_state_init(&init, a->format_info, info)) {
+        loge("%s: %s has no channels to apply a tolerance to", __func__,
+             a->format_info->name);
+        return false;
+    }
+
+    s = init;
+
+    struct compare_job job = {
+        .compare_row = choose_row_func(&init, info->isa),
+        .stop_at_first_mismatch = info->stop_at_first_mismatch && !diff,
+        .init = &init,
+        .a_src = &a_src,
+        .b_src = &a_src,
+        .a_x = a_x,
+        .a_y = a_y,
+        .b_x = b_x,
+        .b_y = b_y,
+        .width = width,
+        .height = height,
+    };
+
+    compare_job_init_bands(&job);
+    const uint32_t num_threads = compare_num_threads(info, &job);
+
+    // Decoding a PNG image row by row limits the comparison to one thread,
+    // so decode it whole if more would help.
+    const bool allow_png_rows = num_threads <= 1;
+
+    if (!row_source_begin(&a_src, a, allow_png_rows))
+        goto cleanup;
+
+    // Comparing an image against itself is legal, but it must be mapped or
+    // decoded only once.
+    if (b != a) {
+        if (!row_source_begin(&b_src, b, allow_png_rows))
+            goto cleanup;
+        job.b_src = &b_src;
+    }
+
+    if (diff) {
+        job.diff_map = diff->map_pixels(diff, CRU_IMAGE_MAP_ACCESS_WRITE);
+        if (!job.diff_map)
+            goto cleanup;
+        job.diff_stride = cru_image_get_pitch_bytes(diff);
+    }
+
+    if (num_threads > 1 && a_src.map && job.b_src->map) {
+        compare_job_run_parallel(&job, &s, num_threads);
+    } else if (!compare_job_run_serial(&job, &s)) {
+        goto cleanup;
+    }
+
+    compare_state_finish(&s, width, height, result);
+    ok = true;
+
+cleanup:
+    if (job.diff_map)
+        diff->unmap_pixels(diff);
+
+    row_source_finish(&b_src);
+    row_source_finish(&a_src);
+
+    return ok;
+}
+
+bool
+cru_image_compare(cru_image_t *a, cru_image_t *b)
+{
+    if (a->width != b->width || a->height != b->height) {
+        loge("%s: image dimensions differ", __func__);
+        return false;
+    }
+
+    return cru_image_compare_rect(a, 0, 0, b, 0, 0, a->width, a->height);
+}
+
+bool
+cru_image_compare_rect(cru_image_t *a, uint32_t a_x, uint32_t a_y,
+                       cru_image_t *b, uint32_t b_x, uint32_t b_y,
+                       uint32_t width, uint32_t height)
+{
+    cru_image_compare_result_t result;
+
+    if (a == b)
+        return true;
+
+    // Only pass or fail is needed, so stop at the first mismatching row.
+    const cru_image_compare_info_t info = {
+        .stop_at_first_mismatch = true,
+    };
+
+    if (!cru_image_compare_rect_stats(a, a_x, a_y, b, b_x, b_y,
+                                      width, height, &info, &result))
+        return false;
+
+    if (result.mismatch_count > 0) {
+        loge("%s: diff found in row %u of rect", __func__, result.min_y);
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,209 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/// \file
+/// \brief Background image file writer.
+///
+/// Encoding a PNG is dominated by deflate, which can take longer than the
+/// test that produced the image. A writer moves that work onto its own
+/// thread. Each queued image is first copied into memory the writer owns,
+/// because the caller's image may be rewritten, or its storage freed by the
+/// test's cleanup, before the write happens.
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "util/log.h"
+#include "util/xalloc.h"
+
+#include "cru_image.h"
+
+struct cru_image_write_job {
+    struct cru_image_write_job *next;
+
+    /// Copy of the queued image, backed by \a pixels.
+    cru_image_t *image;
+    void *pixels;
+
+    char *filename;
+};
+
+struct cru_image_writer {
+    cru_image_write_info_t info;
+
+    pthread_t thread;
+    pthread_mutex_t mutex;
+
+    /// Signaled when a job is queued or the writer is finishing.
+    pthread_cond_t cond;
+
+    /// FIFO of queued jobs. Protected by \a mutex.
+    struct cru_image_write_job *head;
+    struct cru_image_write_job **tail;
+
+    /// Set by cru_image_writer_finish(). Protected by \a mutex.
+    bool finishing;
+
+    /// Written only by the writer thread until it exits.
+    bool failed;
+};
+
+static void
+write_job_destroy(struct cru_image_write_job *job)
+{
+    cru_image_release(job->image);
+    free(job->pixels);
+    free(job->filename);
+    free(job);
+}
+
+static void *
+writer_thread_main(void *arg)
+{
+    cru_image_writer_t *writer = arg;
+
+    pthread_mutex_lock(&writer->mutex);
+
+    for (;;) {
+        while (!writer->head && !writer->finishing)
+            pthread_cond_wait(&writer->cond, &writer->mutex);
+
+        struct cru_image_write_job *job = writer->head;
+        if (!job)
+            break;
+
+        writer->head = job->next;
+        if (!writer->head)
+            writer->tail = &writer->head;
+
+        pthread_mutex_unlock(&writer->mutex);
+
+        if (!cru_image_write_file_info(job->image, job->filename,
+                                       &writer->info)) {
+            loge("failed to write image %s", job->filename);
+            writer->failed = true;
+        }
+
+        write_job_destroy(job);
+
+        pthread_mutex_lock(&writer->mutex);
+    }
+
+    pthread_mutex_unlock(&writer->mutex);
+
+    return NULL;
+}
+
+cru_image_writer_t *
+cru_image_writer_create(const cru_image_write_info_t *info)
+{
+    cru_image_writer_t *writer = xzalloc(sizeof(*writer));
+    int err;
+
+    if (info) {
+        writer->info = *info;
+    } else {
+        writer->info.png_compression_level = -1;
+        writer->info.png_filter = CRU_PNG_FILTER_DEFAULT;
+    }
+
+    writer->tail = &writer->head;
+
+    if (pthread_mutex_init(&writer->mutex, NULL))
+        goto fail_mutex;
+
+    if (pthread_cond_init(&writer->cond, NULL))
+        goto fail_cond;
+
+    err = pthread_create(&writer->thread, NULL, writer_thread_main, writer);
+    if (err) {
+        loge("%s: failed to create thread", __func__);
+        goto fail_thread;
+    }
+
+    return writer;
+
+fail_thread:
+    pthread_cond_destroy(&writer->cond);
+fail_cond:
+    pthread_mutex_destroy(&writer->mutex);
+fail_mutex:
+    free(writer);
+    return NULL;
+}
+
+bool
+cru_image_writer_enqueue(cru_image_writer_t *writer, cru_image_t *image,
+                         const char *filename)
+{
+    struct cru_image_write_job *job = xzalloc(sizeof(*job));
+
+    job->pixels = xmalloc((size_t) image->format_info->cpp *
+                          image->width * image->height);
+
+    job->image = cru_image_from_pixels(job->pixels, image->format_info->format,
+                                       image->width, image->height);
+    if (!job->image)
+        goto fail;
+
+    if (!cru_image_copy(job->image, image))
+        goto fail;
+
+    job->filename = xstrdup(filename);
+
+    pthread_mutex_lock(&writer->mutex);
+    *writer->tail = job;
+    writer->tail = &job->next;
+    pthread_cond_signal(&writer->cond);
+    pthread_mutex_unlock(&writer->mutex);
+
+    return true;
+
+fail:
+    loge("%s: failed to copy image for %s", __func__, filename);
+    if (job->image)
+        cru_image_release(job->image);
+    free(job->pixels);
+    free(job);
+    return false;
+}
+
+bool
+cru_image_writer_finish(cru_image_writer_t *writer)
+{
+    if (!writer)
+        return true;
+
+    pthread_mutex_lock(&writer->mutex);
+    writer->finishing = true;
+    pthread_cond_signal(&writer->cond);
+    pthread_mutex_unlock(&writer->mutex);
+
+    pthread_join(writer->thread, NULL);
+
+    const bool result = !writer->failed;
+
+    pthread_cond_destroy(&writer->cond);
+    pthread_mutex_destroy(&writer->mutex);
+    free(writer);
+
+    return result;
+}
@@ -0,0 +1,145 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/// \file
+/// \brief JPEG image files, load only.
+///
+/// Grayscale JPEG files load as VK_FORMAT_R8_UNORM images and all others as
+/// VK_FORMAT_R8G8B8A8_UNORM images with opaque alpha. The file is decoded
+/// when loaded.
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <jpeglib.h>
+
+#include "util/log.h"
+#include "util/xalloc.h"
+
+#include "cru_image.h"
+
+struct jpeg_error_ctx {
+    struct jpeg_error_mgr mgr;
+    jmp_buf jmp;
+    const char *filename;
+};
+
+static void
+jpeg_error_exit(j_common_ptr cinfo)
+{
+    struct jpeg_error_ctx *err = (struct jpeg_error_ctx *) cinfo->err;
+    char msg[JMSG_LENGTH_MAX];
+
+    cinfo->err->format_message(cinfo, msg);
+    loge("%s: %s", err->filename, msg);
+
+    longjmp(err->jmp, 1);
+}
+
+static void
+jpeg_output_message(j_common_ptr cinfo)
+{
+    // Warnings about corrupt data are errors for crucible, and they are
+    // reported through jpeg_error_exit(). Ignore the rest.
+}
+
+cru_image_t *
+cru_jpeg_image_load_file(const char *filename)
+{
+    struct jpeg_decompress_struct cinfo;
+    struct jpeg_error_ctx err;
+    char *abspath = NULL;
+    FILE *f = NULL;
+
+    // Modified between setjmp() and longjmp(), so volatile.
+    uint8_t *volatile pixels = NULL;
+    uint8_t *volatile row = NULL;
+
+    abspath = cru_image_get_abspath(filename);
+    if (!abspath)
+        return NULL;
+
+    f = fopen(abspath, "rb");
+    if (!f) {
+        loge("failed to open file for reading: %s", abspath);
+        free(abspath);
+        return NULL;
+    }
+
+    cinfo.err = jpeg_std_error(&err.mgr);
+    err.mgr.error_exit = jpeg_error_exit;
+    err.mgr.output_message = jpeg_output_message;
+    err.filename = abspath;
+
+    if (setjmp(err.jmp)) {
+        jpeg_destroy_decompress(&cinfo);
+        free(pixels);
+        free(row);
+        fclose(f);
+        free(abspath);
+        return NULL;
+    }
+
+    jpeg_create_decompress(&cinfo);
+    jpeg_stdio_src(&cinfo, f);
+    jpeg_read_header(&cinfo, TRUE);
+
+    const bool is_gray = cinfo.jpeg_color_space == JCS_GRAYSCALE;
+    cinfo.out_color_space = is_gray ? JCS_GRAYSCALE : JCS_RGB;
+
+    jpeg_start_decompress(&cinfo);
+
+    const uint32_t width = cinfo.output_width;
+    const uint32_t height = cinfo.output_height;
+    const uint32_t cpp = is_gray ? 1 : 4;
+
+    pixels = xmalloc((size_t) width * height * cpp);
+    if (!is_gray)
+        row = xmalloc(3 * width);
+
+    while (cinfo.output_scanline < height) {
+        uint8_t *dest = pixels + (size_t) cinfo.output_scanline * width * cpp;
+        JSAMPROW rows[1] = { is_gray ? dest : row };
+
+        jpeg_read_scanlines(&cinfo, rows, 1);
+
+        if (is_gray)
+            continue;
+
+        for (uint32_t x = 0; x < width; x++) {
+            dest[4 * x + 0] = row[3 * x + 0];
+            dest[4 * x + 1] = row[3 * x + 1];
+            dest[4 * x + 2] = row[3 * x + 2];
+            dest[4 * x + 3] = 0xff;
+        }
+    }
+
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    free(row);
+    fclose(f);
+    free(abspath);
+
+    return cru_pixel_image_from_owned_pixels(pixels,
+            is_gray ? VK_FORMAT_R8_UNORM : VK_FORMAT_R8G8B8A8_UNORM,
+            width, height);
+}
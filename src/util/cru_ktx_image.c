@@ -19,13 +19,34 @@
 // FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
 // IN THE SOFTWARE.
 
+/// \file
+/// \brief KTX and KTX2 image files.
+///
+/// The file is mapped read-only rather than read into memory, and each image
+/// of the array is a view into the mapping. Mapping a KTX image therefore
+/// costs no copy, and concurrent tests that load the same file share its
+/// pages through the page cache.
+///
+/// The exception is a KTX2 file with zstd supercompression, whose miplevels
+/// are decompressed into buffers owned by the ktx_image_info. Crucible
+/// supports zstd only when built with libzstd.
+
 #include <alloca.h>
 #include <endian.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "util/cru_format.h"
 #include "util/log.h"
+#include "util/misc.h"
 #include "util/xalloc.h"
 #include "cru_image.h"
 
@@ -37,10 +58,18 @@
 typedef struct cru_ktx_image cru_ktx_image_t;
 
 struct ktx_image_info {
-    FILE *file;
-    const char *filename;
+    char *filename;
+
+    /// Size of the file, and of the read-only mapping at \a data.
     size_t size;
     void *data;
+
+    bool is_ktx2;
+
+    /// For a supercompressed KTX2 file, the decompressed data of each
+    /// miplevel. Otherwise NULL.
+    uint8_t **level_data;
+
     VkFormat vk_format;
     VkImageViewType target;
     uint32_t gl_type;
@@ -54,6 +83,11 @@ struct ktx_image_info {
     uint32_t array_length;
     uint32_t num_faces;
     uint32_t num_miplevels;
+
+    /// Number of images in each miplevel. Each array layer, and each face
+    /// of a cube map, is a separate image.
+    uint32_t num_layers;
+
     uint32_t num_images;
 
     cru_refcount_t refcount;
@@ -62,32 +96,65 @@ struct ktx_image_info {
 struct cru_ktx_image {
     cru_image_t image;
 
-    void *data;
+    /// The image's pixels, within the mapping of cru_ktx_image::info.
+    uint8_t *data;
     struct ktx_image_info *info;
-
-    struct {
-        /// When mapping the cru_png_image for reading, we decode the file into
-        /// this pixel array.
-        uint8_t *pixels;
-
-        /// Concrete type is cru_pixel_image_t.  The image's backing storage is
-        /// `cru_ktx_image::map.pixels`.
-        cru_image_t *pixel_image;
-
-        /// Bitmask of `CRU_IMAGE_MAP_ACCESS_*`.
-        uint32_t access;
-    } map;
 };
 
 static const int cru_ktx_header_length = 64;
 static const char cru_ktx_magic_number[12] =
         { 0xab, 'K', 'T', 'X', ' ', '1', '1', 0xbb, '\r', '\n', 0x1a, '\n' };
 
+static const int cru_ktx2_header_length = 80;
+static const char cru_ktx2_magic_number[12] =
+        { 0xab, 'K', 'T', 'X', ' ', '2', '0', 0xbb, '\r', '\n', 0x1a, '\n' };
+
+enum ktx2_supercompression_scheme {
+    KTX2_SUPERCOMPRESSION_NONE = 0,
+    KTX2_SUPERCOMPRESSION_BASISLZ = 1,
+    KTX2_SUPERCOMPRESSION_ZSTD = 2,
+    KTX2_SUPERCOMPRESSION_ZLIB = 3,
+};
+
+/// The KTX2 header that follows the identifier. All fields are little
+/// endian.
+struct ktx2_header {
+    uint32_t vk_format;
+    uint32_t type_size;
+    uint32_t pixel_width;
+    uint32_t pixel_height;
+    uint32_t pixel_depth;
+    uint32_t layer_count;
+    uint32_t face_count;
+    uint32_t level_count;
+    uint32_t supercompression_scheme;
+    uint32_t dfd_byte_offset;
+    uint32_t dfd_byte_length;
+    uint32_t kvd_byte_offset;
+    uint32_t kvd_byte_length;
+    uint64_t sgd_byte_offset;
+    uint64_t sgd_byte_length;
+};
+
+/// An entry of the KTX2 level index, which immediately follows the header.
+struct ktx2_level_index {
+    uint64_t byte_offset;
+    uint64_t byte_length;
+    uint64_t uncompressed_byte_length;
+};
+
 static void
 cru_ktx_image_info_unref(struct ktx_image_info *image_info)
 {
     if (cru_refcount_put(&image_info->refcount) == 0) {
-        fclose(image_info->file);
+        if (image_info->level_data) {
+            for (uint32_t i = 0; i < image_info->num_miplevels; i++)
+                free(image_info->level_data[i]);
+            free(image_info->level_data);
+        }
+
+        munmap(image_info->data, image_info->size);
+        free(image_info->filename);
         free(image_info);
     }
 }
@@ -99,7 +166,9 @@ cru_ktx_image_destroy(cru_image_t *image)
     if (!ktx_image)
         return;
 
-    cru_ktx_image_info_unref(ktx_image->info);
+    if (ktx_image->info)
+        cru_ktx_image_info_unref(ktx_image->info);
+
     free(ktx_image);
 }
 
@@ -110,25 +179,16 @@ cru_ktx_image_map_pixels(cru_image_t *image, uint32_t access)
 
     if (access & CRU_IMAGE_MAP_ACCESS_WRITE) {
         loge("crucible ktx images are read-only; cannot image for writing");
-        goto fail;
+        return NULL;
     }
-    if (ktx_image->map.pixels)
-        return ktx_image->map.pixels;
 
-    ktx_image->map.access = access;
-    ktx_image->map.pixels = ktx_image->data;
     return ktx_image->data;
- fail:
-    return NULL;
 }
 
 static bool
 cru_ktx_image_unmap_pixels(cru_image_t *image)
 {
-    cru_ktx_image_t *ktx_image = (cru_ktx_image_t *)image;
-    // PNG images are always read-only.
-    assert(!(ktx_image->map.access & CRU_IMAGE_MAP_ACCESS_WRITE));
-
+    // The pixels remain mapped until the image is destroyed.
     return true;
 }
 
@@ -202,8 +262,8 @@ cru_ktx_calc_base_image_size(struct ktx_image_info *image,
         break;
     case VK_IMAGE_VIEW_TYPE_1D_ARRAY:
         *width = image->pixel_width;
-        *height = image->array_length;
-        *depth = 0;
+        *height = 0;
+        *depth = image->array_length;
         break;
     case VK_IMAGE_VIEW_TYPE_2D:
         *width = image->pixel_width;
@@ -286,10 +346,106 @@ cru_ktx_parse_header(struct ktx_image_info *image)
     if (!ok)
         return false;
 
-    if (image->target == VK_IMAGE_VIEW_TYPE_CUBE)
-        image->num_images = 6 * image->num_miplevels;
-    else
-        image->num_images = image->num_miplevels;
+    switch (image->target) {
+    case VK_IMAGE_VIEW_TYPE_CUBE:
+        image->num_layers = 6;
+        break;
+    case VK_IMAGE_VIEW_TYPE_1D_ARRAY:
+    case VK_IMAGE_VIEW_TYPE_2D_ARRAY:
+        image->num_layers = image->array_length;
+        break;
+    case VK_IMAGE_VIEW_TYPE_CUBE_ARRAY:
+        image->num_layers = 6 * image->array_length;
+        break;
+    default:
+        image->num_layers = 1;
+        break;
+    }
+
+    image->num_images = image->num_layers * image->num_miplevels;
+
+    return true;
+}
+
+static bool
+cru_ktx2_parse_header(struct ktx_image_info *image)
+{
+    struct ktx2_header h;
+
+    if (image->size < cru_ktx2_header_length) {
+        loge("%s: KTX2 data size must be at least 80 bytes", image->filename);
+        return false;
+    }
+
+    memcpy(&h, (const uint8_t *) image->data + sizeof(cru_ktx2_magic_number),
+           sizeof(h));
+
+    if (h.vk_format == VK_FORMAT_UNDEFINED) {
+        loge("%s: KTX2 files without a vkFormat are not supported",
+             image->filename);
+        return false;
+    }
+
+    const struct cru_format_info *format_info =
+        cru_format_get_info(h.vk_format);
+    if (!format_info ||
+        cru_format_get_image_size(format_info, 1, 1) == 0) {
+        loge("%s: unsupported KTX2 vkFormat %u", image->filename,
+             h.vk_format);
+        return false;
+    }
+
+    if (h.pixel_depth > 1) {
+        loge("%s: 3D KTX2 images are not supported", image->filename);
+        return false;
+    }
+
+    switch (h.supercompression_scheme) {
+    case KTX2_SUPERCOMPRESSION_NONE:
+        break;
+    case KTX2_SUPERCOMPRESSION_ZSTD:
+#ifdef HAVE_ZSTD
+        break;
+#else
+        loge("%s: crucible was built without zstd support",
+             image->filename);
+        return false;
+#endif
+    default:
+        loge("%s: unsupported KTX2 supercompression scheme %u",
+             image->filename, h.supercompression_scheme);
+        return false;
+    }
+
+    // A levelCount of 0 requests mipmap generation from the base level,
+    // which crucible does not do. Load the base level alone.
+    const uint32_t num_miplevels = MAX(h.level_count, 1);
+
+    if ((image->size - cru_ktx2_header_length) /
+            sizeof(struct ktx2_level_index) < num_miplevels) {
+        loge("%s: KTX2 level index exceeds file size", image->filename);
+        return false;
+    }
+
+    image->is_ktx2 = true;
+    image->vk_format = h.vk_format;
+    image->pixel_width = h.pixel_width;
+    image->pixel_height = h.pixel_height;
+    image->pixel_depth = 0;
+    image->array_length = h.layer_count;
+    image->num_faces = h.face_count;
+    image->num_miplevels = num_miplevels;
+
+    if (!cru_ktx_calc_target(image))
+        return false;
+
+    image->num_layers = MAX(h.layer_count, 1) * h.face_count;
+    image->num_images = image->num_layers * image->num_miplevels;
+
+    if (h.supercompression_scheme == KTX2_SUPERCOMPRESSION_ZSTD) {
+        image->level_data = xzalloc(num_miplevels *
+                                    sizeof(image->level_data[0]));
+    }
 
     return true;
 }
@@ -303,18 +459,34 @@ minify(uint32_t *n)
                 *n >>= 1;
 }
 
+static bool
+cru_ktx_image_init_view(cru_ktx_image_t *ktx_image,
+                        struct ktx_image_info *image_info,
+                        uint32_t width, uint32_t height,
+                        const uint8_t *data)
+{
+    if (!cru_image_init(&ktx_image->image, CRU_IMAGE_TYPE_KTX,
+                        image_info->vk_format, width, MAX(height, 1),
+                        /*read_only*/ true))
+        return false;
+
+    ktx_image->image.destroy = cru_ktx_image_destroy;
+    ktx_image->image.map_pixels = cru_ktx_image_map_pixels;
+    ktx_image->image.unmap_pixels = cru_ktx_image_unmap_pixels;
+    ktx_image->data = (uint8_t *) data;
+
+    return true;
+}
+
+/// Create the images of \a ia as views into the mapped file, in order of
+/// miplevel and then layer.
 static bool
 cru_ktx_parse_images(struct ktx_image_info *image_info,
                      cru_image_array_t *ia)
 {
-    /*
-     * Current byte being parsed. Used to traverse data with a step of
-     * either 8 or 32 bits.
-     */
-    union piglit_ktx_position {
-        uint8_t *u8;
-        uint32_t *u32;
-    } p;
+    const uint8_t *const begin = image_info->data;
+    const uint8_t *const end = begin + image_info->size;
+    const uint8_t *p = begin + cru_ktx_header_length;
 
     uint32_t pixel_width;
     uint32_t pixel_height;
@@ -322,49 +494,59 @@ cru_ktx_parse_images(struct ktx_image_info *image_info,
 
     cru_ktx_calc_base_image_size(image_info, &pixel_width,
                                  &pixel_height, &pixel_depth);
-    /* Loop counters */
-    int miplevel;
-    int face;
 
-    /* Skip header. */
-    p.u8 = image_info->data;
-    p.u8 += cru_ktx_header_length;
+    // Skip the key/value data.
+    const uint32_t bytes_of_key_value_data = ((const uint32_t *) begin)[15];
+    if (bytes_of_key_value_data > end - p) {
+        loge("%s: key/value data exceeds file size", image_info->filename);
+        return false;
+    }
+    p += bytes_of_key_value_data;
 
-    int idx = 0;
-    struct cru_ktx_image *ktx_image = (struct cru_ktx_image *)ia->images[0];
+    const bool is_cube = image_info->target == VK_IMAGE_VIEW_TYPE_CUBE;
+    uint32_t idx = 0;
 
-#define CUR_SIZE (p.u8 - (uint8_t *) image_info->data)
+    for (uint32_t miplevel = 0; miplevel < image_info->num_miplevels;
+         ++miplevel) {
+        if (end - p < 4) {
+            loge("%s: miplevel %u exceeds file size", image_info->filename,
+                 miplevel);
+            return false;
+        }
 
-    for (miplevel = 0; miplevel < image_info->num_miplevels; ++miplevel) {
-        uint32_t image_size;
+        const uint32_t image_size = *(const uint32_t *) p;
+        p += 4;
 
-        if (image_info->size < CUR_SIZE + 1) {
-            return false;
+        // The imageSize of a non-array cube map is the size of one face, and
+        // each face is padded to 4 bytes. Otherwise it is the size of all
+        // layers of the miplevel.
+        const uint32_t layer_size =
+            is_cube ? image_size : image_size / image_info->num_layers;
+
+        for (uint32_t layer = 0; layer < image_info->num_layers; ++layer) {
+            cru_ktx_image_t *ktx_image = (cru_ktx_image_t *) ia->images[idx++];
+
+            if (layer_size > end - p) {
+                loge("%s: miplevel %u layer %u exceeds file size",
+                     image_info->filename, miplevel, layer);
+                return false;
+            }
+
+            if (!cru_ktx_image_init_view(ktx_image, image_info, pixel_width,
+                                         pixel_height, p))
+                return false;
+
+            p += layer_size;
+
+            if (is_cube) {
+                // cubePadding
+                p += (4 - (p - begin) % 4) % 4;
+            }
         }
 
-        image_size = *p.u32;
-        ++p.u32;
-
-        for (face = 0; face < 6; ++face) {
-            cru_image_init(&ktx_image->image, CRU_IMAGE_TYPE_KTX,
-                           image_info->vk_format, pixel_width, pixel_height, true);
-
-            ktx_image->image.destroy = cru_ktx_image_destroy;
-            ktx_image->image.map_pixels = cru_ktx_image_map_pixels;
-            ktx_image->image.unmap_pixels = cru_ktx_image_unmap_pixels;
-            ktx_image->data = p.u8;
-            p.u8 += image_size;
-            idx++;
-            if (idx >= image_info->num_images)
-                break;
-            ktx_image = (struct cru_ktx_image *)ia->images[idx];
-
-            /* Padding */
-            while (CUR_SIZE % 4 != 0)
-                ++p.u8;
-
-            if (image_info->target != VK_IMAGE_VIEW_TYPE_CUBE)
-                break;
+        if (!is_cube) {
+            // mipPadding
+            p += (4 - (p - begin) % 4) % 4;
         }
 
         switch (image_info->target) {
@@ -390,16 +572,96 @@ cru_ktx_parse_images(struct ktx_image_info *image_info,
         }
     }
 
-    if (image_info->size < CUR_SIZE) {
-        /*
-         * The last image's data lies, at least partially, in
-         * out-of-bounds memory.
-         */
-        loge("size of data stream incorrect");
-        return false;
+    return true;
+}
+
+#ifdef HAVE_ZSTD
+static const uint8_t *
+cru_ktx2_decompress_level(struct ktx_image_info *image_info,
+                          uint32_t miplevel, const uint8_t *src,
+                          const struct ktx2_level_index *level)
+{
+    uint8_t *dest = xmalloc(level->uncompressed_byte_length);
+    const size_t size = ZSTD_decompress(dest, level->uncompressed_byte_length,
+                                        src, level->byte_length);
+
+    if (ZSTD_isError(size) || size != level->uncompressed_byte_length) {
+        loge("%s: failed to decompress miplevel %u", image_info->filename,
+             miplevel);
+        free(dest);
+        return NULL;
+    }
+
+    image_info->level_data[miplevel] = dest;
+    return dest;
+}
+#endif
+
+/// Create the images of \a ia from the KTX2 level index, in order of
+/// miplevel and then layer. Within a KTX2 miplevel, the faces of each layer
+/// are consecutive, which is also Vulkan's order of cube array layers.
+static bool
+cru_ktx2_parse_images(struct ktx_image_info *image_info,
+                      cru_image_array_t *ia)
+{
+    const uint8_t *const begin = image_info->data;
+    const struct cru_format_info *format_info =
+        cru_format_get_info(image_info->vk_format);
+    uint32_t pixel_width = image_info->pixel_width;
+    uint32_t pixel_height = MAX(image_info->pixel_height, 1);
+    uint32_t idx = 0;
+
+    for (uint32_t miplevel = 0; miplevel < image_info->num_miplevels;
+         ++miplevel) {
+        struct ktx2_level_index level;
+
+        memcpy(&level, begin + cru_ktx2_header_length +
+                       miplevel * sizeof(level), sizeof(level));
+
+        if (level.byte_offset > image_info->size ||
+            level.byte_length > image_info->size - level.byte_offset) {
+            loge("%s: miplevel %u exceeds file size", image_info->filename,
+                 miplevel);
+            return false;
+        }
+
+        const uint8_t *p = begin + level.byte_offset;
+        uint64_t level_size = level.byte_length;
+
+        if (image_info->level_data) {
+#ifdef HAVE_ZSTD
+            p = cru_ktx2_decompress_level(image_info, miplevel, p, &level);
+            if (!p)
+                return false;
+            level_size = level.uncompressed_byte_length;
+#else
+            cru_unreachable;
+#endif
+        }
+
+        const size_t layer_size =
+            cru_format_get_image_size(format_info, pixel_width, pixel_height);
+
+        if (level_size / image_info->num_layers < layer_size) {
+            loge("%s: miplevel %u is too small", image_info->filename,
+                 miplevel);
+            return false;
+        }
+
+        for (uint32_t layer = 0; layer < image_info->num_layers; ++layer) {
+            cru_ktx_image_t *ktx_image = (cru_ktx_image_t *) ia->images[idx++];
+
+            if (!cru_ktx_image_init_view(ktx_image, image_info, pixel_width,
+                                         pixel_height, p))
+                return false;
+
+            p += layer_size;
+        }
+
+        minify(&pixel_width);
+        minify(&pixel_height);
     }
 
-    image_info->size = CUR_SIZE;
     return true;
 }
 
@@ -407,84 +669,96 @@ cru_image_array_t *
 cru_ktx_image_array_load_file(const char *filename)
 {
     char *abs_filename = NULL;
-    FILE *file;
-    int error = 0;
-    bool ok;
-    uint32_t size;
+    struct ktx_image_info *image_info = NULL;
+    cru_image_array_t *ia = NULL;
+    struct stat st;
+    void *data;
+    int fd;
 
     abs_filename = cru_image_get_abspath(filename);
     if (!abs_filename)
         goto fail_filename;
 
-    file = fopen(abs_filename, "rb");
-    if (!file) {
+    fd = open(abs_filename, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
         loge("failed to open file for reading: %s", abs_filename);
-        goto fail_fopen;
+        goto fail_open;
     }
 
-    error = fseek(file, 0, SEEK_END);
-    if (error)
-        goto bad_read;
-    size = ftell(file);
-    error = fseek(file, 0, SEEK_SET);
-    if (error)
-        goto bad_read;
+    if (fstat(fd, &st) == -1 || st.st_size == 0) {
+        loge("failed to get size of file: %s", abs_filename);
+        goto fail_mmap;
+    }
 
-    struct ktx_image_info *image_info = calloc(1, sizeof(struct ktx_image_info) + size);
-    if (!image_info)
-        goto fail_alloc;
+    // MAP_PRIVATE with PROT_READ shares the page cache with every other
+    // process that maps the file.
+    data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        loge("failed to map file: %s", abs_filename);
+        goto fail_mmap;
+    }
 
+    // The mapping outlives the file descriptor.
+    close(fd);
+
+    image_info = xzalloc(sizeof(*image_info));
     cru_refcount_init(&image_info->refcount);
-    image_info->file = file;
-    image_info->size = size;
+    image_info->size = st.st_size;
+    image_info->data = data;
     image_info->filename = abs_filename;
-    image_info->data = image_info + 1;
-
-    size_t size_read = fread(image_info->data, 1, image_info->size, file);
-    if (size_read < image_info->size)
-        goto fail_read_file;
 
-    ok = cru_ktx_parse_header(image_info);
-    if (!ok)
-        goto fail_read_file;
+    if (image_info->size >= sizeof(cru_ktx2_magic_number) &&
+        memcmp(data, cru_ktx2_magic_number,
+               sizeof(cru_ktx2_magic_number)) == 0) {
+        if (!cru_ktx2_parse_header(image_info))
+            goto fail;
+    } else {
+        if (!cru_ktx_parse_header(image_info))
+            goto fail;
+    }
 
-    cru_image_array_t *ia = calloc(1, sizeof(*ia));
-    if (!ia)
-        goto bad_ia_alloc;
+    ia = xzalloc(sizeof(*ia));
     cru_refcount_init(&ia->refcount);
     ia->num_images = image_info->num_images;
-    /* allocate an array of images for each image in the ktx file. */
-    ia->images = calloc(image_info->num_images, sizeof(struct cru_ktx_image *));
-    if (!ia->images)
-        goto bad_ia_image_ptrs_alloc;
-    for (unsigned i = 0; i < image_info->num_images; i++) {
-        ia->images[i] = calloc(1, sizeof(struct cru_ktx_image));
-        struct cru_ktx_image *ktx_image = (struct cru_ktx_image *)ia->images[i];
+    ia->num_levels = image_info->num_miplevels;
+    ia->num_layers = image_info->num_layers;
+    ia->images = xzalloc(image_info->num_images * sizeof(ia->images[0]));
+
+    for (uint32_t i = 0; i < image_info->num_images; i++) {
+        cru_ktx_image_t *ktx_image = xzalloc(sizeof(*ktx_image));
         ktx_image->info = image_info;
         cru_refcount_get(&image_info->refcount);
+        ia->images[i] = &ktx_image->image;
+    }
 
-        if (!ia->images[i])
-            goto bad_ia_images_alloc;
+    if (image_info->is_ktx2) {
+        if (!cru_ktx2_parse_images(image_info, ia))
+            goto fail;
+    } else {
+        if (!cru_ktx_parse_images(image_info, ia))
+            goto fail;
     }
-    ok = cru_ktx_parse_images(image_info, ia);
-    if (!ok)
-        goto bad_read;
 
+    // Each image holds its own reference.
     cru_ktx_image_info_unref(image_info);
     return ia;
 
-bad_ia_images_alloc:
-    for (unsigned i = 0; i < ia->num_images; i++)
-        cru_ktx_image_destroy((struct cru_image *)ia->images[i]);
-bad_ia_image_ptrs_alloc:
-    free(ia->images);
-bad_ia_alloc:
-fail_read_file:
-    free(image_info);
-fail_alloc:
-bad_read:
-    fclose(file);
-fail_fopen:
+fail:
+    if (ia) {
+        for (int i = 0; i < ia->num_images; i++)
+            cru_ktx_image_destroy(ia->images[i]);
+        free(ia->images);
+        free(ia);
+    }
+
+    // Drops the last reference, which unmaps the file.
+    cru_ktx_image_info_unref(image_info);
+    return NULL;
+
+fail_mmap:
+    close(fd);
+fail_open:
+    free(abs_filename);
 fail_filename:
     return NULL;
 }
@@ -33,6 +33,9 @@ struct cru_pixel_image {
 
     uint8_t *restrict pixels;
 
+    /// Free \a pixels when the image is destroyed.
+    bool owns_pixels;
+
     ///< Bitmask of `CRU_IMAGE_MAP_ACCESS_*`.
     uint32_t map_access;
 };
@@ -45,6 +48,9 @@ cru_pixel_image_destroy(cru_image_t *image)
     if (!kpix_image)
         return;
 
+    if (kpix_image->owns_pixels)
+        free(kpix_image->pixels);
+
     free(kpix_image);
 }
 
@@ -84,6 +90,7 @@ cru_image_from_pixels(void *restrict pixels,
     }
 
     kpix_image->pixels = pixels;
+    kpix_image->owns_pixels = false;
     kpix_image->map_access = 0;
 
     kpix_image->image.destroy = cru_pixel_image_destroy;
@@ -96,3 +103,20 @@ fail:
     cru_pixel_image_destroy((cru_image_t *) kpix_image);
     return NULL;
 }
+
+cru_image_t *
+cru_pixel_image_from_owned_pixels(void *restrict pixels, VkFormat format,
+                                  uint32_t width, uint32_t height)
+{
+    cru_image_t *image = cru_image_from_pixels(pixels, format, width, height);
+    if (!image) {
+        free(pixels);
+        return NULL;
+    }
+
+    cru_pixel_image_t *kpix_image = (cru_pixel_image_t *) image;
+    kpix_image->owns_pixels = true;
+    kpix_image->image.read_only = true;
+
+    return image;
+}
@@ -27,6 +27,7 @@
 #include <png.h>
 
 #include "util/log.h"
+#include "util/misc.h"
 #include "util/xalloc.h"
 
 #include "cru_image.h"
@@ -129,49 +130,28 @@ fail_create_png_reader:
     return result;
 }
 
+/// Begin decoding the PNG file, transforming its rows to \a format_info.
 static bool
-copy_direct_from_png(cru_image_t *src, cru_image_t *dest)
+png_begin_read(cru_png_image_t *png_image,
+               const cru_format_info_t *format_info,
+               png_structp *out_png_reader, png_infop *out_png_info)
 {
-    cru_png_image_t *png_image;
-
-    bool result = false;
     png_structp png_reader = NULL;
     png_infop png_info = NULL;
 
-    const uint32_t width = src->width;
-    const uint32_t height = src->height;
-    const uint32_t stride = width * src->format_info->cpp;
-    uint8_t *dest_pixels = NULL;
-    uint8_t *dest_rows[height];
-
-    assert(src->format_info == dest->format_info);
-    assert(src->type == CRU_IMAGE_TYPE_PNG);
-    assert(src->width == dest->width);
-    assert(src->height == dest->height);
-
-    png_image = (cru_png_image_t *) src;
-
-    assert(!dest->read_only);
-    dest_pixels = dest->map_pixels(dest, CRU_IMAGE_MAP_ACCESS_WRITE);
-    if (!dest_pixels)
-        return false;
-
-    for (uint32_t y = 0; y < height; ++y) {
-        dest_rows[y] = dest_pixels + y * stride;
-    }
-
     // FINISHME: Error callbacks for libpng
     png_reader = png_create_read_struct(PNG_LIBPNG_VER_STRING,
                                        NULL, NULL, NULL);
     if (!png_reader) {
         loge("failed to create png reader");
-        goto fail_create_png_reader;
+        return false;
     }
 
     png_info = png_create_info_struct(png_reader);
     if (!png_info) {
         loge("failed to create png reader info");
-        goto fail_create_png_info;
+        png_destroy_read_struct(&png_reader, NULL, NULL);
+        return false;
     }
 
     rewind(png_image->file);
@@ -182,13 +162,13 @@ copy_direct_from_png(cru_image_t *src, cru_image_t *dest)
     switch (png_image->png_color_type) {
     case PNG_COLOR_TYPE_RGB:
     case PNG_COLOR_TYPE_GRAY:
-        if (dest->format_info->has_alpha) {
+        if (format_info->has_alpha) {
             png_set_add_alpha(png_reader, UINT32_MAX, PNG_FILLER_AFTER);
         }
         break;
     case PNG_COLOR_TYPE_RGB_ALPHA:
     case PNG_COLOR_TYPE_GRAY_ALPHA:
-        if (!dest->format_info->has_alpha) {
+        if (!format_info->has_alpha) {
             png_set_strip_alpha(png_reader);
         }
         break;
@@ -198,16 +178,53 @@ copy_direct_from_png(cru_image_t *src, cru_image_t *dest)
         break;
     }
 
-    png_read_rows(png_reader, dest_rows, NULL, height);
-    png_read_end(png_reader, NULL);
+    *out_png_reader = png_reader;
+    *out_png_info = png_info;
 
-    result = true;
+    return true;
+}
 
-fail_create_png_info:
+static bool
+copy_direct_from_png(cru_image_t *src, cru_image_t *dest)
+{
+    cru_png_image_t *png_image;
+
+    bool result = false;
+    png_structp png_reader = NULL;
+    png_infop png_info = NULL;
+
+    const uint32_t width = src->width;
+    const uint32_t height = src->height;
+    const uint32_t stride = width * src->format_info->cpp;
+    uint8_t *dest_pixels = NULL;
+    uint8_t *dest_rows[height];
 
+    assert(src->format_info == dest->format_info);
+    assert(src->type == CRU_IMAGE_TYPE_PNG);
+    assert(src->width == dest->width);
+    assert(src->height == dest->height);
+
+    png_image = (cru_png_image_t *) src;
+
+    assert(!dest->read_only);
+    dest_pixels = dest->map_pixels(dest, CRU_IMAGE_MAP_ACCESS_WRITE);
+    if (!dest_pixels)
+        return false;
+
+    for (uint32_t y = 0; y < height; ++y) {
+        dest_rows[y] = dest_pixels + y * stride;
+    }
+
+    if (!png_begin_read(png_image, dest->format_info, &png_reader, &png_info))
+        goto fail_begin_read;
+
+    png_read_rows(png_reader, dest_rows, NULL, height);
+    png_read_end(png_reader, NULL);
     png_destroy_read_struct(&png_reader, &png_info, NULL);
-fail_create_png_reader:
 
+    result = true;
+
+fail_begin_read:
     if (!dest->unmap_pixels(dest)) {
         loge("failed to unmap pixel image");
         abort();
@@ -216,32 +233,50 @@ fail_create_png_reader:
     return result;
 }
 
+/// Decode the PNG one row at a time and convert each row into \a dest, so
+/// that the decoded image is never held in memory whole.
 static bool
 copy_indirect_from_png(cru_image_t *src, cru_image_t *dest)
 {
-    void *tmp_pixels = NULL;
-    cru_image_t *tmp_image = NULL;
+    cru_png_row_reader_t *reader = NULL;
+    uint8_t *dest_pixels = NULL;
     bool result = false;
 
-    tmp_pixels = xmalloc(src->format_info->cpp * src->width * src->height);
+    cru_format_convert_t conv;
+    if (!cru_format_convert_init(&conv, src->format_info, dest->format_info)) {
+        loge("%s: unsupported format combination", __func__);
+        return false;
+    }
 
-    tmp_image = cru_image_from_pixels(tmp_pixels,
-                                      src->format_info->format,
-                                      src->width, src->height);
-    if (!tmp_image)
-        goto cleanup;
+    reader = cru_png_image_begin_read_rows(src);
+    if (!reader)
+        return false;
 
-    if (!copy_direct_from_png(src, tmp_image))
-        goto cleanup;
+    assert(!dest->read_only);
+    dest_pixels = dest->map_pixels(dest, CRU_IMAGE_MAP_ACCESS_WRITE);
+    if (!dest_pixels)
+        goto fail_map_dest;
 
-    if (!cru_image_copy(dest, tmp_image))
-        goto cleanup;
+    const uint32_t src_stride = src->width * src->format_info->cpp;
+    const uint32_t dest_stride = cru_image_get_pitch_bytes(dest);
+
+    for (uint32_t y = 0; y < src->height; ++y) {
+        const uint8_t *row = cru_png_row_reader_read(reader);
+        if (!row)
+            goto fail_copy;
+
+        cru_format_convert_rect(&conv, src->width, 1, row, 0, 0, src_stride,
+                                dest_pixels, 0, y, dest_stride);
+    }
 
     result = true;
 
-cleanup:
-    cru_image_release(tmp_image);
-    free(tmp_pixels);
+fail_copy:
+    // Check the result of unmapping the destination image because writeback
+    // can fail during unmap.
+    result &= dest->unmap_pixels(dest);
+fail_map_dest:
+    cru_png_row_reader_destroy(reader);
 
     return result;
 }
@@ -256,6 +291,73 @@ cru_png_image_copy_to_pixels(cru_image_t *src, cru_image_t *dest)
     }
 }
 
+struct cru_png_row_reader {
+    cru_png_image_t *png_image;
+    png_structp png_reader;
+    png_infop png_info;
+
+    /// The most recently decoded row.
+    uint8_t *row;
+    uint32_t next_y;
+};
+
+cru_png_row_reader_t *
+cru_png_image_begin_read_rows(cru_image_t *image)
+{
+    cru_png_image_t *png_image = (cru_png_image_t *) image;
+    cru_png_row_reader_t *reader;
+
+    if (image->type != CRU_IMAGE_TYPE_PNG)
+        return NULL;
+
+    reader = xzalloc(sizeof(*reader));
+    reader->png_image = png_image;
+
+    if (!png_begin_read(png_image, image->format_info,
+                        &reader->png_reader, &reader->png_info)) {
+        free(reader);
+        return NULL;
+    }
+
+    // Interlaced images can't be decoded one final row at a time.
+    if (png_get_interlace_type(reader->png_reader, reader->png_info) !=
+        PNG_INTERLACE_NONE) {
+        cru_png_row_reader_destroy(reader);
+        return NULL;
+    }
+
+    reader->row = xmalloc(image->width * image->format_info->cpp);
+
+    return reader;
+}
+
+const uint8_t *
+cru_png_row_reader_read(cru_png_row_reader_t *reader)
+{
+    if (reader->next_y >= reader->png_image->image.height) {
+        loge("%s: read past the last row of %s", __func__,
+             reader->png_image->filename);
+        return NULL;
+    }
+
+    png_read_row(reader->png_reader, reader->row, NULL);
+    reader->next_y++;
+
+    return reader->row;
+}
+
+void
+cru_png_row_reader_destroy(cru_png_row_reader_t *reader)
+{
+    if (!reader)
+        return;
+
+    // Stopping before the last row is fine; the next reader rewinds the file.
+    png_destroy_read_struct(&reader->png_reader, &reader->png_info, NULL);
+    free(reader->row);
+    free(reader);
+}
+
 static uint8_t *
 cru_png_image_map_pixels(cru_image_t *image, uint32_t access)
 {
@@ -301,6 +403,14 @@ fail:
     return NULL;
 }
 
+bool
+cru_png_image_needs_decode(cru_image_t *image)
+{
+    cru_png_image_t *png_image = (cru_png_image_t *) image;
+
+    return image->type == CRU_IMAGE_TYPE_PNG && !png_image->map.pixels;
+}
+
 static bool
 cru_png_image_unmap_pixels(cru_image_t *image)
 {
@@ -395,8 +505,32 @@ fail_filename:
     return NULL;
 }
 
+static int
+get_png_filter_flags(enum cru_png_filter filter)
+{
+    switch (filter) {
+    case CRU_PNG_FILTER_NONE:
+        return PNG_FILTER_NONE;
+    case CRU_PNG_FILTER_SUB:
+        return PNG_FILTER_SUB;
+    case CRU_PNG_FILTER_UP:
+        return PNG_FILTER_UP;
+    case CRU_PNG_FILTER_AVG:
+        return PNG_FILTER_AVG;
+    case CRU_PNG_FILTER_PAETH:
+        return PNG_FILTER_PAETH;
+    case CRU_PNG_FILTER_ALL:
+        return PNG_ALL_FILTERS;
+    case CRU_PNG_FILTER_DEFAULT:
+        break;
+    }
+
+    return 0;
+}
+
 static bool
-write_direct_to_png(cru_image_t *image, const string_t *filename)
+write_direct_to_png(cru_image_t *image, const string_t *filename,
+                    const cru_image_write_info_t *info)
 {
     bool result = false;
     char *abspath = NULL;
@@ -480,6 +614,16 @@ write_direct_to_png(cru_image_t *image, const string_t *filename)
                  PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT,
                  PNG_FILTER_TYPE_DEFAULT);
 
+    if (info->png_compression_level >= 0) {
+        png_set_compression_level(png_writer,
+                                  MIN(info->png_compression_level, 9));
+    }
+
+    if (info->png_filter != CRU_PNG_FILTER_DEFAULT) {
+        png_set_filter(png_writer, PNG_FILTER_TYPE_BASE,
+                       get_png_filter_flags(info->png_filter));
+    }
+
     png_write_info(png_writer, png_info);
     png_set_rows(png_writer, png_info, src_rows);
     png_write_png(png_writer, png_info, PNG_TRANSFORM_IDENTITY, NULL);
@@ -501,10 +645,12 @@ fail_get_abspath:
 }
 
 static bool
-write_indirect_to_png(cru_image_t *image, const string_t *filename)
+write_indirect_to_png(cru_image_t *image, const string_t *filename,
+                      const cru_image_write_info_t *info)
 {
     VkFormat tmp_format;
     const cru_format_info_t *tmp_format_info;
+    cru_format_convert_t conv;
     void *tmp_pixels = NULL;
     cru_image_t *tmp_image = NULL;
     bool result = false;
@@ -521,8 +667,25 @@ write_indirect_to_png(cru_image_t *image, const string_t *filename)
         tmp_format = VK_FORMAT_R8_UNORM;
         break;
     default:
-        loge("cannot write %s to PNG", image->format_info->name);
-        return false;
+        // Convert other formats, such as those loaded from raw dumps, to
+        // the 8-bit format with the same number of channels. PNG has no
+        // 8-bit format for the others, which include combined depth/stencil
+        // formats.
+        if (image->format_info->cpp == 0) {
+            loge("cannot write block-compressed format %s to PNG",
+                 image->format_info->name);
+            return false;
+        } else if (image->format_info->num_channels == 1) {
+            tmp_format = VK_FORMAT_R8_UNORM;
+        } else if (image->format_info->num_channels == 4) {
+            tmp_format = VK_FORMAT_R8G8B8A8_UNORM;
+        } else {
+            loge("cannot write %s to PNG: it has %u channels, and PNG "
+                 "writes only 1 or 4; write it to a .raw file instead",
+                 image->format_info->name, image->format_info->num_channels);
+            return false;
+        }
+        break;
     }
 
     tmp_format_info = cru_format_get_info(tmp_format);
@@ -531,6 +694,13 @@ write_indirect_to_png(cru_image_t *image, const string_t *filename)
         return false;
     }
 
+    if (!cru_format_convert_init(&conv, image->format_info, tmp_format_info)) {
+        loge("cannot write %s to PNG: it cannot be converted to %s; "
+             "write it to a .raw file instead",
+             image->format_info->name, tmp_format_info->name);
+        return false;
+    }
+
     tmp_pixels = xmalloc(tmp_format_info->cpp * image->width * image->height);
 
     tmp_image = cru_image_from_pixels(tmp_pixels,
@@ -542,7 +712,7 @@ write_indirect_to_png(cru_image_t *image, const string_t *filename)
     if (!cru_image_copy(tmp_image, image))
         goto cleanup;
 
-    if (!write_direct_to_png(tmp_image, filename))
+    if (!write_direct_to_png(tmp_image, filename, info))
         goto cleanup;
 
     result = true;
@@ -555,13 +725,14 @@ cleanup:
 }
 
 bool
-cru_png_image_write_file(cru_image_t *image, const string_t *filename)
+cru_png_image_write_file(cru_image_t *image, const string_t *filename,
+                         const cru_image_write_info_t *info)
 {
     switch (image->format_info->format) {
     case VK_FORMAT_R8G8B8A8_UNORM:
     case VK_FORMAT_R8_UNORM:
-        return write_direct_to_png(image, filename);
+        return write_direct_to_png(image, filename, info);
     default:
-        return write_indirect_to_png(image, filename);
+        return write_indirect_to_png(image, filename, info);
     }
 }
@@ -0,0 +1,531 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/// \file
+/// \brief A quad-at-a-time triangle rasterizer.
+///
+/// Each triangle is snapped to 8 bits of subpixel precision and set up as
+/// three integer edge functions, which are evaluated exactly with 64-bit
+/// arithmetic. The edge functions, barycentrics, depth, and color of the four
+/// pixels of a 2x2 quad are computed together in 4-wide vectors, which the
+/// compiler maps onto the target's SIMD registers.
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util/cru_raster.h"
+#include "util/log.h"
+#include "util/misc.h"
+#include "util/xalloc.h"
+
+#include "cru_image.h"
+
+#define SUBPIXEL_BITS 8
+#define SUBPIXEL_ONE (1 << SUBPIXEL_BITS)
+#define SUBPIXEL_HALF (SUBPIXEL_ONE / 2)
+
+// The 4-wide double and float vectors fill an AVX register each, so build an
+// AVX2 variant of the per-quad loop too and pick one when the program loads.
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__)
+#define RASTER_TARGET_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define RASTER_TARGET_CLONES
+#endif
+
+typedef double v4d __attribute__((vector_size(32)));
+typedef int32_t v4i32 __attribute__((vector_size(16)));
+typedef float v4f __attribute__((vector_size(16)));
+
+struct cru_raster {
+    uint32_t width;
+    uint32_t height;
+
+    /// Pixels per row of both attachments. The attachments are padded to an
+    /// even width and height, so that every 2x2 quad lies in memory.
+    uint32_t stride;
+
+    /// VK_FORMAT_R8G8B8A8_UNORM.
+    uint8_t *color;
+
+    /// VK_FORMAT_D32_SFLOAT.
+    float *depth;
+};
+
+/// A vertex after the viewport transform.
+struct window_vertex {
+    /// Window coordinates, in subpixels.
+    int64_t x;
+    int64_t y;
+
+    /// Normalized device z, before the depth range is applied.
+    float z;
+
+    float inv_w;
+    const float *color;
+};
+
+/// An edge function E(x, y) = a * x + b * y + c, whose sign tells on which
+/// side of the edge the subpixel (x, y) lies.
+struct edge {
+    int64_t a;
+    int64_t b;
+    int64_t c;
+
+    /// Added to E before testing E >= 0. It is -1 for edges that are
+    /// neither top nor left, so that samples exactly on them are not
+    /// covered.
+    int64_t bias;
+};
+
+cru_raster_t *
+cru_raster_create(uint32_t width, uint32_t height)
+{
+    if (width == 0 || height == 0 ||
+        width > CRU_RASTER_GUARD_BAND || height > CRU_RASTER_GUARD_BAND) {
+        loge("%s: invalid size %ux%u", __func__, width, height);
+        return NULL;
+    }
+
+    cru_raster_t *raster = xzalloc(sizeof(*raster));
+    raster->width = width;
+    raster->height = height;
+    raster->stride = cru_align_size(width, 2);
+
+    const size_t num_pixels = (size_t) raster->stride *
+                              cru_align_size(height, 2);
+    raster->color = xzalloc(4 * num_pixels);
+    raster->depth = xzalloc(sizeof(float) * num_pixels);
+
+    return raster;
+}
+
+void
+cru_raster_destroy(cru_raster_t *raster)
+{
+    if (!raster)
+        return;
+
+    free(raster->color);
+    free(raster->depth);
+    free(raster);
+}
+
+uint32_t
+cru_raster_get_width(cru_raster_t *raster)
+{
+    return raster->width;
+}
+
+uint32_t
+cru_raster_get_height(cru_raster_t *raster)
+{
+    return raster->height;
+}
+
+static inline uint8_t
+float_to_unorm8(float f)
+{
+    return CLAMP(f, 0.0f, 1.0f) * 255.0f + 0.5f;
+}
+
+void
+cru_raster_clear(cru_raster_t *raster, const float color[4], float depth)
+{
+    const size_t num_pixels = (size_t) raster->stride *
+                              cru_align_size(raster->height, 2);
+    const uint8_t rgba[4] = {
+        float_to_unorm8(color[0]),
+        float_to_unorm8(color[1]),
+        float_to_unorm8(color[2]),
+        float_to_unorm8(color[3]),
+    };
+
+    for (size_t i = 0; i < num_pixels; i++) {
+        memcpy(raster->color + 4 * i, rgba, 4);
+        raster->depth[i] = depth;
+    }
+}
+
+static bool
+viewport_transform(const VkViewport *vp, const cru_raster_vertex_t *v,
+                   struct window_vertex *out)
+{
+    if (!(v->pos[3] > 0.0f))
+        return false;
+
+    const float inv_w = 1.0f / v->pos[3];
+    const float x = vp->x + 0.5f * vp->width * (v->pos[0] * inv_w + 1.0f);
+    const float y = vp->y + 0.5f * vp->height * (v->pos[1] * inv_w + 1.0f);
+
+    if (!(fabsf(x) <= CRU_RASTER_GUARD_BAND &&
+          fabsf(y) <= CRU_RASTER_GUARD_BAND))
+        return false;
+
+    out->x = lrintf(x * SUBPIXEL_ONE);
+    out->y = lrintf(y * SUBPIXEL_ONE);
+    out->z = v->pos[2] * inv_w;
+    out->inv_w = inv_w;
+    out->color = v->color;
+
+    return true;
+}
+
+/// Set up the edge from \a v0 to \a v1 of a triangle whose vertices wind so
+/// that the edge functions are positive inside it.
+static void
+edge_setup(struct edge *e, const struct window_vertex *v0,
+           const struct window_vertex *v1)
+{
+    const int64_t dx = v1->x - v0->x;
+    const int64_t dy = v1->y - v0->y;
+
+    e->a = -dy;
+    e->b = dx;
+    e->c = dy * v0->x - dx * v0->y;
+
+    // In this winding, with y pointing down, top edges run in +x and left
+    // edges run in -y.
+    const bool top_left = (dy == 0 && dx > 0) || dy < 0;
+    e->bias = top_left ? 0 : -1;
+}
+
+static inline v4f
+load_quad_f(const float *p, uint32_t stride)
+{
+    return (v4f) { p[0], p[1], p[stride], p[stride + 1] };
+}
+
+static inline void
+store_quad_f(float *p, uint32_t stride, v4f v)
+{
+    p[0] = v[0];
+    p[1] = v[1];
+    p[stride] = v[2];
+    p[stride + 1] = v[3];
+}
+
+static inline v4i32
+load_quad_u32(const uint32_t *p, uint32_t stride)
+{
+    return (v4i32) { p[0], p[1], p[stride], p[stride + 1] };
+}
+
+static inline void
+store_quad_u32(uint32_t *p, uint32_t stride, v4i32 v)
+{
+    p[0] = v[0];
+    p[1] = v[1];
+    p[stride] = v[2];
+    p[stride + 1] = v[3];
+}
+
+static inline bool
+mask_any(v4i32 m)
+{
+    return (m[0] | m[1] | m[2] | m[3]) != 0;
+}
+
+/// Clamp to [0, 1]. NaN becomes 0.
+static inline v4f
+clamp01(v4f f)
+{
+    const v4i32 one = (v4i32) { 0, 0, 0, 0 } + 0x3f800000;
+    const v4i32 above = f > 1.0f;
+    v4i32 bits = (v4i32) f & (f >= 0.0f);
+
+    bits = (bits & ~above) | (one & above);
+    return (v4f) bits;
+}
+
+static inline v4i32
+depth_test(VkCompareOp op, v4f z, v4f stored)
+{
+    switch (op) {
+    case VK_COMPARE_OP_NEVER:               return (v4i32) { 0, 0, 0, 0 };
+    case VK_COMPARE_OP_LESS:                return z < stored;
+    case VK_COMPARE_OP_EQUAL:               return z == stored;
+    case VK_COMPARE_OP_LESS_OR_EQUAL:       return z <= stored;
+    case VK_COMPARE_OP_GREATER:             return z > stored;
+    case VK_COMPARE_OP_NOT_EQUAL:           return z != stored;
+    case VK_COMPARE_OP_GREATER_OR_EQUAL:    return z >= stored;
+    case VK_COMPARE_OP_ALWAYS:              return (v4i32) { -1, -1, -1, -1 };
+    default:
+        cru_unreachable;
+    }
+}
+
+RASTER_TARGET_CLONES static void
+draw_triangle(cru_raster_t *raster, const cru_raster_state_t *state,
+              const VkViewport *vp, const VkRect2D *scissor,
+              const cru_raster_vertex_t *in0,
+              const cru_raster_vertex_t *in1,
+              const cru_raster_vertex_t *in2)
+{
+    struct window_vertex v[3];
+
+    if (!viewport_transform(vp, in0, &v[0]) ||
+        !viewport_transform(vp, in1, &v[1]) ||
+        !viewport_transform(vp, in2, &v[2]))
+        return;
+
+    // Twice the signed area. Vulkan's definition of the area has the
+    // opposite sign, so a negative value here is counter-clockwise.
+    int64_t area = (v[1].x - v[0].x) * (v[2].y - v[0].y) -
+                   (v[2].x - v[0].x) * (v[1].y - v[0].y);
+    if (area == 0)
+        return;
+
+    const bool front = (state->front_face == VK_FRONT_FACE_COUNTER_CLOCKWISE)
+                       == (area < 0);
+    if ((state->cull_mode & VK_CULL_MODE_FRONT_BIT) && front)
+        return;
+    if ((state->cull_mode & VK_CULL_MODE_BACK_BIT) && !front)
+        return;
+
+    const float *flat_color = v[0].color;
+
+    if (area < 0) {
+        struct window_vertex tmp = v[1];
+        v[1] = v[2];
+        v[2] = tmp;
+        area = -area;
+    }
+
+    // Edge i is opposite vertex i, so E_i / area is the barycentric weight
+    // of vertex i.
+    struct edge e[3];
+    edge_setup(&e[0], &v[1], &v[2]);
+    edge_setup(&e[1], &v[2], &v[0]);
+    edge_setup(&e[2], &v[0], &v[1]);
+
+    // Bounding box in pixels, inclusive, clamped to the scissor. The guard
+    // band keeps it well within int32_t.
+    int32_t min_x = MIN(v[0].x, MIN(v[1].x, v[2].x)) >> SUBPIXEL_BITS;
+    int32_t min_y = MIN(v[0].y, MIN(v[1].y, v[2].y)) >> SUBPIXEL_BITS;
+    int32_t max_x = MAX(v[0].x, MAX(v[1].x, v[2].x)) >> SUBPIXEL_BITS;
+    int32_t max_y = MAX(v[0].y, MAX(v[1].y, v[2].y)) >> SUBPIXEL_BITS;
+
+    min_x = MAX(min_x, scissor->offset.x);
+    min_y = MAX(min_y, scissor->offset.y);
+    max_x = MIN(max_x, (int32_t) (scissor->offset.x + scissor->extent.width - 1));
+    max_y = MIN(max_y, (int32_t) (scissor->offset.y + scissor->extent.height - 1));
+
+    if (min_x > max_x || min_y > max_y)
+        return;
+
+    // Quads are aligned to even pixels.
+    const int32_t quad_x0 = min_x & ~1;
+    const int32_t quad_y0 = min_y & ~1;
+
+    // Lanes are ordered (0, 0), (1, 0), (0, 1), (1, 1) within a quad.
+    const v4i32 lane_dx = { 0, 1, 0, 1 };
+    const v4i32 lane_dy = { 0, 0, 1, 1 };
+
+    v4d e_row[3];
+    v4d e_step_x[3];
+    v4d e_step_y[3];
+    for (int i = 0; i < 3; i++) {
+        const int64_t sx = (int64_t) quad_x0 * SUBPIXEL_ONE + SUBPIXEL_HALF;
+        const int64_t sy = (int64_t) quad_y0 * SUBPIXEL_ONE + SUBPIXEL_HALF;
+        const int64_t e00 = e[i].a * sx + e[i].b * sy + e[i].c + e[i].bias;
+
+        const int64_t step_x = e[i].a * SUBPIXEL_ONE;
+        const int64_t step_y = e[i].b * SUBPIXEL_ONE;
+
+        e_row[i] = (v4d) {
+            e00,
+            e00 + step_x,
+            e00 + step_y,
+            e00 + step_x + step_y,
+        };
+        e_step_x[i] = (v4d) { 0, 0, 0, 0 } + (double) (2 * step_x);
+        e_step_y[i] = (v4d) { 0, 0, 0, 0 } + (double) (2 * step_y);
+    }
+
+    const float inv_area = 1.0f / (float) area;
+    const float depth_scale = vp->maxDepth - vp->minDepth;
+    const VkCompareOp depth_op = state->depth_test_enable
+                                 ? state->depth_compare_op
+                                 : VK_COMPARE_OP_ALWAYS;
+    const bool depth_write = state->depth_test_enable &&
+                             state->depth_write_enable;
+
+    for (int32_t qy = quad_y0; qy <= max_y; qy += 2) {
+        v4d e0 = e_row[0];
+        v4d e1 = e_row[1];
+        v4d e2 = e_row[2];
+
+        const v4i32 py = qy + lane_dy;
+        const v4i32 row_mask = (py >= min_y) & (py <= max_y);
+
+        for (int32_t qx = quad_x0; qx <= max_x; qx += 2) {
+            const v4i32 px = qx + lane_dx;
+            const v4i32 inside = __builtin_convertvector((e0 >= 0) &
+                                                         (e1 >= 0) &
+                                                         (e2 >= 0), v4i32);
+            v4i32 mask = row_mask & (px >= min_x) & (px <= max_x) & inside;
+
+            if (!mask_any(mask))
+                goto next_quad;
+
+            // The fill-rule bias is still in the edge values, but at one
+            // subpixel squared it is far below float precision.
+            const v4f w1 = __builtin_convertvector(e1, v4f) * inv_area;
+            const v4f w2 = __builtin_convertvector(e2, v4f) * inv_area;
+            const v4f w0 = 1.0f - w1 - w2;
+
+            const v4f z = w0 * v[0].z + w1 * v[1].z + w2 * v[2].z;
+            mask &= (z >= 0.0f) & (z <= 1.0f);
+            if (!mask_any(mask))
+                goto next_quad;
+
+            const v4f depth = vp->minDepth + z * depth_scale;
+
+            const size_t offset = (size_t) qy * raster->stride + qx;
+            float *depth_quad = raster->depth + offset;
+            uint32_t *color_quad = (uint32_t *) raster->color + offset;
+
+            const v4f stored = load_quad_f(depth_quad, raster->stride);
+            mask &= depth_test(depth_op, depth, stored);
+            if (!mask_any(mask))
+                goto next_quad;
+
+            v4f rgba[4];
+            if (state->flat_shading) {
+                for (int c = 0; c < 4; c++)
+                    rgba[c] = (v4f) { 0, 0, 0, 0 } + flat_color[c];
+            } else {
+                // Perspective-correct weights.
+                const v4f p0 = w0 * v[0].inv_w;
+                const v4f p1 = w1 * v[1].inv_w;
+                const v4f p2 = w2 * v[2].inv_w;
+                const v4f inv_sum = 1.0f / (p0 + p1 + p2);
+
+                for (int c = 0; c < 4; c++) {
+                    rgba[c] = (p0 * v[0].color[c] + p1 * v[1].color[c] +
+                               p2 * v[2].color[c]) * inv_sum;
+                }
+            }
+
+            v4i32 rgba8 = { 0, 0, 0, 0 };
+            for (int c = 0; c < 4; c++) {
+                const v4f f = clamp01(rgba[c]) * 255.0f + 0.5f;
+                rgba8 |= __builtin_convertvector(f, v4i32) << (8 * c);
+            }
+
+            const v4i32 old_rgba8 = load_quad_u32(color_quad, raster->stride);
+            store_quad_u32(color_quad, raster->stride,
+                           (rgba8 & mask) | (old_rgba8 & ~mask));
+
+            if (depth_write) {
+                store_quad_f(depth_quad, raster->stride,
+                             (v4f) (((v4i32) depth & mask) |
+                                    ((v4i32) stored & ~mask)));
+            }
+
+        next_quad:
+            e0 += e_step_x[0];
+            e1 += e_step_x[1];
+            e2 += e_step_x[2];
+        }
+
+        e_row[0] += e_step_y[0];
+        e_row[1] += e_step_y[1];
+        e_row[2] += e_step_y[2];
+    }
+}
+
+void
+cru_raster_draw(cru_raster_t *raster, const cru_raster_state_t *state,
+                const cru_raster_vertex_t *vertices, uint32_t num_vertices)
+{
+    VkViewport vp = state->viewport;
+    if (vp.width == 0) {
+        vp = (VkViewport) {
+            .width = raster->width,
+            .height = raster->height,
+            .minDepth = 0.0f,
+            .maxDepth = 1.0f,
+        };
+    }
+
+    VkRect2D fb = {
+        .extent = { raster->width, raster->height },
+    };
+    VkRect2D scissor = fb;
+    if (state->scissor.extent.width != 0) {
+        int64_t x0 = MAX(state->scissor.offset.x, 0);
+        int64_t y0 = MAX(state->scissor.offset.y, 0);
+        int64_t x1 = MIN((int64_t) state->scissor.offset.x +
+                         state->scissor.extent.width, raster->width);
+        int64_t y1 = MIN((int64_t) state->scissor.offset.y +
+                         state->scissor.extent.height, raster->height);
+
+        if (x0 >= x1 || y0 >= y1)
+            return;
+
+        scissor = (VkRect2D) {
+            .offset = { x0, y0 },
+            .extent = { x1 - x0, y1 - y0 },
+        };
+    }
+
+    if (state->triangle_strip) {
+        // Odd triangles swap their last two vertices to keep the strip's
+        // winding consistent.
+        for (uint32_t i = 0; i + 2 < num_vertices; i++) {
+            draw_triangle(raster, state, &vp, &scissor, &vertices[i],
+                          &vertices[i + 1 + (i & 1)],
+                          &vertices[i + 2 - (i & 1)]);
+        }
+    } else {
+        for (uint32_t i = 0; i + 2 < num_vertices; i += 3) {
+            draw_triangle(raster, state, &vp, &scissor, &vertices[i],
+                          &vertices[i + 1], &vertices[i + 2]);
+        }
+    }
+}
+
+cru_image_t *
+cru_raster_get_image(cru_raster_t *raster, VkImageAspectFlagBits aspect)
+{
+    cru_image_t *image;
+
+    switch (aspect) {
+    case VK_IMAGE_ASPECT_COLOR_BIT:
+        image = cru_image_from_pixels(raster->color, VK_FORMAT_R8G8B8A8_UNORM,
+                                      raster->width, raster->height);
+        break;
+    case VK_IMAGE_ASPECT_DEPTH_BIT:
+        image = cru_image_from_pixels(raster->depth, VK_FORMAT_D32_SFLOAT,
+                                      raster->width, raster->height);
+        break;
+    default:
+        loge("%s: unsupported aspect 0x%x", __func__, aspect);
+        return NULL;
+    }
+
+    if (image)
+        cru_image_set_pitch_bytes(image, 4 * raster->stride);
+
+    return image;
+}
@@ -0,0 +1,174 @@
+// Copyright 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including the next
+// paragraph) shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/// \file
+/// \brief Raw image files.
+///
+/// A raw image file is a one-line JSON header followed by the pixels,
+/// uncompressed and tightly packed, in the image's own format:
+///
+///     {"format": "VK_FORMAT_D32_SFLOAT", "width": 64, "height": 64, "stride": 256}
+///     <height * stride bytes>
+///
+/// Writing one costs little more than a memcpy, and every format that
+/// cru_format knows can be written without conversion. That makes raw files
+/// suited to bulk debugging dumps. `crucible dump-image` converts them to
+/// PNG.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util/log.h"
+#include "util/xalloc.h"
+
+#include "cru_image.h"
+
+/// Longest header line that the loader accepts, including the newline.
+#define RAW_HEADER_MAX_LEN 256
+
+cru_image_t *
+cru_raw_image_load_file(const char *filename)
+{
+    char *abspath = NULL;
+    FILE *f = NULL;
+    uint8_t *pixels = NULL;
+    cru_image_t *image = NULL;
+    char header[RAW_HEADER_MAX_LEN];
+    char format_name[64];
+    uint32_t width, height, stride;
+
+    abspath = cru_image_get_abspath(filename);
+    if (!abspath)
+        goto fail_get_abspath;
+
+    f = fopen(abspath, "rb");
+    if (!f) {
+        loge("failed to open file for reading: %s", abspath);
+        goto fail_fopen;
+    }
+
+    if (!fgets(header, sizeof(header), f) ||
+        sscanf(header, "{\"format\": \"%63[^\"]\", \"width\": %u, "
+               "\"height\": %u, \"stride\": %u}",
+               format_name, &width, &height, &stride) != 4) {
+        loge("%s: invalid raw image header", abspath);
+        goto fail_header;
+    }
+
+    const cru_format_info_t *format_info =
+        cru_format_get_info_by_name(format_name);
+    if (!format_info) {
+        loge("%s: unknown format %s", abspath, format_name);
+        goto fail_header;
+    }
+
+    if (format_info->cpp == 0) {
+        loge("%s: raw image files cannot hold block-compressed format %s",
+             abspath, format_name);
+        goto fail_header;
+    }
+
+    if (width == 0 || height == 0 || stride != width * format_info->cpp) {
+        loge("%s: invalid raw image size", abspath);
+        goto fail_header;
+    }
+
+    pixels = xmalloc((size_t) height * stride);
+    if (fread(pixels, stride, height, f) != height) {
+        loge("%s: raw image file is truncated", abspath);
+        free(pixels);
+        goto fail_header;
+    }
+
+    image = cru_pixel_image_from_owned_pixels(pixels, format_info->format,
+                                              width, height);
+
+fail_header:
+    fclose(f);
+fail_fopen:
+    free(abspath);
+fail_get_abspath:
+    return image;
+}
+
+bool
+cru_raw_image_write_file(cru_image_t *image, const string_t *filename)
+{
+    bool result = false;
+    char *abspath = NULL;
+    FILE *f = NULL;
+    const uint8_t *pixels = NULL;
+
+    const cru_format_info_t *format_info = image->format_info;
+    const uint32_t stride = image->width * format_info->cpp;
+    const uint32_t pitch = cru_image_get_pitch_bytes(image);
+
+    // The header describes rows of pixels, which block-compressed images
+    // don't have.
+    if (format_info->cpp == 0) {
+        loge("cannot write block-compressed format %s to a raw file: %s",
+             format_info->name, string_data(filename));
+        goto fail_get_abspath;
+    }
+
+    abspath = cru_image_get_abspath(string_data(filename));
+    if (!abspath)
+        goto fail_get_abspath;
+
+    pixels = image->map_pixels(image, CRU_IMAGE_MAP_ACCESS_READ);
+    if (!pixels)
+        goto fail_map_pixels;
+
+    f = fopen(abspath, "wb");
+    if (!f) {
+        loge("failed to open file for writing: %s", abspath);
+        goto fail_fopen;
+    }
+
+    fprintf(f, "{\"format\": \"%s\", \"width\": %u, \"height\": %u, "
+            "\"stride\": %u}\n",
+            format_info->name, image->width, image->height, stride);
+
+    if (pitch == stride) {
+        result = fwrite(pixels, stride, image->height, f) == image->height;
+    } else {
+        result = true;
+        for (uint32_t y = 0; y < image->height && result; ++y)
+            result = fwrite(pixels + y * pitch, stride, 1, f) == 1;
+    }
+
+    // Check the result of fclose because it flushes the buffered writes.
+    if (fclose(f) != 0)
+        result = false;
+
+    if (!result)
+        loge("failed to write file: %s", abspath);
+
+fail_fopen:
+    // Ignore the result of unmap because no write-back occurs when unmapping
+    // a read-only map.
+    image->unmap_pixels(image);
+fail_map_pixels:
+    free(abspath);
+fail_get_abspath:
+    return result;
+}
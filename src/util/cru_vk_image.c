@@ -19,6 +19,7 @@
 // FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
 // IN THE SOFTWARE.
 
+#include <pthread.h>
 #include <stdlib.h>
 
 #include "qonos/qonos.h"
@@ -31,17 +32,66 @@
 
 typedef struct cru_vk_image cru_vk_image_t;
 
+/// Number of command buffers (and fences) in a staging context's submit
+/// ring. A submission waits only when it wraps around onto a slot that is
+/// still in flight.
+#define STAGING_NUM_SUBMITS 4
+
+/// Maximum number of idle staging buffers kept for reuse.
+#define STAGING_MAX_FREE_BUFFERS 8
+
 enum copy_direction {
     COPY_IMAGE_TO_BUFFER,
     COPY_BUFFER_TO_IMAGE,
 };
 
+struct staging_buffer {
+    VkBuffer vk_buffer;
+    VkDeviceMemory vk_mem;
+    VkDeviceSize size;
+    void *map;
+};
+
+struct staging_submit {
+    VkCommandBuffer cmd;
+    VkFence fence;
+
+    /// Serial of the most recent submission that used this slot.
+    uint64_t serial;
+
+    /// True if the slot's fence has not yet been observed as signalled.
+    bool busy;
+};
+
+struct cru_vk_staging {
+    cru_refcount_t refcount;
+
+    /// Protects everything below. Vulkan requires external synchronization
+    /// of the command pool, and images on different test threads may share
+    /// one staging context.
+    pthread_mutex_t mutex;
+
+    VkDevice vk_dev;
+    uint32_t queue_family;
+    VkPhysicalDeviceMemoryProperties mem_props;
+    VkMemoryPropertyFlags tmp_mem_props;
+
+    /// Created on first submission.
+    VkCommandPool cmd_pool;
+
+    struct staging_submit submits[STAGING_NUM_SUBMITS];
+    uint32_t next_submit;
+    uint64_t serial;
+
+    uint32_t num_free_buffers;
+    struct staging_buffer free_buffers[STAGING_MAX_FREE_BUFFERS];
+};
+
 struct cru_vk_image {
     cru_image_t cru_image;
 
-    VkDevice vk_dev;
+    cru_vk_staging_t *staging;
     VkQueue vk_queue;
-    VkMemoryPropertyFlags vk_tmp_mem_props;
 
     struct {
         VkImage vk_image;
@@ -52,60 +102,58 @@ struct cru_vk_image {
 
 
     struct {
-        VkBuffer vk_buffer;
-        VkDeviceMemory vk_mem;
-        void *pixels;
+        struct staging_buffer buffer;
         uint32_t access; ///< Mask of CRU_IMAGE_MAP_ACCESS_* .
+
+        /// If nonzero, a readback begun by cru_image_begin_readback() is in
+        /// flight in staging submit slot `pending_slot`.
+        uint64_t pending_serial;
+        uint32_t pending_slot;
     } map;
 };
 
 static void
-cleanup_map(cru_vk_image_t *self)
+destroy_staging_buffer(VkDevice dev, struct staging_buffer *buf)
 {
-    if (self->map.pixels)
-        vkUnmapMemory(self->vk_dev, self->map.vk_mem);
-    if (self->map.vk_mem != VK_NULL_HANDLE)
-        vkFreeMemory(self->vk_dev, self->map.vk_mem, NULL);
-    if (self->map.vk_buffer != VK_NULL_HANDLE)
-        vkDestroyBuffer(self->vk_dev, self->map.vk_buffer, NULL);
-
-    self->map = (typeof(self->map)) {0};
+    if (buf->map)
+        vkUnmapMemory(dev, buf->vk_mem);
+    if (buf->vk_mem != VK_NULL_HANDLE)
+        vkFreeMemory(dev, buf->vk_mem, NULL);
+    if (buf->vk_buffer != VK_NULL_HANDLE)
+        vkDestroyBuffer(dev, buf->vk_buffer, NULL);
+
+    *buf = (struct staging_buffer) {0};
 }
 
-/// Setup cru_vk_image::map.
 static VkResult
-setup_map(cru_vk_image_t *self)
+create_staging_buffer(cru_vk_staging_t *staging, VkDeviceSize size,
+                      struct staging_buffer *buf)
 {
-    VkDevice dev = self->vk_dev;
+    VkDevice dev = staging->vk_dev;
     VkResult r = VK_SUCCESS;
 
-    if (self->map.pixels)
-        return VK_SUCCESS;
-
-    const size_t buffer_size = self->cru_image.format_info->cpp *
-                               self->cru_image.width *
-                               self->cru_image.height;
+    *buf = (struct staging_buffer) { .size = size };
 
     r = vkCreateBuffer(dev, &(VkBufferCreateInfo) {
             .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-            .size = buffer_size,
+            .size = size,
             .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
                      VK_BUFFER_USAGE_TRANSFER_DST_BIT,
         },
         NULL,
-        &self->map.vk_buffer);
+        &buf->vk_buffer);
     if (r != VK_SUCCESS)
         goto fail;
 
     VkMemoryRequirements mem_reqs;
-    vkGetBufferMemoryRequirements(dev, self->map.vk_buffer, &mem_reqs);
+    vkGetBufferMemoryRequirements(dev, buf->vk_buffer, &mem_reqs);
 
     uint32_t type_index = UINT32_MAX;
-    const VkPhysicalDeviceMemoryProperties *props = t_physical_dev_mem_props;
+    const VkPhysicalDeviceMemoryProperties *props = &staging->mem_props;
     for (uint32_t i = 0; i < props->memoryTypeCount; i++) {
         const VkMemoryType *type = &props->memoryTypes[i];
         if ((mem_reqs.memoryTypeBits & (1 << i)) &&
-            (type->propertyFlags & self->vk_tmp_mem_props) == self->vk_tmp_mem_props) {
+            (type->propertyFlags & staging->tmp_mem_props) == staging->tmp_mem_props) {
             type_index = i;
             break;
         }
@@ -118,56 +166,330 @@ setup_map(cru_vk_image_t *self)
             .memoryTypeIndex = type_index,
         },
         NULL,
-        &self->map.vk_mem);
+        &buf->vk_mem);
     if (r != VK_SUCCESS)
         goto fail;
 
-    r = vkBindBufferMemory(dev, self->map.vk_buffer, self->map.vk_mem, 0);
+    r = vkBindBufferMemory(dev, buf->vk_buffer, buf->vk_mem, 0);
     if (r != VK_SUCCESS)
         goto fail;
 
-    r = vkMapMemory(dev, self->map.vk_mem, /*offset*/ 0, buffer_size,
-                    /*flags*/ 0, &self->map.pixels);
+    r = vkMapMemory(dev, buf->vk_mem, /*offset*/ 0, size,
+                    /*flags*/ 0, &buf->map);
     if (r != VK_SUCCESS)
         goto fail;
 
     return VK_SUCCESS;
 
 fail:
-    cleanup_map(self);
+    destroy_staging_buffer(dev, buf);
     return r;
 }
 
+/// Take the smallest idle staging buffer that holds at least \a size bytes,
+/// or create a new one.
 static VkResult
-copy(cru_vk_image_t *self, enum copy_direction dir)
+staging_acquire_buffer(cru_vk_staging_t *staging, VkDeviceSize size,
+                       struct staging_buffer *buf)
+{
+    int best = -1;
+
+    pthread_mutex_lock(&staging->mutex);
+
+    for (uint32_t i = 0; i < staging->num_free_buffers; i++) {
+        const struct staging_buffer *b = &staging->free_buffers[i];
+        if (b->size < size)
+            continue;
+        if (best < 0 || b->size < staging->free_buffers[best].size)
+            best = i;
+    }
+
+    if (best >= 0) {
+        *buf = staging->free_buffers[best];
+        staging->free_buffers[best] =
+            staging->free_buffers[--staging->num_free_buffers];
+    }
+
+    pthread_mutex_unlock(&staging->mutex);
+
+    if (best >= 0)
+        return VK_SUCCESS;
+
+    return create_staging_buffer(staging, size, buf);
+}
+
+/// Return a staging buffer to the staging context for reuse. The buffer must
+/// have no pending GPU access.
+static void
+staging_release_buffer(cru_vk_staging_t *staging, struct staging_buffer *buf)
+{
+    if (buf->vk_buffer == VK_NULL_HANDLE)
+        return;
+
+    pthread_mutex_lock(&staging->mutex);
+
+    if (staging->num_free_buffers < STAGING_MAX_FREE_BUFFERS) {
+        staging->free_buffers[staging->num_free_buffers++] = *buf;
+        *buf = (struct staging_buffer) {0};
+    }
+
+    pthread_mutex_unlock(&staging->mutex);
+
+    // No-op unless the free list was full.
+    destroy_staging_buffer(staging->vk_dev, buf);
+}
+
+/// Wait for the submission in \a slot to complete. Called with
+/// cru_vk_staging::mutex held.
+static VkResult
+staging_wait_slot_locked(cru_vk_staging_t *staging, uint32_t slot)
+{
+    struct staging_submit *s = &staging->submits[slot];
+    VkResult r;
+
+    if (!s->busy)
+        return VK_SUCCESS;
+
+    r = vkWaitForFences(staging->vk_dev, 1, &s->fence, true,
+                        /*timeout*/ UINT64_MAX);
+    if (r != VK_SUCCESS) {
+        if (r == VK_TIMEOUT)
+            logw("vkWaitForFences timed out!");
+        return r;
+    }
+
+    s->busy = false;
+    return VK_SUCCESS;
+}
+
+/// Wait for the submission identified by (\a slot, \a serial). If the slot
+/// has since been recycled for a newer submission, then the requested one has
+/// already completed.
+static VkResult
+staging_wait(cru_vk_staging_t *staging, uint32_t slot, uint64_t serial)
 {
-    VkDevice dev = self->vk_dev;
-    VkCommandPool cmd_pool = VK_NULL_HANDLE;
-    VkCommandBuffer cmd = VK_NULL_HANDLE;
-    VkFence fence = {0};
     VkResult r = VK_SUCCESS;
 
-    r = vkCreateCommandPool(dev, &(VkCommandPoolCreateInfo) {
-            .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
-        },
-        NULL,
-        &cmd_pool);
+    pthread_mutex_lock(&staging->mutex);
 
-    r = vkAllocateCommandBuffers(dev, &(VkCommandBufferAllocateInfo) {
-            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-            .commandPool = cmd_pool,
-            .commandBufferCount = 1,
-        },
-        &cmd);
+    if (staging->submits[slot].serial == serial)
+        r = staging_wait_slot_locked(staging, slot);
+
+    pthread_mutex_unlock(&staging->mutex);
+
+    return r;
+}
+
+/// Acquire the next slot in the submit ring and begin recording its command
+/// buffer. On success, cru_vk_staging::mutex remains held until
+/// staging_end_submit().
+static VkResult
+staging_begin_submit(cru_vk_staging_t *staging, uint32_t *out_slot)
+{
+    VkDevice dev = staging->vk_dev;
+    VkResult r = VK_SUCCESS;
+
+    pthread_mutex_lock(&staging->mutex);
+
+    if (staging->cmd_pool == VK_NULL_HANDLE) {
+        r = vkCreateCommandPool(dev, &(VkCommandPoolCreateInfo) {
+                .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+                .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT |
+                         VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+                .queueFamilyIndex = staging->queue_family,
+            },
+            NULL,
+            &staging->cmd_pool);
+        if (r != VK_SUCCESS)
+            goto fail;
+    }
+
+    uint32_t slot = staging->next_submit;
+    struct staging_submit *s = &staging->submits[slot];
+
+    r = staging_wait_slot_locked(staging, slot);
     if (r != VK_SUCCESS)
-        goto cleanup;
+        goto fail;
+
+    if (s->cmd == VK_NULL_HANDLE) {
+        r = vkAllocateCommandBuffers(dev, &(VkCommandBufferAllocateInfo) {
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                .commandPool = staging->cmd_pool,
+                .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                .commandBufferCount = 1,
+            },
+            &s->cmd);
+        if (r != VK_SUCCESS)
+            goto fail;
+    } else {
+        r = vkResetCommandBuffer(s->cmd, 0);
+        if (r != VK_SUCCESS)
+            goto fail;
+    }
+
+    if (s->fence == VK_NULL_HANDLE) {
+        r = vkCreateFence(dev, &(VkFenceCreateInfo) {
+                .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+            },
+            NULL,
+            &s->fence);
+    } else {
+        r = vkResetFences(dev, 1, &s->fence);
+    }
+    if (r != VK_SUCCESS)
+        goto fail;
 
-    r = vkBeginCommandBuffer(cmd, &(VkCommandBufferBeginInfo) {
+    r = vkBeginCommandBuffer(s->cmd, &(VkCommandBufferBeginInfo) {
             .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
         });
     if (r != VK_SUCCESS)
-        goto cleanup;
+        goto fail;
+
+    *out_slot = slot;
+    return VK_SUCCESS;
+
+fail:
+    pthread_mutex_unlock(&staging->mutex);
+    return r;
+}
+
+/// Finish recording the command buffer in \a slot and submit it to \a queue
+/// without waiting. Releases cru_vk_staging::mutex.
+static VkResult
+staging_end_submit(cru_vk_staging_t *staging, uint32_t slot, VkQueue queue,
+                   uint64_t *out_serial)
+{
+    struct staging_submit *s = &staging->submits[slot];
+    VkResult r;
+
+    // Make transfer writes to the staging buffers available to the host.
+    vkCmdPipelineBarrier(s->cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_HOST_BIT, 0,
+                         1, &(VkMemoryBarrier) {
+                            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                            .dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+                         },
+                         0, NULL, 0, NULL);
+
+    r = vkEndCommandBuffer(s->cmd);
+    if (r != VK_SUCCESS)
+        goto done;
+
+    r = vkQueueSubmit(queue, 1,
+        &(VkSubmitInfo) {
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .commandBufferCount = 1,
+            .pCommandBuffers = &s->cmd,
+        }, s->fence);
+    if (r != VK_SUCCESS)
+        goto done;
+
+    s->busy = true;
+    s->serial = ++staging->serial;
+    staging->next_submit = (slot + 1) % STAGING_NUM_SUBMITS;
+    *out_serial = s->serial;
+
+done:
+    pthread_mutex_unlock(&staging->mutex);
+    return r;
+}
+
+static void
+staging_destroy(cru_vk_staging_t *staging)
+{
+    VkDevice dev = staging->vk_dev;
+
+    for (uint32_t i = 0; i < STAGING_NUM_SUBMITS; i++) {
+        struct staging_submit *s = &staging->submits[i];
+
+        staging_wait_slot_locked(staging, i);
+
+        if (s->fence != VK_NULL_HANDLE)
+            vkDestroyFence(dev, s->fence, NULL);
+        if (s->cmd != VK_NULL_HANDLE)
+            vkFreeCommandBuffers(dev, staging->cmd_pool, 1, &s->cmd);
+    }
+
+    if (staging->cmd_pool != VK_NULL_HANDLE)
+        vkDestroyCommandPool(dev, staging->cmd_pool, NULL);
+
+    for (uint32_t i = 0; i < staging->num_free_buffers; i++)
+        destroy_staging_buffer(dev, &staging->free_buffers[i]);
+
+    pthread_mutex_destroy(&staging->mutex);
+    free(staging);
+}
+
+malloclike cru_vk_staging_t *
+cru_vk_staging_create(VkDevice dev, uint32_t queue_family,
+                      const VkPhysicalDeviceMemoryProperties *mem_props,
+                      VkMemoryPropertyFlags tmp_mem_props)
+{
+    cru_vk_staging_t *staging = xzalloc(sizeof(*staging));
+
+    cru_refcount_init(&staging->refcount);
+    pthread_mutex_init(&staging->mutex, NULL);
+
+    staging->vk_dev = dev;
+    staging->queue_family = queue_family;
+    staging->mem_props = *mem_props;
+    staging->tmp_mem_props = tmp_mem_props;
+
+    return staging;
+}
+
+void
+cru_vk_staging_reference(cru_vk_staging_t *staging)
+{
+    cru_refcount_get(&staging->refcount);
+}
+
+void
+cru_vk_staging_release(cru_vk_staging_t *staging)
+{
+    if (!staging)
+        return;
+
+    if (cru_refcount_put(&staging->refcount) > 0)
+        return;
 
+    staging_destroy(staging);
+}
+
+static void
+cleanup_map(cru_vk_image_t *self)
+{
+    if (self->map.pending_serial) {
+        // The GPU may still be writing to the buffer.
+        staging_wait(self->staging, self->map.pending_slot,
+                     self->map.pending_serial);
+        self->map.pending_serial = 0;
+    }
+
+    staging_release_buffer(self->staging, &self->map.buffer);
+}
+
+/// Setup cru_vk_image::map.
+static VkResult
+setup_map(cru_vk_image_t *self)
+{
+    if (self->map.buffer.map)
+        return VK_SUCCESS;
+
+    const size_t buffer_size = self->cru_image.format_info->cpp *
+                               self->cru_image.width *
+                               self->cru_image.height;
+
+    return staging_acquire_buffer(self->staging, buffer_size,
+                                  &self->map.buffer);
+}
+
+static void
+record_copy(cru_vk_image_t *self, VkCommandBuffer cmd,
+            enum copy_direction dir)
+{
     const VkBufferImageCopy region = {
         .bufferOffset = 0,
         .imageSubresource = {
@@ -187,53 +509,37 @@ copy(cru_vk_image_t *self, enum copy_direction dir)
     switch (dir) {
     case COPY_IMAGE_TO_BUFFER:
         vkCmdCopyImageToBuffer(cmd, self->target.vk_image,
-                               VK_IMAGE_LAYOUT_GENERAL, self->map.vk_buffer,
+                               VK_IMAGE_LAYOUT_GENERAL,
+                               self->map.buffer.vk_buffer,
                                1, &region);
         break;
     case COPY_BUFFER_TO_IMAGE:
-        vkCmdCopyBufferToImage(cmd, self->map.vk_buffer,
+        vkCmdCopyBufferToImage(cmd, self->map.buffer.vk_buffer,
                                self->target.vk_image, VK_IMAGE_LAYOUT_GENERAL,
                                1, &region);
         break;
     }
+}
 
-    r = vkEndCommandBuffer(cmd);
-    if (r != VK_SUCCESS)
-        goto cleanup;
-
-    r = vkCreateFence(dev, &(VkFenceCreateInfo) {
-            .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
-        },
-        NULL,
-        &fence);
-    if (r != VK_SUCCESS)
-        goto cleanup;
+static VkResult
+copy(cru_vk_image_t *self, enum copy_direction dir)
+{
+    cru_vk_staging_t *staging = self->staging;
+    uint32_t slot;
+    uint64_t serial;
+    VkResult r;
 
-    r = vkQueueSubmit(self->vk_queue, 1,
-        &(VkSubmitInfo) {
-            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-            .commandBufferCount = 1,
-            .pCommandBuffers = &cmd,
-        }, fence);
+    r = staging_begin_submit(staging, &slot);
     if (r != VK_SUCCESS)
-        goto cleanup;
+        return r;
 
-    r = vkWaitForFences(dev, 1, &fence, true, /*timeout*/ UINT64_MAX);
-    if (r != VK_SUCCESS) {
-        if (r == VK_TIMEOUT)
-            logw("vkWaitForFences timed out!");
-        goto cleanup;
-    }
+    record_copy(self, staging->submits[slot].cmd, dir);
 
-cleanup:
-    if (fence != VK_NULL_HANDLE)
-        vkDestroyFence(dev, fence, NULL);
-    if (cmd)
-        vkFreeCommandBuffers(dev, cmd_pool, 1, &cmd);
-    if (cmd_pool)
-        vkDestroyCommandPool(dev, cmd_pool, NULL);
+    r = staging_end_submit(staging, slot, self->vk_queue, &serial);
+    if (r != VK_SUCCESS)
+        return r;
 
-    return r;
+    return staging_wait(staging, slot, serial);
 }
 
 static uint8_t *
@@ -246,14 +552,20 @@ map_pixels(cru_image_t *_self, uint32_t access)
     if (setup_map(self) != VK_SUCCESS)
         return NULL;
 
-    if (access & CRU_IMAGE_MAP_ACCESS_READ) {
+    if (self->map.pending_serial) {
+        VkResult r = staging_wait(self->staging, self->map.pending_slot,
+                                  self->map.pending_serial);
+        self->map.pending_serial = 0;
+        if (r != VK_SUCCESS)
+            return NULL;
+    } else if (access & CRU_IMAGE_MAP_ACCESS_READ) {
         if (copy(self, COPY_IMAGE_TO_BUFFER) != VK_SUCCESS)
             return NULL;
     }
 
     self->map.access = access;
 
-    return self->map.pixels;
+    return self->map.buffer.map;
 }
 
 static bool
@@ -284,16 +596,93 @@ destroy(cru_image_t *_self)
 
     cru_vk_image_t *self = (cru_vk_image_t *) _self;
 
-    cleanup_map(self);
+    if (self->staging) {
+        cleanup_map(self);
+        cru_vk_staging_release(self->staging);
+    }
+
     free(self);
 }
 
+/// Record one image-to-buffer copy per image into a single command buffer and
+/// submit it. All images must share the same staging context and queue.
+static bool
+begin_readback_batch(cru_vk_image_t **images, uint32_t count)
+{
+    cru_vk_staging_t *staging = images[0]->staging;
+    uint32_t slot;
+    uint64_t serial;
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (setup_map(images[i]) != VK_SUCCESS)
+            return false;
+    }
+
+    if (staging_begin_submit(staging, &slot) != VK_SUCCESS)
+        return false;
+
+    for (uint32_t i = 0; i < count; i++) {
+        record_copy(images[i], staging->submits[slot].cmd,
+                    COPY_IMAGE_TO_BUFFER);
+    }
+
+    if (staging_end_submit(staging, slot, images[0]->vk_queue,
+                           &serial) != VK_SUCCESS)
+        return false;
+
+    for (uint32_t i = 0; i < count; i++) {
+        images[i]->map.pending_slot = slot;
+        images[i]->map.pending_serial = serial;
+    }
+
+    return true;
+}
+
+bool
+cru_image_begin_readback(cru_image_t *const *images, uint32_t count)
+{
+    if (count == 0)
+        return true;
+
+    cru_vk_image_t *batch[count];
+    uint32_t batch_len = 0;
+    bool ok = true;
+
+    for (uint32_t i = 0; i < count; i++) {
+        // Other image types have nothing to read back.
+        if (images[i]->type != CRU_IMAGE_TYPE_VULKAN)
+            continue;
+
+        cru_vk_image_t *vk_image = (cru_vk_image_t *) images[i];
+
+        // Skip images that are mapped or already have a readback in flight.
+        if (vk_image->map.access || vk_image->map.pending_serial)
+            continue;
+
+        // Flush the current batch if this image needs a different command
+        // pool or queue.
+        if (batch_len > 0 &&
+            (batch[0]->staging != vk_image->staging ||
+             batch[0]->vk_queue != vk_image->vk_queue)) {
+            ok &= begin_readback_batch(batch, batch_len);
+            batch_len = 0;
+        }
+
+        batch[batch_len++] = vk_image;
+    }
+
+    if (batch_len > 0)
+        ok &= begin_readback_batch(batch, batch_len);
+
+    return ok;
+}
+
 malloclike cru_image_t *
-cru_image_from_vk_image(VkDevice dev, VkQueue queue, VkImage image,
-                        VkFormat format, VkImageAspectFlagBits aspect,
-                        uint32_t level0_width, uint32_t level0_height,
-                        uint32_t miplevel, uint32_t array_slice,
-                        VkMemoryPropertyFlags tmp_mem_props)
+cru_image_from_vk_image_staged(cru_vk_staging_t *staging, VkQueue queue,
+                               VkImage image, VkFormat format,
+                               VkImageAspectFlagBits aspect,
+                               uint32_t level0_width, uint32_t level0_height,
+                               uint32_t miplevel, uint32_t array_slice)
 {
     cru_vk_image_t *self = xzalloc(sizeof(*self));
 
@@ -304,9 +693,9 @@ cru_image_from_vk_image(VkDevice dev, VkQueue queue, VkImage image,
         goto fail;
     }
 
-    self->vk_dev = dev;
+    cru_vk_staging_reference(staging);
+    self->staging = staging;
     self->vk_queue = queue;
-    self->vk_tmp_mem_props = tmp_mem_props;
     self->target.vk_image = image;
     self->target.vk_aspect = aspect;
     self->target.miplevel = miplevel;
@@ -322,3 +711,25 @@ fail:
     destroy(&self->cru_image);
     return NULL;
 }
+
+malloclike cru_image_t *
+cru_image_from_vk_image(VkDevice dev, VkQueue queue, uint32_t queue_family,
+                        VkImage image, VkFormat format, VkImageAspectFlagBits aspect,
+                        uint32_t level0_width, uint32_t level0_height,
+                        uint32_t miplevel, uint32_t array_slice,
+                        VkMemoryPropertyFlags tmp_mem_props)
+{
+    // The image owns a private staging context, so its command buffer,
+    // fence and staging buffer are still reused across maps.
+    cru_vk_staging_t *staging =
+        cru_vk_staging_create(dev, queue_family,
+                              t_physical_dev_mem_props, tmp_mem_props);
+
+    cru_image_t *self = cru_image_from_vk_image_staged(staging, queue, image,
+            format, aspect, level0_width, level0_height, miplevel,
+            array_slice);
+
+    cru_vk_staging_release(staging);
+
+    return self;
+}
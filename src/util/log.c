@@ -19,19 +19,144 @@
 // FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
 // IN THE SOFTWARE.
 
+#include <errno.h>
+#include <limits.h>
 #include <pthread.h>
 #include <stdarg.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdio_ext.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "framework/runner/runner.h"
 #include "framework/test/test.h"
 #include "util/log.h"
 
-static pthread_mutex_t log_mutex = PTHREAD_MUTEX_INITIALIZER;
+/// Lines shorter than this are formatted without touching the heap.
+#define LOG_LINE_STACK_SIZE 1024
+
+/// \brief Excludes lines that the kernel may split from all other lines.
+///
+/// Each thread formats its line privately and commits it with a single
+/// write(2). POSIX guarantees that writes of at most PIPE_BUF bytes to
+/// a pipe, which is where workers' stdout goes, are never interleaved with
+/// other writes. Such lines take the lock shared, so they never wait on
+/// each other. Longer lines take it exclusive.
+static pthread_rwlock_t log_commit_lock = PTHREAD_RWLOCK_INITIALIZER;
+
 static bool log_has_aligned_tags = false;
 static bool log_should_print_pids = false;
 
+/// A log line being built by one thread.
+struct log_line {
+    char *data;
+    size_t len;
+    size_t cap;
+    char stack_buf[LOG_LINE_STACK_SIZE];
+};
+
+static void
+log_line_init(struct log_line *l)
+{
+    l->data = l->stack_buf;
+    l->len = 0;
+    l->cap = sizeof(l->stack_buf);
+    l->data[0] = 0;
+}
+
+static void
+log_line_finish(struct log_line *l)
+{
+    if (l->data != l->stack_buf)
+        free(l->data);
+}
+
+/// Append to the line, moving it to the heap if it outgrows the stack. If
+/// that allocation fails, the line is truncated rather than lost.
+static void
+log_line_vappendf(struct log_line *l, const char *format, va_list va)
+{
+    va_list va_retry;
+    va_copy(va_retry, va);
+
+    int n = vsnprintf(l->data + l->len, l->cap - l->len, format, va);
+    if (n < 0)
+        goto out;
+
+    if ((size_t) n >= l->cap - l->len) {
+        // Reserve room for the newline and null terminator.
+        size_t cap = l->len + n + 2;
+        char *data = malloc(cap);
+        if (!data) {
+            l->len = l->cap - 1;
+            goto out;
+        }
+
+        memcpy(data, l->data, l->len);
+        log_line_finish(l);
+        l->data = data;
+        l->cap = cap;
+
+        vsnprintf(l->data + l->len, l->cap - l->len, format, va_retry);
+    }
+
+    l->len += n;
+
+out:
+    va_end(va_retry);
+}
+
+static void printflike(2, 3)
+log_line_appendf(struct log_line *l, const char *format, ...)
+{
+    va_list va;
+
+    va_start(va, format);
+    log_line_vappendf(l, format, va);
+    va_end(va);
+}
+
+/// Terminate the line and write it to stdout in one piece.
+///
+/// Don't buffer the log messages. If a GPU hang occurs, buffering makes it
+/// difficult to determine which test hung the GPU.
+static void
+log_line_commit(struct log_line *l)
+{
+    if (l->len + 1 < l->cap)
+        l->data[l->len++] = '\n';
+    else
+        l->data[l->len - 1] = '\n';
+
+    // Anything printf() left in stdout's buffer must precede this line.
+    // Peeking at the buffer takes no lock.
+    if (__fpending(stdout) > 0)
+        fflush(stdout);
+
+    if (l->len <= PIPE_BUF)
+        pthread_rwlock_rdlock(&log_commit_lock);
+    else
+        pthread_rwlock_wrlock(&log_commit_lock);
+
+    const char *data = l->data;
+    size_t len = l->len;
+
+    while (len > 0) {
+        ssize_t n = write(STDOUT_FILENO, data, len);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        data += n;
+        len -= n;
+    }
+
+    pthread_rwlock_unlock(&log_commit_lock);
+}
+
 void
 log_tag(const char *tag, pid_t pid, const char *format, ...)
 {
@@ -95,7 +220,9 @@ logd(const char *format, ...)
 void
 log_tag_v(const char *tag, pid_t pid, const char *format, va_list va)
 {
-    pthread_mutex_lock(&log_mutex);
+    struct log_line l;
+
+    log_line_init(&l);
 
     // Tags are aligned to 7 because that's wide enough for "warning".
     // PID fields are aligned to 10 because that's enough for "dispatcher" and
@@ -103,38 +230,33 @@ log_tag_v(const char *tag, pid_t pid, const char *format, va_list va)
     if (log_should_print_pids) {
         if (pid == 0) {
             if (log_has_aligned_tags) {
-                printf("crucible [dispatcher]: %-7s: ", tag);
+                log_line_appendf(&l, "crucible [dispatcher]: %-7s: ", tag);
             } else {
-                printf("crucible [dispatcher]: %s: ", tag);
+                log_line_appendf(&l, "crucible [dispatcher]: %s: ", tag);
             }
         } else {
             int ipid = pid; // printf likes standard data types better
             if (log_has_aligned_tags) {
-                printf("crucible [%-10d]: %-7s: ", ipid, tag);
+                log_line_appendf(&l, "crucible [%-10d]: %-7s: ", ipid, tag);
             } else {
-                printf("crucible [%-10d]: %s: ", ipid, tag);
+                log_line_appendf(&l, "crucible [%-10d]: %s: ", ipid, tag);
             }
         }
     } else {
         if (log_has_aligned_tags) {
-            printf("crucible: %-7s: ", tag);
+            log_line_appendf(&l, "crucible: %-7s: ", tag);
         } else {
-            printf("crucible: %s: ", tag);
+            log_line_appendf(&l, "crucible: %s: ", tag);
         }
     }
 
     if (test_is_current()) {
-        printf("%s: ", t_name);
+        log_line_appendf(&l, "%s: ", t_name);
     }
 
-    vprintf(format, va);
-    printf("\n");
-
-    // Don't buffer the log messages. If a GPU hang occurs, buffering makes it
-    // difficult to determine which test hung the GPU.
-    fflush(stdout);
-
-    pthread_mutex_unlock(&log_mutex);
+    log_line_vappendf(&l, format, va);
+    log_line_commit(&l);
+    log_line_finish(&l);
 }
 
 void
@@ -171,17 +293,18 @@ logd_v(const char *format, va_list va)
 void
 __log_finishme(const char *file, int line, const char *format, ...)
 {
+    struct log_line l;
     va_list va;
 
-    pthread_mutex_lock(&log_mutex);
+    log_line_init(&l);
+    log_line_appendf(&l, "FINISHME: %s:%d: ", file, line);
 
     va_start(va, format);
-    printf("FINISHME: %s:%d: ", file, line);
-    vprintf(format, va);
-    printf("\n");
+    log_line_vappendf(&l, format, va);
     va_end(va);
 
-    pthread_mutex_unlock(&log_mutex);
+    log_line_commit(&l);
+    log_line_finish(&l);
 }
 
 void
@@ -199,11 +322,12 @@ void
 log_internal_error_loc_v(const char *file, int line,
                              const char *format, va_list va)
 {
-    pthread_mutex_lock(&log_mutex);
+    struct log_line l;
 
-    printf("internal error: %s:%d: ", file, line);
-    vprintf(format, va);
-    printf("\n");
+    log_line_init(&l);
+    log_line_appendf(&l, "internal error: %s:%d: ", file, line);
+    log_line_vappendf(&l, format, va);
+    log_line_commit(&l);
 
     abort();
 }
@@ -256,8 +256,7 @@ void run_simple_compute_pipeline(VkShaderModule cs,
         .requiredSubgroupSize = opts->required_subgroup_size,
     };
 
-    VkPipeline pipeline;
-    VkResult result = vkCreateComputePipelines(t_device, t_pipeline_cache, 1,
+    VkPipeline pipeline = qoCreateComputePipeline(t_device, t_pipeline_cache,
         &(VkComputePipelineCreateInfo) {
             .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
             .stage = {
@@ -269,9 +268,7 @@ void run_simple_compute_pipeline(VkShaderModule cs,
             },
             .flags = 0,
             .layout = pipeline_layout
-        }, NULL, &pipeline);
-    t_assert(result == VK_SUCCESS);
-    t_cleanup_push_vk_pipeline(t_device, pipeline);
+        });
 
     VkDescriptorSet set = qoAllocateDescriptorSet(t_device,
         .descriptorPool = t_descriptor_pool,